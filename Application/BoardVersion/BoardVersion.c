@@ -40,7 +40,20 @@ UefiMain (
   IN EFI_SYSTEM_TABLE  *SystemTable
   )
 {
+  CONST ADLINK_BOARD_IDENTITY  *Identity;
   UINT8 MajorVersion =  GetFirmwareMajorVersion();
-  
+
+  Identity = GetBoardIdentity ();
+  if (Identity != NULL) {
+    Print (
+      L"Board A%X, MMC %a, CPU %c%02d-%02X\n",
+      Identity->BoardRevision & 0x0F,
+      (Identity->MmcVersion[0] != '\0') ? Identity->MmcVersion : "unknown",
+      Identity->CpuIsAltraMax ? L'M' : L'Q',
+      Identity->CpuSkuMaxCore,
+      Identity->CpuSkuMaxTurbo
+      );
+  }
+
   return MajorVersion;
 }
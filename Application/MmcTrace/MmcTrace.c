@@ -0,0 +1,86 @@
+/** @file
+  Shell application dumping the trace of the recent MMC transactions.
+
+  Copyright (c) 2022, ADLink. All rights reserved.<BR>
+
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#include <Uefi.h>
+#include <Library/BaseLib.h>
+#include <Library/UefiLib.h>
+#include <Library/UefiApplicationEntryPoint.h>
+#include <Guid/MmcTrace.h>
+
+/**
+  Print Size bytes as hex.
+
+**/
+STATIC
+VOID
+PrintBytes (
+  IN CONST UINT8  *Bytes,
+  IN UINTN        Size
+  )
+{
+  UINTN  Index;
+
+  for (Index = 0; Index < Size; Index++) {
+    Print (L" %02X", Bytes[Index]);
+  }
+}
+
+/**
+  The user Entry Point for Application. Prints the MMC transactions kept in
+  the trace, oldest first.
+
+  @param[in] ImageHandle    The firmware allocated handle for the EFI image.
+  @param[in] SystemTable    A pointer to the EFI System Table.
+
+  @retval EFI_SUCCESS       The trace was printed.
+  @retval EFI_NOT_FOUND     No trace is published.
+
+**/
+EFI_STATUS
+EFIAPI
+UefiMain (
+  IN EFI_HANDLE        ImageHandle,
+  IN EFI_SYSTEM_TABLE  *SystemTable
+  )
+{
+  ADLINK_MMC_TRACE_LOG          *Log;
+  CONST ADLINK_MMC_TRACE_ENTRY  *Entry;
+  UINT64                        First;
+  UINT64                        Index;
+  EFI_STATUS                    Status;
+
+  Status = EfiGetSystemConfigurationTable (&gAdlinkMmcTraceGuid, (VOID **)&Log);
+  if (EFI_ERROR (Status) || (Log->Signature != ADLINK_MMC_TRACE_SIGNATURE)) {
+    Print (L"No MMC trace\n");
+    return EFI_NOT_FOUND;
+  }
+
+  First = (Log->Recorded > Log->Capacity) ? Log->Recorded - Log->Capacity : 0;
+  Print (L"%ld MMC transactions, last %ld:\n", Log->Recorded, Log->Recorded - First);
+
+  for (Index = First; Index < Log->Recorded; Index++) {
+    Entry = &Log->Entries[(UINTN)Index % Log->Capacity];
+    Print (
+      L"%6ld %10ld us %6d us %r\n   >",
+      Index,
+      DivU64x32 (Entry->Timestamp, 1000),
+      Entry->LatencyUs,
+      (EFI_STATUS)Entry->Status
+      );
+    PrintBytes (Entry->Command, Entry->CommandSize);
+    if (Entry->ResponseSize != 0) {
+      Print (L"\n   <");
+      PrintBytes (Entry->Response, Entry->ResponseSize);
+    }
+
+    Print (L"\n");
+  }
+
+  return EFI_SUCCESS;
+}
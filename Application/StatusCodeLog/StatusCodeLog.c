@@ -0,0 +1,74 @@
+/** @file
+  Shell application dumping the binary status code log as hex, for
+  tools/StatusCodeLogDecode.py to format from a capture of the console.
+
+  Copyright (c) 2022, ADLink. All rights reserved.<BR>
+
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#include <Uefi.h>
+#include <Library/BaseLib.h>
+#include <Library/UefiLib.h>
+#include <Library/UefiApplicationEntryPoint.h>
+#include <Guid/StatusCodeLog.h>
+
+//
+// Bytes per line of the dump.
+//
+#define STATUS_CODE_LOG_DUMP_LINE  32
+
+/**
+  The user Entry Point for Application. Prints the header and ring of the
+  log, one line of STATUS_CODE_LOG_DUMP_LINE bytes prefixed by their offset,
+  between a BEGIN and an END line.
+
+  @param[in] ImageHandle    The firmware allocated handle for the EFI image.
+  @param[in] SystemTable    A pointer to the EFI System Table.
+
+  @retval EFI_SUCCESS       The log was printed.
+  @retval EFI_NOT_FOUND     No log is published.
+
+**/
+EFI_STATUS
+EFIAPI
+UefiMain (
+  IN EFI_HANDLE        ImageHandle,
+  IN EFI_SYSTEM_TABLE  *SystemTable
+  )
+{
+  ADLINK_STATUS_CODE_LOG_HEADER  *Log;
+  CONST UINT8                    *Bytes;
+  UINTN                          Size;
+  UINTN                          Offset;
+  EFI_STATUS                     Status;
+
+  Status = EfiGetSystemConfigurationTable (&gAdlinkStatusCodeLogGuid, (VOID **)&Log);
+  if (EFI_ERROR (Status) || (Log->Signature != ADLINK_STATUS_CODE_LOG_SIGNATURE)) {
+    Print (L"No status code log\n");
+    return EFI_NOT_FOUND;
+  }
+
+  Bytes = (CONST UINT8 *)Log;
+  Size  = sizeof (*Log) + Log->Size;
+  Print (L"STATUS CODE LOG BEGIN %d\n", Size);
+  for (Offset = 0; Offset < Size; Offset++) {
+    if ((Offset % STATUS_CODE_LOG_DUMP_LINE) == 0) {
+      Print (L"%08x:", Offset);
+    }
+
+    Print (L" %02x", Bytes[Offset]);
+    if (((Offset + 1) % STATUS_CODE_LOG_DUMP_LINE) == 0) {
+      Print (L"\n");
+    }
+  }
+
+  if ((Size % STATUS_CODE_LOG_DUMP_LINE) != 0) {
+    Print (L"\n");
+  }
+
+  Print (L"STATUS CODE LOG END\n");
+
+  return EFI_SUCCESS;
+}
@@ -0,0 +1,249 @@
+/** @file
+  Shell application showing and setting the status code routing policy
+  described in Guid/StatusCodeRouting.h. The policy applies from the next
+  boot on.
+
+    StatusCodeRouting                      show the policy
+    StatusCodeRouting production           errors only, progress codes still sent as POST codes
+                                           and kept in the persistent log
+    StatusCodeRouting debug                everything to every sink
+    StatusCodeRouting default              delete the variable, same as debug
+    StatusCodeRouting caller GUID LEVELS   DEBUG () error levels (hex) of one module on
+                                           the serial port and binary log, 0 mutes it
+
+  Copyright (c) 2022, ADLink. All rights reserved.<BR>
+
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#include <Uefi.h>
+#include <Library/BaseLib.h>
+#include <Library/BaseMemoryLib.h>
+#include <Library/DebugLib.h>
+#include <Library/UefiLib.h>
+#include <Library/ShellCEntryLib.h>
+#include <Library/UefiRuntimeServicesTableLib.h>
+#include <Guid/StatusCodeRouting.h>
+
+#define STATUS_CODE_ROUTING_ALL_SEVERITIES \
+  ((1U << (EFI_ERROR_MINOR >> 28)) | (1U << (EFI_ERROR_MAJOR >> 28)) | \
+   (1U << (EFI_ERROR_UNRECOVERED >> 28)) | (1U << (EFI_ERROR_UNCONTAINED >> 28)))
+
+STATIC CONST CHAR16  *mSinkNames[ADLINK_STATUS_CODE_SINK_COUNT] = {
+  L"Serial",
+  L"Memory",
+  L"POST code",
+  L"Binary log",
+  L"Persistent"
+};
+
+/**
+  Fill in a policy forwarding everything to every sink.
+
+  @param[out] Routing  The policy.
+
+**/
+STATIC
+VOID
+StatusCodeRoutingDefault (
+  OUT ADLINK_STATUS_CODE_ROUTING  *Routing
+  )
+{
+  ZeroMem (Routing, sizeof (*Routing));
+  Routing->Signature = ADLINK_STATUS_CODE_ROUTING_SIGNATURE;
+  SetMem (Routing->Sinks, sizeof (Routing->Sinks), 0xFF);
+}
+
+/**
+  Read the policy in effect from the next boot on.
+
+  @param[out] Routing  The policy, the default one if none is stored.
+
+**/
+STATIC
+VOID
+StatusCodeRoutingRead (
+  OUT ADLINK_STATUS_CODE_ROUTING  *Routing
+  )
+{
+  EFI_STATUS  Status;
+  UINTN       DataSize;
+
+  DataSize = sizeof (*Routing);
+  Status   = gRT->GetVariable (
+                    ADLINK_STATUS_CODE_ROUTING_VARIABLE_NAME,
+                    &gAdlinkStatusCodeRoutingGuid,
+                    NULL,
+                    &DataSize,
+                    Routing
+                    );
+  if (EFI_ERROR (Status) || (DataSize != sizeof (*Routing)) ||
+      (Routing->Signature != ADLINK_STATUS_CODE_ROUTING_SIGNATURE) ||
+      (Routing->CallerCount > ADLINK_STATUS_CODE_ROUTING_CALLERS))
+  {
+    StatusCodeRoutingDefault (Routing);
+  }
+}
+
+/**
+  Store a policy.
+
+  @param[in] Routing  The policy, or NULL to delete the variable.
+
+  @return The status of SetVariable ().
+
+**/
+STATIC
+EFI_STATUS
+StatusCodeRoutingWrite (
+  IN ADLINK_STATUS_CODE_ROUTING  *Routing  OPTIONAL
+  )
+{
+  EFI_STATUS  Status;
+
+  Status = gRT->SetVariable (
+                  ADLINK_STATUS_CODE_ROUTING_VARIABLE_NAME,
+                  &gAdlinkStatusCodeRoutingGuid,
+                  EFI_VARIABLE_BOOTSERVICE_ACCESS | EFI_VARIABLE_NON_VOLATILE,
+                  (Routing == NULL) ? 0 : sizeof (*Routing),
+                  Routing
+                  );
+  if (Status == EFI_NOT_FOUND) {
+    //
+    // Nothing to delete.
+    //
+    Status = EFI_SUCCESS;
+  }
+
+  if (EFI_ERROR (Status)) {
+    Print (L"Error writing %s - %r\n", ADLINK_STATUS_CODE_ROUTING_VARIABLE_NAME, Status);
+  } else {
+    Print (L"Status code routing updated, applies from the next boot on\n");
+  }
+
+  return Status;
+}
+
+/**
+  Print a policy.
+
+  @param[in] Routing  The policy.
+
+**/
+STATIC
+VOID
+StatusCodeRoutingShow (
+  IN CONST ADLINK_STATUS_CODE_ROUTING  *Routing
+  )
+{
+  UINTN  Index;
+
+  Print (L"%-12s %-10s %-10s %-10s\n", L"Sink", L"CodeTypes", L"Severities", L"ErrorLevels");
+  for (Index = 0; Index < ADLINK_STATUS_CODE_SINK_COUNT; Index++) {
+    Print (
+      L"%-12s %08x   %08x   %08x\n",
+      mSinkNames[Index],
+      Routing->Sinks[Index].CodeTypes,
+      Routing->Sinks[Index].Severities,
+      Routing->Sinks[Index].ErrorLevels
+      );
+  }
+
+  for (Index = 0; Index < Routing->CallerCount; Index++) {
+    Print (
+      L"Caller %g: sinks %x, error levels %08x\n",
+      &Routing->Callers[Index].CallerId,
+      Routing->Callers[Index].Sinks,
+      Routing->Callers[Index].ErrorLevels
+      );
+  }
+}
+
+/**
+  UEFI application entry point which has an interface similar to a
+  standard C main function.
+
+  @param[in] Argc     The number of items in Argv.
+  @param[in] Argv     Array of pointers to strings.
+
+  @retval  0               The application exited normally.
+  @retval  Other           An error occurred.
+
+**/
+INTN
+EFIAPI
+ShellAppMain (
+  IN UINTN   Argc,
+  IN CHAR16  **Argv
+  )
+{
+  ADLINK_STATUS_CODE_ROUTING  Routing;
+  EFI_GUID                    CallerId;
+  UINTN                       Index;
+  UINTN                       Sink;
+
+  StatusCodeRoutingRead (&Routing);
+
+  if ((Argc < 2) || (StrCmp (Argv[1], L"show") == 0)) {
+    StatusCodeRoutingShow (&Routing);
+    return 0;
+  }
+
+  if (StrCmp (Argv[1], L"default") == 0) {
+    return StatusCodeRoutingWrite (NULL);
+  }
+
+  if (StrCmp (Argv[1], L"debug") == 0) {
+    StatusCodeRoutingDefault (&Routing);
+    return StatusCodeRoutingWrite (&Routing);
+  }
+
+  if (StrCmp (Argv[1], L"production") == 0) {
+    for (Sink = 0; Sink < ADLINK_STATUS_CODE_SINK_COUNT; Sink++) {
+      Routing.Sinks[Sink].CodeTypes   = 1U << EFI_ERROR_CODE;
+      Routing.Sinks[Sink].Severities  = STATUS_CODE_ROUTING_ALL_SEVERITIES;
+      Routing.Sinks[Sink].ErrorLevels = DEBUG_ERROR;
+    }
+
+    //
+    // DEBUG_ERROR messages stay on the serial port, progress codes keep
+    // showing where the boot stopped on the MMC and after a reset.
+    //
+    Routing.Sinks[ADLINK_STATUS_CODE_SINK_SERIAL].CodeTypes     |= 1U << EFI_DEBUG_CODE;
+    Routing.Sinks[ADLINK_STATUS_CODE_SINK_POST_CODE].CodeTypes  |= 1U << EFI_PROGRESS_CODE;
+    Routing.Sinks[ADLINK_STATUS_CODE_SINK_PERSISTENT].CodeTypes |= 1U << EFI_PROGRESS_CODE;
+    return StatusCodeRoutingWrite (&Routing);
+  }
+
+  if ((StrCmp (Argv[1], L"caller") == 0) && (Argc == 4)) {
+    if (EFI_ERROR (StrToGuid (Argv[2], &CallerId))) {
+      Print (L"Invalid GUID %s\n", Argv[2]);
+      return EFI_INVALID_PARAMETER;
+    }
+
+    for (Index = 0; Index < Routing.CallerCount; Index++) {
+      if (CompareGuid (&Routing.Callers[Index].CallerId, &CallerId)) {
+        break;
+      }
+    }
+
+    if (Index == ADLINK_STATUS_CODE_ROUTING_CALLERS) {
+      Print (L"No room for more than %d callers\n", ADLINK_STATUS_CODE_ROUTING_CALLERS);
+      return EFI_OUT_OF_RESOURCES;
+    }
+
+    if (Index == Routing.CallerCount) {
+      Routing.CallerCount++;
+    }
+
+    CopyGuid (&Routing.Callers[Index].CallerId, &CallerId);
+    Routing.Callers[Index].Sinks = (1U << ADLINK_STATUS_CODE_SINK_SERIAL) |
+                                   (1U << ADLINK_STATUS_CODE_SINK_BINARY_LOG);
+    Routing.Callers[Index].ErrorLevels = (UINT32)StrHexToUintn (Argv[3]);
+    return StatusCodeRoutingWrite (&Routing);
+  }
+
+  Print (L"Usage: StatusCodeRouting [show | production | debug | default | caller GUID LEVELS]\n");
+  return EFI_INVALID_PARAMETER;
+}
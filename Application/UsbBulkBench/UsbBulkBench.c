@@ -0,0 +1,571 @@
+/** @file
+  Shell application measuring the read throughput of a USB mass storage
+  device (Bulk-Only Transport, SCSI), with one synchronous bulk transfer
+  after the other as the mass storage driver does, then with the bulk
+  transfers of each command queued through ADLINK_USB_BULK_QUEUE_PROTOCOL.
+
+    UsbBulkBench [MB [KB]]   read MB megabytes (default 64) in commands of
+                             KB kilobytes (default 64)
+
+  Each mode reads the same blocks from LBA 0, after an untimed pass to warm
+  up the caches. Under qemu, for instance:
+
+    -device qemu-xhci -drive if=none,id=stick,format=raw,file=disk.img
+    -device usb-storage,drive=stick
+
+  The first Bulk-Only mass storage interface is opened exclusively, which
+  disconnects the mass storage driver from it for the time of the
+  benchmark, and connected again at the end. Its bus address and speed are
+  those the XHCI driver returns for its device path.
+
+  Copyright (c) 2022, ADLink. All rights reserved.<BR>
+
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#include <Uefi.h>
+#include <IndustryStandard/Usb.h>
+#include <Library/BaseLib.h>
+#include <Library/BaseMemoryLib.h>
+#include <Library/DevicePathLib.h>
+#include <Library/MemoryAllocationLib.h>
+#include <Library/ShellCEntryLib.h>
+#include <Library/TimerLib.h>
+#include <Library/UefiBootServicesTableLib.h>
+#include <Library/UefiLib.h>
+#include <Protocol/DevicePath.h>
+#include <Protocol/UsbIo.h>
+#include <Protocol/UsbBulkQueue.h>
+
+#define BENCH_CBW_SIGNATURE  0x43425355
+#define BENCH_CSW_SIGNATURE  0x53425355
+#define BENCH_TIMEOUT        3000 // ms
+#define BENCH_CHUNK_SIZE     SIZE_64KB
+
+#pragma pack(1)
+typedef struct {
+  UINT32    Signature;
+  UINT32    Tag;
+  UINT32    DataLen;
+  UINT8     Flag;
+  UINT8     Lun;
+  UINT8     CmdLen;
+  UINT8     CmdBlock[16];
+} BENCH_CBW;
+
+typedef struct {
+  UINT32    Signature;
+  UINT32    Tag;
+  UINT32    DataResidue;
+  UINT8     CmdStatus;
+} BENCH_CSW;
+#pragma pack()
+
+typedef struct {
+  EFI_HANDLE                        Handle;
+  EFI_USB_IO_PROTOCOL               *UsbIo;
+  ADLINK_USB_BULK_QUEUE_PROTOCOL    *Queue;
+  UINT8                             Address;
+  UINT8                             Speed;
+  UINT8                             BulkIn;
+  UINT8                             BulkOut;
+  UINT16                            MaxPacket;
+  UINT32                            Tag;
+  BENCH_CBW                         *Cbw;
+  BENCH_CSW                         *Csw;
+} BENCH_DEVICE;
+
+/**
+  Build the CBW of a SCSI command reading into the host.
+
+  @param[in] Device   The device.
+  @param[in] Cdb      The command block, 10 bytes.
+  @param[in] DataLen  Number of bytes the command reads.
+
+**/
+STATIC
+VOID
+BenchBuildCbw (
+  IN BENCH_DEVICE  *Device,
+  IN CONST UINT8   *Cdb,
+  IN UINT32        DataLen
+  )
+{
+  ZeroMem (Device->Cbw, sizeof (BENCH_CBW));
+  Device->Cbw->Signature = BENCH_CBW_SIGNATURE;
+  Device->Cbw->Tag       = ++Device->Tag;
+  Device->Cbw->DataLen   = DataLen;
+  Device->Cbw->Flag      = 0x80;
+  Device->Cbw->CmdLen    = 10;
+  CopyMem (Device->Cbw->CmdBlock, Cdb, 10);
+}
+
+/**
+  Check the CSW of the last command.
+
+  @param[in] Device  The device.
+
+  @retval EFI_SUCCESS       The command passed.
+  @retval EFI_DEVICE_ERROR  The CSW is invalid or the command failed.
+
+**/
+STATIC
+EFI_STATUS
+BenchCheckCsw (
+  IN BENCH_DEVICE  *Device
+  )
+{
+  if ((Device->Csw->Signature != BENCH_CSW_SIGNATURE) ||
+      (Device->Csw->Tag != Device->Tag) ||
+      (Device->Csw->CmdStatus != 0))
+  {
+    return EFI_DEVICE_ERROR;
+  }
+
+  return EFI_SUCCESS;
+}
+
+/**
+  Run a SCSI command reading into the host, one synchronous USB I/O bulk
+  transfer after the other.
+
+  @param[in]  Device   The device.
+  @param[in]  Cdb      The command block, 10 bytes.
+  @param[out] Data     The buffer read into.
+  @param[in]  DataLen  Number of bytes to read.
+
+  @retval EFI_SUCCESS  The command passed.
+  @retval Others       A transfer or the command failed.
+
+**/
+STATIC
+EFI_STATUS
+BenchReadSync (
+  IN  BENCH_DEVICE  *Device,
+  IN  CONST UINT8   *Cdb,
+  OUT VOID          *Data,
+  IN  UINT32        DataLen
+  )
+{
+  EFI_STATUS  Status;
+  UINTN       Length;
+  UINT32      Result;
+
+  BenchBuildCbw (Device, Cdb, DataLen);
+  Length = sizeof (BENCH_CBW);
+  Status = Device->UsbIo->UsbBulkTransfer (Device->UsbIo, Device->BulkOut, Device->Cbw, &Length, BENCH_TIMEOUT, &Result);
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+
+  Length = DataLen;
+  Status = Device->UsbIo->UsbBulkTransfer (Device->UsbIo, Device->BulkIn, Data, &Length, BENCH_TIMEOUT, &Result);
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+
+  Length = sizeof (BENCH_CSW);
+  Status = Device->UsbIo->UsbBulkTransfer (Device->UsbIo, Device->BulkIn, Device->Csw, &Length, BENCH_TIMEOUT, &Result);
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+
+  return BenchCheckCsw (Device);
+}
+
+/**
+  Run a SCSI command reading into the host, with the CBW, the data in
+  BENCH_CHUNK_SIZE transfers and the CSW queued at once. A full queue is
+  made room for by completing the oldest transfer of the bulk in endpoint.
+
+  @param[in]  Device   The device.
+  @param[in]  Cdb      The command block, 10 bytes.
+  @param[out] Data     The buffer read into.
+  @param[in]  DataLen  Number of bytes to read.
+
+  @retval EFI_SUCCESS  The command passed.
+  @retval Others       A transfer or the command failed.
+
+**/
+STATIC
+EFI_STATUS
+BenchReadQueued (
+  IN  BENCH_DEVICE  *Device,
+  IN  CONST UINT8   *Cdb,
+  OUT VOID          *Data,
+  IN  UINT32        DataLen
+  )
+{
+  ADLINK_USB_BULK_QUEUE_PROTOCOL  *Queue;
+  EFI_STATUS                      Status;
+  EFI_STATUS                      Error;
+  UINT32                          Submitted;
+  UINT32                          Chunk;
+  UINTN                           Length;
+  UINT32                          Result;
+  BOOLEAN                         CswQueued;
+
+  Queue = Device->Queue;
+  BenchBuildCbw (Device, Cdb, DataLen);
+  Status = Queue->Submit (Queue, Device->Address, Device->BulkOut, Device->Speed, Device->MaxPacket, Device->Cbw, sizeof (BENCH_CBW));
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+
+  Submitted = 0;
+  CswQueued = FALSE;
+  while (!CswQueued) {
+    if (Submitted < DataLen) {
+      Chunk  = MIN (DataLen - Submitted, BENCH_CHUNK_SIZE);
+      Status = Queue->Submit (Queue, Device->Address, Device->BulkIn, Device->Speed, Device->MaxPacket, (UINT8 *)Data + Submitted, Chunk);
+      if (!EFI_ERROR (Status)) {
+        Submitted += Chunk;
+      }
+    } else {
+      Status = Queue->Submit (Queue, Device->Address, Device->BulkIn, Device->Speed, Device->MaxPacket, Device->Csw, sizeof (BENCH_CSW));
+      if (!EFI_ERROR (Status)) {
+        CswQueued = TRUE;
+      }
+    }
+
+    if (Status == EFI_NOT_READY) {
+      Status = Queue->Complete (Queue, Device->Address, Device->BulkIn, BENCH_TIMEOUT, NULL, &Length, &Result);
+    }
+
+    if (EFI_ERROR (Status)) {
+      break;
+    }
+  }
+
+  //
+  // Complete what is left in order, the first error is the one reported.
+  //
+  Error = Queue->Complete (Queue, Device->Address, Device->BulkOut, BENCH_TIMEOUT, NULL, &Length, &Result);
+  if (!EFI_ERROR (Error)) {
+    Error = Status;
+  }
+
+  do {
+    Status = Queue->Complete (Queue, Device->Address, Device->BulkIn, BENCH_TIMEOUT, NULL, &Length, &Result);
+    if (EFI_ERROR (Status) && (Status != EFI_NOT_FOUND) && !EFI_ERROR (Error)) {
+      Error = Status;
+    }
+  } while (Status != EFI_NOT_FOUND);
+
+  if (EFI_ERROR (Error)) {
+    return Error;
+  }
+
+  return BenchCheckCsw (Device);
+}
+
+/**
+  Close the USB I/O instance opened by BenchFindDevice (), and connect the
+  drivers of the interface again.
+
+  @param[in, out] Device  The device.
+
+**/
+STATIC
+VOID
+BenchReleaseDevice (
+  IN OUT BENCH_DEVICE  *Device
+  )
+{
+  if (Device->Handle == NULL) {
+    return;
+  }
+
+  gBS->CloseProtocol (Device->Handle, &gEfiUsbIoProtocolGuid, gImageHandle, Device->Handle);
+  gBS->ConnectController (Device->Handle, NULL, NULL, TRUE);
+  Device->Handle = NULL;
+  Device->UsbIo  = NULL;
+}
+
+/**
+  Find the first USB mass storage interface using the Bulk-Only Transport
+  behind a controller with a bulk queue, and open its USB I/O exclusively.
+  The driver managing the interface is disconnected from it.
+
+  @param[out] Device  The device, its bus address and speed are those the
+                      controller driver returns.
+
+  @retval EFI_SUCCESS    The device was found and opened.
+  @retval EFI_NOT_FOUND  No such device could be opened.
+
+**/
+STATIC
+EFI_STATUS
+BenchFindDevice (
+  OUT BENCH_DEVICE  *Device
+  )
+{
+  EFI_HANDLE                    *Handles;
+  UINTN                         HandleCount;
+  UINTN                         Index;
+  EFI_USB_IO_PROTOCOL           *UsbIo;
+  EFI_USB_INTERFACE_DESCRIPTOR  Interface;
+  EFI_USB_ENDPOINT_DESCRIPTOR   Endpoint;
+  EFI_DEVICE_PATH_PROTOCOL      *DevicePath;
+  EFI_DEVICE_PATH_PROTOCOL      *RemainingPath;
+  EFI_HANDLE                    Controller;
+  EFI_STATUS                    Status;
+  UINT8                         EpIndex;
+
+  Status = gBS->LocateHandleBuffer (ByProtocol, &gEfiUsbIoProtocolGuid, NULL, &HandleCount, &Handles);
+  if (EFI_ERROR (Status)) {
+    return EFI_NOT_FOUND;
+  }
+
+  Status = EFI_NOT_FOUND;
+  for (Index = 0; Index < HandleCount; Index++) {
+    gBS->HandleProtocol (Handles[Index], &gEfiUsbIoProtocolGuid, (VOID **)&UsbIo);
+    if (EFI_ERROR (UsbIo->UsbGetInterfaceDescriptor (UsbIo, &Interface)) ||
+        (Interface.InterfaceClass != 0x08) ||
+        (Interface.InterfaceSubClass != 0x06) ||
+        (Interface.InterfaceProtocol != 0x50))
+    {
+      continue;
+    }
+
+    ZeroMem (Device, sizeof (BENCH_DEVICE));
+    DevicePath    = DevicePathFromHandle (Handles[Index]);
+    RemainingPath = DevicePath;
+    if ((DevicePath == NULL) ||
+        EFI_ERROR (gBS->LocateDevicePath (&gAdlinkUsbBulkQueueProtocolGuid, &RemainingPath, &Controller)) ||
+        EFI_ERROR (gBS->HandleProtocol (Controller, &gAdlinkUsbBulkQueueProtocolGuid, (VOID **)&Device->Queue)) ||
+        (Device->Queue->Revision < 0x00010001) ||
+        EFI_ERROR (Device->Queue->GetDevice (Device->Queue, DevicePath, &Device->Address, &Device->Speed)))
+    {
+      continue;
+    }
+
+    //
+    // The mass storage driver must not issue commands in the middle of ours.
+    //
+    if (EFI_ERROR (
+          gBS->OpenProtocol (
+                 Handles[Index],
+                 &gEfiUsbIoProtocolGuid,
+                 (VOID **)&Device->UsbIo,
+                 gImageHandle,
+                 Handles[Index],
+                 EFI_OPEN_PROTOCOL_BY_DRIVER | EFI_OPEN_PROTOCOL_EXCLUSIVE
+                 )
+          ))
+    {
+      continue;
+    }
+
+    Device->Handle = Handles[Index];
+    for (EpIndex = 0; EpIndex < Interface.NumEndpoints; EpIndex++) {
+      if (EFI_ERROR (Device->UsbIo->UsbGetEndpointDescriptor (Device->UsbIo, EpIndex, &Endpoint)) ||
+          ((Endpoint.Attributes & USB_ENDPOINT_TYPE_MASK) != USB_ENDPOINT_BULK))
+      {
+        continue;
+      }
+
+      if ((Endpoint.EndpointAddress & USB_ENDPOINT_DIR_IN) != 0) {
+        Device->BulkIn = Endpoint.EndpointAddress;
+      } else {
+        Device->BulkOut = Endpoint.EndpointAddress;
+      }
+
+      Device->MaxPacket = Endpoint.MaxPacketSize;
+    }
+
+    if ((Device->BulkIn != 0) && (Device->BulkOut != 0)) {
+      Status = EFI_SUCCESS;
+      break;
+    }
+
+    BenchReleaseDevice (Device);
+  }
+
+  FreePool (Handles);
+  return Status;
+}
+
+/**
+  Read the same blocks with one of the modes, and print the throughput.
+
+  @param[in]  Device       The device.
+  @param[in]  Name         The name of the mode, NULL for the warm up pass.
+  @param[in]  Queued       TRUE to queue the transfers, FALSE to run them one by one.
+  @param[out] Buffer       The buffer read into, CommandSize bytes.
+  @param[in]  CommandSize  Number of bytes read by each command.
+  @param[in]  Commands     Number of commands.
+  @param[in]  BlockSize    The block size of the device.
+
+  @retval EFI_SUCCESS  All the commands passed.
+  @retval Others       A command failed.
+
+**/
+STATIC
+EFI_STATUS
+BenchRun (
+  IN  BENCH_DEVICE   *Device,
+  IN  CONST CHAR16   *Name OPTIONAL,
+  IN  BOOLEAN        Queued,
+  OUT VOID           *Buffer,
+  IN  UINT32         CommandSize,
+  IN  UINT32         Commands,
+  IN  UINT32         BlockSize
+  )
+{
+  UINT8       Cdb[10];
+  UINT32      Lba;
+  UINT32      Blocks;
+  UINT32      Index;
+  UINT64      Start;
+  UINT64      Time;
+  UINT64      Bytes;
+  EFI_STATUS  Status;
+
+  Blocks = CommandSize / BlockSize;
+  Start  = GetPerformanceCounter ();
+
+  for (Index = 0; Index < Commands; Index++) {
+    Lba = Index * Blocks;
+    ZeroMem (Cdb, sizeof (Cdb));
+    Cdb[0] = 0x28; // READ (10)
+    Cdb[2] = (UINT8)(Lba >> 24);
+    Cdb[3] = (UINT8)(Lba >> 16);
+    Cdb[4] = (UINT8)(Lba >> 8);
+    Cdb[5] = (UINT8)Lba;
+    Cdb[7] = (UINT8)(Blocks >> 8);
+    Cdb[8] = (UINT8)Blocks;
+
+    if (Queued) {
+      Status = BenchReadQueued (Device, Cdb, Buffer, CommandSize);
+    } else {
+      Status = BenchReadSync (Device, Cdb, Buffer, CommandSize);
+    }
+
+    if (EFI_ERROR (Status)) {
+      Print (L"READ (10) at LBA %d failed: %r\n", Lba, Status);
+      return Status;
+    }
+  }
+
+  if (Name != NULL) {
+    Time  = GetTimeInNanoSecond (GetPerformanceCounter () - Start);
+    Bytes = MultU64x32 (CommandSize, Commands);
+    Print (
+      L"%-12s %6ld KB/s  %4ld us per command\n",
+      Name,
+      DivU64x64Remainder (MultU64x32 (Bytes, 1000000), MAX (Time, 1), NULL),
+      DivU64x32 (Time, Commands * 1000)
+      );
+  }
+
+  return EFI_SUCCESS;
+}
+
+/**
+  UEFI application entry point which has an interface similar to a
+  standard C main function.
+
+  @param[in] Argc     The number of items in Argv.
+  @param[in] Argv     Array of pointers to strings.
+
+  @retval  0               The application exited normally.
+  @retval  Other           An error occurred.
+
+**/
+INTN
+EFIAPI
+ShellAppMain (
+  IN UINTN   Argc,
+  IN CHAR16  **Argv
+  )
+{
+  BENCH_DEVICE  Device;
+  UINT8         Cdb[10];
+  UINT8         Capacity[8];
+  UINT32        BlockSize;
+  UINT32        LastLba;
+  UINT32        CommandSize;
+  UINT32        Commands;
+  UINT64        TotalSize;
+  VOID          *Buffer;
+  EFI_STATUS    Status;
+
+  TotalSize   = MultU64x32 ((Argc > 1) ? StrDecimalToUintn (Argv[1]) : 64, SIZE_1MB);
+  CommandSize = (UINT32)((Argc > 2) ? StrDecimalToUintn (Argv[2]) : 64) * SIZE_1KB;
+  if ((TotalSize == 0) || (CommandSize == 0)) {
+    Print (L"Usage: UsbBulkBench [MB [KB]]\n");
+    return EFI_INVALID_PARAMETER;
+  }
+
+  Status = BenchFindDevice (&Device);
+  if (EFI_ERROR (Status)) {
+    Print (L"No USB mass storage device behind a controller with a bulk queue\n");
+    return Status;
+  }
+
+  Device.Cbw = AllocateZeroPool (sizeof (BENCH_CBW));
+  Device.Csw = AllocateZeroPool (sizeof (BENCH_CSW));
+  Buffer     = AllocatePool (CommandSize);
+  if ((Device.Cbw == NULL) || (Device.Csw == NULL) || (Buffer == NULL)) {
+    Status = EFI_OUT_OF_RESOURCES;
+    goto ON_EXIT;
+  }
+
+  ZeroMem (Cdb, sizeof (Cdb));
+  Cdb[0] = 0x25; // READ CAPACITY (10)
+  Status = BenchReadSync (&Device, Cdb, Capacity, sizeof (Capacity));
+  if (EFI_ERROR (Status)) {
+    Print (L"READ CAPACITY (10) failed: %r\n", Status);
+    goto ON_EXIT;
+  }
+
+  LastLba   = SwapBytes32 (*(UINT32 *)&Capacity[0]);
+  BlockSize = SwapBytes32 (*(UINT32 *)&Capacity[4]);
+  if ((BlockSize == 0) || (CommandSize % BlockSize != 0) || (CommandSize / BlockSize > MAX_UINT16)) {
+    Print (L"Unsupported command size for %d byte blocks\n", BlockSize);
+    Status = EFI_UNSUPPORTED;
+    goto ON_EXIT;
+  }
+
+  Commands = (UINT32)DivU64x32 (TotalSize, CommandSize);
+  Commands = (UINT32)MIN (Commands, DivU64x32 (MultU64x32 ((UINT64)LastLba + 1, BlockSize), CommandSize));
+
+  Print (
+    L"Device %d at speed %d, %d byte blocks, bulk endpoints %02x/%02x of %d bytes, queue of %d\n",
+    Device.Address,
+    Device.Speed,
+    BlockSize,
+    Device.BulkIn,
+    Device.BulkOut,
+    Device.MaxPacket,
+    Device.Queue->MaxTransfers
+    );
+  Print (L"Reading %d commands of %d KB\n", Commands, CommandSize / SIZE_1KB);
+
+  Status = BenchRun (&Device, NULL, FALSE, Buffer, CommandSize, Commands, BlockSize);
+  if (!EFI_ERROR (Status)) {
+    Status = BenchRun (&Device, L"Synchronous", FALSE, Buffer, CommandSize, Commands, BlockSize);
+  }
+
+  if (!EFI_ERROR (Status)) {
+    Status = BenchRun (&Device, L"Queued", TRUE, Buffer, CommandSize, Commands, BlockSize);
+  }
+
+ON_EXIT:
+  if (Device.Cbw != NULL) {
+    FreePool (Device.Cbw);
+  }
+
+  if (Device.Csw != NULL) {
+    FreePool (Device.Csw);
+  }
+
+  if (Buffer != NULL) {
+    FreePool (Buffer);
+  }
+
+  BenchReleaseDevice (&Device);
+  return Status;
+}
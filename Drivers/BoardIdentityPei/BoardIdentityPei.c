@@ -0,0 +1,81 @@
+/** @file
+  Publish the board identity HOB.
+
+  Copyright (c) 2022, ADLink. All rights reserved.<BR>
+
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#include <PiPei.h>
+#include <Library/AmpereCpuLib.h>
+#include <Library/BaseMemoryLib.h>
+#include <Library/DebugLib.h>
+#include <Library/HobLib.h>
+#include <Library/MmcLib.h>
+#include <Library/NVLib.h>
+#include <Library/PcdLib.h>
+#include <Library/PeimEntryPoint.h>
+#include <Guid/BoardIdentityHob.h>
+
+/**
+  The Entry Point to collect the board revision, the MMC firmware version
+  and the CPU SKU into the board identity HOB, after moving the MMC link to
+  its fastest baud rate.
+
+  @retval EFI_SUCCESS           The HOB was published.
+  @retval EFI_OUT_OF_RESOURCES  The HOB could not be allocated.
+
+**/
+EFI_STATUS
+EFIAPI
+BoardIdentityPeim (
+  IN       EFI_PEI_FILE_HANDLE  FileHandle,
+  IN CONST EFI_PEI_SERVICES     **PeiServices
+  )
+{
+  ADLINK_BOARD_IDENTITY  *Identity;
+  UINT8                  BoardRevision;
+
+  if (GetBoardIdentity () != NULL) {
+    return EFI_SUCCESS;
+  }
+
+  BoardRevision = GetFirmwareMajorVersion ();
+
+  Identity = BuildGuidHob (&gAdlinkBoardIdentityHobGuid, sizeof (*Identity));
+  if (Identity == NULL) {
+    return EFI_OUT_OF_RESOURCES;
+  }
+
+  //
+  // The HOB is visible from here on, so the MMC query below already gets
+  // the board revision from it.
+  //
+  ZeroMem (Identity, sizeof (*Identity));
+  Identity->BoardRevision  = BoardRevision;
+  Identity->CpuIsAltraMax  = !IsAc01Processor ();
+  Identity->CpuSkuMaxCore  = (UINT16)GetSkuMaxCore (0);
+  Identity->CpuSkuMaxTurbo = (UINT16)GetSkuMaxTurbo (0);
+
+  if (Identity->BoardRevision != 0xA1) {
+    Identity->MmcBaudRate = (UINT32)MmcNegotiateBaudRate (FixedPcdGet32 (PcdMmcMaxBaudRate));
+  }
+
+  if (EFI_ERROR (MmcFirmwareVersion ((UINT8 *)Identity->MmcVersion, sizeof (Identity->MmcVersion)))) {
+    Identity->MmcVersion[0] = '\0';
+  }
+
+  DEBUG ((
+    DEBUG_INFO,
+    "Board A%X, MMC %a at %u baud, CPU %c%02d-%02X\n",
+    Identity->BoardRevision & 0x0F,
+    (Identity->MmcVersion[0] != '\0') ? Identity->MmcVersion : "unknown",
+    Identity->MmcBaudRate,
+    Identity->CpuIsAltraMax ? 'M' : 'Q',
+    Identity->CpuSkuMaxCore,
+    Identity->CpuSkuMaxTurbo
+    ));
+
+  return EFI_SUCCESS;
+}
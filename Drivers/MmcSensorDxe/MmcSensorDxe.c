@@ -0,0 +1,349 @@
+/** @file
+  Cache of the MMC board sensors behind the ADLINK MMC sensor protocol.
+
+  A sensor joins the background poll the first time it is asked for. The
+  poll runs every half time-to-live and refreshes all such sensors with a
+  single batched MMC request, so their readings never get older than the
+  time-to-live and GetReading () normally returns without touching the
+  UART.
+
+  Copyright (c) 2022, ADLink. All rights reserved.<BR>
+
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#include <Uefi.h>
+#include <Library/BaseLib.h>
+#include <Library/BaseMemoryLib.h>
+#include <Library/DebugLib.h>
+#include <Library/MmcLib.h>
+#include <Library/PcdLib.h>
+#include <Library/TimerLib.h>
+#include <Library/UefiBootServicesTableLib.h>
+#include <Protocol/MmcSensor.h>
+
+//
+// MMC exchanges are not re-entrant, so the cache and the UART are only
+// touched at this TPL, the TPL of the poll.
+//
+#define MMC_SENSOR_TPL  TPL_CALLBACK
+
+typedef struct {
+  BOOLEAN             Polled;      ///< Refreshed by the background poll.
+  BOOLEAN             Valid;
+  UINT64              Timestamp;   ///< Nanoseconds of the performance counter.
+  MMC_SENSOR_READING  Reading;
+} MMC_SENSOR_CACHE_ENTRY;
+
+STATIC MMC_SENSOR_CACHE_ENTRY  mMmcSensorCache[MmcSensorMax];
+STATIC UINT64                  mMmcSensorTimeToLive;
+STATIC EFI_EVENT               mMmcSensorPollEvent;
+
+/**
+  Return the current time in nanoseconds of the performance counter.
+
+**/
+STATIC
+UINT64
+MmcSensorNow (
+  VOID
+  )
+{
+  return GetTimeInNanoSecond (GetPerformanceCounter ());
+}
+
+/**
+  Read sensors from the MMC and store the readings in the cache.
+
+  Must be called at MMC_SENSOR_TPL.
+
+**/
+STATIC
+EFI_STATUS
+MmcSensorCacheFill (
+  IN CONST MMC_SENSOR_ID  *Ids,
+  IN UINTN                Count
+  )
+{
+  MMC_SENSOR_READING  Readings[MmcSensorMax];
+  UINT64              Now;
+  UINTN               Index;
+  EFI_STATUS          Status;
+
+  Status = MmcReadSensors (Ids, Count, Readings);
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+
+  Now = MmcSensorNow ();
+  for (Index = 0; Index < Count; Index++) {
+    mMmcSensorCache[Ids[Index]].Valid     = TRUE;
+    mMmcSensorCache[Ids[Index]].Timestamp = Now;
+    CopyMem (&mMmcSensorCache[Ids[Index]].Reading, &Readings[Index], sizeof (Readings[Index]));
+  }
+
+  return EFI_SUCCESS;
+}
+
+/**
+  Refresh the polled sensors whose reading is older than half the
+  time-to-live, in one MMC request.
+
+  @param  Event    The poll timer event, not used.
+  @param  Context  Not used.
+
+**/
+STATIC
+VOID
+EFIAPI
+MmcSensorPoll (
+  IN EFI_EVENT  Event,
+  IN VOID       *Context
+  )
+{
+  MMC_SENSOR_ID  Ids[MmcSensorMax];
+  UINTN          Count;
+  UINTN          Index;
+  UINT64         Now;
+  EFI_STATUS     Status;
+
+  Now   = MmcSensorNow ();
+  Count = 0;
+  for (Index = 0; Index < MmcSensorMax; Index++) {
+    if (mMmcSensorCache[Index].Polled &&
+        (!mMmcSensorCache[Index].Valid ||
+         (Now - mMmcSensorCache[Index].Timestamp >= mMmcSensorTimeToLive / 2)))
+    {
+      Ids[Count++] = (MMC_SENSOR_ID)Index;
+    }
+  }
+
+  if (Count == 0) {
+    return;
+  }
+
+  Status = MmcSensorCacheFill (Ids, Count);
+  if (EFI_ERROR (Status)) {
+    DEBUG ((DEBUG_WARN, "%a failed to refresh %u sensors - %r\n", __FUNCTION__, (UINT32)Count, Status));
+  }
+}
+
+/**
+  Copy a cache entry to the caller.
+
+**/
+STATIC
+VOID
+MmcSensorCacheGet (
+  IN  MMC_SENSOR_ID       Id,
+  OUT MMC_SENSOR_READING  *Reading,
+  OUT UINT64              *Timestamp OPTIONAL
+  )
+{
+  CopyMem (Reading, &mMmcSensorCache[Id].Reading, sizeof (*Reading));
+  if (Timestamp != NULL) {
+    *Timestamp = mMmcSensorCache[Id].Timestamp;
+  }
+}
+
+/**
+  Read a sensor now and store the reading in the cache.
+
+  Must be called at MMC_SENSOR_TPL.
+
+**/
+STATIC
+EFI_STATUS
+MmcSensorCacheRead (
+  IN  MMC_SENSOR_ID       Id,
+  OUT MMC_SENSOR_READING  *Reading,
+  OUT UINT64              *Timestamp OPTIONAL
+  )
+{
+  EFI_STATUS  Status;
+
+  mMmcSensorCache[Id].Polled = TRUE;
+
+  Status = MmcSensorCacheFill (&Id, 1);
+  if (!EFI_ERROR (Status)) {
+    MmcSensorCacheGet (Id, Reading, Timestamp);
+  }
+
+  return Status;
+}
+
+/**
+  Return the cached reading of a sensor.
+
+  @param[in]  This       The protocol instance.
+  @param[in]  Id         The sensor.
+  @param[out] Reading    The decoded reading.
+  @param[out] Timestamp  Optional. When the reading was taken, in
+                         nanoseconds of the performance counter.
+
+  @retval EFI_SUCCESS            The reading was returned.
+  @retval EFI_INVALID_PARAMETER  Id is out of range or Reading is NULL.
+  @retval Others                 As returned by MmcReadSensor ().
+
+**/
+STATIC
+EFI_STATUS
+EFIAPI
+MmcSensorGetReading (
+  IN  ADLINK_MMC_SENSOR_PROTOCOL  *This,
+  IN  MMC_SENSOR_ID               Id,
+  OUT MMC_SENSOR_READING          *Reading,
+  OUT UINT64                      *Timestamp OPTIONAL
+  )
+{
+  EFI_TPL     OldTpl;
+  EFI_STATUS  Status;
+
+  if (((UINTN)Id >= MmcSensorMax) || (Reading == NULL)) {
+    return EFI_INVALID_PARAMETER;
+  }
+
+  OldTpl = gBS->RaiseTPL (MMC_SENSOR_TPL);
+
+  if (mMmcSensorCache[Id].Valid &&
+      (MmcSensorNow () - mMmcSensorCache[Id].Timestamp < mMmcSensorTimeToLive))
+  {
+    MmcSensorCacheGet (Id, Reading, Timestamp);
+    Status = EFI_SUCCESS;
+  } else {
+    Status = MmcSensorCacheRead (Id, Reading, Timestamp);
+  }
+
+  gBS->RestoreTPL (OldTpl);
+  return Status;
+}
+
+/**
+  Read a sensor from the MMC now and update the cache with the result.
+
+  @param[in]  This       The protocol instance.
+  @param[in]  Id         The sensor.
+  @param[out] Reading    The decoded reading.
+  @param[out] Timestamp  Optional. When the reading was taken, in
+                         nanoseconds of the performance counter.
+
+  @retval EFI_SUCCESS            The reading was returned.
+  @retval EFI_INVALID_PARAMETER  Id is out of range or Reading is NULL.
+  @retval Others                 As returned by MmcReadSensor ().
+
+**/
+STATIC
+EFI_STATUS
+EFIAPI
+MmcSensorRefresh (
+  IN  ADLINK_MMC_SENSOR_PROTOCOL  *This,
+  IN  MMC_SENSOR_ID               Id,
+  OUT MMC_SENSOR_READING          *Reading,
+  OUT UINT64                      *Timestamp OPTIONAL
+  )
+{
+  EFI_TPL     OldTpl;
+  EFI_STATUS  Status;
+
+  if (((UINTN)Id >= MmcSensorMax) || (Reading == NULL)) {
+    return EFI_INVALID_PARAMETER;
+  }
+
+  OldTpl = gBS->RaiseTPL (MMC_SENSOR_TPL);
+  Status = MmcSensorCacheRead (Id, Reading, Timestamp);
+  gBS->RestoreTPL (OldTpl);
+
+  return Status;
+}
+
+/**
+  Change how long a cached reading stays valid, and poll accordingly.
+
+  @param[in] This          The protocol instance.
+  @param[in] TimeToLiveMs  The new time-to-live, in milliseconds.
+
+  @retval EFI_SUCCESS            The time-to-live was changed.
+  @retval EFI_INVALID_PARAMETER  TimeToLiveMs is 0.
+
+**/
+STATIC
+EFI_STATUS
+EFIAPI
+MmcSensorSetTimeToLive (
+  IN ADLINK_MMC_SENSOR_PROTOCOL  *This,
+  IN UINT32                      TimeToLiveMs
+  )
+{
+  if (TimeToLiveMs == 0) {
+    return EFI_INVALID_PARAMETER;
+  }
+
+  mMmcSensorTimeToLive = MultU64x32 (TimeToLiveMs, 1000000);
+
+  //
+  // Timer periods are in 100 ns units.
+  //
+  return gBS->SetTimer (mMmcSensorPollEvent, TimerPeriodic, MultU64x32 (TimeToLiveMs, 10000 / 2));
+}
+
+STATIC ADLINK_MMC_SENSOR_PROTOCOL  mMmcSensorProtocol = {
+  ADLINK_MMC_SENSOR_PROTOCOL_REVISION,
+  MmcSensorGetReading,
+  MmcSensorRefresh,
+  MmcSensorSetTimeToLive
+};
+
+/**
+  The Entry Point for the MMC sensor cache.
+
+  @param  ImageHandle    The firmware allocated handle for the EFI image.
+  @param  SystemTable    A pointer to the EFI System Table.
+
+  @retval EFI_SUCCESS    The entry point is executed successfully.
+  @retval Other          Some error occurred when executing this entry point.
+
+**/
+EFI_STATUS
+EFIAPI
+MmcSensorDxeInitialize (
+  IN EFI_HANDLE        ImageHandle,
+  IN EFI_SYSTEM_TABLE  *SystemTable
+  )
+{
+  EFI_STATUS  Status;
+  EFI_HANDLE  Handle;
+
+  Status = gBS->CreateEvent (
+                  EVT_TIMER | EVT_NOTIFY_SIGNAL,
+                  MMC_SENSOR_TPL,
+                  MmcSensorPoll,
+                  NULL,
+                  &mMmcSensorPollEvent
+                  );
+  ASSERT_EFI_ERROR (Status);
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+
+  Status = MmcSensorSetTimeToLive (&mMmcSensorProtocol, FixedPcdGet32 (PcdMmcSensorCacheTimeToLive));
+  ASSERT_EFI_ERROR (Status);
+  if (EFI_ERROR (Status)) {
+    gBS->CloseEvent (mMmcSensorPollEvent);
+    return Status;
+  }
+
+  Handle = NULL;
+  Status = gBS->InstallMultipleProtocolInterfaces (
+                  &Handle,
+                  &gAdlinkMmcSensorProtocolGuid,
+                  &mMmcSensorProtocol,
+                  NULL
+                  );
+  ASSERT_EFI_ERROR (Status);
+  if (EFI_ERROR (Status)) {
+    gBS->CloseEvent (mMmcSensorPollEvent);
+  }
+
+  return Status;
+}
@@ -10,7 +10,7 @@
 #include <Library/BaseMemoryLib.h>
 #include <Library/DebugLib.h>
 #include <Library/UefiBootServicesTableLib.h>
-#include <Library/MmcLib.h>
+#include <Library/MmcSettingsLib.h>
 
 /**
   Event notification that is fired when GUIDed Event Group is signaled.
@@ -28,12 +28,17 @@ MmcNotifyReadyToBoot (
   )
 {
   EFI_STATUS  Status;
-  STATIC UINT8 SettingCount=0;
 
-  if (SettingCount++ == 0) {
-    Status = MmcSetPowerOffType(1);
-    ASSERT_EFI_ERROR (Status);
-  }
+  gBS->CloseEvent (Event);
+
+  //
+  // Commit whatever the DXE modules staged along with the power off type.
+  // The commit writes a variable, hence TPL_CALLBACK.
+  //
+  Status = MmcSettingsSet (MmcSettingPowerOffType, 1);
+  ASSERT_EFI_ERROR (Status);
+
+  MmcSettingsCommit ();
 }
 
 /**
@@ -58,7 +63,7 @@ MmcSetPowerOffTypeDxeInitialize (
 
   Status = gBS->CreateEventEx (
                 EVT_NOTIFY_SIGNAL,
-                TPL_NOTIFY,
+                TPL_CALLBACK,
                 MmcNotifyReadyToBoot,
                 NULL,
                 &gEfiEventReadyToBootGuid,
@@ -11,7 +11,7 @@
 #include <Library/DebugLib.h>
 #include <Library/PeimEntryPoint.h>
 #include <Library/PeiServicesLib.h>
-#include <Library/MmcLib.h>
+#include <Library/MmcSettingsLib.h>
 
 /**
   The Entry Point to clear MMC set power off type 
@@ -27,14 +27,15 @@ MmcSetPowerOffTypePeim (
   IN CONST EFI_PEI_SERVICES     **PeiServices
   )
 {
-
   EFI_STATUS  Status;
-  STATIC UINT8 SettingCount=0;
 
-  if (SettingCount++ == 0) {
-    Status = MmcSetPowerOffType(0);
-    ASSERT_EFI_ERROR (Status);
-  }
+  //
+  // Commit whatever the PEIMs staged along with the power off type.
+  //
+  Status = MmcSettingsSet (MmcSettingPowerOffType, 0);
+  ASSERT_EFI_ERROR (Status);
+
+  MmcSettingsCommit ();
 
   return EFI_SUCCESS;
 }
@@ -0,0 +1,44 @@
+/** @file
+  GUIDed HOB describing the board, published once in PEI so that later
+  phases do not have to ask the SMpro or the MMC again.
+
+  Copyright (c) 2022, ADLink. All rights reserved.<BR>
+
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#ifndef BOARD_IDENTITY_HOB_H_
+#define BOARD_IDENTITY_HOB_H_
+
+#define ADLINK_BOARD_IDENTITY_HOB_GUID \
+  { 0x8d3e1f52, 0x6a47, 0x4c0b, { 0x9e, 0x21, 0x5b, 0x7c, 0x40, 0xd3, 0xa8, 0x16 } }
+
+#define ADLINK_MMC_VERSION_LENGTH  8
+
+typedef struct {
+  ///
+  /// Board revision: 0xA0, 0xA1 or 0xA2.
+  ///
+  UINT8      BoardRevision;
+  ///
+  /// MMC firmware version as "XX.XX", or an empty string when the MMC did
+  /// not answer.
+  ///
+  CHAR8      MmcVersion[ADLINK_MMC_VERSION_LENGTH];
+  ///
+  /// CPU SKU of socket 0.
+  ///
+  BOOLEAN    CpuIsAltraMax;
+  UINT16     CpuSkuMaxCore;
+  UINT16     CpuSkuMaxTurbo;
+  ///
+  /// Baud rate negotiated with the MMC on the debug UART, or 0 if it was not
+  /// negotiated.
+  ///
+  UINT32     MmcBaudRate;
+} ADLINK_BOARD_IDENTITY;
+
+extern EFI_GUID  gAdlinkBoardIdentityHobGuid;
+
+#endif
@@ -0,0 +1,124 @@
+/** @file
+  State of the UART link to the MMC, shared by every module using MmcLib.
+
+  In PEI the state is a GUIDed HOB, created by the first module talking to
+  the MMC. In DXE it is a configuration table, started from the HOB by the
+  first module. Each module would otherwise negotiate on its own and
+  disagree with the MMC about what was already negotiated.
+
+  What the baud rate negotiation learns about an MMC firmware is kept in a
+  non-volatile variable under the same GUID, read in PEI and written by
+  DXE, so that later boots skip the rates that firmware does not do.
+
+  Copyright (c) 2022, ADLink. All rights reserved.<BR>
+
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#ifndef MMC_LINK_H_
+#define MMC_LINK_H_
+
+#define ADLINK_MMC_LINK_GUID \
+  { 0xf4adb8a4, 0x7b81, 0x4929, { 0x9f, 0x2f, 0x1e, 0x33, 0x74, 0x34, 0x4d, 0x80 } }
+
+#define ADLINK_MMC_LINK_SIGNATURE  SIGNATURE_32 ('M', 'M', 'C', 'L')
+
+//
+// Debug output held back while a transaction owns the UART, about one
+// status code line per answer byte at 57600 baud.
+//
+#define ADLINK_MMC_LINK_HOLD_BYTES  512
+
+#define ADLINK_MMC_LINK_VARIABLE_NAME  L"MmcLink"
+
+//
+// Sensors of MmcLib whose conversion factors are kept.
+//
+#define ADLINK_MMC_LINK_SENSORS  16
+
+typedef enum {
+  AdlinkMmcFactorsUnknown = 0,
+  ///
+  /// The MMC reported the factors of its sensor data record.
+  ///
+  AdlinkMmcFactorsReported,
+  ///
+  /// The MMC refused to report them, the nominal factors of MmcLib apply.
+  ///
+  AdlinkMmcFactorsNominal
+} ADLINK_MMC_FACTORS_STATE;
+
+///
+/// Conversion factors of a sensor, as in its IPMI Full Sensor Record:
+/// Value = (M * Raw + B * 10^BExponent) * 10^RExponent, in volts or degrees
+/// Celsius.
+///
+typedef struct {
+  INT16    M;
+  INT16    B;
+  INT8     RExponent;
+  INT8     BExponent;
+  UINT8    State;           ///< ADLINK_MMC_FACTORS_STATE
+  UINT8    Reserved;
+} ADLINK_MMC_SENSOR_FACTORS;
+
+///
+/// Content of the variable.
+///
+typedef struct {
+  ///
+  /// MMC firmware version, the last two auxiliary firmware revision bytes
+  /// of its Get Device ID answer, first one in the upper byte.
+  ///
+  UINT16    MmcVersion;
+  UINT16    Reserved;
+  ///
+  /// Fastest baud rate that firmware accepted, 0 if it refused every rate.
+  ///
+  UINT32    BaudRate;
+} ADLINK_MMC_LINK_CACHE;
+
+typedef struct {
+  UINT32                       Signature;
+  ///
+  /// Framing the MMC answers with, MMC_FRAMING of MmcLib. 0 until it is
+  /// negotiated.
+  ///
+  UINT8                        Framing;
+  ///
+  /// IPMI sequence number of the next request.
+  ///
+  UINT8                        Sequence;
+  ///
+  /// A transaction owns the UART. Debug output of any module is held back
+  /// meanwhile, and written by the owner when it is done.
+  ///
+  BOOLEAN                      Busy;
+  ///
+  /// Cache differs from the variable.
+  ///
+  BOOLEAN                      CacheDirty;
+  ///
+  /// Baud rate both ends run at, 0 while the UART is left at
+  /// PcdSerialDbgUartBaudRate. Every module keeps the UART at this rate.
+  ///
+  UINT32                       BaudRate;
+  ADLINK_MMC_LINK_CACHE        Cache;
+  UINT32                       DebugHeld;
+  UINT8                        DebugHold[ADLINK_MMC_LINK_HOLD_BYTES];
+  ///
+  /// Whether the MMC firmware reads several sensors in one request,
+  /// MMC_BATCH_SUPPORT of MmcLib. 0 until the MMC answered or refused one.
+  ///
+  UINT8                        SensorBatch;
+  ///
+  /// Conversion factors of each MMC_SENSOR_ID of MmcLib, read from the MMC
+  /// on the first reading of the sensor.
+  ///
+  ADLINK_MMC_SENSOR_FACTORS    Factors[ADLINK_MMC_LINK_SENSORS];
+} ADLINK_MMC_LINK;
+
+extern EFI_GUID  gAdlinkMmcLinkGuid;
+
+#endif
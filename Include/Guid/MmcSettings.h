@@ -0,0 +1,62 @@
+/** @file
+  MMC settings store: the values last acknowledged by the MMC, kept in a
+  non-volatile variable, and the store shared by the modules of one phase,
+  kept in a GUIDed HOB in PEI and in a configuration table in DXE. The
+  variable, the HOB and the table all use the same GUID.
+
+  Copyright (c) 2022, ADLink. All rights reserved.<BR>
+
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#ifndef MMC_SETTINGS_H_
+#define MMC_SETTINGS_H_
+
+#include <Guid/BoardIdentityHob.h>
+
+#define ADLINK_MMC_SETTINGS_GUID \
+  { 0x9eed66ab, 0xec48, 0x4bb9, { 0x93, 0xf7, 0x71, 0x1b, 0xf7, 0xb7, 0x0e, 0x3e } }
+
+#define ADLINK_MMC_SETTINGS_VARIABLE_NAME  L"MmcSettings"
+
+///
+/// Room for settings added later, so that the variable keeps its size.
+///
+#define ADLINK_MMC_SETTINGS_MAX  16
+
+///
+/// Content of the variable.
+///
+typedef struct {
+  ///
+  /// Version of the MMC firmware that acknowledged the values. Values
+  /// acknowledged by another firmware are not trusted.
+  ///
+  CHAR8     MmcVersion[ADLINK_MMC_VERSION_LENGTH];
+  ///
+  /// Bit N is set when Value[N] holds the value of setting N in the MMC.
+  ///
+  UINT32    Known;
+  UINT8     Value[ADLINK_MMC_SETTINGS_MAX];
+} ADLINK_MMC_SETTINGS_SHADOW;
+
+///
+/// Content of the HOB and of the configuration table.
+///
+typedef struct {
+  ADLINK_MMC_SETTINGS_SHADOW    Acknowledged;
+  ///
+  /// Bit N is set when Desired[N] waits for the next commit.
+  ///
+  UINT32                        Staged;
+  UINT8                         Desired[ADLINK_MMC_SETTINGS_MAX];
+  ///
+  /// Acknowledged differs from the variable.
+  ///
+  BOOLEAN                       Dirty;
+} ADLINK_MMC_SETTINGS_STORE;
+
+extern EFI_GUID  gAdlinkMmcSettingsGuid;
+
+#endif
@@ -0,0 +1,50 @@
+/** @file
+  Trace of the recent MMC transactions, published as a configuration table
+  so that it can be dumped from the shell or read by the OS.
+
+  Copyright (c) 2022, ADLink. All rights reserved.<BR>
+
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#ifndef MMC_TRACE_H_
+#define MMC_TRACE_H_
+
+#define ADLINK_MMC_TRACE_GUID \
+  { 0x23605e49, 0x566f, 0x44eb, { 0x9f, 0xd1, 0x74, 0x53, 0x9a, 0xb6, 0x7f, 0x8b } }
+
+#define ADLINK_MMC_TRACE_SIGNATURE   SIGNATURE_32 ('M', 'M', 'C', 'T')
+
+//
+// Entries kept, a power of two, and command or response bytes kept per
+// entry.
+//
+#define ADLINK_MMC_TRACE_ENTRIES     64
+#define ADLINK_MMC_TRACE_DATA_BYTES  32
+
+typedef struct {
+  UINT64    Timestamp;    ///< Nanoseconds of the performance counter at the command.
+  UINT64    Status;       ///< EFI_STATUS of the transaction.
+  UINT32    LatencyUs;    ///< Time to the answer, 0 for commands without one.
+  UINT8     CommandSize;
+  UINT8     ResponseSize;
+  UINT8     Reserved[2];
+  UINT8     Command[ADLINK_MMC_TRACE_DATA_BYTES];
+  UINT8     Response[ADLINK_MMC_TRACE_DATA_BYTES];
+} ADLINK_MMC_TRACE_ENTRY;
+
+typedef struct {
+  UINT32                    Signature;
+  UINT32                    Capacity;   ///< ADLINK_MMC_TRACE_ENTRIES.
+  ///
+  /// Transactions recorded since boot. The newest is at index
+  /// (Recorded - 1) % Capacity.
+  ///
+  UINT64                    Recorded;
+  ADLINK_MMC_TRACE_ENTRY    Entries[ADLINK_MMC_TRACE_ENTRIES];
+} ADLINK_MMC_TRACE_LOG;
+
+extern EFI_GUID  gAdlinkMmcTraceGuid;
+
+#endif
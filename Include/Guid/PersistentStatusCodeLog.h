@@ -0,0 +1,72 @@
+/** @file
+  Persistent status code log: the status codes of a boot, kept in memory
+  that a warm reset leaves alone, so that the next boot can tell where the
+  previous one stopped.
+
+  The region at PcdStatusCodePersistentLogBase is split in two logs of the
+  same size. Every boot starts the log that did not hold the previous
+  boot, so the previous one stays intact. StatusCodeHandlerPei and
+  StatusCodeHandlerRuntimeDxe append to the current log until boot
+  services end. The runtime driver publishes the previous log as a
+  configuration table under gAdlinkPersistentStatusCodeLogGuid and appends
+  it to the Boot Error Record Table region as a Generic Error Status Block
+  of informational severity whose data entry has gAdlinkPersistentStatusCodeLogGuid
+  as section type.
+
+  With PcdStatusCodePersistentLogFlashSize set, the runtime driver also
+  copies the latest records of the current log, as a smaller log of the
+  same format, to the non-volatile variable ADLINK_PERSISTENT_LOG_VARIABLE_NAME
+  under gAdlinkPersistentStatusCodeLogGuid: at ReadyToBoot and after an
+  unrecovered error code. When the memory log of the previous boot did not
+  survive, as after a cold reset, that copy is published instead.
+
+  Records are written back to the point of coherency as they are written,
+  so that a reset losing the caches loses no completed record.
+
+  Records are never locked. A writer reserves a sequence number, fills the
+  record in and writes its CRC last. A record torn by a reset fails its
+  CRC and is skipped by readers.
+
+  Copyright (c) 2022, ADLink. All rights reserved.<BR>
+
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#ifndef PERSISTENT_STATUS_CODE_LOG_H_
+#define PERSISTENT_STATUS_CODE_LOG_H_
+
+#include <Guid/TimedStatusCodeRecord.h>
+
+#define ADLINK_PERSISTENT_STATUS_CODE_LOG_GUID \
+  { 0x9922b9eb, 0x0339, 0x470e, { 0xa8, 0x9d, 0xc8, 0xa8, 0x1e, 0x5d, 0xde, 0x22 } }
+
+#define ADLINK_PERSISTENT_LOG_SIGNATURE  SIGNATURE_32 ('P', 'S', 'L', 'G')
+
+#define ADLINK_PERSISTENT_LOG_VARIABLE_NAME  L"PersistentStatusCodeLog"
+
+typedef struct {
+  UINT32                            Sequence;   ///< Order of the record in its boot, from 0.
+  UINT32                            Crc;        ///< CRC32 of the record with Crc zero.
+  ADLINK_TIMED_STATUSCODE_RECORD    Record;
+} ADLINK_PERSISTENT_LOG_RECORD;
+
+///
+/// Followed by MaxRecordsNumber records. The record with sequence number N
+/// is at index N % MaxRecordsNumber. The records of a log are those whose
+/// CRC matches and whose sequence number is below NextSequence and not
+/// below NextSequence - MaxRecordsNumber.
+///
+typedef struct {
+  UINT32    Signature;
+  UINT32    RecordSize;        ///< sizeof (ADLINK_PERSISTENT_LOG_RECORD).
+  UINT32    MaxRecordsNumber;
+  UINT32    BootCount;         ///< One more than the previous log.
+  UINT64    Frequency;         ///< Generic timer ticks per second.
+  UINT32    HeaderCrc;         ///< CRC32 of the fields above.
+  UINT32    NextSequence;      ///< Sequence number of the next record.
+} ADLINK_PERSISTENT_LOG_HEADER;
+
+extern EFI_GUID  gAdlinkPersistentStatusCodeLogGuid;
+
+#endif
@@ -0,0 +1,106 @@
+/** @file
+  Binary status code log: a byte ring of compact records, formatted later
+  by a host decoder (tools/StatusCodeLogDecode.py).
+
+  The log is a GUIDed HOB in PEI and a configuration table in runtime
+  memory in DXE, both under gAdlinkStatusCodeLogGuid.
+
+  DEBUG () messages are not formatted. Their record carries a 32-bit
+  token of the format string, the raw BASE_LIST arguments and copies of
+  the strings and GUIDs the arguments point to. The text of a format
+  string is written once, in an ADLINK_STATUS_CODE_LOG_FORMAT record
+  preceding the first record using it, and again after that record was
+  overwritten.
+
+  All multi-byte fields are little endian.
+
+  Copyright (c) 2022, ADLink. All rights reserved.<BR>
+
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#ifndef STATUS_CODE_LOG_H_
+#define STATUS_CODE_LOG_H_
+
+#define ADLINK_STATUS_CODE_LOG_GUID \
+  { 0x9580a490, 0x33ca, 0x4158, { 0xb5, 0x81, 0xa1, 0x41, 0x1c, 0x2d, 0xa5, 0x90 } }
+
+#define ADLINK_STATUS_CODE_LOG_SIGNATURE  SIGNATURE_32 ('S', 'C', 'L', 'G')
+
+//
+// Record types.
+//
+#define ADLINK_STATUS_CODE_LOG_PAD       0   ///< Filler up to the end of the ring.
+#define ADLINK_STATUS_CODE_LOG_FORMAT    1   ///< Text of a format string.
+#define ADLINK_STATUS_CODE_LOG_DEBUG     2   ///< DEBUG () message.
+#define ADLINK_STATUS_CODE_LOG_CODE      3   ///< Progress, error or other status code.
+
+//
+// Records start on and are padded to this boundary.
+//
+#define ADLINK_STATUS_CODE_LOG_ALIGNMENT  8
+
+//
+// Arguments kept per DEBUG () message, as many as the DEBUG () status code
+// data carries, and bytes kept per string argument, NUL included.
+//
+#define ADLINK_STATUS_CODE_LOG_MAX_ARGS         12
+#define ADLINK_STATUS_CODE_LOG_MAX_STRING       64
+
+//
+// Format strings whose record is known to be in the ring.
+//
+#define ADLINK_STATUS_CODE_LOG_FORMAT_CACHE     64
+
+typedef struct {
+  UINT32    Token;
+  UINT32    Reserved;
+  UINT64    Position;   ///< Where its ADLINK_STATUS_CODE_LOG_FORMAT record starts.
+} ADLINK_STATUS_CODE_LOG_FORMAT_ENTRY;
+
+typedef struct {
+  UINT32                                 Signature;
+  UINT32                                 Size;        ///< Bytes of ring following the header.
+  UINT64                                 Frequency;   ///< Timestamp ticks per second.
+  ///
+  /// Bytes ever written and offset of the oldest record, both counted from
+  /// the creation of the log. The ring offset of a position is Position %
+  /// Size.
+  ///
+  UINT64                                 Head;
+  UINT64                                 Tail;
+  UINT64                                 Overwritten; ///< Records lost to wrap around.
+  ADLINK_STATUS_CODE_LOG_FORMAT_ENTRY    Formats[ADLINK_STATUS_CODE_LOG_FORMAT_CACHE];
+} ADLINK_STATUS_CODE_LOG_HEADER;
+
+///
+/// Header of every record.
+///
+typedef struct {
+  UINT16      Size;       ///< Record bytes, header included, padding excluded.
+  UINT8       Type;       ///< ADLINK_STATUS_CODE_LOG_*.
+  UINT8       ArgCount;   ///< UINT64 arguments following a DEBUG record.
+  UINT32      Token;      ///< Format string token of FORMAT and DEBUG records.
+  UINT64      Timestamp;  ///< Performance counter, see Frequency.
+  EFI_GUID    CallerId;   ///< Module reporting the status code, zero if unknown.
+  UINT32      CodeType;   ///< Code type, or the error level of a DEBUG record.
+  UINT32      Value;
+  UINT32      Instance;
+  UINT32      Reserved;
+} ADLINK_STATUS_CODE_LOG_RECORD;
+
+//
+// A FORMAT record is followed by the NUL terminated format string.
+//
+// A DEBUG record is followed by ArgCount UINT64 arguments as found in the
+// BASE_LIST, then, in the order of the format string, by one copy per %a,
+// %s or %g argument: a NUL terminated ASCII string of at most
+// ADLINK_STATUS_CODE_LOG_MAX_STRING bytes for %a and %s (%s narrowed to
+// ASCII), or 16 bytes for %g. A NULL string argument is copied as an empty
+// string, a NULL GUID argument as zeros.
+//
+
+extern EFI_GUID  gAdlinkStatusCodeLogGuid;
+
+#endif
@@ -0,0 +1,78 @@
+/** @file
+  Status code routing policy: which status codes the StatusCodeHandler
+  PEIM and runtime driver forward to each of their sinks.
+
+  The policy is read from a non-volatile variable once variable services
+  are available in PEI, kept in a GUIDed HOB and picked up by the runtime
+  driver, so a change takes effect on the next boot. Without the variable
+  every status code goes to every enabled sink. The variable and the HOB
+  use the same GUID. In PEI, the handlers reach the HOB through the PPI of
+  Ppi/StatusCodeRouting.h; Library/StatusCodeRoutingLib.h applies it.
+
+  Copyright (c) 2022, ADLink. All rights reserved.<BR>
+
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#ifndef STATUS_CODE_ROUTING_H_
+#define STATUS_CODE_ROUTING_H_
+
+#define ADLINK_STATUS_CODE_ROUTING_GUID \
+  { 0xe7d3bfc6, 0x49bc, 0x40a7, { 0x8e, 0x27, 0xfd, 0x09, 0x5b, 0xaa, 0xb5, 0xa4 } }
+
+#define ADLINK_STATUS_CODE_ROUTING_VARIABLE_NAME  L"StatusCodeRouting"
+
+#define ADLINK_STATUS_CODE_ROUTING_SIGNATURE  SIGNATURE_32 ('S', 'C', 'R', 'T')
+
+//
+// Sinks.
+//
+#define ADLINK_STATUS_CODE_SINK_SERIAL      0   ///< Text on the serial port.
+#define ADLINK_STATUS_CODE_SINK_MEMORY      1   ///< Guid/TimedStatusCodeRecord.h.
+#define ADLINK_STATUS_CODE_SINK_POST_CODE   2   ///< POST codes sent to the MMC.
+#define ADLINK_STATUS_CODE_SINK_BINARY_LOG  3   ///< Guid/StatusCodeLog.h.
+#define ADLINK_STATUS_CODE_SINK_PERSISTENT  4   ///< Guid/PersistentStatusCodeLog.h.
+#define ADLINK_STATUS_CODE_SINK_COUNT       5
+
+//
+// Caller specific rules kept.
+//
+#define ADLINK_STATUS_CODE_ROUTING_CALLERS  8
+
+///
+/// What a sink is sent. A status code goes through when the bit of its
+/// type is set in CodeTypes, the bit of its severity is set in Severities
+/// for an error code, and one of its error levels is set in ErrorLevels
+/// for a DEBUG () message.
+///
+typedef struct {
+  UINT32    CodeTypes;     ///< Bit (1 << EFI_*_CODE) per code type.
+  UINT32    Severities;    ///< Bit (1 << (EFI_ERROR_* >> 28)) per error severity.
+  UINT32    ErrorLevels;   ///< DEBUG_* error levels.
+  UINT32    Reserved;
+} ADLINK_STATUS_CODE_ROUTE;
+
+///
+/// DEBUG () error levels of one module, replacing those of the route on
+/// the sinks it applies to. ErrorLevels 0 mutes the module.
+///
+typedef struct {
+  EFI_GUID    CallerId;
+  UINT32      Sinks;         ///< Bit (1 << ADLINK_STATUS_CODE_SINK_*) per sink.
+  UINT32      ErrorLevels;
+} ADLINK_STATUS_CODE_CALLER_ROUTE;
+
+///
+/// Content of the variable and of the HOB.
+///
+typedef struct {
+  UINT32                             Signature;
+  UINT32                             CallerCount;
+  ADLINK_STATUS_CODE_ROUTE           Sinks[ADLINK_STATUS_CODE_SINK_COUNT];
+  ADLINK_STATUS_CODE_CALLER_ROUTE    Callers[ADLINK_STATUS_CODE_ROUTING_CALLERS];
+} ADLINK_STATUS_CODE_ROUTING;
+
+extern EFI_GUID  gAdlinkStatusCodeRoutingGuid;
+
+#endif
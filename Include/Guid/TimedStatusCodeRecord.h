@@ -0,0 +1,55 @@
+/** @file
+  Memory status code records carrying a timestamp and the caller, written
+  by StatusCodeHandlerPei into a GUIDed HOB and by StatusCodeHandlerRuntimeDxe
+  into a runtime configuration table, both under
+  gAdlinkTimedStatusCodeRecordGuid. Both drivers still write the records
+  of Guid/MemoryStatusCodeRecord.h, which have no time, next to them.
+
+  The runtime table starts with the records carried over from the HOB, so
+  it covers the whole boot. tools/StatusCodePhases.py turns it into boot
+  phase durations.
+
+  Copyright (c) 2022, ADLink. All rights reserved.<BR>
+
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#ifndef TIMED_STATUS_CODE_RECORD_H_
+#define TIMED_STATUS_CODE_RECORD_H_
+
+#include <Pi/PiStatusCode.h>
+
+#define ADLINK_TIMED_STATUSCODE_RECORD_GUID \
+  { 0x51376e06, 0x4d6a, 0x485c, { 0x8a, 0x4f, 0xfc, 0x2d, 0x81, 0x86, 0x95, 0xf1 } }
+
+#define ADLINK_TIMED_STATUSCODE_SIGNATURE  SIGNATURE_32 ('T', 'S', 'C', 'R')
+
+typedef struct {
+  EFI_STATUS_CODE_TYPE     CodeType;
+  EFI_STATUS_CODE_VALUE    Value;
+  UINT32                   Instance;
+  UINT8                    PostCode;     ///< POST code sent to the MMC for it, 0 if none.
+  UINT8                    Reserved[3];
+  UINT64                   Timestamp;    ///< Generic timer count, see Frequency.
+  EFI_GUID                 CallerId;     ///< Zero if the caller is unknown.
+} ADLINK_TIMED_STATUSCODE_RECORD;
+
+///
+/// Followed by MaxRecordsNumber records. While NumberOfRecords is below
+/// MaxRecordsNumber the oldest record is the first one, afterwards it is
+/// the one at RecordIndex.
+///
+typedef struct {
+  UINT32    Signature;
+  UINT32    RecordSize;        ///< sizeof (ADLINK_TIMED_STATUSCODE_RECORD).
+  UINT32    RecordIndex;       ///< Where the next record goes.
+  UINT32    NumberOfRecords;   ///< Records written, including the overwritten ones.
+  UINT32    MaxRecordsNumber;
+  UINT32    Reserved;
+  UINT64    Frequency;         ///< Generic timer ticks per second.
+} ADLINK_TIMED_STATUSCODE_HEADER;
+
+extern EFI_GUID  gAdlinkTimedStatusCodeRecordGuid;
+
+#endif
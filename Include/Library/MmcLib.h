@@ -8,6 +8,40 @@
 #include <Uefi.h>
 #include <Library/UefiLib.h>
 
+///
+/// Board sensors that the MMC exposes through the IPMI Get Sensor Reading
+/// command.
+///
+typedef enum {
+  MmcSensorP3V3 = 0,
+  MmcSensorP12V,
+  MmcSensorP5V,
+  MmcSensorP1V5Vddh,
+  MmcSensorP0V75Pcp,
+  MmcSensorP0V9VddcRca,
+  MmcSensorP0V75VddcSoc,
+  MmcSensorP1V2VddqAb,
+  MmcSensorP1V2VddqCd,
+  MmcSensorP1V8Pcp,
+  MmcSensorCpuTemp,
+  MmcSensorMax
+} MMC_SENSOR_ID;
+
+typedef enum {
+  MmcSensorUnitMilliVolt = 0,
+  MmcSensorUnitMilliCelsius
+} MMC_SENSOR_UNIT;
+
+///
+/// Decoded sensor reading.
+///
+typedef struct {
+  MMC_SENSOR_ID    Id;
+  MMC_SENSOR_UNIT  Unit;
+  UINT8            Raw;     ///< Reading byte as reported by the MMC.
+  INT32            Value;   ///< Reading converted to Unit.
+} MMC_SENSOR_READING;
+
 /**
   Sends a 32-bit value to a POST card.
 
@@ -31,9 +65,149 @@ MmcPostCode (
   IN UINT32  Value
   );
 
+/**
+  Return whether a command can be written to the MMC right away, i.e.
+  without waiting for earlier UART output to drain.
+
+  @retval TRUE   The UART transmit FIFO is empty and no transaction owns it.
+  @retval FALSE  Writing now would wait for the UART.
+
+**/
+BOOLEAN
+MmcCanSendCommand (
+  VOID
+  );
+
+/**
+  Return whether a byte of debug output can be written to the UART right
+  away, i.e. without waiting for room in its transmit FIFO.
+
+  @retval TRUE   The transmit FIFO is not full and no transaction owns it.
+  @retval FALSE  Writing now would wait for the UART.
+
+**/
+BOOLEAN
+MmcCanWriteDebugOutput (
+  VOID
+  );
+
+///
+/// Round trip statistics of the commands that expect an answer from the MMC,
+/// and wire traffic of all commands.
+///
+typedef struct {
+  UINT32    Commands;        ///< Commands sent expecting an answer.
+  UINT32    Timeouts;        ///< Commands that got no answer before their deadline.
+  UINT32    Resyncs;         ///< Malformed or unrelated frames skipped.
+  UINT32    LateResponses;   ///< Answers carrying the tag of an earlier command.
+  UINT32    Collisions;      ///< Commands refused while another one owned the UART.
+  UINT32    DebugBytesHeld;  ///< Debug output held back during a transaction.
+  UINT32    DebugBytesLost;  ///< Debug output dropped because the hold buffer was full.
+  UINT32    BytesWritten;    ///< Frame bytes written to the MMC, commands without answer included.
+  UINT32    BytesRead;       ///< Bytes read from the MMC, discarded ones included.
+  UINT32    LastLatencyUs;   ///< Round trip of the last answered command.
+  UINT32    MaxLatencyUs;    ///< Longest round trip of an answered command.
+  UINT64    TotalLatencyUs;  ///< Sum of the round trips of answered commands.
+} MMC_TRANSPORT_STATISTICS;
+
+/**
+  Hold back debug output while an MMC transaction owns the UART.
+
+  The MMC listens on the UART that also carries the firmware log. Log bytes
+  written between a command and its answer corrupt the exchange, so writers
+  sharing the UART call this first, and only write the bytes themselves
+  when it returns FALSE. Held bytes are written when the transaction ends.
+
+  @param[in] Buffer  The debug output.
+  @param[in] Length  Number of bytes in Buffer.
+
+  @retval TRUE   The bytes were taken over.
+  @retval FALSE  No transaction is in progress, the caller writes the bytes.
+
+**/
+BOOLEAN
+MmcHoldDebugOutput (
+  IN CONST UINT8  *Buffer,
+  IN UINTN        Length
+  );
+
+/**
+  Return the round trip statistics of the MMC commands issued so far by
+  this module.
+
+  @param[out] Statistics  The statistics.
+
+**/
+VOID
+MmcGetTransportStatistics (
+  OUT MMC_TRANSPORT_STATISTICS  *Statistics
+  );
+
+/**
+  Move the debug UART shared with the MMC to the fastest baud rate both ends
+  support, up to MaxBaudRate.
+
+  The MMC is first looked for at PcdSerialDbgUartBaudRate, then at each
+  candidate rate, and kept at the rate it answers at if an earlier boot left
+  it at another one. Otherwise each candidate rate is requested from the
+  MMC and then checked with a Get Device ID round trip at that rate. Both
+  ends return to PcdSerialDbgUartBaudRate if no candidate works.
+
+  The fastest rate the MMC firmware accepted, or that it accepted none, is
+  kept per firmware version in a variable, and later boots do not request
+  faster rates. The rate is part of the link state, every MmcLib instance
+  keeps the UART at it.
+
+  @param[in] MaxBaudRate  Fastest rate to try.
+
+  @return The baud rate in use.
+
+**/
+UINT64
+MmcNegotiateBaudRate (
+  IN UINT64  MaxBaudRate
+  );
+
+/**
+  Return the MMC link to the state the MMC powers on in, before a reset.
+
+  The MMC is not reset with the host. Without this, the firmware of the
+  next boot would find it still using the framing and baud rate this boot
+  negotiated. Reset notifications call this.
+
+  @retval EFI_SUCCESS          The MMC is back to its power on state.
+  @retval EFI_ALREADY_STARTED  Another transaction owns the UART.
+  @retval Others               The MMC did not acknowledge.
+
+**/
+EFI_STATUS
+MmcResetLink (
+  VOID
+  );
+
+/**
+  Send an OEM command to the MMC and wait for its acknowledgement.
+
+  Only the MMC settings store is expected to use this, it owns the
+  encoding of the settings.
+
+  @param[in] Command   The OEM command byte.
+  @param[in] Data      The request data following the command byte.
+  @param[in] DataSize  Number of bytes in Data.
+
+  @retval EFI_SUCCESS            The MMC acknowledged the command.
+  @retval EFI_INVALID_PARAMETER  Data does not fit in one frame.
+  @retval EFI_DEVICE_ERROR       The MMC refused the command.
+  @retval EFI_ALREADY_STARTED    Another transaction owns the UART.
+  @retval EFI_NO_RESPONSE        The UART write failed.
+  @retval EFI_TIMEOUT            The MMC did not answer.
+
+**/
 EFI_STATUS
-MmcSetPowerOffType (
-  IN UINT8  Value
+MmcExecuteOemCommand (
+  IN UINT8        Command,
+  IN CONST UINT8  *Data,
+  IN UINTN        DataSize
   );
 
 EFI_STATUS
@@ -42,6 +216,68 @@ MmcFirmwareVersion (
   IN UINTN BufferSize
   );
 
+/**
+  Read and decode one board sensor from the MMC.
+
+  @param[in]  Id       The sensor to read.
+  @param[out] Reading  The decoded reading.
+
+  @retval EFI_SUCCESS            The sensor was read.
+  @retval EFI_INVALID_PARAMETER  Id is out of range or Reading is NULL.
+  @retval EFI_UNSUPPORTED        The board revision has no MMC sensor support.
+  @retval EFI_NO_RESPONSE        The MMC did not answer.
+  @retval EFI_PROTOCOL_ERROR     The MMC answer could not be decoded.
+
+**/
+EFI_STATUS
+MmcReadSensor (
+  IN  MMC_SENSOR_ID       Id,
+  OUT MMC_SENSOR_READING  *Reading
+  );
+
+///
+/// Largest number of sensors accepted by one MmcReadSensors () call.
+///
+#define MMC_BATCH_MAX_SENSORS  16
+
+/**
+  Read and decode several board sensors from the MMC.
+
+  The sensors are read with a single request when the MMC firmware supports
+  it, and one by one otherwise.
+
+  @param[in]  Ids       The sensors to read.
+  @param[in]  Count     Number of entries in Ids and Readings.
+  @param[out] Readings  The decoded readings, in the order of Ids.
+
+  @retval EFI_SUCCESS            All sensors were read.
+  @retval EFI_INVALID_PARAMETER  An Id is out of range, Count is 0 or above
+                                 MMC_BATCH_MAX_SENSORS, or a pointer is NULL.
+  @retval Others                 As returned by MmcReadSensor ().
+
+**/
+EFI_STATUS
+MmcReadSensors (
+  IN  CONST MMC_SENSOR_ID  *Ids,
+  IN  UINTN                Count,
+  OUT MMC_SENSOR_READING   *Readings
+  );
+
+/**
+  Return the printable name of a sensor, or NULL if Id is out of range.
+
+**/
+CONST CHAR8 *
+MmcGetSensorName (
+  IN MMC_SENSOR_ID  Id
+  );
+
+//
+// Legacy accessors copying BufferSize bytes of the ASCII reply from the
+// reading byte on, "XX XX XX]\r\n", without terminating NUL. A BufferSize
+// of 2 gives the reading byte as two hex digits. New code should use
+// MmcReadSensor ().
+//
 EFI_STATUS
 IPMI_P3V3_Sensor_Reading (
   IN UINT8 *Buffer,
@@ -108,11 +344,4 @@ CPU_Temp_Sensor_Reading(
     IN UINTN BufferSize
     );
 
-EFI_STATUS
-WolDisableCmd( 
-  );
-  
-EFI_STATUS
-WolEnableCmd( 
-  );
 #endif
@@ -0,0 +1,46 @@
+/** @file
+  Control of the POST code queue kept by the MMC POST Code Library.
+
+  Copyright (c) 2022, ADLink. All rights reserved.<BR>
+
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#ifndef __MMC_POST_CODE_LIB_H__
+#define __MMC_POST_CODE_LIB_H__
+
+///
+/// Counters kept by the POST code queue.
+///
+typedef struct {
+  UINT32    Reported;   ///< Codes passed to PostCode ().
+  UINT32    Collapsed;  ///< Repeats of the previous code, not sent again.
+  UINT32    Dropped;    ///< Codes overwritten while the queue was full, or not sent.
+  UINT32    Sent;       ///< Codes written to the MMC.
+  UINT32    HighWater;  ///< Deepest queue occupancy seen.
+} MMC_POST_CODE_STATISTICS;
+
+/**
+  Write every queued POST code to the MMC, waiting for the UART as needed.
+
+**/
+VOID
+EFIAPI
+MmcPostCodeFlush (
+  VOID
+  );
+
+/**
+  Return the POST code queue counters.
+
+  @param[out] Statistics  Receives the counters.
+
+**/
+VOID
+EFIAPI
+MmcPostCodeGetStatistics (
+  OUT MMC_POST_CODE_STATISTICS  *Statistics
+  );
+
+#endif
@@ -0,0 +1,95 @@
+/** @file
+  MMC settings store.
+
+  The store remembers the value of each setting last acknowledged by the
+  MMC. Modules stage the values they want, and MmcSettingsCommit () sends
+  only the ones the MMC does not have yet. The modules of one phase share
+  the store, so that a single commit sends the whole batch.
+
+  Copyright (c) 2022, ADLink. All rights reserved.<BR>
+
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#ifndef __MMC_SETTINGS_LIB_H__
+#define __MMC_SETTINGS_LIB_H__
+
+#include <Uefi.h>
+
+typedef enum {
+  MmcSettingPowerOffType = 0,  ///< Power off type, 0 during POST and 1 once booting.
+  MmcSettingWakeOnLan,         ///< Wake On LAN, 0 disabled and 1 enabled.
+  MmcSettingMax
+} MMC_SETTING_ID;
+
+/**
+  Stage the value a setting should have after the next commit.
+
+  @param[in] Id     The setting.
+  @param[in] Value  The wanted value.
+
+  @retval EFI_SUCCESS            The value was staged.
+  @retval EFI_INVALID_PARAMETER  Id is out of range.
+  @retval EFI_OUT_OF_RESOURCES   The store could not be created.
+
+**/
+EFI_STATUS
+EFIAPI
+MmcSettingsSet (
+  IN MMC_SETTING_ID  Id,
+  IN UINT8           Value
+  );
+
+/**
+  Return the value of a setting last acknowledged by the MMC.
+
+  @param[in]  Id     The setting.
+  @param[out] Value  The value.
+
+  @retval EFI_SUCCESS            Value holds the value in the MMC.
+  @retval EFI_INVALID_PARAMETER  Id is out of range or Value is NULL.
+  @retval EFI_NOT_FOUND          The value in the MMC is not known.
+  @retval EFI_OUT_OF_RESOURCES   The store could not be created.
+
+**/
+EFI_STATUS
+EFIAPI
+MmcSettingsGet (
+  IN  MMC_SETTING_ID  Id,
+  OUT UINT8           *Value
+  );
+
+/**
+  Send the staged values the MMC does not have yet, and remember what it
+  acknowledged.
+
+  In PEI the acknowledged values are handed to DXE, which writes them to
+  the variable on its commit.
+
+  @retval EFI_SUCCESS           Every staged value is in the MMC.
+  @retval EFI_OUT_OF_RESOURCES  The store could not be created.
+  @retval Others                A value could not be sent. It stays staged
+                                for the next commit.
+
+**/
+EFI_STATUS
+EFIAPI
+MmcSettingsCommit (
+  VOID
+  );
+
+//
+// Legacy helpers, staging the Wake On LAN setting and committing it.
+//
+EFI_STATUS
+WolDisableCmd (
+  VOID
+  );
+
+EFI_STATUS
+WolEnableCmd (
+  VOID
+  );
+
+#endif
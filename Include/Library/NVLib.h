@@ -7,8 +7,23 @@
 
 #include <Uefi.h>
 #include <Library/UefiLib.h>
+#include <Guid/BoardIdentityHob.h>
 
+/**
+  Return the board identity published in PEI.
 
+  @return The board identity, or NULL before it is published.
+
+**/
+CONST ADLINK_BOARD_IDENTITY *
+GetBoardIdentity (
+  VOID
+  );
+
+/**
+  Return the board revision: 0xA0, 0xA1 or 0xA2.
+
+**/
 UINT8
 GetFirmwareMajorVersion();
 #endif
@@ -0,0 +1,109 @@
+/** @file
+  Writes and finds the persistent status code logs described in
+  Guid/PersistentStatusCodeLog.h.
+
+  Copyright (c) 2022, ADLink. All rights reserved.<BR>
+
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#ifndef __PERSISTENT_STATUS_CODE_LOG_LIB_H__
+#define __PERSISTENT_STATUS_CODE_LOG_LIB_H__
+
+#include <Guid/PersistentStatusCodeLog.h>
+
+/**
+  Start the log of this boot, in the half of the region that does not hold
+  the previous boot. Called once per boot, by the first phase writing it.
+
+  @return The log, or NULL if PcdStatusCodePersistentLogSize is 0.
+
+**/
+ADLINK_PERSISTENT_LOG_HEADER *
+EFIAPI
+PersistentLogStart (
+  VOID
+  );
+
+/**
+  Return the log of this boot.
+
+  @return The log with the highest boot count, or NULL if there is none.
+
+**/
+ADLINK_PERSISTENT_LOG_HEADER *
+EFIAPI
+PersistentLogGetCurrent (
+  VOID
+  );
+
+/**
+  Return the log of the previous boot.
+
+  @return The log, or NULL if the region did not survive the reset.
+
+**/
+CONST ADLINK_PERSISTENT_LOG_HEADER *
+EFIAPI
+PersistentLogGetPrevious (
+  VOID
+  );
+
+/**
+  Append a status code.
+
+  @param[in] Log       The log of this boot.
+  @param[in] CodeType  The type of the status code.
+  @param[in] Value     The status code.
+  @param[in] Instance  The instance of the reporting entity.
+  @param[in] PostCode  The POST code sent to the MMC for it, 0 if none.
+  @param[in] CallerId  The reporting module, or NULL.
+
+**/
+VOID
+EFIAPI
+PersistentLogAppend (
+  IN ADLINK_PERSISTENT_LOG_HEADER  *Log,
+  IN EFI_STATUS_CODE_TYPE          CodeType,
+  IN EFI_STATUS_CODE_VALUE         Value,
+  IN UINT32                        Instance,
+  IN UINT8                         PostCode,
+  IN CONST EFI_GUID                *CallerId  OPTIONAL
+  );
+
+/**
+  Copy the latest records of a log into a smaller log of the same format,
+  for the flash slot.
+
+  @param[in]  Log       The log.
+  @param[out] Snapshot  The copy.
+  @param[in]  Size      Size of Snapshot in bytes.
+
+  @return Bytes of Snapshot used, or 0 if it has no room for a record.
+
+**/
+UINTN
+EFIAPI
+PersistentLogSnapshot (
+  IN  CONST ADLINK_PERSISTENT_LOG_HEADER  *Log,
+  OUT ADLINK_PERSISTENT_LOG_HEADER        *Snapshot,
+  IN  UINTN                               Size
+  );
+
+/**
+  Return whether a copy made by PersistentLogSnapshot() and read back from
+  the flash slot is intact.
+
+  @param[in] Snapshot  The copy.
+  @param[in] Size      Size of Snapshot in bytes.
+
+**/
+BOOLEAN
+EFIAPI
+PersistentLogSnapshotValid (
+  IN CONST ADLINK_PERSISTENT_LOG_HEADER  *Snapshot,
+  IN UINTN                               Size
+  );
+
+#endif
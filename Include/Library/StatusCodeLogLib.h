@@ -0,0 +1,87 @@
+/** @file
+  Writes the binary status code log described in Guid/StatusCodeLog.h.
+
+  Copyright (c) 2022, ADLink. All rights reserved.<BR>
+
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#ifndef __STATUS_CODE_LOG_LIB_H__
+#define __STATUS_CODE_LOG_LIB_H__
+
+#include <Pi/PiStatusCode.h>
+#include <Guid/StatusCodeLog.h>
+
+/**
+  Create an empty log.
+
+  @param[out] Buffer      The memory holding the log.
+  @param[in]  BufferSize  Size of Buffer.
+
+  @return The log, or NULL if BufferSize leaves no room for records.
+
+**/
+ADLINK_STATUS_CODE_LOG_HEADER *
+EFIAPI
+StatusCodeLogInitialize (
+  OUT VOID   *Buffer,
+  IN  UINTN  BufferSize
+  );
+
+/**
+  Append a DEBUG () message, without formatting it.
+
+  @param[in] Log         The log.
+  @param[in] CallerId    The reporting module, or NULL.
+  @param[in] ErrorLevel  The error level of the message.
+  @param[in] Format      The format string.
+  @param[in] Marker      The arguments of the format string.
+
+**/
+VOID
+EFIAPI
+StatusCodeLogDebug (
+  IN ADLINK_STATUS_CODE_LOG_HEADER  *Log,
+  IN CONST EFI_GUID                 *CallerId  OPTIONAL,
+  IN UINT32                         ErrorLevel,
+  IN CONST CHAR8                    *Format,
+  IN BASE_LIST                      Marker
+  );
+
+/**
+  Append a status code.
+
+  @param[in] Log       The log.
+  @param[in] CallerId  The reporting module, or NULL.
+  @param[in] CodeType  The type of the status code.
+  @param[in] Value     The status code.
+  @param[in] Instance  The instance of the reporting entity.
+
+**/
+VOID
+EFIAPI
+StatusCodeLogCode (
+  IN ADLINK_STATUS_CODE_LOG_HEADER  *Log,
+  IN CONST EFI_GUID                 *CallerId  OPTIONAL,
+  IN EFI_STATUS_CODE_TYPE           CodeType,
+  IN EFI_STATUS_CODE_VALUE          Value,
+  IN UINT32                         Instance
+  );
+
+/**
+  Append the records of another log, oldest first, keeping their
+  timestamps. Used to carry the PEI log into the DXE one.
+
+  @param[in] Log     The log appended to.
+  @param[in] Source  The log whose records are copied.
+
+**/
+VOID
+EFIAPI
+StatusCodeLogAppendLog (
+  IN ADLINK_STATUS_CODE_LOG_HEADER        *Log,
+  IN CONST ADLINK_STATUS_CODE_LOG_HEADER  *Source
+  );
+
+#endif
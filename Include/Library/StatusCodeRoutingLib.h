@@ -0,0 +1,74 @@
+/** @file
+  Decisions of the status code routing policy described in
+  Guid/StatusCodeRouting.h, shared by the StatusCodeHandler PEIM and
+  runtime driver.
+
+  Copyright (c) 2022, ADLink. All rights reserved.<BR>
+
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#ifndef __STATUS_CODE_ROUTING_LIB_H__
+#define __STATUS_CODE_ROUTING_LIB_H__
+
+#include <Pi/PiStatusCode.h>
+#include <Guid/StatusCodeRouting.h>
+
+/**
+  Fill a policy forwarding every status code to every sink.
+
+  @param[out] Routing  The policy.
+
+**/
+VOID
+EFIAPI
+StatusCodeRoutingSetDefault (
+  OUT ADLINK_STATUS_CODE_ROUTING  *Routing
+  );
+
+/**
+  Tell whether a policy read from the variable or the HOB can be used.
+
+  @param[in] Routing  The policy.
+  @param[in] Size     Size of the policy as read.
+
+  @retval TRUE   The policy is well formed.
+  @retval FALSE  The policy is to be ignored.
+
+**/
+BOOLEAN
+EFIAPI
+StatusCodeRoutingIsValid (
+  IN CONST ADLINK_STATUS_CODE_ROUTING  *Routing,
+  IN UINTN                             Size
+  );
+
+/**
+  Tell whether a policy forwards a status code to a sink.
+
+  The code type and severity masks are tested first. The DEBUG () error
+  level and the caller rules are only looked at for a DEBUG () message
+  that passed them.
+
+  @param[in] Routing   The policy.
+  @param[in] Sink      ADLINK_STATUS_CODE_SINK_*.
+  @param[in] CodeType  The type of the status code.
+  @param[in] CallerId  The reporting module, or NULL.
+  @param[in] Data      The data of the status code, or NULL.
+
+  @retval TRUE   The status code goes to the sink.
+  @retval FALSE  The sink does not take the status code.
+
+**/
+BOOLEAN
+EFIAPI
+StatusCodeRoutingAccepts (
+  IN CONST ADLINK_STATUS_CODE_ROUTING  *Routing,
+  IN UINTN                             Sink,
+  IN EFI_STATUS_CODE_TYPE              CodeType,
+  IN CONST EFI_GUID                    *CallerId  OPTIONAL,
+  IN CONST EFI_STATUS_CODE_DATA        *Data      OPTIONAL
+  );
+
+#endif
@@ -0,0 +1,25 @@
+/** @file
+  PPI handing the StatusCodeHandler PEIM the routing policy of
+  Guid/StatusCodeRouting.h, so that no status code walks the HOB list to
+  find it. The interface is the data of the policy HOB, which the PEI core
+  moves along with the HOB list when permanent memory is installed.
+
+  Copyright (c) 2022, ADLink. All rights reserved.<BR>
+
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#ifndef STATUS_CODE_ROUTING_PPI_H_
+#define STATUS_CODE_ROUTING_PPI_H_
+
+#include <Guid/StatusCodeRouting.h>
+
+#define ADLINK_STATUS_CODE_ROUTING_PPI_GUID \
+  { 0xdc09034a, 0x9990, 0x44c7, { 0x86, 0xa3, 0xa2, 0x6f, 0x9e, 0xe0, 0x66, 0x07 } }
+
+typedef ADLINK_STATUS_CODE_ROUTING ADLINK_STATUS_CODE_ROUTING_PPI;
+
+extern EFI_GUID  gAdlinkStatusCodeRoutingPpiGuid;
+
+#endif
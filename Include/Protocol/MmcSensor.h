@@ -0,0 +1,103 @@
+/** @file
+  Cached access to the board sensors reported by the MMC.
+
+  Readings are served from a cache that a background poll keeps fresh, so
+  consumers such as setup, SMBIOS or the shell do not wait on the MMC UART
+  in the common case.
+
+  Copyright (c) 2022, ADLink. All rights reserved.<BR>
+
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#ifndef MMC_SENSOR_PROTOCOL_H_
+#define MMC_SENSOR_PROTOCOL_H_
+
+#include <Library/MmcLib.h>
+
+#define ADLINK_MMC_SENSOR_PROTOCOL_GUID \
+  { 0xd185a67c, 0x6d41, 0x4ba4, { 0x99, 0x78, 0x65, 0x80, 0x40, 0x1a, 0x2d, 0xb6 } }
+
+#define ADLINK_MMC_SENSOR_PROTOCOL_REVISION  0x00010000
+
+typedef struct _ADLINK_MMC_SENSOR_PROTOCOL ADLINK_MMC_SENSOR_PROTOCOL;
+
+/**
+  Return the cached reading of a sensor.
+
+  The reading is read from the MMC only if it was never read or is older
+  than the time-to-live. From then on the sensor is kept fresh by the
+  background poll.
+
+  @param[in]  This       The protocol instance.
+  @param[in]  Id         The sensor.
+  @param[out] Reading    The decoded reading.
+  @param[out] Timestamp  Optional. When the reading was taken, in
+                         nanoseconds of the performance counter.
+
+  @retval EFI_SUCCESS            The reading was returned.
+  @retval EFI_INVALID_PARAMETER  Id is out of range or Reading is NULL.
+  @retval Others                 As returned by MmcReadSensor ().
+
+**/
+typedef
+EFI_STATUS
+(EFIAPI *ADLINK_MMC_SENSOR_GET_READING)(
+  IN  ADLINK_MMC_SENSOR_PROTOCOL  *This,
+  IN  MMC_SENSOR_ID               Id,
+  OUT MMC_SENSOR_READING          *Reading,
+  OUT UINT64                      *Timestamp OPTIONAL
+  );
+
+/**
+  Read a sensor from the MMC now, bypassing the cache, and update the cache
+  with the result.
+
+  @param[in]  This       The protocol instance.
+  @param[in]  Id         The sensor.
+  @param[out] Reading    The decoded reading.
+  @param[out] Timestamp  Optional. When the reading was taken, in
+                         nanoseconds of the performance counter.
+
+  @retval EFI_SUCCESS            The reading was returned.
+  @retval EFI_INVALID_PARAMETER  Id is out of range or Reading is NULL.
+  @retval Others                 As returned by MmcReadSensor ().
+
+**/
+typedef
+EFI_STATUS
+(EFIAPI *ADLINK_MMC_SENSOR_REFRESH)(
+  IN  ADLINK_MMC_SENSOR_PROTOCOL  *This,
+  IN  MMC_SENSOR_ID               Id,
+  OUT MMC_SENSOR_READING          *Reading,
+  OUT UINT64                      *Timestamp OPTIONAL
+  );
+
+/**
+  Change how long a cached reading stays valid.
+
+  @param[in] This          The protocol instance.
+  @param[in] TimeToLiveMs  The new time-to-live, in milliseconds.
+
+  @retval EFI_SUCCESS            The time-to-live was changed.
+  @retval EFI_INVALID_PARAMETER  TimeToLiveMs is 0.
+
+**/
+typedef
+EFI_STATUS
+(EFIAPI *ADLINK_MMC_SENSOR_SET_TIME_TO_LIVE)(
+  IN ADLINK_MMC_SENSOR_PROTOCOL  *This,
+  IN UINT32                      TimeToLiveMs
+  );
+
+struct _ADLINK_MMC_SENSOR_PROTOCOL {
+  UINT32                                Revision;
+  ADLINK_MMC_SENSOR_GET_READING         GetReading;
+  ADLINK_MMC_SENSOR_REFRESH             Refresh;
+  ADLINK_MMC_SENSOR_SET_TIME_TO_LIVE    SetTimeToLive;
+};
+
+extern EFI_GUID  gAdlinkMmcSensorProtocolGuid;
+
+#endif
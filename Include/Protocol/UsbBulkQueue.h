@@ -0,0 +1,162 @@
+/** @file
+  Queued bulk transfers, installed next to EFI_USB2_HC_PROTOCOL by the XHCI
+  driver.
+
+  EFI_USB2_HC_PROTOCOL.BulkTransfer () returns only when its transfer is
+  done, so the endpoint sits idle until the caller submits the next one.
+  Here transfers are submitted without waiting and the controller runs them
+  back to back, several of them in flight per endpoint. Completions are
+  collected per endpoint in the order of submission.
+
+  A failed or timed out transfer aborts the transfers submitted after it to
+  the same endpoint, they complete with EFI_ABORTED.
+
+  Devices are known by the address the USB bus driver assigned them, which
+  USB I/O doesn't tell. GetDevice () returns it for a device path.
+
+  Copyright (c) 2022, ADLink. All rights reserved.<BR>
+
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#ifndef USB_BULK_QUEUE_PROTOCOL_H_
+#define USB_BULK_QUEUE_PROTOCOL_H_
+
+#include <Protocol/DevicePath.h>
+
+#define ADLINK_USB_BULK_QUEUE_PROTOCOL_GUID \
+  { 0x4f8bdd6c, 0x4321, 0x4e6f, { 0xad, 0x36, 0xcf, 0x69, 0x3c, 0x89, 0x7f, 0x6e } }
+
+#define ADLINK_USB_BULK_QUEUE_PROTOCOL_REVISION  0x00010001
+
+typedef struct _ADLINK_USB_BULK_QUEUE_PROTOCOL ADLINK_USB_BULK_QUEUE_PROTOCOL;
+
+/**
+  Start a bulk transfer without waiting for it.
+
+  The buffer must stay allocated and untouched until the transfer is
+  completed by Complete () or Cancel ().
+
+  @param[in] This                 The protocol instance.
+  @param[in] DeviceAddress        Target device address.
+  @param[in] EndPointAddress      Endpoint number and its direction in bit 7.
+  @param[in] DeviceSpeed          Device speed, low speed devices have no bulk
+                                  endpoints.
+  @param[in] MaximumPacketLength  Maximum packet size of the endpoint.
+  @param[in] Data                 The buffer to transmit from or receive into.
+  @param[in] DataLength           Size of Data.
+
+  @retval EFI_SUCCESS            The transfer was started.
+  @retval EFI_NOT_READY          MaxTransfers transfers are already in flight on
+                                 the endpoint, or their TRBs fill the transfer
+                                 ring. Complete one first.
+  @retval EFI_INVALID_PARAMETER  Some parameters are invalid.
+  @retval EFI_OUT_OF_RESOURCES   The transfer couldn't be set up.
+  @retval EFI_DEVICE_ERROR       The controller is halted or the device is gone.
+
+**/
+typedef
+EFI_STATUS
+(EFIAPI *ADLINK_USB_BULK_QUEUE_SUBMIT)(
+  IN ADLINK_USB_BULK_QUEUE_PROTOCOL  *This,
+  IN UINT8                           DeviceAddress,
+  IN UINT8                           EndPointAddress,
+  IN UINT8                           DeviceSpeed,
+  IN UINTN                           MaximumPacketLength,
+  IN VOID                            *Data,
+  IN UINTN                           DataLength
+  );
+
+/**
+  Complete the oldest transfer submitted to an endpoint.
+
+  @param[in]  This             The protocol instance.
+  @param[in]  DeviceAddress    Target device address.
+  @param[in]  EndPointAddress  Endpoint number and its direction in bit 7.
+  @param[in]  Timeout          How long to wait for the transfer, in
+                               milliseconds. 0 checks it without waiting.
+  @param[out] Data             Optional. The buffer of the transfer.
+  @param[out] DataLength       The number of bytes transferred.
+  @param[out] TransferResult   The EFI_USB_ERR_* result of the transfer.
+
+  @retval EFI_SUCCESS            The transfer completed successfully.
+  @retval EFI_NOT_READY          Timeout is 0 and the transfer is still in
+                                 flight. It stays queued.
+  @retval EFI_NOT_FOUND          No transfer is queued on the endpoint.
+  @retval EFI_TIMEOUT            The transfer didn't complete in time and was
+                                 aborted.
+  @retval EFI_ABORTED            An earlier transfer on the endpoint failed,
+                                 this one was not executed.
+  @retval EFI_DEVICE_ERROR       The transfer failed.
+  @retval EFI_INVALID_PARAMETER  DataLength or TransferResult is NULL.
+
+**/
+typedef
+EFI_STATUS
+(EFIAPI *ADLINK_USB_BULK_QUEUE_COMPLETE)(
+  IN  ADLINK_USB_BULK_QUEUE_PROTOCOL  *This,
+  IN  UINT8                           DeviceAddress,
+  IN  UINT8                           EndPointAddress,
+  IN  UINTN                           Timeout,
+  OUT VOID                            **Data OPTIONAL,
+  OUT UINTN                           *DataLength,
+  OUT UINT32                          *TransferResult
+  );
+
+/**
+  Abort and discard all the transfers queued on an endpoint.
+
+  @param[in] This             The protocol instance.
+  @param[in] DeviceAddress    Target device address.
+  @param[in] EndPointAddress  Endpoint number and its direction in bit 7.
+
+  @retval EFI_SUCCESS    The transfers were discarded.
+  @retval EFI_NOT_FOUND  No transfer is queued on the endpoint.
+
+**/
+typedef
+EFI_STATUS
+(EFIAPI *ADLINK_USB_BULK_QUEUE_CANCEL)(
+  IN ADLINK_USB_BULK_QUEUE_PROTOCOL  *This,
+  IN UINT8                           DeviceAddress,
+  IN UINT8                           EndPointAddress
+  );
+
+/**
+  Return the address and speed of a device attached to the controller, as
+  the USB bus driver uses them.
+
+  @param[in]  This           The protocol instance.
+  @param[in]  DevicePath     The device path of a USB I/O instance of the
+                             device, or of a path below it.
+  @param[out] DeviceAddress  The address of the device.
+  @param[out] DeviceSpeed    The EFI_USB_SPEED_* speed of the device.
+
+  @retval EFI_SUCCESS            The device was found.
+  @retval EFI_NOT_FOUND          DevicePath is not the path of a device
+                                 attached to this controller.
+  @retval EFI_INVALID_PARAMETER  A parameter is NULL.
+
+**/
+typedef
+EFI_STATUS
+(EFIAPI *ADLINK_USB_BULK_QUEUE_GET_DEVICE)(
+  IN  ADLINK_USB_BULK_QUEUE_PROTOCOL  *This,
+  IN  EFI_DEVICE_PATH_PROTOCOL        *DevicePath,
+  OUT UINT8                           *DeviceAddress,
+  OUT UINT8                           *DeviceSpeed
+  );
+
+struct _ADLINK_USB_BULK_QUEUE_PROTOCOL {
+  UINT32                              Revision;
+  UINT32                              MaxTransfers; ///< In flight per endpoint
+  ADLINK_USB_BULK_QUEUE_SUBMIT        Submit;
+  ADLINK_USB_BULK_QUEUE_COMPLETE      Complete;
+  ADLINK_USB_BULK_QUEUE_CANCEL        Cancel;
+  ADLINK_USB_BULK_QUEUE_GET_DEVICE    GetDevice;  ///< Since revision 0x00010001
+};
+
+extern EFI_GUID  gAdlinkUsbBulkQueueProtocolGuid;
+
+#endif
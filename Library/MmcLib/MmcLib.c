@@ -7,701 +7,95 @@
 
 **/
 
-#include <Uefi.h>
-#include <Library/UefiLib.h>
-#include <Library/DebugLib.h>
-#include <Library/PrintLib.h>
-#include <Library/PcdLib.h>
-#include <Library/PL011UartLib.h>
-#include <Library/BaseMemoryLib.h>
-#include <Library/MmcLib.h>
-#include <Library/NVLib.h>
+#include "MmcLibInternal.h"
 
 EFI_STATUS
-MmcPostCode(
-    IN UINT32 Value)
+MmcPostCode (
+  IN UINT32  Value
+  )
 {
-  UINTN NumberOfBytes;
-  UINT8 IpmiCmdBuf[] = {"[C0 00 80 11]\r\n"};
-  UINTN IpmiCmdBufSize = sizeof(IpmiCmdBuf);
+  UINT8       Command[] = { MMC_IPMI_NETFN_OEM, 0x00, MMC_OEM_POST_CODE, (UINT8)Value };
+  EFI_STATUS  Status;
 
-  AsciiSPrint((CHAR8 *)IpmiCmdBuf, sizeof(IpmiCmdBuf), "[C0 00 80 %2X]\r\n", (UINT8)Value);
-
-  NumberOfBytes = PL011UartWrite((UINTN)PcdGet64(PcdSerialDbgRegisterBase), IpmiCmdBuf, IpmiCmdBufSize);
-
-  if (NumberOfBytes == 0)
-  {
-    DEBUG((DEBUG_ERROR, "%a Failed to Write MMC POST code data\n", __FUNCTION__));
-    return EFI_NO_RESPONSE;
+  //
+  // A POST code reported from within another transaction is left to the
+  // caller to retry, and must not be logged on the UART that transaction
+  // owns.
+  //
+  Status = MmcSendCommand (Command, sizeof (Command));
+  if (EFI_ERROR (Status) && (Status != EFI_ALREADY_STARTED)) {
+    DEBUG ((DEBUG_ERROR, "%a Failed to Write MMC POST code data\n", __FUNCTION__));
   }
 
-  return EFI_SUCCESS;
+  return Status;
 }
 
 EFI_STATUS
-MmcSetPowerOffType(
-    IN UINT8 Value)
+MmcExecuteOemCommand (
+  IN UINT8        Command,
+  IN CONST UINT8  *Data,
+  IN UINTN        DataSize
+  )
 {
-  UINTN numofbytes;
-  UINT8 IpmiCmdBuf[] = {"[C0 00 15 01]\r\n"};
-  UINTN IpmiCmdBufSize = sizeof(IpmiCmdBuf);
-
-  AsciiSPrint((CHAR8 *)IpmiCmdBuf, sizeof(IpmiCmdBuf), "[C0 00 80 %02X]\r\n", Value);
+  UINT8  Request[MMC_FRAME_MAX_BYTES];
+  UINT8  Response[MMC_FRAME_MAX_BYTES];
+  UINTN  ResponseSize;
 
-  DEBUG((DEBUG_INFO, "%a Write MMC Power off type %d\n", __FUNCTION__, Value));
-  numofbytes = PL011UartWrite((UINTN)PcdGet64(PcdSerialDbgRegisterBase), IpmiCmdBuf, IpmiCmdBufSize);
-
-  if (numofbytes == 0)
-  {
-    DEBUG((DEBUG_ERROR, "%a Failed to Write MMC Power off type\n", __FUNCTION__));
+  if ((DataSize > sizeof (Request) - 3) || ((Data == NULL) && (DataSize != 0))) {
     return EFI_INVALID_PARAMETER;
   }
-  return EFI_SUCCESS;
-}
-
-EFI_STATUS
-MmcFirmwareVersion(
-    IN UINT8 *Buffer,
-    IN UINTN BufferSize)
-{
-  UINTN NumberOfBytes;
-  UINT8 IpmiCmdBuf[] = {"[18 00 01]\r\n"};
-  UINTN IpmiCmdBufSize = sizeof(IpmiCmdBuf);
-  UINT8 xBuffer[19 * 3 + 5 + 12];
-  UINTN xBufferSize = sizeof(xBuffer);
-
-  if (GetFirmwareMajorVersion()==0xA1) {
-    DEBUG((DEBUG_INFO, "%a A1 is not supported\n", __FUNCTION__));
-    return EFI_UNSUPPORTED;
-  }
-
-  NumberOfBytes = PL011UartWrite((UINTN)PcdGet64(PcdSerialDbgRegisterBase), IpmiCmdBuf, IpmiCmdBufSize);
-
-  if (NumberOfBytes == 0)
-  {
-    DEBUG((DEBUG_ERROR, "%a Failed to Get MMC Version\n", __FUNCTION__));
-    return EFI_NO_RESPONSE;
-  }
-
-  NumberOfBytes = PL011UartRead((UINTN)PcdGet64(PcdSerialDbgRegisterBase), xBuffer, xBufferSize);
-
-  if (NumberOfBytes == 0)
-  {
-
-    DEBUG((DEBUG_ERROR, "%a Failed to Get MMC Version\n", __FUNCTION__));
-
-    return EFI_NO_RESPONSE;
-  }
-
-  DEBUG((DEBUG_INFO, "%a [18 00 01]--->", __FUNCTION__));
-  for (int i=0; i< xBufferSize; i++) {
-    DEBUG((DEBUG_INFO, "%02d:%02x ", i, xBuffer[i]));
-  }
-  DEBUG((DEBUG_INFO, "\n"));
-
-  DEBUG((DEBUG_INFO, "%a [18 00 01]--->", __FUNCTION__));
-  for (int i=0; i< xBufferSize; i++) {
-    DEBUG((DEBUG_INFO, "%c", xBuffer[i]));
-  }
-  DEBUG((DEBUG_INFO, "\n"));
-
-  CopyMem(Buffer, xBuffer + 66, BufferSize - 1);
-
-  Buffer[2] = '.';
-
-  return EFI_SUCCESS;
-}
-
-EFI_STATUS
-IPMI_P3V3_Sensor_Reading(
-    IN UINT8 *Buffer,
-    IN UINTN BufferSize)
-{
-  UINTN NumberOfBytes;
-  UINT8 IpmiCmdBuf[] = {"[10 04 2D 01]\r\n"};
-  UINTN IpmiCmdBufSize = sizeof(IpmiCmdBuf);
-  UINT8 xBuffer[72];
-  UINTN xBufferSize = sizeof(xBuffer);
-
-  if (GetFirmwareMajorVersion()==0xA1) {
-    DEBUG((DEBUG_INFO, "%a A1 is not supported\n", __FUNCTION__));
-    return EFI_UNSUPPORTED;
-  }
-
-  NumberOfBytes = PL011UartWrite((UINTN)PcdGet64(PcdSerialDbgRegisterBase), IpmiCmdBuf, IpmiCmdBufSize);
-
-  if (NumberOfBytes == 0)
-  {
-    DEBUG((DEBUG_ERROR, "%a Failed to Get IPMI_P3V3_Sensor_Reading\n", __FUNCTION__));
-    return EFI_NO_RESPONSE;
-  }
-
-  NumberOfBytes = PL011UartRead((UINTN)PcdGet64(PcdSerialDbgRegisterBase), xBuffer, xBufferSize);
-
-  if (NumberOfBytes == 0)
-  {
-
-    DEBUG((DEBUG_ERROR, "%a Failed to Get IPMI_P3V3_Sensor_Reading\n", __FUNCTION__));
-
-    return EFI_NO_RESPONSE;
-  }
-
-  DEBUG((DEBUG_INFO, "%a [10 04 2D 01]--->", __FUNCTION__));
-  for (int i=0; i< xBufferSize; i++) {
-    DEBUG((DEBUG_INFO, "%02d:%02x ", i, xBuffer[i]));
-  }
-  DEBUG((DEBUG_INFO, "\n"));
-
-  DEBUG((DEBUG_INFO, "%a [10 04 2D 01]--->", __FUNCTION__));
-  for (int i=0; i< xBufferSize; i++) {
-    DEBUG((DEBUG_INFO, "%c", xBuffer[i]));
-  }
-  DEBUG((DEBUG_INFO, "\n"));
-
-  CopyMem(Buffer, xBuffer + 63, BufferSize);
-
-  return EFI_SUCCESS;
-}
-
-EFI_STATUS
-IPMI_P12V_Sensor_Reading(
-    IN UINT8 *Buffer,
-    IN UINTN BufferSize)
-{
-  UINTN NumberOfBytes;
-  UINT8 IpmiCmdBuf[] = {"[10 08 2D 02]\r\n"};
-  UINTN IpmiCmdBufSize = sizeof(IpmiCmdBuf);
-  UINT8 xBuffer[42];
-  UINTN xBufferSize = sizeof(xBuffer);
-
-  if (GetFirmwareMajorVersion()==0xA1) {
-    DEBUG((DEBUG_INFO, "%a A1 is not supported\n", __FUNCTION__));
-    return EFI_UNSUPPORTED;
-  }
-
-  NumberOfBytes = PL011UartWrite((UINTN)PcdGet64(PcdSerialDbgRegisterBase), IpmiCmdBuf, IpmiCmdBufSize);
-
-  if (NumberOfBytes == 0)
-  {
-    DEBUG((DEBUG_ERROR, "%a Failed to Get IPMI_P12V_Sensor_Reading\n", __FUNCTION__));
-    return EFI_NO_RESPONSE;
-  }
-
-  NumberOfBytes = PL011UartRead((UINTN)PcdGet64(PcdSerialDbgRegisterBase), xBuffer, xBufferSize);
-
-  if (NumberOfBytes == 0)
-  {
-
-    DEBUG((DEBUG_ERROR, "%a Failed to Get IPMI_P12V_Sensor_Reading\n", __FUNCTION__));
-
-    return EFI_NO_RESPONSE;
-  }
-
-  DEBUG((DEBUG_INFO, "%a [10 08 2D 02]--->", __FUNCTION__));
-  for (int i=0; i< xBufferSize; i++) {
-    DEBUG((DEBUG_INFO, "%02d:%02x ", i, xBuffer[i]));
-  }
-  DEBUG((DEBUG_INFO, "\n"));
-
-  DEBUG((DEBUG_INFO, "%a [10 08 2D 02]--->", __FUNCTION__));
-  for (int i=0; i< xBufferSize; i++) {
-    DEBUG((DEBUG_INFO, "%c", xBuffer[i]));
-  }
-  DEBUG((DEBUG_INFO, "\n"));
-
-  CopyMem(Buffer, xBuffer + 33, BufferSize);
-
-  return EFI_SUCCESS;
-}
-
-EFI_STATUS
-IPMI_P5V_Sensor_Reading(
-    IN UINT8 *Buffer,
-    IN UINTN BufferSize)
-{
-  UINTN NumberOfBytes;
-  UINT8 IpmiCmdBuf[] = {"[10 0C 2D 03]\r\n"};
-  UINTN IpmiCmdBufSize = sizeof(IpmiCmdBuf);
-  UINT8 xBuffer[42];
-  UINTN xBufferSize = sizeof(xBuffer);
-
-  if (GetFirmwareMajorVersion()==0xA1) {
-    DEBUG((DEBUG_INFO, "%a A1 is not supported\n", __FUNCTION__));
-    return EFI_UNSUPPORTED;
-  }
-
-  NumberOfBytes = PL011UartWrite((UINTN)PcdGet64(PcdSerialDbgRegisterBase), IpmiCmdBuf, IpmiCmdBufSize);
-
-  if (NumberOfBytes == 0)
-  {
-    DEBUG((DEBUG_ERROR, "%a Failed to Get IPMI_P5V_Sensor_Reading\n", __FUNCTION__));
-    return EFI_NO_RESPONSE;
-  }
-
-  NumberOfBytes = PL011UartRead((UINTN)PcdGet64(PcdSerialDbgRegisterBase), xBuffer, xBufferSize);
-
-  if (NumberOfBytes == 0)
-  {
-
-    DEBUG((DEBUG_ERROR, "%a Failed to Get IPMI_P5V_Sensor_Reading\n", __FUNCTION__));
-
-    return EFI_NO_RESPONSE;
-  }
-
-  DEBUG((DEBUG_INFO, "%a [10 0C 2D 03]--->", __FUNCTION__));
-  for (int i=0; i< xBufferSize; i++) {
-    DEBUG((DEBUG_INFO, "%02d:%02x ", i, xBuffer[i]));
-  }
-  DEBUG((DEBUG_INFO, "\n"));
-
-  DEBUG((DEBUG_INFO, "%a [10 0C 2D 03]--->", __FUNCTION__));
-  for (int i=0; i< xBufferSize; i++) {
-    DEBUG((DEBUG_INFO, "%c", xBuffer[i]));
-  }
-  DEBUG((DEBUG_INFO, "\n"));
-
-  CopyMem(Buffer, xBuffer + 33, BufferSize);
-
-  return EFI_SUCCESS;
-}
-
-EFI_STATUS
-P1V5_VDDH_Sensor_Reading(
-    IN UINT8 *Buffer,
-    IN UINTN BufferSize)
-{
-  UINTN NumberOfBytes;
-  UINT8 IpmiCmdBuf[] = {"[10 10 2D 05]\r\n"};
-  UINTN IpmiCmdBufSize = sizeof(IpmiCmdBuf);
-  UINT8 xBuffer[42];
-  UINTN xBufferSize = sizeof(xBuffer);
-
-  if (GetFirmwareMajorVersion()==0xA1) {
-    DEBUG((DEBUG_INFO, "%a A1 is not supported\n", __FUNCTION__));
-    return EFI_UNSUPPORTED;
-  }
-
-  NumberOfBytes = PL011UartWrite((UINTN)PcdGet64(PcdSerialDbgRegisterBase), IpmiCmdBuf, IpmiCmdBufSize);
-
-  if (NumberOfBytes == 0)
-  {
-    DEBUG((DEBUG_ERROR, "%a Failed to Get P1V5_VDDH_Sensor_Reading\n", __FUNCTION__));
-    return EFI_NO_RESPONSE;
-  }
-
-  NumberOfBytes = PL011UartRead((UINTN)PcdGet64(PcdSerialDbgRegisterBase), xBuffer, xBufferSize);
-
-  if (NumberOfBytes == 0)
-  {
-
-    DEBUG((DEBUG_ERROR, "%a Failed to Get P1V5_VDDH_Sensor_Reading\n", __FUNCTION__));
-
-    return EFI_NO_RESPONSE;
-  }
-
-  DEBUG((DEBUG_INFO, "%a [10 10 2D 05]--->", __FUNCTION__));
-  for (int i=0; i< xBufferSize; i++) {
-    DEBUG((DEBUG_INFO, "%02d:%02x ", i, xBuffer[i]));
-  }
-  DEBUG((DEBUG_INFO, "\n"));
-
-  DEBUG((DEBUG_INFO, "%a [10 10 2D 05]--->", __FUNCTION__));
-  for (int i=0; i< xBufferSize; i++) {
-    DEBUG((DEBUG_INFO, "%c", xBuffer[i]));
-  }
-  DEBUG((DEBUG_INFO, "\n"));
-
-  CopyMem(Buffer, xBuffer + 33, BufferSize);
-
-  return EFI_SUCCESS;
-}
-
-EFI_STATUS
-P0V75_PCP_Sensor_Reading(
-    IN UINT8 *Buffer,
-    IN UINTN BufferSize)
-{
-  UINTN NumberOfBytes;
-  UINT8 IpmiCmdBuf[] = {"[10 14 2D 06]\r\n"};
-  UINTN IpmiCmdBufSize = sizeof(IpmiCmdBuf);
-  UINT8 xBuffer[42];
-  UINTN xBufferSize = sizeof(xBuffer);
-
-  if (GetFirmwareMajorVersion()==0xA1) {
-    DEBUG((DEBUG_INFO, "%a A1 is not supported\n", __FUNCTION__));
-    return EFI_UNSUPPORTED;
-  }
-
-  NumberOfBytes = PL011UartWrite((UINTN)PcdGet64(PcdSerialDbgRegisterBase), IpmiCmdBuf, IpmiCmdBufSize);
-
-  if (NumberOfBytes == 0)
-  {
-    DEBUG((DEBUG_ERROR, "%a Failed to Get P0V75_PCP_Sensor_Reading\n", __FUNCTION__));
-    return EFI_NO_RESPONSE;
-  }
-
-  NumberOfBytes = PL011UartRead((UINTN)PcdGet64(PcdSerialDbgRegisterBase), xBuffer, xBufferSize);
-
-  if (NumberOfBytes == 0)
-  {
-
-    DEBUG((DEBUG_ERROR, "%a Failed to Get P0V75_PCP_Sensor_Reading\n", __FUNCTION__));
-
-    return EFI_NO_RESPONSE;
-  }
-
-  DEBUG((DEBUG_INFO, "%a [10 14 2D 06]--->", __FUNCTION__));
-  for (int i=0; i< xBufferSize; i++) {
-    DEBUG((DEBUG_INFO, "%02d:%02x ", i, xBuffer[i]));
-  }
-  DEBUG((DEBUG_INFO, "\n"));
-
-  DEBUG((DEBUG_INFO, "%a [10 14 2D 06]--->", __FUNCTION__));
-  for (int i=0; i< xBufferSize; i++) {
-    DEBUG((DEBUG_INFO, "%c", xBuffer[i]));
-  }
-  DEBUG((DEBUG_INFO, "\n"));
-
-  CopyMem(Buffer, xBuffer + 33, BufferSize);
-
-  return EFI_SUCCESS;
-}
-
-EFI_STATUS
-P0V9_VDDC_RCA_Sensor_Reading(
-    IN UINT8 *Buffer,
-    IN UINTN BufferSize)
-{
-  UINTN NumberOfBytes;
-  UINT8 IpmiCmdBuf[] = {"[10 18 2D 07]\r\n"};
-  UINTN IpmiCmdBufSize = sizeof(IpmiCmdBuf);
-  UINT8 xBuffer[42];
-  UINTN xBufferSize = sizeof(xBuffer);
-
-  if (GetFirmwareMajorVersion()==0xA1) {
-    DEBUG((DEBUG_INFO, "%a A1 is not supported\n", __FUNCTION__));
-    return EFI_UNSUPPORTED;
-  }
-
-  NumberOfBytes = PL011UartWrite((UINTN)PcdGet64(PcdSerialDbgRegisterBase), IpmiCmdBuf, IpmiCmdBufSize);
-
-  if (NumberOfBytes == 0)
-  {
-    DEBUG((DEBUG_ERROR, "%a Failed to Get P0V9_VDDC_RCA_Sensor_Reading\n", __FUNCTION__));
-    return EFI_NO_RESPONSE;
-  }
-
-  NumberOfBytes = PL011UartRead((UINTN)PcdGet64(PcdSerialDbgRegisterBase), xBuffer, xBufferSize);
-
-  if (NumberOfBytes == 0)
-  {
-
-    DEBUG((DEBUG_ERROR, "%a Failed to Get P0V9_VDDC_RCA_Sensor_Reading\n", __FUNCTION__));
-
-    return EFI_NO_RESPONSE;
-  }
-
-  DEBUG((DEBUG_INFO, "%a [10 18 2D 07]--->", __FUNCTION__));
-  for (int i=0; i< xBufferSize; i++) {
-    DEBUG((DEBUG_INFO, "%02d:%02x ", i, xBuffer[i]));
-  }
-  DEBUG((DEBUG_INFO, "\n"));
-
-  DEBUG((DEBUG_INFO, "%a [10 18 2D 07]--->", __FUNCTION__));
-  for (int i=0; i< xBufferSize; i++) {
-    DEBUG((DEBUG_INFO, "%c", xBuffer[i]));
-  }
-  DEBUG((DEBUG_INFO, "\n"));
-
-  CopyMem(Buffer, xBuffer + 33, BufferSize);
-
-  return EFI_SUCCESS;
-}
-
-EFI_STATUS
-P0V75_VDDC_SOC_Sensor_Reading(
-    IN UINT8 *Buffer,
-    IN UINTN BufferSize)
-{
-  UINTN NumberOfBytes;
-  UINT8 IpmiCmdBuf[] = {"[10 1C 2D 08]\r\n"};
-  UINTN IpmiCmdBufSize = sizeof(IpmiCmdBuf);
-  UINT8 xBuffer[42];
-  UINTN xBufferSize = sizeof(xBuffer);
-
-  if (GetFirmwareMajorVersion()==0xA1) {
-    DEBUG((DEBUG_INFO, "%a A1 is not supported\n", __FUNCTION__));
-    return EFI_UNSUPPORTED;
-  }
-
-  NumberOfBytes = PL011UartWrite((UINTN)PcdGet64(PcdSerialDbgRegisterBase), IpmiCmdBuf, IpmiCmdBufSize);
-
-  if (NumberOfBytes == 0)
-  {
-    DEBUG((DEBUG_ERROR, "%a Failed to Get P0V75_VDDC_SOC_Sensor_Reading\n", __FUNCTION__));
-    return EFI_NO_RESPONSE;
-  }
-
-  NumberOfBytes = PL011UartRead((UINTN)PcdGet64(PcdSerialDbgRegisterBase), xBuffer, xBufferSize);
-
-  if (NumberOfBytes == 0)
-  {
-
-    DEBUG((DEBUG_ERROR, "%a Failed to Get P0V75_VDDC_SOC_Sensor_Reading\n", __FUNCTION__));
-
-    return EFI_NO_RESPONSE;
-  }
-
-  DEBUG((DEBUG_INFO, "%a [10 1C 2D 08]--->", __FUNCTION__));
-  for (int i=0; i< xBufferSize; i++) {
-    DEBUG((DEBUG_INFO, "%02d:%02x ", i, xBuffer[i]));
-  }
-  DEBUG((DEBUG_INFO, "\n"));
-
-  DEBUG((DEBUG_INFO, "%a [10 1C 2D 08]--->", __FUNCTION__));
-  for (int i=0; i< xBufferSize; i++) {
-    DEBUG((DEBUG_INFO, "%c", xBuffer[i]));
-  }
-  DEBUG((DEBUG_INFO, "\n"));
-
-  CopyMem(Buffer, xBuffer + 33, BufferSize);
-
-  return EFI_SUCCESS;
-}
-
-EFI_STATUS
-P1V2_VDDQ_AB_Sensor_Reading(
-    IN UINT8 *Buffer,
-    IN UINTN BufferSize)
-{
-  UINTN NumberOfBytes;
-  UINT8 IpmiCmdBuf[] = {"[10 20 2D 09]\r\n"};
-  UINTN IpmiCmdBufSize = sizeof(IpmiCmdBuf);
-  UINT8 xBuffer[42];
-  UINTN xBufferSize = sizeof(xBuffer);
-
-  if (GetFirmwareMajorVersion()==0xA1) {
-    DEBUG((DEBUG_INFO, "%a A1 is not supported\n", __FUNCTION__));
-    return EFI_UNSUPPORTED;
-  }
-
-  NumberOfBytes = PL011UartWrite((UINTN)PcdGet64(PcdSerialDbgRegisterBase), IpmiCmdBuf, IpmiCmdBufSize);
-
-  if (NumberOfBytes == 0)
-  {
-    DEBUG((DEBUG_ERROR, "%a Failed to Get P1V2_VDDQ_AB_Sensor_Reading\n", __FUNCTION__));
-    return EFI_NO_RESPONSE;
-  }
-
-  NumberOfBytes = PL011UartRead((UINTN)PcdGet64(PcdSerialDbgRegisterBase), xBuffer, xBufferSize);
-
-  if (NumberOfBytes == 0)
-  {
-
-    DEBUG((DEBUG_ERROR, "%a Failed to Get P1V2_VDDQ_AB_Sensor_Reading\n", __FUNCTION__));
-
-    return EFI_NO_RESPONSE;
-  }
-
-  DEBUG((DEBUG_INFO, "%a [10 20 2D 09]--->", __FUNCTION__));
-  for (int i=0; i< xBufferSize; i++) {
-    DEBUG((DEBUG_INFO, "%02d:%02x ", i, xBuffer[i]));
-  }
-  DEBUG((DEBUG_INFO, "\n"));
-
-  DEBUG((DEBUG_INFO, "%a [10 20 2D 09]--->", __FUNCTION__));
-  for (int i=0; i< xBufferSize; i++) {
-    DEBUG((DEBUG_INFO, "%c", xBuffer[i]));
-  }
-  DEBUG((DEBUG_INFO, "\n"));
-
-  CopyMem(Buffer, xBuffer + 33, BufferSize);
-
-  return EFI_SUCCESS;
-}
-
-EFI_STATUS
-P1V2_VDDQ_CD_Sensor_Reading(
-    IN UINT8 *Buffer,
-    IN UINTN BufferSize)
-{
-  UINTN NumberOfBytes;
-  UINT8 IpmiCmdBuf[] = {"[10 24 2D 0A]\r\n"};
-  UINTN IpmiCmdBufSize = sizeof(IpmiCmdBuf);
-  UINT8 xBuffer[42];
-  UINTN xBufferSize = sizeof(xBuffer);
-
-  if (GetFirmwareMajorVersion()==0xA1) {
-    DEBUG((DEBUG_INFO, "%a A1 is not supported\n", __FUNCTION__));
-    return EFI_UNSUPPORTED;
-  }
 
-  NumberOfBytes = PL011UartWrite((UINTN)PcdGet64(PcdSerialDbgRegisterBase), IpmiCmdBuf, IpmiCmdBufSize);
+  Request[0] = MMC_IPMI_NETFN_OEM;
+  Request[1] = 0x00;
+  Request[2] = Command;
+  CopyMem (&Request[3], Data, DataSize);
 
-  if (NumberOfBytes == 0)
-  {
-    DEBUG((DEBUG_ERROR, "%a Failed to Get P1V2_VDDQ_CD_Sensor_Reading\n", __FUNCTION__));
-    return EFI_NO_RESPONSE;
-  }
-
-  NumberOfBytes = PL011UartRead((UINTN)PcdGet64(PcdSerialDbgRegisterBase), xBuffer, xBufferSize);
-
-  if (NumberOfBytes == 0)
-  {
-
-    DEBUG((DEBUG_ERROR, "%a Failed to Get P1V2_VDDQ_CD_Sensor_Reading\n", __FUNCTION__));
-
-    return EFI_NO_RESPONSE;
-  }
-
-  DEBUG((DEBUG_INFO, "%a [10 24 2D 0A]--->", __FUNCTION__));
-  for (int i=0; i< xBufferSize; i++) {
-    DEBUG((DEBUG_INFO, "%02d:%02x ", i, xBuffer[i]));
-  }
-  DEBUG((DEBUG_INFO, "\n"));
-
-  DEBUG((DEBUG_INFO, "%a [10 24 2D 0A]--->", __FUNCTION__));
-  for (int i=0; i< xBufferSize; i++) {
-    DEBUG((DEBUG_INFO, "%c", xBuffer[i]));
-  }
-  DEBUG((DEBUG_INFO, "\n"));
-
-  CopyMem(Buffer, xBuffer + 33, BufferSize);
-
-  return EFI_SUCCESS;
+  return MmcExecuteCommand (Request, DataSize + 3, Response, sizeof (Response), &ResponseSize);
 }
 
 EFI_STATUS
-P1V8_PCP_Sensor_Reading(
-    IN UINT8 *Buffer,
-    IN UINTN BufferSize)
+MmcFirmwareVersion (
+  IN UINT8  *Buffer,
+  IN UINTN  BufferSize
+  )
 {
-  UINTN NumberOfBytes;
-  UINT8 IpmiCmdBuf[] = {"[10 28 2D 0B]\r\n"};
-  UINTN IpmiCmdBufSize = sizeof(IpmiCmdBuf);
-  UINT8 xBuffer[42];
-  UINTN xBufferSize = sizeof(xBuffer);
-
-  if (GetFirmwareMajorVersion()==0xA1) {
-    DEBUG((DEBUG_INFO, "%a A1 is not supported\n", __FUNCTION__));
-    return EFI_UNSUPPORTED;
-  }
-
-  NumberOfBytes = PL011UartWrite((UINTN)PcdGet64(PcdSerialDbgRegisterBase), IpmiCmdBuf, IpmiCmdBufSize);
-
-  if (NumberOfBytes == 0)
-  {
-    DEBUG((DEBUG_ERROR, "%a Failed to Get P1V8_PCP_Sensor_Reading\n", __FUNCTION__));
-    return EFI_NO_RESPONSE;
-  }
-
-  NumberOfBytes = PL011UartRead((UINTN)PcdGet64(PcdSerialDbgRegisterBase), xBuffer, xBufferSize);
-
-  if (NumberOfBytes == 0)
-  {
-
-    DEBUG((DEBUG_ERROR, "%a Failed to Get P1V8_PCP_Sensor_Reading\n", __FUNCTION__));
-
-    return EFI_NO_RESPONSE;
-  }
+  UINT8                        Command[] = { MMC_IPMI_NETFN_APP, 0x00, MMC_IPMI_GET_DEVICE_ID };
+  UINT8                        Response[MMC_FRAME_MAX_BYTES];
+  UINTN                        ResponseSize;
+  CONST ADLINK_BOARD_IDENTITY  *Identity;
+  EFI_STATUS                   Status;
 
-  DEBUG((DEBUG_INFO, "%a [10 28 2D 0B]--->", __FUNCTION__));
-  for (int i=0; i< xBufferSize; i++) {
-    DEBUG((DEBUG_INFO, "%02d:%02x ", i, xBuffer[i]));
+  //
+  // The version is asked once in PEI and kept in the board identity HOB.
+  //
+  Identity = GetBoardIdentity ();
+  if ((Identity != NULL) && (Identity->MmcVersion[0] != '\0')) {
+    AsciiStrCpyS ((CHAR8 *)Buffer, BufferSize, Identity->MmcVersion);
+    return EFI_SUCCESS;
   }
-  DEBUG((DEBUG_INFO, "\n"));
 
-  DEBUG((DEBUG_INFO, "%a [10 28 2D 0B]--->", __FUNCTION__));
-  for (int i=0; i< xBufferSize; i++) {
-    DEBUG((DEBUG_INFO, "%c", xBuffer[i]));
-  }
-  DEBUG((DEBUG_INFO, "\n"));
-
-  CopyMem(Buffer, xBuffer + 33, BufferSize);
-
-  return EFI_SUCCESS;
-}
-
-EFI_STATUS
-CPU_Temp_Sensor_Reading(
-    IN UINT8 *Buffer,
-    IN UINTN BufferSize)
-{
-  UINTN NumberOfBytes;
-  UINT8 IpmiCmdBuf[] = {"[10 2C 2D 0C]\r\n"};
-  UINTN IpmiCmdBufSize = sizeof(IpmiCmdBuf);
-  UINT8 xBuffer[42];
-  UINTN xBufferSize = sizeof(xBuffer);
-
-  if (GetFirmwareMajorVersion()==0xA1) {
-    DEBUG((DEBUG_INFO, "%a A1 is not supported\n", __FUNCTION__));
+  if (GetFirmwareMajorVersion () == 0xA1) {
+    DEBUG ((DEBUG_INFO, "%a A1 is not supported\n", __FUNCTION__));
     return EFI_UNSUPPORTED;
   }
 
-  NumberOfBytes = PL011UartWrite((UINTN)PcdGet64(PcdSerialDbgRegisterBase), IpmiCmdBuf, IpmiCmdBufSize);
-
-  if (NumberOfBytes == 0)
-  {
-    DEBUG((DEBUG_ERROR, "%a Failed to Get CPU_Temp_Sensor_Reading\n", __FUNCTION__));
-    return EFI_NO_RESPONSE;
+  Status = MmcExecuteCommand (Command, sizeof (Command), Response, sizeof (Response), &ResponseSize);
+  if (!EFI_ERROR (Status) && (ResponseSize < MMC_DEVICE_ID_RESPONSE_SIZE)) {
+    Status = EFI_PROTOCOL_ERROR;
   }
 
-  NumberOfBytes = PL011UartRead((UINTN)PcdGet64(PcdSerialDbgRegisterBase), xBuffer, xBufferSize);
-
-  if (NumberOfBytes == 0)
-  {
-
-    DEBUG((DEBUG_ERROR, "%a Failed to Get CPU_Temp_Sensor_Reading\n", __FUNCTION__));
-
+  if (EFI_ERROR (Status)) {
+    DEBUG ((DEBUG_ERROR, "%a Failed to Get MMC Version - %r\n", __FUNCTION__, Status));
     return EFI_NO_RESPONSE;
   }
 
-  DEBUG((DEBUG_INFO, "%a [10 2C 2D 0C]--->", __FUNCTION__));
-  for (int i=0; i< xBufferSize; i++) {
-    DEBUG((DEBUG_INFO, "%02d:%02x ", i, xBuffer[i]));
-  }
-  DEBUG((DEBUG_INFO, "\n"));
-
-  DEBUG((DEBUG_INFO, "%a [10 2C 2D 0C]--->", __FUNCTION__));
-  for (int i=0; i< xBufferSize; i++) {
-    DEBUG((DEBUG_INFO, "%c", xBuffer[i]));
-  }
-  DEBUG((DEBUG_INFO, "\n"));
-
-  CopyMem(Buffer, xBuffer + 33, BufferSize);
-
-  return EFI_SUCCESS;
-}
-EFI_STATUS
-WolDisableCmd( )
-{
-  UINTN NumberOfBytes;
-  UINT8 wolCmdBuf_1[] = {"[C0 00 3C 00]\r\n"}; // cmd to disable WOL
-  UINTN wolCmdBufSize_1 = sizeof(wolCmdBuf_1);  
-
-  NumberOfBytes = PL011UartWrite((UINTN)PcdGet64(PcdSerialDbgRegisterBase), wolCmdBuf_1, wolCmdBufSize_1);
-
-  if (NumberOfBytes == 0)
-  {
-    return EFI_NO_RESPONSE;
-  }
-
-  return EFI_SUCCESS;
-}
-
-EFI_STATUS
-WolEnableCmd( )
-{
-  UINTN NumberOfBytes;
-  UINT8 wolCmdBuf_1[] = {"[C0 00 3C 01]\r\n"}; // cmd to enable WOL
-  UINTN wolCmdBufSize_1 = sizeof(wolCmdBuf_1);  
-
-  NumberOfBytes = PL011UartWrite((UINTN)PcdGet64(PcdSerialDbgRegisterBase), wolCmdBuf_1, wolCmdBufSize_1);
-
-  if (NumberOfBytes == 0)
-  {
-    return EFI_NO_RESPONSE;
-  }
+  AsciiSPrint (
+    (CHAR8 *)Buffer,
+    BufferSize,
+    "%02X.%02X",
+    Response[MMC_DEVICE_ID_VERSION],
+    Response[MMC_DEVICE_ID_VERSION + 1]
+    );
 
   return EFI_SUCCESS;
 }
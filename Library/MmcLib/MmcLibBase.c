@@ -0,0 +1,103 @@
+/** @file
+  SEC and PEI parts of the MMC Library.
+
+  These phases run on one processor with interrupts masked, so nothing can
+  enter MmcLib behind the caller's back and the transaction busy flag of
+  the link state alone catches re-entry, such as a status code reported
+  from within a transaction and handled by another PEIM.
+
+  The link state is a GUIDed HOB, looked up on every use because the HOB
+  list moves when permanent memory is installed. Code running before the
+  HOB list exists keeps a state of its own. Variables are read-only here,
+  what the baud rate negotiation learns is written to the variable by DXE.
+
+  Nothing could dump a trace kept here, so transactions are not traced.
+
+  Copyright (c) 2022, ADLink. All rights reserved.<BR>
+
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#include <PiPei.h>
+#include "MmcLibInternal.h"
+#include <Library/HobLib.h>
+#include <Library/PeiServicesLib.h>
+#include <Ppi/ReadOnlyVariable2.h>
+
+STATIC ADLINK_MMC_LINK  mMmcLocalLink;
+
+UINTN
+MmcEnterCriticalSection (
+  VOID
+  )
+{
+  return 0;
+}
+
+VOID
+MmcLeaveCriticalSection (
+  IN UINTN  State
+  )
+{
+}
+
+ADLINK_MMC_LINK *
+MmcGetLink (
+  VOID
+  )
+{
+  VOID             *GuidHob;
+  ADLINK_MMC_LINK  *Link;
+
+  GuidHob = GetFirstGuidHob (&gAdlinkMmcLinkGuid);
+  if (GuidHob != NULL) {
+    return GET_GUID_HOB_DATA (GuidHob);
+  }
+
+  Link = BuildGuidHob (&gAdlinkMmcLinkGuid, sizeof (*Link));
+  if (Link == NULL) {
+    Link = &mMmcLocalLink;
+  }
+
+  if (Link->Signature != ADLINK_MMC_LINK_SIGNATURE) {
+    ZeroMem (Link, sizeof (*Link));
+    Link->Signature = ADLINK_MMC_LINK_SIGNATURE;
+  }
+
+  return Link;
+}
+
+BOOLEAN
+MmcReadLinkCache (
+  OUT ADLINK_MMC_LINK_CACHE  *Cache
+  )
+{
+  EFI_PEI_READ_ONLY_VARIABLE2_PPI  *Variable;
+  UINTN                            Size;
+  EFI_STATUS                       Status;
+
+  Status = PeiServicesLocatePpi (&gEfiPeiReadOnlyVariable2PpiGuid, 0, NULL, (VOID **)&Variable);
+  if (EFI_ERROR (Status)) {
+    return FALSE;
+  }
+
+  Size   = sizeof (*Cache);
+  Status = Variable->GetVariable (
+                       Variable,
+                       ADLINK_MMC_LINK_VARIABLE_NAME,
+                       &gAdlinkMmcLinkGuid,
+                       NULL,
+                       &Size,
+                       Cache
+                       );
+  return !EFI_ERROR (Status) && (Size == sizeof (*Cache));
+}
+
+ADLINK_MMC_TRACE_LOG *
+MmcGetTraceLog (
+  VOID
+  )
+{
+  return NULL;
+}
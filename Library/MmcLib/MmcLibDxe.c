@@ -0,0 +1,324 @@
+/** @file
+  DXE parts of the MMC Library.
+
+  Transactions run at TPL_NOTIFY so that timer callbacks, such as the POST
+  code flush or the sensor poll, cannot start another one on the UART
+  meanwhile. After ExitBootServices () the OS owns scheduling and the
+  transaction busy flag is the only guard left, per module since the
+  shared link state is left behind then.
+
+  All DXE modules share one link state and record their transactions in
+  one trace, both published as configuration tables by the first of them.
+  The link state starts from the one PEI left in its HOB, and the module
+  publishing it saves what the baud rate negotiation learned in PEI once
+  variables can be written. At
+  ExitBootServices () each module takes a copy of the link state and
+  tracing stops, before both move under the OS mapping.
+
+  Copyright (c) 2022, ADLink. All rights reserved.<BR>
+
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#include "MmcLibInternal.h"
+#include <Library/HobLib.h>
+#include <Library/MemoryAllocationLib.h>
+#include <Library/UefiBootServicesTableLib.h>
+#include <Library/UefiRuntimeServicesTableLib.h>
+#include <Protocol/VariableWrite.h>
+
+#define MMC_TPL               TPL_NOTIFY
+#define MMC_TPL_NOT_RAISED    MAX_UINTN
+
+STATIC EFI_EVENT  mMmcExitBootServicesEvent;
+STATIC EFI_EVENT  mMmcVariableWriteEvent;
+STATIC VOID       *mMmcVariableWriteRegistration;
+STATIC BOOLEAN    mMmcAtRuntime;
+
+STATIC ADLINK_MMC_LINK       *mMmcLink;
+STATIC ADLINK_MMC_LINK       mMmcLocalLink;
+STATIC ADLINK_MMC_TRACE_LOG  *mMmcTraceLog;
+
+/**
+  Stop using boot services once the OS takes over.
+
+  @param  Event    The Event that is being processed, not used.
+  @param  Context  Event Context, not used.
+
+**/
+STATIC
+VOID
+EFIAPI
+MmcNotifyExitBootServices (
+  IN EFI_EVENT  Event,
+  IN VOID       *Context
+  )
+{
+  if (mMmcLink != NULL) {
+    CopyMem (&mMmcLocalLink, mMmcLink, sizeof (mMmcLocalLink));
+  }
+
+  mMmcAtRuntime = TRUE;
+}
+
+UINTN
+MmcEnterCriticalSection (
+  VOID
+  )
+{
+  if (mMmcAtRuntime || (EfiGetCurrentTpl () >= MMC_TPL)) {
+    return MMC_TPL_NOT_RAISED;
+  }
+
+  return gBS->RaiseTPL (MMC_TPL);
+}
+
+VOID
+MmcLeaveCriticalSection (
+  IN UINTN  State
+  )
+{
+  if (State != MMC_TPL_NOT_RAISED) {
+    gBS->RestoreTPL ((EFI_TPL)State);
+  }
+}
+
+ADLINK_MMC_LINK *
+MmcGetLink (
+  VOID
+  )
+{
+  return (mMmcAtRuntime || (mMmcLink == NULL)) ? &mMmcLocalLink : mMmcLink;
+}
+
+ADLINK_MMC_TRACE_LOG *
+MmcGetTraceLog (
+  VOID
+  )
+{
+  return mMmcAtRuntime ? NULL : mMmcTraceLog;
+}
+
+BOOLEAN
+MmcReadLinkCache (
+  OUT ADLINK_MMC_LINK_CACHE  *Cache
+  )
+{
+  UINTN       Size;
+  EFI_STATUS  Status;
+
+  if (mMmcAtRuntime) {
+    return FALSE;
+  }
+
+  Size   = sizeof (*Cache);
+  Status = gRT->GetVariable (
+                  ADLINK_MMC_LINK_VARIABLE_NAME,
+                  &gAdlinkMmcLinkGuid,
+                  NULL,
+                  &Size,
+                  Cache
+                  );
+  return !EFI_ERROR (Status) && (Size == sizeof (*Cache));
+}
+
+/**
+  Save the link cache once variables can be written.
+
+  @param  Event    The Event that is being processed.
+  @param  Context  Event Context, not used.
+
+**/
+STATIC
+VOID
+EFIAPI
+MmcNotifyVariableWrite (
+  IN EFI_EVENT  Event,
+  IN VOID       *Context
+  )
+{
+  VOID        *Interface;
+  EFI_STATUS  Status;
+
+  Status = gBS->LocateProtocol (&gEfiVariableWriteArchProtocolGuid, NULL, &Interface);
+  if (EFI_ERROR (Status)) {
+    return;
+  }
+
+  gBS->CloseEvent (Event);
+  mMmcVariableWriteEvent = NULL;
+
+  if ((mMmcLink == NULL) || !mMmcLink->CacheDirty) {
+    return;
+  }
+
+  Status = gRT->SetVariable (
+                  ADLINK_MMC_LINK_VARIABLE_NAME,
+                  &gAdlinkMmcLinkGuid,
+                  EFI_VARIABLE_NON_VOLATILE | EFI_VARIABLE_BOOTSERVICE_ACCESS,
+                  sizeof (mMmcLink->Cache),
+                  &mMmcLink->Cache
+                  );
+  if (EFI_ERROR (Status)) {
+    DEBUG ((DEBUG_ERROR, "%a Failed to save MMC link cache - %r\n", __FUNCTION__, Status));
+    return;
+  }
+
+  mMmcLink->CacheDirty = FALSE;
+}
+
+/**
+  Find the link state published by another module, or publish one starting
+  from the state PEI left.
+
+**/
+STATIC
+VOID
+MmcLinkInitialize (
+  VOID
+  )
+{
+  ADLINK_MMC_LINK  *Link;
+  VOID             *GuidHob;
+  EFI_STATUS       Status;
+
+  mMmcLocalLink.Signature = ADLINK_MMC_LINK_SIGNATURE;
+
+  Status = EfiGetSystemConfigurationTable (&gAdlinkMmcLinkGuid, (VOID **)&Link);
+  if (!EFI_ERROR (Status)) {
+    mMmcLink = Link;
+    return;
+  }
+
+  Link = AllocateRuntimeZeroPool (sizeof (*Link));
+  if (Link == NULL) {
+    return;
+  }
+
+  GuidHob = GetFirstGuidHob (&gAdlinkMmcLinkGuid);
+  if (GuidHob != NULL) {
+    CopyMem (Link, GET_GUID_HOB_DATA (GuidHob), sizeof (*Link));
+  }
+
+  Link->Signature = ADLINK_MMC_LINK_SIGNATURE;
+
+  Status = gBS->InstallConfigurationTable (&gAdlinkMmcLinkGuid, Link);
+  if (EFI_ERROR (Status)) {
+    FreePool (Link);
+    return;
+  }
+
+  mMmcLink = Link;
+
+  if (Link->CacheDirty) {
+    mMmcVariableWriteEvent = EfiCreateProtocolNotifyEvent (
+                               &gEfiVariableWriteArchProtocolGuid,
+                               TPL_CALLBACK,
+                               MmcNotifyVariableWrite,
+                               NULL,
+                               &mMmcVariableWriteRegistration
+                               );
+  }
+}
+
+/**
+  Find the trace published by another module, or publish one.
+
+**/
+STATIC
+VOID
+MmcTraceInitialize (
+  VOID
+  )
+{
+  ADLINK_MMC_TRACE_LOG  *Log;
+  EFI_STATUS            Status;
+
+  Status = EfiGetSystemConfigurationTable (&gAdlinkMmcTraceGuid, (VOID **)&Log);
+  if (!EFI_ERROR (Status)) {
+    mMmcTraceLog = Log;
+    return;
+  }
+
+  //
+  // Runtime memory, so that the trace of the boot is still there for the OS.
+  //
+  Log = AllocateRuntimeZeroPool (sizeof (*Log));
+  if (Log == NULL) {
+    return;
+  }
+
+  Log->Signature = ADLINK_MMC_TRACE_SIGNATURE;
+  Log->Capacity  = ADLINK_MMC_TRACE_ENTRIES;
+
+  Status = gBS->InstallConfigurationTable (&gAdlinkMmcTraceGuid, Log);
+  if (EFI_ERROR (Status)) {
+    FreePool (Log);
+    return;
+  }
+
+  mMmcTraceLog = Log;
+}
+
+/**
+  The constructor function registers for ExitBootServices () and attaches
+  to the link state and the trace.
+
+  @param  ImageHandle   The firmware allocated handle for the EFI image.
+  @param  SystemTable   A pointer to the EFI System Table.
+
+  @retval EFI_SUCCESS   The constructor always returns EFI_SUCCESS.
+
+**/
+EFI_STATUS
+EFIAPI
+MmcLibDxeConstructor (
+  IN EFI_HANDLE        ImageHandle,
+  IN EFI_SYSTEM_TABLE  *SystemTable
+  )
+{
+  EFI_STATUS  Status;
+
+  Status = gBS->CreateEvent (
+                  EVT_SIGNAL_EXIT_BOOT_SERVICES,
+                  TPL_NOTIFY,
+                  MmcNotifyExitBootServices,
+                  NULL,
+                  &mMmcExitBootServicesEvent
+                  );
+  ASSERT_EFI_ERROR (Status);
+
+  MmcLinkInitialize ();
+  MmcTraceInitialize ();
+
+  return EFI_SUCCESS;
+}
+
+/**
+  The destructor function closes the ExitBootServices () event, and the
+  variable write event if it did not fire.
+
+  @param  ImageHandle   The firmware allocated handle for the EFI image.
+  @param  SystemTable   A pointer to the EFI System Table.
+
+  @retval EFI_SUCCESS   The destructor always returns EFI_SUCCESS.
+
+**/
+EFI_STATUS
+EFIAPI
+MmcLibDxeDestructor (
+  IN EFI_HANDLE        ImageHandle,
+  IN EFI_SYSTEM_TABLE  *SystemTable
+  )
+{
+  if (mMmcExitBootServicesEvent != NULL) {
+    gBS->CloseEvent (mMmcExitBootServicesEvent);
+  }
+
+  if (mMmcVariableWriteEvent != NULL) {
+    gBS->CloseEvent (mMmcVariableWriteEvent);
+  }
+
+  return EFI_SUCCESS;
+}
@@ -0,0 +1,289 @@
+/** @file
+  Internal definitions shared by the MMC Library source files.
+
+  Copyright (c) 2022, ADLink. All rights reserved.<BR>
+
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#ifndef MMC_LIB_INTERNAL_H_
+#define MMC_LIB_INTERNAL_H_
+
+#include <Uefi.h>
+#include <Library/UefiLib.h>
+#include <Library/DebugLib.h>
+#include <Library/BaseLib.h>
+#include <Library/PrintLib.h>
+#include <Library/PcdLib.h>
+#include <Library/IoLib.h>
+#include <Library/PL011UartLib.h>
+#include <Library/TimerLib.h>
+#include <Library/BaseMemoryLib.h>
+#include <Library/MmcLib.h>
+#include <Library/NVLib.h>
+#include <Guid/MmcLink.h>
+#include <Guid/MmcTrace.h>
+
+#define MMC_UART_BASE  ((UINTN)PcdGet64 (PcdSerialDbgRegisterBase))
+
+//
+// PL011 flag register and its transmit FIFO full bit, and integer and
+// fractional baud rate divisor registers.
+//
+#define PL011_UARTFR       0x18
+#define PL011_UARTFR_TXFF  BIT5
+#define PL011_UARTIBRD     0x24
+#define PL011_UARTFBRD     0x28
+
+//
+// The second byte of every request carries a 6-bit sequence number above
+// the bridge bits, echoed by the MMC in its answer.
+//
+#define MMC_IPMI_SEQUENCE_SHIFT        2
+#define MMC_IPMI_SEQUENCE_MASK         0x3F
+
+//
+// IPMI NetFn values, shifted into the upper six bits of the first byte.
+//
+#define MMC_IPMI_NETFN_SENSOR          0x10
+#define MMC_IPMI_NETFN_APP             0x18
+#define MMC_IPMI_NETFN_OEM             0xC0
+
+//
+// The response NetFn is the request NetFn plus one, i.e. plus 4 once
+// shifted above the LUN bits.
+//
+#define MMC_IPMI_RESPONSE_NETFN(NetFn)  ((UINT8)((NetFn) + 0x04))
+#define MMC_IPMI_CC_SUCCESS             0x00
+#define MMC_IPMI_CC_INVALID_COMMAND     0xC1
+
+//
+// Offsets in an IPMI response frame.
+//
+#define MMC_IPMI_RESPONSE_CC           3
+#define MMC_IPMI_RESPONSE_DATA         4
+
+#define MMC_IPMI_GET_DEVICE_ID         0x01
+#define MMC_IPMI_GET_SENSOR_READING    0x2D
+
+//
+// IPMI Get Sensor Reading Factors (IPMI 2.0, 35.5), answering with bytes
+// 25 to 30 of the Full Sensor Record of the sensor (43.1):
+//   request  [10 00 23 <Sensor> <Reading>]
+//   response [14 00 23 <CC> <Next reading> <M> <M, tolerance> <B>
+//             <B, accuracy> <accuracy, direction> <R exp, B exp>]
+//
+#define MMC_IPMI_GET_SENSOR_FACTORS    0x23
+#define MMC_SENSOR_FACTORS_SIZE        (MMC_IPMI_RESPONSE_DATA + 7)
+
+//
+// The MMC reports its own version in the last two auxiliary firmware
+// revision bytes of the Get Device ID response.
+//
+#define MMC_DEVICE_ID_RESPONSE_SIZE    19
+#define MMC_DEVICE_ID_VERSION          17
+
+//
+// OEM commands.
+//
+#define MMC_OEM_POST_CODE              0x80
+
+//
+// OEM command reading several sensors at once:
+//   request  [C0 00 2D <Count> <Sensor> ...]
+//   response [C4 00 2D <CC> <Reading> ...]
+//
+#define MMC_OEM_GET_SENSOR_READINGS    0x2D
+
+//
+// OEM command selecting the framing the MMC answers with:
+//   request  [C0 00 F0 <MMC_FRAMING>]
+//   response [C4 00 F0 <CC>]
+// Requests are accepted in either framing at any time.
+//
+#define MMC_OEM_SET_FRAMING            0xF0
+
+//
+// OEM command moving the MMC to another baud rate:
+//   request  [C0 00 F1 <rate in bits per second, 4 bytes little endian>]
+//   response [C4 00 F1 <CC>]
+// The response is sent at the current rate, and the MMC switches right
+// after it. Rates the MMC cannot do are refused with an error CC.
+//
+#define MMC_OEM_SET_BAUD_RATE          0xF1
+
+//
+// Time the MMC takes to reprogram its UART after acknowledging a rate.
+//
+#define MMC_BAUD_RATE_SETTLE_US        1000
+
+typedef enum {
+  MmcFramingUnknown = 0,
+  MmcFramingAscii,
+  MmcFramingBinary
+} MMC_FRAMING;
+
+//
+// Binary frame: <SOF> <Length> <Length bytes> <CRC-8 of Length and bytes>.
+//
+#define MMC_BINARY_SOF                 0xA5
+#define MMC_BINARY_OVERHEAD            3
+
+//
+// Line terminator following every ASCII frame.
+//
+#define MMC_ASCII_TERMINATOR           "\r\n"
+
+//
+// Bytes carried by one frame, the time a command may take from the first
+// byte written to the last byte of its answer, and the number of unrelated
+// frames skipped while waiting for an answer.
+//
+#define MMC_FRAME_MAX_BYTES            32
+#define MMC_COMMAND_TIMEOUT_US         (100 * 1000)
+#define MMC_FRAME_MAX_SKIP             8
+
+///
+/// Describes how to query one MMC sensor and how to decode its answer.
+///
+typedef struct {
+  MMC_SENSOR_ID    Id;
+  CONST CHAR8      *Name;
+  UINT8            SensorNumber;   ///< IPMI sensor number.
+  MMC_SENSOR_UNIT  Unit;
+  ///
+  /// Nominal conversion to Unit, Value = M * Raw + B, used when the MMC does
+  /// not report the factors of the sensor.
+  ///
+  INT32            M;
+  INT32            B;
+} MMC_SENSOR_DESCRIPTOR;
+
+/**
+  Keep code running on this processor from entering MmcLib until
+  MmcLeaveCriticalSection (). Implemented per phase.
+
+  @return State to hand to MmcLeaveCriticalSection ().
+
+**/
+UINTN
+MmcEnterCriticalSection (
+  VOID
+  );
+
+/**
+  End the section started by MmcEnterCriticalSection ().
+
+  @param[in] State  As returned by MmcEnterCriticalSection ().
+
+**/
+VOID
+MmcLeaveCriticalSection (
+  IN UINTN  State
+  );
+
+/**
+  Return the link state shared with the other modules. Implemented per
+  phase.
+
+  @return The link state, never NULL.
+
+**/
+ADLINK_MMC_LINK *
+MmcGetLink (
+  VOID
+  );
+
+/**
+  Read what an earlier boot learned about the MMC firmware. Implemented per
+  phase.
+
+  @param[out] Cache  The content of the variable.
+
+  @retval TRUE   Cache holds the variable.
+  @retval FALSE  There is no variable, or it cannot be read in this phase.
+
+**/
+BOOLEAN
+MmcReadLinkCache (
+  OUT ADLINK_MMC_LINK_CACHE  *Cache
+  );
+
+/**
+  Return the trace to record transactions in. Implemented per phase.
+
+  @return The trace, or NULL when transactions are not traced.
+
+**/
+ADLINK_MMC_TRACE_LOG *
+MmcGetTraceLog (
+  VOID
+  );
+
+/**
+  Send a command to the MMC without waiting for an answer.
+
+  The second command byte is replaced with the sequence number of the
+  transaction.
+
+  @param[in] Command      The command bytes, starting with the NetFn.
+  @param[in] CommandSize  Number of command bytes.
+
+  @retval EFI_SUCCESS          The command was sent.
+  @retval EFI_ALREADY_STARTED  Another transaction owns the UART.
+  @retval EFI_NO_RESPONSE      The UART write failed.
+
+**/
+EFI_STATUS
+MmcSendCommand (
+  IN CONST UINT8  *Command,
+  IN UINTN        CommandSize
+  );
+
+/**
+  Send a command to the MMC and wait for the frame answering it.
+
+  The UART is owned by the transaction until the answer is in, and the
+  second command byte is replaced with the sequence number of the
+  transaction. Frames answering other commands, such as the ASCII echo of
+  the request or the late answer to an earlier command, are skipped.
+
+  @param[in]  Command       The command bytes, starting with the NetFn.
+  @param[in]  CommandSize   Number of command bytes.
+  @param[out] Response      Buffer receiving the response frame, starting
+                            with the response NetFn.
+  @param[in]  MaxResponse   Size of Response.
+  @param[out] ResponseSize  Number of bytes stored in Response.
+
+  @retval EFI_SUCCESS       The answer was received with a success
+                            completion code.
+  @retval EFI_DEVICE_ERROR     The answer carries an error completion code.
+  @retval EFI_ALREADY_STARTED  Another transaction owns the UART.
+  @retval EFI_NO_RESPONSE      The UART write failed.
+  @retval EFI_TIMEOUT       No answer arrived within MMC_COMMAND_TIMEOUT_US.
+
+**/
+EFI_STATUS
+MmcExecuteCommand (
+  IN  CONST UINT8  *Command,
+  IN  UINTN        CommandSize,
+  OUT UINT8        *Response,
+  IN  UINTN        MaxResponse,
+  OUT UINTN        *ResponseSize
+  );
+
+/**
+  Look up the descriptor of a sensor.
+
+  @param[in] Id  The sensor.
+
+  @return The descriptor, or NULL if Id is out of range.
+
+**/
+CONST MMC_SENSOR_DESCRIPTOR *
+MmcGetSensorDescriptor (
+  IN MMC_SENSOR_ID  Id
+  );
+
+#endif
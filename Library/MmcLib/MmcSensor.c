@@ -0,0 +1,562 @@
+/** @file
+  Table driven access to the board sensors reported by the MMC.
+
+  Copyright (c) 2022, ADLink. All rights reserved.<BR>
+
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#include "MmcLibInternal.h"
+
+//
+// Whether the MMC firmware implements MMC_OEM_GET_SENSOR_READINGS, kept in
+// the link state. Probed on batched reads until the MMC answers or refuses
+// one.
+//
+typedef enum {
+  MmcBatchUnknown = 0,
+  MmcBatchSupported,
+  MmcBatchUnsupported
+} MMC_BATCH_SUPPORT;
+
+//
+// The M and B factors below are fallbacks for MMC firmware that does not
+// answer Get Sensor Reading Factors. They are not taken from the sensor
+// data records of the MMC, which only the MMC itself provides, so readings
+// converted with them are approximate.
+//
+STATIC CONST MMC_SENSOR_DESCRIPTOR  mMmcSensors[MmcSensorMax] = {
+  { MmcSensorP3V3,         "P3V3",           0x01, MmcSensorUnitMilliVolt,    20,   0 },
+  { MmcSensorP12V,         "P12V",           0x02, MmcSensorUnitMilliVolt,    80,   0 },
+  { MmcSensorP5V,          "P5V",            0x03, MmcSensorUnitMilliVolt,    30,   0 },
+  { MmcSensorP1V5Vddh,     "P1V5_VDDH",      0x05, MmcSensorUnitMilliVolt,    10,   0 },
+  { MmcSensorP0V75Pcp,     "P0V75_PCP",      0x06, MmcSensorUnitMilliVolt,    5,    0 },
+  { MmcSensorP0V9VddcRca,  "P0V9_VDDC_RCA",  0x07, MmcSensorUnitMilliVolt,    5,    0 },
+  { MmcSensorP0V75VddcSoc, "P0V75_VDDC_SOC", 0x08, MmcSensorUnitMilliVolt,    5,    0 },
+  { MmcSensorP1V2VddqAb,   "P1V2_VDDQ_AB",   0x09, MmcSensorUnitMilliVolt,    8,    0 },
+  { MmcSensorP1V2VddqCd,   "P1V2_VDDQ_CD",   0x0A, MmcSensorUnitMilliVolt,    8,    0 },
+  { MmcSensorP1V8Pcp,      "P1V8_PCP",       0x0B, MmcSensorUnitMilliVolt,    10,   0 },
+  { MmcSensorCpuTemp,      "CPU_TEMP",       0x0C, MmcSensorUnitMilliCelsius, 1000, 0 },
+};
+
+STATIC_ASSERT (MmcSensorMax <= ADLINK_MMC_LINK_SENSORS, "Sensor factors do not fit in the link state");
+
+CONST MMC_SENSOR_DESCRIPTOR *
+MmcGetSensorDescriptor (
+  IN MMC_SENSOR_ID  Id
+  )
+{
+  if ((UINTN)Id >= MmcSensorMax) {
+    return NULL;
+  }
+
+  ASSERT (mMmcSensors[Id].Id == Id);
+  return &mMmcSensors[Id];
+}
+
+/**
+  Query a sensor with the IPMI Get Sensor Reading command.
+
+  @param[in]  Sensor        The sensor descriptor.
+  @param[out] Response      Buffer of MMC_FRAME_MAX_BYTES receiving the
+                            answer. The reading byte is at
+                            MMC_IPMI_RESPONSE_DATA.
+  @param[out] ResponseSize  Number of bytes stored in Response.
+
+  @retval EFI_SUCCESS      The reading was received.
+  @retval EFI_UNSUPPORTED  The board revision has no MMC sensor support.
+  @retval Others           The MMC did not answer or reported an error.
+
+**/
+STATIC
+EFI_STATUS
+MmcQuerySensor (
+  IN  CONST MMC_SENSOR_DESCRIPTOR  *Sensor,
+  OUT UINT8                        *Response,
+  OUT UINTN                        *ResponseSize
+  )
+{
+  UINT8       Command[4];
+  EFI_STATUS  Status;
+
+  if (GetFirmwareMajorVersion () == 0xA1) {
+    DEBUG ((DEBUG_INFO, "%a A1 is not supported\n", __FUNCTION__));
+    return EFI_UNSUPPORTED;
+  }
+
+  Command[0] = MMC_IPMI_NETFN_SENSOR;
+  Command[1] = 0x00;
+  Command[2] = MMC_IPMI_GET_SENSOR_READING;
+  Command[3] = Sensor->SensorNumber;
+
+  Status = MmcExecuteCommand (Command, sizeof (Command), Response, MMC_FRAME_MAX_BYTES, ResponseSize);
+  if (!EFI_ERROR (Status) && (*ResponseSize <= MMC_IPMI_RESPONSE_DATA)) {
+    Status = EFI_PROTOCOL_ERROR;
+  }
+
+  if (EFI_ERROR (Status)) {
+    DEBUG ((DEBUG_ERROR, "%a Failed to read sensor %a - %r\n", __FUNCTION__, Sensor->Name, Status));
+  }
+
+  return Status;
+}
+
+/**
+  Sign extend the two's complement number in the low Bits bits of Value.
+
+**/
+STATIC
+INT16
+MmcSignExtend (
+  IN UINT16  Value,
+  IN UINTN   Bits
+  )
+{
+  Value &= (UINT16)((1 << Bits) - 1);
+  return (INT16)((Value ^ (1 << (Bits - 1))) - (1 << (Bits - 1)));
+}
+
+/**
+  Return Value * 10^Exponent, rounded toward 0.
+
+**/
+STATIC
+INT64
+MmcScale (
+  IN INT64  Value,
+  IN INTN   Exponent
+  )
+{
+  for ( ; Exponent > 0; Exponent--) {
+    Value = MultS64x64 (Value, 10);
+  }
+
+  for ( ; Exponent < 0; Exponent++) {
+    Value = DivS64x64Remainder (Value, 10, NULL);
+  }
+
+  return Value;
+}
+
+/**
+  Return the conversion factors the MMC reports for a sensor, from its
+  sensor data record. The MMC is asked on the first reading of the sensor,
+  and again later if it did not answer.
+
+  @param[in] Sensor  The sensor descriptor.
+
+  @return The factors, or NULL if the MMC does not report them and the
+          nominal factors of the descriptor apply.
+
+**/
+STATIC
+CONST ADLINK_MMC_SENSOR_FACTORS *
+MmcGetSensorFactors (
+  IN CONST MMC_SENSOR_DESCRIPTOR  *Sensor
+  )
+{
+  UINT8                      Command[5];
+  UINT8                      Response[MMC_FRAME_MAX_BYTES];
+  UINTN                      ResponseSize;
+  CONST UINT8                *Data;
+  ADLINK_MMC_SENSOR_FACTORS  *Factors;
+  EFI_STATUS                 Status;
+
+  Factors = &MmcGetLink ()->Factors[Sensor->Id];
+  if (Factors->State == AdlinkMmcFactorsUnknown) {
+    Command[0] = MMC_IPMI_NETFN_SENSOR;
+    Command[1] = 0x00;
+    Command[2] = MMC_IPMI_GET_SENSOR_FACTORS;
+    Command[3] = Sensor->SensorNumber;
+    Command[4] = 0x00;
+
+    Status = MmcExecuteCommand (Command, sizeof (Command), Response, sizeof (Response), &ResponseSize);
+    if (!EFI_ERROR (Status) && (ResponseSize >= MMC_SENSOR_FACTORS_SIZE)) {
+      //
+      // The factors follow the next reading byte: M and B are 10 bit, with
+      // their upper 2 bits on top of the next byte, and the exponents are
+      // 4 bit, in the last byte.
+      //
+      Data               = &Response[MMC_IPMI_RESPONSE_DATA + 1];
+      Factors->M         = MmcSignExtend ((UINT16)(Data[0] | ((Data[1] & 0xC0) << 2)), 10);
+      Factors->B         = MmcSignExtend ((UINT16)(Data[2] | ((Data[3] & 0xC0) << 2)), 10);
+      Factors->RExponent = (INT8)MmcSignExtend (Data[5] >> 4, 4);
+      Factors->BExponent = (INT8)MmcSignExtend (Data[5] & 0x0F, 4);
+      Factors->State     = AdlinkMmcFactorsReported;
+    } else if (!EFI_ERROR (Status) || (Status == EFI_DEVICE_ERROR)) {
+      //
+      // Refused or answered without factors, the firmware does not have
+      // the command. Other failures are retried on the next reading.
+      //
+      DEBUG ((DEBUG_INFO, "%a No factors for sensor %a, using nominal ones\n", __FUNCTION__, Sensor->Name));
+      Factors->State = AdlinkMmcFactorsNominal;
+    }
+  }
+
+  return (Factors->State == AdlinkMmcFactorsReported) ? Factors : NULL;
+}
+
+/**
+  Convert a raw reading byte with the factors the MMC reports for the
+  sensor, or with the nominal factors of the descriptor.
+
+**/
+STATIC
+VOID
+MmcDecodeReading (
+  IN  CONST MMC_SENSOR_DESCRIPTOR  *Sensor,
+  IN  UINT8                        Raw,
+  OUT MMC_SENSOR_READING           *Reading
+  )
+{
+  CONST ADLINK_MMC_SENSOR_FACTORS  *Factors;
+  INTN                             Shift;
+  INT64                            Sum;
+
+  Reading->Id   = Sensor->Id;
+  Reading->Unit = Sensor->Unit;
+  Reading->Raw  = Raw;
+
+  Factors = MmcGetSensorFactors (Sensor);
+  if (Factors == NULL) {
+    Reading->Value = Sensor->M * Raw + Sensor->B;
+    return;
+  }
+
+  //
+  // (M * Raw + B * 10^BExponent) * 10^RExponent in units, times 1000 for
+  // the milli-units of Unit. The sum is taken at the smaller exponent so
+  // that a fractional B is not lost.
+  //
+  Shift          = MIN (0, Factors->BExponent);
+  Sum            = MmcScale ((INT64)Factors->M * Raw, -Shift) + MmcScale (Factors->B, Factors->BExponent - Shift);
+  Reading->Value = (INT32)MmcScale (Sum, Factors->RExponent + 3 + Shift);
+}
+
+/**
+  Return the printable name of a sensor, or NULL if Id is out of range.
+
+**/
+CONST CHAR8 *
+MmcGetSensorName (
+  IN MMC_SENSOR_ID  Id
+  )
+{
+  CONST MMC_SENSOR_DESCRIPTOR  *Sensor;
+
+  Sensor = MmcGetSensorDescriptor (Id);
+  return (Sensor == NULL) ? NULL : Sensor->Name;
+}
+
+/**
+  Read and decode one board sensor from the MMC.
+
+  @param[in]  Id       The sensor to read.
+  @param[out] Reading  The decoded reading.
+
+  @retval EFI_SUCCESS            The sensor was read.
+  @retval EFI_INVALID_PARAMETER  Id is out of range or Reading is NULL.
+  @retval EFI_UNSUPPORTED        The board revision has no MMC sensor support.
+  @retval EFI_NO_RESPONSE        The MMC did not answer.
+  @retval EFI_PROTOCOL_ERROR     The MMC answer could not be decoded.
+
+**/
+EFI_STATUS
+MmcReadSensor (
+  IN  MMC_SENSOR_ID       Id,
+  OUT MMC_SENSOR_READING  *Reading
+  )
+{
+  CONST MMC_SENSOR_DESCRIPTOR  *Sensor;
+  UINT8                        Response[MMC_FRAME_MAX_BYTES];
+  UINTN                        ResponseSize;
+  EFI_STATUS                   Status;
+
+  Sensor = MmcGetSensorDescriptor (Id);
+  if ((Sensor == NULL) || (Reading == NULL)) {
+    return EFI_INVALID_PARAMETER;
+  }
+
+  Status = MmcQuerySensor (Sensor, Response, &ResponseSize);
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+
+  MmcDecodeReading (Sensor, Response[MMC_IPMI_RESPONSE_DATA], Reading);
+
+  return EFI_SUCCESS;
+}
+
+/**
+  Read several sensors with one MMC_OEM_GET_SENSOR_READINGS request.
+
+  @retval EFI_SUCCESS      All readings were decoded.
+  @retval EFI_UNSUPPORTED  The MMC does not know the batch command: it
+                           refused it as invalid, or gave a malformed answer.
+  @retval Others           The MMC did not answer, or failed the command
+                           for another reason that may not last.
+
+**/
+STATIC
+EFI_STATUS
+MmcReadSensorsBatched (
+  IN  CONST MMC_SENSOR_ID  *Ids,
+  IN  UINTN                Count,
+  OUT MMC_SENSOR_READING   *Readings
+  )
+{
+  UINT8       Command[4 + MMC_BATCH_MAX_SENSORS];
+  UINT8       Response[MMC_FRAME_MAX_BYTES];
+  UINTN       ResponseSize;
+  UINTN       Index;
+  EFI_STATUS  Status;
+
+  Command[0] = MMC_IPMI_NETFN_OEM;
+  Command[1] = 0x00;
+  Command[2] = MMC_OEM_GET_SENSOR_READINGS;
+  Command[3] = (UINT8)Count;
+  for (Index = 0; Index < Count; Index++) {
+    Command[4 + Index] = mMmcSensors[Ids[Index]].SensorNumber;
+  }
+
+  Status = MmcExecuteCommand (Command, 4 + Count, Response, sizeof (Response), &ResponseSize);
+  if (Status == EFI_DEVICE_ERROR) {
+    DEBUG ((DEBUG_INFO, "%a MMC rejected batch read, CC 0x%02x\n", __FUNCTION__, Response[MMC_IPMI_RESPONSE_CC]));
+    if (Response[MMC_IPMI_RESPONSE_CC] == MMC_IPMI_CC_INVALID_COMMAND) {
+      return EFI_UNSUPPORTED;
+    }
+  }
+
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+
+  if (ResponseSize != MMC_IPMI_RESPONSE_DATA + Count) {
+    DEBUG ((DEBUG_INFO, "%a Malformed batch answer, %u bytes\n", __FUNCTION__, (UINT32)ResponseSize));
+    return EFI_UNSUPPORTED;
+  }
+
+  for (Index = 0; Index < Count; Index++) {
+    MmcDecodeReading (&mMmcSensors[Ids[Index]], Response[MMC_IPMI_RESPONSE_DATA + Index], &Readings[Index]);
+  }
+
+  return EFI_SUCCESS;
+}
+
+/**
+  Read and decode several board sensors from the MMC.
+
+  The sensors are read with a single request when the MMC firmware supports
+  it, and one by one otherwise.
+
+  @param[in]  Ids       The sensors to read.
+  @param[in]  Count     Number of entries in Ids and Readings.
+  @param[out] Readings  The decoded readings, in the order of Ids.
+
+  @retval EFI_SUCCESS            All sensors were read.
+  @retval EFI_INVALID_PARAMETER  An Id is out of range, Count is 0 or above
+                                 MMC_BATCH_MAX_SENSORS, or a pointer is NULL.
+  @retval Others                 As returned by MmcReadSensor ().
+
+**/
+EFI_STATUS
+MmcReadSensors (
+  IN  CONST MMC_SENSOR_ID  *Ids,
+  IN  UINTN                Count,
+  OUT MMC_SENSOR_READING   *Readings
+  )
+{
+  ADLINK_MMC_LINK  *Link;
+  UINTN            Index;
+  EFI_STATUS       Status;
+
+  if ((Ids == NULL) || (Readings == NULL) ||
+      (Count == 0) || (Count > MMC_BATCH_MAX_SENSORS))
+  {
+    return EFI_INVALID_PARAMETER;
+  }
+
+  for (Index = 0; Index < Count; Index++) {
+    if ((UINTN)Ids[Index] >= MmcSensorMax) {
+      return EFI_INVALID_PARAMETER;
+    }
+  }
+
+  if (GetFirmwareMajorVersion () == 0xA1) {
+    DEBUG ((DEBUG_INFO, "%a A1 is not supported\n", __FUNCTION__));
+    return EFI_UNSUPPORTED;
+  }
+
+  Link = MmcGetLink ();
+  if ((Count > 1) && (Link->SensorBatch != MmcBatchUnsupported)) {
+    Status = MmcReadSensorsBatched (Ids, Count, Readings);
+    if (!EFI_ERROR (Status)) {
+      Link->SensorBatch = MmcBatchSupported;
+      return EFI_SUCCESS;
+    }
+
+    //
+    // Only a refusal tells that the firmware lacks the command. After a
+    // timeout or a busy UART, the next call tries again.
+    //
+    if (Status == EFI_UNSUPPORTED) {
+      Link->SensorBatch = MmcBatchUnsupported;
+    }
+  }
+
+  for (Index = 0; Index < Count; Index++) {
+    Status = MmcReadSensor (Ids[Index], &Readings[Index]);
+    if (EFI_ERROR (Status)) {
+      return Status;
+    }
+  }
+
+  return EFI_SUCCESS;
+}
+
+/**
+  Copy the answer of a sensor the way the legacy accessors did: the ASCII
+  reply from the reading byte on, "XX XX XX]\r\n", without terminating
+  NUL. A BufferSize of 2 gives the two hex digits of the reading byte.
+
+  @param[in]  Id          The sensor to read.
+  @param[out] Buffer      Buffer receiving the ASCII reply.
+  @param[in]  BufferSize  Number of bytes to copy, at most the length of
+                          the reply.
+
+**/
+STATIC
+EFI_STATUS
+MmcLegacySensorReading (
+  IN  MMC_SENSOR_ID  Id,
+  OUT UINT8          *Buffer,
+  IN  UINTN          BufferSize
+  )
+{
+  UINT8       Response[MMC_FRAME_MAX_BYTES];
+  UINTN       ResponseSize;
+  CHAR8       Reply[MMC_FRAME_MAX_BYTES * 3 + sizeof ("]" MMC_ASCII_TERMINATOR)];
+  UINTN       Length;
+  UINTN       Index;
+  EFI_STATUS  Status;
+
+  Status = MmcQuerySensor (MmcGetSensorDescriptor (Id), Response, &ResponseSize);
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+
+  Length = 0;
+  for (Index = MMC_IPMI_RESPONSE_DATA; Index < ResponseSize; Index++) {
+    Length += AsciiSPrint (
+                &Reply[Length],
+                sizeof (Reply) - Length,
+                (Index == MMC_IPMI_RESPONSE_DATA) ? "%02X" : " %02X",
+                Response[Index]
+                );
+  }
+
+  Length += AsciiSPrint (&Reply[Length], sizeof (Reply) - Length, "]" MMC_ASCII_TERMINATOR);
+  CopyMem (Buffer, Reply, MIN (BufferSize, Length));
+
+  return EFI_SUCCESS;
+}
+
+EFI_STATUS
+IPMI_P3V3_Sensor_Reading (
+  IN UINT8  *Buffer,
+  IN UINTN  BufferSize
+  )
+{
+  return MmcLegacySensorReading (MmcSensorP3V3, Buffer, BufferSize);
+}
+
+EFI_STATUS
+IPMI_P12V_Sensor_Reading (
+  IN UINT8  *Buffer,
+  IN UINTN  BufferSize
+  )
+{
+  return MmcLegacySensorReading (MmcSensorP12V, Buffer, BufferSize);
+}
+
+EFI_STATUS
+IPMI_P5V_Sensor_Reading (
+  IN UINT8  *Buffer,
+  IN UINTN  BufferSize
+  )
+{
+  return MmcLegacySensorReading (MmcSensorP5V, Buffer, BufferSize);
+}
+
+EFI_STATUS
+P1V5_VDDH_Sensor_Reading (
+  IN UINT8  *Buffer,
+  IN UINTN  BufferSize
+  )
+{
+  return MmcLegacySensorReading (MmcSensorP1V5Vddh, Buffer, BufferSize);
+}
+
+EFI_STATUS
+P0V75_PCP_Sensor_Reading (
+  IN UINT8  *Buffer,
+  IN UINTN  BufferSize
+  )
+{
+  return MmcLegacySensorReading (MmcSensorP0V75Pcp, Buffer, BufferSize);
+}
+
+EFI_STATUS
+P0V9_VDDC_RCA_Sensor_Reading (
+  IN UINT8  *Buffer,
+  IN UINTN  BufferSize
+  )
+{
+  return MmcLegacySensorReading (MmcSensorP0V9VddcRca, Buffer, BufferSize);
+}
+
+EFI_STATUS
+P0V75_VDDC_SOC_Sensor_Reading (
+  IN UINT8  *Buffer,
+  IN UINTN  BufferSize
+  )
+{
+  return MmcLegacySensorReading (MmcSensorP0V75VddcSoc, Buffer, BufferSize);
+}
+
+EFI_STATUS
+P1V2_VDDQ_AB_Sensor_Reading (
+  IN UINT8  *Buffer,
+  IN UINTN  BufferSize
+  )
+{
+  return MmcLegacySensorReading (MmcSensorP1V2VddqAb, Buffer, BufferSize);
+}
+
+EFI_STATUS
+P1V2_VDDQ_CD_Sensor_Reading (
+  IN UINT8  *Buffer,
+  IN UINTN  BufferSize
+  )
+{
+  return MmcLegacySensorReading (MmcSensorP1V2VddqCd, Buffer, BufferSize);
+}
+
+EFI_STATUS
+P1V8_PCP_Sensor_Reading (
+  IN UINT8  *Buffer,
+  IN UINTN  BufferSize
+  )
+{
+  return MmcLegacySensorReading (MmcSensorP1V8Pcp, Buffer, BufferSize);
+}
+
+EFI_STATUS
+CPU_Temp_Sensor_Reading (
+  IN UINT8  *Buffer,
+  IN UINTN  BufferSize
+  )
+{
+  return MmcLegacySensorReading (MmcSensorCpuTemp, Buffer, BufferSize);
+}
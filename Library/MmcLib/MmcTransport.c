@@ -0,0 +1,1116 @@
+/** @file
+  Framing of the IPMI style requests exchanged with the MMC over the debug
+  UART.
+
+  Two framings are supported. The ASCII framing "[C0 00 80 11]\r\n" is
+  understood by every MMC firmware and costs three wire bytes per command
+  byte. The binary framing <SOF> <Length> <Bytes> <CRC-8> costs one wire
+  byte per command byte plus three, and is selected at first contact when
+  the MMC accepts it. The choice is kept in the link state shared by all
+  modules, and answers are read in whichever framing they come in: the MMC
+  is not reset with the host and may still answer in binary from an
+  earlier boot. Likewise the baud rate is part of the link state, and the
+  MMC is looked for at every candidate rate when it does not answer at
+  PcdSerialDbgUartBaudRate.
+
+  Every command is a transaction owning the UART until its answer is in.
+  Competing debug output is held back meanwhile, and each request carries
+  an IPMI sequence number so that a late answer to an earlier command is
+  told apart from the awaited one. The owner, the held output and the
+  sequence are part of the shared link state, since the debug output of a
+  transaction usually goes through the status code handler, another
+  module. In DXE, transactions are recorded in
+  the trace published under gAdlinkMmcTraceGuid.
+
+  Copyright (c) 2022, ADLink. All rights reserved.<BR>
+
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#include "MmcLibInternal.h"
+
+STATIC MMC_TRANSPORT_STATISTICS  mMmcStatistics;
+STATIC UINT64                    mMmcCommandTimeoutTicks;
+
+//
+// Baud rate of the link as last seen by this module, and the divisor it
+// programs for it.
+//
+STATIC UINT64                    mMmcBaudRate;
+STATIC UINT32                    mMmcBaudDivisor;
+
+//
+// Candidate rates for MmcNegotiateBaudRate (), fastest first.
+//
+STATIC CONST UINT32  mMmcBaudRates[] = { 921600, 230400, 115200 };
+
+/**
+  Return the PL011 divisor, in 1/64ths, for a baud rate.
+
+**/
+STATIC
+UINT32
+MmcUartDivisor (
+  IN UINT64  BaudRate
+  )
+{
+  return (UINT32)DivU64x64Remainder (
+                   MultU64x32 (FixedPcdGet32 (PcdSerialDbgUartClkInReference), 4),
+                   BaudRate,
+                   NULL
+                   );
+}
+
+/**
+  Return the divisor, in 1/64ths, the UART is programmed with.
+
+  This is the only UART access not going through PL011UartLib, which has
+  no call for it.
+
+**/
+STATIC
+UINT32
+MmcGetUartDivisor (
+  VOID
+  )
+{
+  return (MmioRead32 (MMC_UART_BASE + PL011_UARTIBRD) << 6) |
+         (MmioRead32 (MMC_UART_BASE + PL011_UARTFBRD) & 0x3F);
+}
+
+/**
+  Reprogram the UART for BaudRate, 8N1, once earlier output has drained,
+  and have every module follow.
+
+**/
+STATIC
+VOID
+MmcSetUartBaudRate (
+  IN UINT64  BaudRate
+  )
+{
+  UINT32              FifoDepth;
+  EFI_PARITY_TYPE     Parity;
+  UINT8               DataBits;
+  EFI_STOP_BITS_TYPE  StopBits;
+  RETURN_STATUS       Status;
+
+  FifoDepth = 0;
+  Parity    = NoParity;
+  DataBits  = 8;
+  StopBits  = OneStopBit;
+  Status    = PL011UartInitializePort (
+                MMC_UART_BASE,
+                FixedPcdGet32 (PcdSerialDbgUartClkInReference),
+                &BaudRate,
+                &FifoDepth,
+                &Parity,
+                &DataBits,
+                &StopBits
+                );
+  if (!RETURN_ERROR (Status)) {
+    mMmcBaudRate    = BaudRate;
+    mMmcBaudDivisor = MmcUartDivisor (BaudRate);
+
+    MmcGetLink ()->BaudRate = (UINT32)BaudRate;
+  }
+}
+
+/**
+  Put the UART back to the rate of the link if another module moved the
+  link, or if something, such as the serial port library of a module loaded
+  later, reprogrammed the UART.
+
+**/
+STATIC
+VOID
+MmcSyncBaudRate (
+  VOID
+  )
+{
+  ADLINK_MMC_LINK  *Link;
+
+  Link = MmcGetLink ();
+  if (Link->BaudRate == 0) {
+    return;
+  }
+
+  if (mMmcBaudRate != Link->BaudRate) {
+    mMmcBaudRate    = Link->BaudRate;
+    mMmcBaudDivisor = MmcUartDivisor (mMmcBaudRate);
+  }
+
+  if (MmcGetUartDivisor () != mMmcBaudDivisor) {
+    MmcSetUartBaudRate (mMmcBaudRate);
+  }
+}
+
+/**
+  Take ownership of the UART for one transaction.
+
+  @param[out] State  To hand to MmcEndTransaction ().
+
+  @retval EFI_SUCCESS          The UART is owned by the caller.
+  @retval EFI_ALREADY_STARTED  A transaction is already in progress, e.g.
+                               when a status code is reported from within
+                               one.
+
+**/
+STATIC
+EFI_STATUS
+MmcBeginTransaction (
+  OUT UINTN  *State
+  )
+{
+  ADLINK_MMC_LINK  *Link;
+
+  *State = MmcEnterCriticalSection ();
+  Link   = MmcGetLink ();
+  if (Link->Busy) {
+    MmcLeaveCriticalSection (*State);
+    mMmcStatistics.Collisions++;
+    return EFI_ALREADY_STARTED;
+  }
+
+  Link->Busy = TRUE;
+  MmcSyncBaudRate ();
+  return EFI_SUCCESS;
+}
+
+/**
+  Write the debug output held during the transaction and release the UART.
+
+  @param[in] State  As returned by MmcBeginTransaction ().
+
+**/
+STATIC
+VOID
+MmcEndTransaction (
+  IN UINTN  State
+  )
+{
+  ADLINK_MMC_LINK  *Link;
+
+  Link = MmcGetLink ();
+  if (Link->DebugHeld != 0) {
+    PL011UartWrite (MMC_UART_BASE, Link->DebugHold, Link->DebugHeld);
+    Link->DebugHeld = 0;
+  }
+
+  Link->Busy = FALSE;
+  MmcLeaveCriticalSection (State);
+}
+
+/**
+  Record a transaction in the trace, if transactions are traced.
+
+  @param[in] Request       The command as written.
+  @param[in] RequestSize   Number of command bytes.
+  @param[in] Response      The answer, if any.
+  @param[in] ResponseSize  Number of answer bytes, 0 if none.
+  @param[in] Start         Performance counter when the command was written.
+  @param[in] LatencyUs     Time to the answer.
+  @param[in] Status        Outcome of the transaction.
+
+**/
+STATIC
+VOID
+MmcTraceRecord (
+  IN CONST UINT8  *Request,
+  IN UINTN        RequestSize,
+  IN CONST UINT8  *Response OPTIONAL,
+  IN UINTN        ResponseSize,
+  IN UINT64       Start,
+  IN UINT32       LatencyUs,
+  IN EFI_STATUS   Status
+  )
+{
+  ADLINK_MMC_TRACE_LOG    *Log;
+  ADLINK_MMC_TRACE_ENTRY  *Entry;
+
+  Log = MmcGetTraceLog ();
+  if (Log == NULL) {
+    return;
+  }
+
+  Entry = &Log->Entries[(UINTN)Log->Recorded & (ADLINK_MMC_TRACE_ENTRIES - 1)];
+  Log->Recorded++;
+
+  Entry->Timestamp    = GetTimeInNanoSecond (Start);
+  Entry->Status       = (UINT64)Status;
+  Entry->LatencyUs    = LatencyUs;
+  Entry->CommandSize  = (UINT8)MIN (RequestSize, sizeof (Entry->Command));
+  Entry->ResponseSize = (UINT8)MIN (ResponseSize, sizeof (Entry->Response));
+  CopyMem (Entry->Command, Request, Entry->CommandSize);
+  if (Response != NULL) {
+    CopyMem (Entry->Response, Response, Entry->ResponseSize);
+  }
+}
+
+/**
+  Update a CRC-8 with polynomial x^8 + x^2 + x + 1. Frames start from a
+  zero seed.
+
+**/
+STATIC
+UINT8
+MmcCrc8 (
+  IN UINT8        Crc,
+  IN CONST UINT8  *Data,
+  IN UINTN        Length
+  )
+{
+  UINTN  Bit;
+
+  while (Length-- != 0) {
+    Crc ^= *Data++;
+    for (Bit = 0; Bit < 8; Bit++) {
+      Crc = (UINT8)((Crc & 0x80) != 0 ? (Crc << 1) ^ 0x07 : (Crc << 1));
+    }
+  }
+
+  return Crc;
+}
+
+/**
+  Return the performance counter value at which a command started at Start
+  runs out of time. The ARM generic timer behind the performance counter
+  counts up and does not wrap within a boot.
+
+**/
+STATIC
+UINT64
+MmcGetDeadline (
+  IN UINT64  Start
+  )
+{
+  if (mMmcCommandTimeoutTicks == 0) {
+    mMmcCommandTimeoutTicks = DivU64x32 (
+                                MultU64x32 (GetPerformanceCounterProperties (NULL, NULL), MMC_COMMAND_TIMEOUT_US),
+                                1000000
+                                );
+  }
+
+  return Start + mMmcCommandTimeoutTicks;
+}
+
+/**
+  Read one byte from the MMC.
+
+  @param[in]  Deadline  Performance counter value after which to give up.
+  @param[out] Byte      The byte read.
+
+  @retval EFI_SUCCESS  A byte was read.
+  @retval EFI_TIMEOUT  The deadline passed.
+
+**/
+STATIC
+EFI_STATUS
+MmcReadByte (
+  IN  UINT64  Deadline,
+  OUT UINT8   *Byte
+  )
+{
+  while (!PL011UartPoll (MMC_UART_BASE)) {
+    if (GetPerformanceCounter () >= Deadline) {
+      return EFI_TIMEOUT;
+    }
+  }
+
+  PL011UartRead (MMC_UART_BASE, Byte, 1);
+  mMmcStatistics.BytesRead++;
+  return EFI_SUCCESS;
+}
+
+/**
+  Discard what the MMC sent before the next command, such as the late
+  answer to a command that timed out.
+
+**/
+STATIC
+VOID
+MmcDrainInput (
+  VOID
+  )
+{
+  UINT8  Byte;
+
+  while (PL011UartPoll (MMC_UART_BASE)) {
+    PL011UartRead (MMC_UART_BASE, &Byte, 1);
+    mMmcStatistics.BytesRead++;
+  }
+}
+
+/**
+  Convert a hex digit to its value.
+
+  @return The value, or MAX_UINT8 if Digit is not a hex digit.
+
+**/
+STATIC
+UINT8
+MmcHexDigit (
+  IN UINT8  Digit
+  )
+{
+  if ((Digit >= '0') && (Digit <= '9')) {
+    return Digit - '0';
+  }
+
+  if ((Digit >= 'A') && (Digit <= 'F')) {
+    return Digit - 'A' + 10;
+  }
+
+  if ((Digit >= 'a') && (Digit <= 'f')) {
+    return Digit - 'a' + 10;
+  }
+
+  return MAX_UINT8;
+}
+
+/**
+  Read the rest of a "[XX XX ...]\r\n" frame after its opening bracket,
+  returning as soon as its terminator is received.
+
+  @param[out] Next  The byte that made a malformed frame stop, which may
+                    open the next frame.
+
+  @retval EFI_SUCCESS         A frame was read.
+  @retval EFI_PROTOCOL_ERROR  The frame is malformed or oversized.
+  @retval EFI_TIMEOUT         The deadline passed.
+
+**/
+STATIC
+EFI_STATUS
+MmcReadAsciiFrame (
+  IN  UINT64  Deadline,
+  OUT UINT8   *Bytes,
+  IN  UINTN   MaxBytes,
+  OUT UINTN   *Count,
+  OUT UINT8   *Next
+  )
+{
+  UINT8       Char;
+  UINT8       Digit;
+  UINT8       Value;
+  UINTN       Digits;
+  UINTN       Index;
+  EFI_STATUS  Status;
+
+  *Count = 0;
+  Digits = 0;
+  Value  = 0;
+  while (TRUE) {
+    Status = MmcReadByte (Deadline, &Char);
+    if (EFI_ERROR (Status)) {
+      return Status;
+    }
+
+    *Next = Char;
+    if ((Char == ' ') || (Char == ']')) {
+      if ((Digits == 2) && (*Count < MaxBytes)) {
+        Bytes[(*Count)++] = Value;
+      } else if (Digits != 0) {
+        return EFI_PROTOCOL_ERROR;
+      }
+
+      if (Char == ']') {
+        break;
+      }
+
+      Digits = 0;
+      Value  = 0;
+      continue;
+    }
+
+    Digit = MmcHexDigit (Char);
+    if ((Digit == MAX_UINT8) || (Digits == 2)) {
+      return EFI_PROTOCOL_ERROR;
+    }
+
+    Value = (UINT8)((Value << 4) | Digit);
+    Digits++;
+  }
+
+  if (*Count == 0) {
+    return EFI_PROTOCOL_ERROR;
+  }
+
+  //
+  // Consume the terminator too, so that the frame is over when this
+  // returns. The payload is already complete, so a missing terminator is
+  // not an error.
+  //
+  for (Index = 0; Index < sizeof (MMC_ASCII_TERMINATOR) - 1; Index++) {
+    if (EFI_ERROR (MmcReadByte (Deadline, &Char)) ||
+        (Char == MMC_ASCII_TERMINATOR[sizeof (MMC_ASCII_TERMINATOR) - 2]))
+    {
+      break;
+    }
+  }
+
+  return EFI_SUCCESS;
+}
+
+/**
+  Read the rest of a binary frame after its start of frame marker.
+
+  @param[out] Next  A length byte that made the frame stop, which may be
+                    the marker of the next frame if this one was noise,
+                    otherwise 0.
+
+  @retval EFI_SUCCESS         A frame was read.
+  @retval EFI_PROTOCOL_ERROR  The frame has a bad length or checksum.
+  @retval EFI_TIMEOUT         The deadline passed.
+
+**/
+STATIC
+EFI_STATUS
+MmcReadBinaryFrame (
+  IN  UINT64  Deadline,
+  OUT UINT8   *Bytes,
+  IN  UINTN   MaxBytes,
+  OUT UINTN   *Count,
+  OUT UINT8   *Next
+  )
+{
+  UINT8       Length;
+  UINT8       Crc;
+  UINTN       Index;
+  EFI_STATUS  Status;
+
+  *Next  = 0;
+  Status = MmcReadByte (Deadline, &Length);
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+
+  if ((Length == 0) || (Length > MaxBytes)) {
+    *Next = Length;
+    return EFI_PROTOCOL_ERROR;
+  }
+
+  for (Index = 0; Index < Length; Index++) {
+    Status = MmcReadByte (Deadline, &Bytes[Index]);
+    if (EFI_ERROR (Status)) {
+      return Status;
+    }
+  }
+
+  Status = MmcReadByte (Deadline, &Crc);
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+
+  if (Crc != MmcCrc8 (MmcCrc8 (0, &Length, 1), Bytes, Length)) {
+    return EFI_PROTOCOL_ERROR;
+  }
+
+  *Count = Length;
+  return EFI_SUCCESS;
+}
+
+/**
+  Read one frame in either framing, told apart by its first byte. Bytes
+  before an opening bracket or a start of frame marker are dropped, and a
+  malformed frame is dropped up to the next one.
+
+  @retval EFI_SUCCESS  A frame was read.
+  @retval EFI_TIMEOUT  The deadline passed.
+
+**/
+STATIC
+EFI_STATUS
+MmcReadFrame (
+  IN  UINT64  Deadline,
+  OUT UINT8   *Bytes,
+  IN  UINTN   MaxBytes,
+  OUT UINTN   *Count
+  )
+{
+  UINT8       Lead;
+  EFI_STATUS  Status;
+
+  Lead = 0;
+  while (TRUE) {
+    while ((Lead != '[') && (Lead != MMC_BINARY_SOF)) {
+      Status = MmcReadByte (Deadline, &Lead);
+      if (EFI_ERROR (Status)) {
+        return Status;
+      }
+    }
+
+    if (Lead == '[') {
+      Status = MmcReadAsciiFrame (Deadline, Bytes, MaxBytes, Count, &Lead);
+    } else {
+      Status = MmcReadBinaryFrame (Deadline, Bytes, MaxBytes, Count, &Lead);
+    }
+
+    if (Status != EFI_PROTOCOL_ERROR) {
+      return Status;
+    }
+
+    mMmcStatistics.Resyncs++;
+  }
+}
+
+/**
+  Encode and write a command in the given framing.
+
+**/
+STATIC
+EFI_STATUS
+MmcWriteFrame (
+  IN MMC_FRAMING  Framing,
+  IN CONST UINT8  *Command,
+  IN UINTN        CommandSize
+  )
+{
+  UINT8  Frame[MMC_FRAME_MAX_BYTES * 3 + 4];
+  UINTN  Length;
+  UINTN  Index;
+
+  ASSERT (CommandSize != 0 && CommandSize <= MMC_FRAME_MAX_BYTES);
+
+  if (Framing == MmcFramingBinary) {
+    Frame[0] = MMC_BINARY_SOF;
+    Frame[1] = (UINT8)CommandSize;
+    CopyMem (&Frame[2], Command, CommandSize);
+    Frame[2 + CommandSize] = MmcCrc8 (0, &Frame[1], CommandSize + 1);
+    Length = CommandSize + MMC_BINARY_OVERHEAD;
+  } else {
+    Length = 0;
+    for (Index = 0; Index < CommandSize; Index++) {
+      Length += AsciiSPrint (
+                  (CHAR8 *)Frame + Length,
+                  sizeof (Frame) - Length,
+                  (Index == 0) ? "[%02X" : " %02X",
+                  Command[Index]
+                  );
+    }
+
+    Length += AsciiSPrint ((CHAR8 *)Frame + Length, sizeof (Frame) - Length, "]" MMC_ASCII_TERMINATOR);
+  }
+
+  if (PL011UartWrite (MMC_UART_BASE, Frame, Length) == 0) {
+    return EFI_NO_RESPONSE;
+  }
+
+  mMmcStatistics.BytesWritten += (UINT32)Length;
+  return EFI_SUCCESS;
+}
+
+/**
+  Write a command with the next sequence number in its second byte.
+
+  @param[in]  Framing      The framing to use.
+  @param[in]  Command      The command bytes, starting with the NetFn.
+  @param[in]  CommandSize  Number of command bytes.
+  @param[out] Request      Receives the command as written, at least
+                           MMC_FRAME_MAX_BYTES long.
+
+**/
+STATIC
+EFI_STATUS
+MmcWriteTaggedFrame (
+  IN  MMC_FRAMING  Framing,
+  IN  CONST UINT8  *Command,
+  IN  UINTN        CommandSize,
+  OUT UINT8        *Request
+  )
+{
+  ADLINK_MMC_LINK  *Link;
+
+  ASSERT (CommandSize >= 2 && CommandSize <= MMC_FRAME_MAX_BYTES);
+
+  Link = MmcGetLink ();
+  CopyMem (Request, Command, CommandSize);
+  Request[1]     = (UINT8)((Link->Sequence & MMC_IPMI_SEQUENCE_MASK) << MMC_IPMI_SEQUENCE_SHIFT);
+  Link->Sequence = (UINT8)((Link->Sequence + 1) & MMC_IPMI_SEQUENCE_MASK);
+
+  return MmcWriteFrame (Framing, Request, CommandSize);
+}
+
+/**
+  Send a command in the given framing and wait for its answer, within
+  MMC_COMMAND_TIMEOUT_US of the first byte written.
+
+**/
+STATIC
+EFI_STATUS
+MmcExchange (
+  IN  MMC_FRAMING  Framing,
+  IN  CONST UINT8  *Command,
+  IN  UINTN        CommandSize,
+  OUT UINT8        *Response,
+  IN  UINTN        MaxResponse,
+  OUT UINTN        *ResponseSize
+  )
+{
+  UINT8       Request[MMC_FRAME_MAX_BYTES];
+  UINT64      Start;
+  UINT64      Deadline;
+  UINT32      LatencyUs;
+  UINTN       Skipped;
+  EFI_STATUS  Status;
+
+  MmcDrainInput ();
+
+  Start    = GetPerformanceCounter ();
+  Deadline = MmcGetDeadline (Start);
+  Status   = MmcWriteTaggedFrame (Framing, Command, CommandSize, Request);
+  if (EFI_ERROR (Status)) {
+    MmcTraceRecord (Request, CommandSize, NULL, 0, Start, 0, Status);
+    return Status;
+  }
+
+  mMmcStatistics.Commands++;
+
+  Status = EFI_TIMEOUT;
+  for (Skipped = 0; Skipped < MMC_FRAME_MAX_SKIP; Skipped++) {
+    Status = MmcReadFrame (Deadline, Response, MaxResponse, ResponseSize);
+    if (EFI_ERROR (Status)) {
+      break;
+    }
+
+    //
+    // Skip the ASCII echo of the request, answers to other commands and
+    // late answers to an earlier instance of this one.
+    //
+    Status = EFI_TIMEOUT;
+    if ((*ResponseSize <= MMC_IPMI_RESPONSE_CC) ||
+        (Response[0] != MMC_IPMI_RESPONSE_NETFN (Request[0])) ||
+        (Response[2] != Request[2]))
+    {
+      continue;
+    }
+
+    if (Response[1] != Request[1]) {
+      mMmcStatistics.LateResponses++;
+      continue;
+    }
+
+    Status = (Response[MMC_IPMI_RESPONSE_CC] == MMC_IPMI_CC_SUCCESS) ? EFI_SUCCESS : EFI_DEVICE_ERROR;
+    break;
+  }
+
+  if (Status == EFI_TIMEOUT) {
+    mMmcStatistics.Timeouts++;
+    MmcTraceRecord (Request, CommandSize, NULL, 0, Start, 0, Status);
+    DEBUG ((DEBUG_WARN, "%a command %02X %02X %02X timed out\n", __FUNCTION__, Request[0], Request[1], Request[2]));
+    return Status;
+  }
+
+  LatencyUs = (UINT32)DivU64x32 (GetTimeInNanoSecond (GetPerformanceCounter () - Start), 1000);
+  mMmcStatistics.LastLatencyUs   = LatencyUs;
+  mMmcStatistics.MaxLatencyUs    = MAX (mMmcStatistics.MaxLatencyUs, LatencyUs);
+  mMmcStatistics.TotalLatencyUs += LatencyUs;
+  MmcTraceRecord (Request, CommandSize, Response, *ResponseSize, Start, LatencyUs, Status);
+
+  return Status;
+}
+
+/**
+  Select the framing used with the MMC, on first contact of the first
+  module.
+
+**/
+STATIC
+MMC_FRAMING
+MmcGetFraming (
+  VOID
+  )
+{
+  UINT8            Command[] = { MMC_IPMI_NETFN_OEM, 0x00, MMC_OEM_SET_FRAMING, MmcFramingBinary };
+  UINT8            Response[MMC_FRAME_MAX_BYTES];
+  UINTN            ResponseSize;
+  ADLINK_MMC_LINK  *Link;
+  EFI_STATUS       Status;
+
+  Link = MmcGetLink ();
+  if (Link->Framing != MmcFramingUnknown) {
+    return (MMC_FRAMING)Link->Framing;
+  }
+
+  //
+  // Fall back to ASCII unless the MMC acknowledges the switch, and do so
+  // before asking so that nothing sent meanwhile recurses here.
+  //
+  Link->Framing = MmcFramingAscii;
+  Status        = MmcExchange (MmcFramingAscii, Command, sizeof (Command), Response, sizeof (Response), &ResponseSize);
+  if (!EFI_ERROR (Status)) {
+    Link->Framing = MmcFramingBinary;
+  }
+
+  DEBUG ((DEBUG_INFO, "%a MMC framing %a\n", __FUNCTION__, (Link->Framing == MmcFramingBinary) ? "binary" : "ASCII"));
+  return (MMC_FRAMING)Link->Framing;
+}
+
+/**
+  Move both ends of the link to BaudRate and check that they still talk.
+
+  @retval EFI_SUCCESS      The link runs at BaudRate.
+  @retval EFI_UNSUPPORTED  The MMC refused or ignored the request, and the
+                           link stays at the current rate.
+  @retval Others           The link is back at PcdSerialDbgUartBaudRate.
+
+**/
+STATIC
+EFI_STATUS
+MmcSwitchBaudRate (
+  IN MMC_FRAMING  Framing,
+  IN UINT32       BaudRate
+  )
+{
+  UINT8       Command[] = {
+    MMC_IPMI_NETFN_OEM, 0x00, MMC_OEM_SET_BAUD_RATE,
+    (UINT8)BaudRate, (UINT8)(BaudRate >> 8), (UINT8)(BaudRate >> 16), (UINT8)(BaudRate >> 24)
+  };
+  UINT8       DeviceId[] = { MMC_IPMI_NETFN_APP, 0x00, MMC_IPMI_GET_DEVICE_ID };
+  UINT8       Response[MMC_FRAME_MAX_BYTES];
+  UINT8       Request[MMC_FRAME_MAX_BYTES];
+  UINTN       ResponseSize;
+  UINT64      DefaultRate;
+  EFI_STATUS  Status;
+
+  Status = MmcExchange (Framing, Command, sizeof (Command), Response, sizeof (Response), &ResponseSize);
+  if (Status == EFI_DEVICE_ERROR) {
+    //
+    // Refused, the MMC stays at the current rate.
+    //
+    return EFI_UNSUPPORTED;
+  }
+
+  if (!EFI_ERROR (Status)) {
+    MicroSecondDelay (MMC_BAUD_RATE_SETTLE_US);
+    MmcSetUartBaudRate (BaudRate);
+    Status = MmcExchange (Framing, DeviceId, sizeof (DeviceId), Response, sizeof (Response), &ResponseSize);
+    if (!EFI_ERROR (Status)) {
+      return EFI_SUCCESS;
+    }
+  } else if (!EFI_ERROR (MmcExchange (Framing, DeviceId, sizeof (DeviceId), Response, sizeof (Response), &ResponseSize))) {
+    //
+    // Firmware without the command ignores it and still answers at the
+    // current rate. The recovery below would only be garbage to it.
+    //
+    return EFI_UNSUPPORTED;
+  }
+
+  //
+  // The MMC may have switched with its acknowledgment lost, or not followed
+  // at all. Ask it at the new rate to return, then return locally.
+  //
+  DefaultRate = FixedPcdGet64 (PcdSerialDbgUartBaudRate);
+  Command[3]  = (UINT8)DefaultRate;
+  Command[4]  = (UINT8)(DefaultRate >> 8);
+  Command[5]  = (UINT8)(DefaultRate >> 16);
+  Command[6]  = (UINT8)(DefaultRate >> 24);
+  MmcSetUartBaudRate (BaudRate);
+  MmcWriteTaggedFrame (Framing, Command, sizeof (Command), Request);
+  MicroSecondDelay (MMC_BAUD_RATE_SETTLE_US);
+  MmcSetUartBaudRate (DefaultRate);
+
+  return Status;
+}
+
+/**
+  Find the rate the MMC answers at, PcdSerialDbgUartBaudRate first, and
+  read its firmware version on the way.
+
+  @param[out] BaudRate  The rate the MMC answers at.
+  @param[out] Version   The MMC firmware version, as kept in
+                        ADLINK_MMC_LINK_CACHE.
+
+  @retval EFI_SUCCESS    The UART runs at BaudRate.
+  @retval EFI_NOT_FOUND  The MMC answers at no rate. The UART is back at
+                         PcdSerialDbgUartBaudRate.
+
+**/
+STATIC
+EFI_STATUS
+MmcFindBaudRate (
+  OUT UINT64  *BaudRate,
+  OUT UINT16  *Version
+  )
+{
+  UINT8       DeviceId[] = { MMC_IPMI_NETFN_APP, 0x00, MMC_IPMI_GET_DEVICE_ID };
+  UINT8       Response[MMC_FRAME_MAX_BYTES];
+  UINTN       ResponseSize;
+  UINT64      DefaultRate;
+  UINTN       Index;
+  EFI_STATUS  Status;
+
+  DefaultRate = FixedPcdGet64 (PcdSerialDbgUartBaudRate);
+  *BaudRate   = DefaultRate;
+  *Version    = 0;
+
+  for (Index = 0; Index <= ARRAY_SIZE (mMmcBaudRates); Index++) {
+    if (Index > 0) {
+      if (mMmcBaudRates[Index - 1] == DefaultRate) {
+        continue;
+      }
+
+      *BaudRate = mMmcBaudRates[Index - 1];
+    }
+
+    //
+    // ASCII requests are understood whatever framing the MMC answers in.
+    //
+    MmcSetUartBaudRate (*BaudRate);
+    Status = MmcExchange (MmcFramingAscii, DeviceId, sizeof (DeviceId), Response, sizeof (Response), &ResponseSize);
+    if (Status == EFI_TIMEOUT) {
+      continue;
+    }
+
+    if (!EFI_ERROR (Status) && (ResponseSize >= MMC_DEVICE_ID_RESPONSE_SIZE)) {
+      *Version = (UINT16)((Response[MMC_DEVICE_ID_VERSION] << 8) | Response[MMC_DEVICE_ID_VERSION + 1]);
+    }
+
+    return EFI_SUCCESS;
+  }
+
+  *BaudRate = DefaultRate;
+  MmcSetUartBaudRate (DefaultRate);
+  return EFI_NOT_FOUND;
+}
+
+UINT64
+MmcNegotiateBaudRate (
+  IN UINT64  MaxBaudRate
+  )
+{
+  ADLINK_MMC_LINK        *Link;
+  ADLINK_MMC_LINK_CACHE  Cache;
+  MMC_FRAMING            Framing;
+  UINT64                 DefaultRate;
+  UINT64                 BaudRate;
+  UINT16                 Version;
+  BOOLEAN                Cached;
+  BOOLEAN                Tried;
+  BOOLEAN                Refused;
+  UINTN                  State;
+  UINTN                  Index;
+  EFI_STATUS             Status;
+
+  DefaultRate = FixedPcdGet64 (PcdSerialDbgUartBaudRate);
+
+  if (EFI_ERROR (MmcBeginTransaction (&State))) {
+    Link = MmcGetLink ();
+    return (Link->BaudRate != 0) ? Link->BaudRate : DefaultRate;
+  }
+
+  //
+  // An MMC found at another rate was left there by an earlier boot, and
+  // stays there.
+  //
+  Status = MmcFindBaudRate (&BaudRate, &Version);
+  if (!EFI_ERROR (Status) && (BaudRate == DefaultRate)) {
+    Cached = MmcReadLinkCache (&Cache) && (Cache.MmcVersion == Version);
+    if (Cached) {
+      MaxBaudRate = MIN (MaxBaudRate, Cache.BaudRate);
+    }
+
+    Framing = MmcGetFraming ();
+    Tried   = FALSE;
+    Refused = TRUE;
+    for (Index = 0; Index < ARRAY_SIZE (mMmcBaudRates); Index++) {
+      if ((mMmcBaudRates[Index] > MaxBaudRate) || (mMmcBaudRates[Index] <= BaudRate)) {
+        continue;
+      }
+
+      Tried  = TRUE;
+      Status = MmcSwitchBaudRate (Framing, mMmcBaudRates[Index]);
+      if (!EFI_ERROR (Status)) {
+        BaudRate = mMmcBaudRates[Index];
+        break;
+      }
+
+      if (Status != EFI_UNSUPPORTED) {
+        Refused = FALSE;
+      }
+    }
+
+    //
+    // Remember the rate reached, or that the firmware refused them all, but
+    // not a link that merely failed at the faster rates.
+    //
+    if (Tried && ((BaudRate != DefaultRate) || Refused)) {
+      Cache.MmcVersion = Version;
+      Cache.Reserved   = 0;
+      Cache.BaudRate   = (BaudRate != DefaultRate) ? (UINT32)BaudRate : 0;
+      Link             = MmcGetLink ();
+      if (CompareMem (&Link->Cache, &Cache, sizeof (Cache)) != 0) {
+        CopyMem (&Link->Cache, &Cache, sizeof (Cache));
+        Link->CacheDirty = TRUE;
+      }
+    }
+  }
+
+  MmcEndTransaction (State);
+
+  DEBUG ((DEBUG_INFO, "%a MMC link at %lu baud\n", __FUNCTION__, BaudRate));
+  return BaudRate;
+}
+
+EFI_STATUS
+MmcResetLink (
+  VOID
+  )
+{
+  UINT8            Command[] = { MMC_IPMI_NETFN_OEM, 0x00, MMC_OEM_SET_FRAMING, MmcFramingAscii };
+  UINT64           DefaultRate;
+  UINT8            BaudCommand[] = {
+    MMC_IPMI_NETFN_OEM, 0x00, MMC_OEM_SET_BAUD_RATE,
+    (UINT8)FixedPcdGet64 (PcdSerialDbgUartBaudRate),
+    (UINT8)(FixedPcdGet64 (PcdSerialDbgUartBaudRate) >> 8),
+    (UINT8)(FixedPcdGet64 (PcdSerialDbgUartBaudRate) >> 16),
+    (UINT8)(FixedPcdGet64 (PcdSerialDbgUartBaudRate) >> 24)
+  };
+  UINT8            Response[MMC_FRAME_MAX_BYTES];
+  UINTN            ResponseSize;
+  ADLINK_MMC_LINK  *Link;
+  UINTN            State;
+  EFI_STATUS       Status;
+  EFI_STATUS       BaudStatus;
+
+  Status = MmcBeginTransaction (&State);
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+
+  //
+  // Stay in ASCII for whatever is sent until the reset, rather than
+  // negotiating again.
+  //
+  Link = MmcGetLink ();
+  if (Link->Framing == MmcFramingBinary) {
+    Status = MmcExchange (MmcFramingBinary, Command, sizeof (Command), Response, sizeof (Response), &ResponseSize);
+  }
+
+  Link->Framing = MmcFramingAscii;
+
+  //
+  // And at the rate the next boot first looks for it at. The UART follows
+  // whether or not the MMC acknowledged, as the next boot will.
+  //
+  DefaultRate = FixedPcdGet64 (PcdSerialDbgUartBaudRate);
+  if ((Link->BaudRate != 0) && (Link->BaudRate != DefaultRate)) {
+    BaudStatus = MmcExchange (MmcFramingAscii, BaudCommand, sizeof (BaudCommand), Response, sizeof (Response), &ResponseSize);
+    MicroSecondDelay (MMC_BAUD_RATE_SETTLE_US);
+    MmcSetUartBaudRate (DefaultRate);
+    if (!EFI_ERROR (Status)) {
+      Status = BaudStatus;
+    }
+  }
+
+  MmcEndTransaction (State);
+
+  return Status;
+}
+
+BOOLEAN
+MmcHoldDebugOutput (
+  IN CONST UINT8  *Buffer,
+  IN UINTN        Length
+  )
+{
+  ADLINK_MMC_LINK  *Link;
+  UINTN            Held;
+
+  Link = MmcGetLink ();
+  if (!Link->Busy) {
+    return FALSE;
+  }
+
+  Held = MIN (Length, sizeof (Link->DebugHold) - Link->DebugHeld);
+  CopyMem (&Link->DebugHold[Link->DebugHeld], Buffer, Held);
+  Link->DebugHeld += (UINT32)Held;
+
+  mMmcStatistics.DebugBytesHeld += (UINT32)Held;
+  mMmcStatistics.DebugBytesLost += (UINT32)(Length - Held);
+  return TRUE;
+}
+
+VOID
+MmcGetTransportStatistics (
+  OUT MMC_TRANSPORT_STATISTICS  *Statistics
+  )
+{
+  CopyMem (Statistics, &mMmcStatistics, sizeof (*Statistics));
+}
+
+BOOLEAN
+MmcCanSendCommand (
+  VOID
+  )
+{
+  UINT32  Control;
+
+  if (MmcGetLink ()->Busy || RETURN_ERROR (PL011UartGetControl (MMC_UART_BASE, &Control))) {
+    return FALSE;
+  }
+
+  return (BOOLEAN)((Control & EFI_SERIAL_OUTPUT_BUFFER_EMPTY) != 0);
+}
+
+BOOLEAN
+MmcCanWriteDebugOutput (
+  VOID
+  )
+{
+  if (MmcGetLink ()->Busy) {
+    return FALSE;
+  }
+
+  return (BOOLEAN)((MmioRead32 (MMC_UART_BASE + PL011_UARTFR) & PL011_UARTFR_TXFF) == 0);
+}
+
+EFI_STATUS
+MmcSendCommand (
+  IN CONST UINT8  *Command,
+  IN UINTN        CommandSize
+  )
+{
+  UINT8       Request[MMC_FRAME_MAX_BYTES];
+  MMC_FRAMING Framing;
+  UINT64      Start;
+  UINTN       State;
+  EFI_STATUS  Status;
+
+  Status = MmcBeginTransaction (&State);
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+
+  Framing = MmcGetFraming ();
+  Start   = GetPerformanceCounter ();
+  Status  = MmcWriteTaggedFrame (Framing, Command, CommandSize, Request);
+  MmcTraceRecord (Request, CommandSize, NULL, 0, Start, 0, Status);
+  MmcEndTransaction (State);
+
+  return Status;
+}
+
+EFI_STATUS
+MmcExecuteCommand (
+  IN  CONST UINT8  *Command,
+  IN  UINTN        CommandSize,
+  OUT UINT8        *Response,
+  IN  UINTN        MaxResponse,
+  OUT UINTN        *ResponseSize
+  )
+{
+  UINTN       State;
+  EFI_STATUS  Status;
+
+  Status = MmcBeginTransaction (&State);
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+
+  Status = MmcExchange (MmcGetFraming (), Command, CommandSize, Response, MaxResponse, ResponseSize);
+  MmcEndTransaction (State);
+
+  return Status;
+}
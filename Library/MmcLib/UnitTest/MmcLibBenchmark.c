@@ -0,0 +1,208 @@
+/** @file
+  Host based benchmark of the MMC Library, against the simulated MMC.
+
+  Each MmcLib call is repeated on a freshly powered simulated MMC for a few
+  link conditions, and the bytes on the wire, the modeled time and the
+  transport errors per call are printed as one table row. The figures are
+  modeled, so runs on different hosts give the same table and a protocol
+  change can be compared row by row.
+
+  Copyright (c) 2022, ADLink. All rights reserved.<BR>
+
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#include <stdio.h>
+#include "../MmcLibInternal.h"
+#include "MmcSimulator.h"
+
+typedef EFI_STATUS (*MMC_BENCH_CALL)(
+  IN UINTN  Iteration
+  );
+
+typedef struct {
+  CONST CHAR8       *Name;
+  MMC_BENCH_CALL    Call;
+  UINTN             Calls;
+} MMC_BENCH_API;
+
+typedef struct {
+  CONST CHAR8       *Name;
+  MMC_SIM_CONFIG    Config;
+  ///
+  /// Rate to negotiate up to first, 0 to stay at PcdSerialDbgUartBaudRate.
+  ///
+  UINT64            MaxBaudRate;
+} MMC_BENCH_SCENARIO;
+
+STATIC
+EFI_STATUS
+MmcBenchPostCode (
+  IN UINTN  Iteration
+  )
+{
+  return MmcPostCode ((UINT32)Iteration);
+}
+
+STATIC
+EFI_STATUS
+MmcBenchReadSensor (
+  IN UINTN  Iteration
+  )
+{
+  MMC_SENSOR_READING  Reading;
+
+  return MmcReadSensor ((MMC_SENSOR_ID)(Iteration % MmcSensorMax), &Reading);
+}
+
+STATIC
+EFI_STATUS
+MmcBenchReadSensors (
+  IN UINTN  Iteration
+  )
+{
+  MMC_SENSOR_ID       Ids[MmcSensorMax];
+  MMC_SENSOR_READING  Readings[MmcSensorMax];
+  UINTN               Index;
+
+  for (Index = 0; Index < MmcSensorMax; Index++) {
+    Ids[Index] = (MMC_SENSOR_ID)Index;
+  }
+
+  return MmcReadSensors (Ids, MmcSensorMax, Readings);
+}
+
+STATIC
+EFI_STATUS
+MmcBenchFirmwareVersion (
+  IN UINTN  Iteration
+  )
+{
+  CHAR8  Version[ADLINK_MMC_VERSION_LENGTH];
+
+  return MmcFirmwareVersion ((UINT8 *)Version, sizeof (Version));
+}
+
+STATIC CONST MMC_BENCH_API  mMmcBenchApis[] = {
+  { "MmcPostCode",        MmcBenchPostCode,        256 },
+  { "MmcReadSensor",      MmcBenchReadSensor,      64  },
+  { "MmcReadSensors",     MmcBenchReadSensors,     64  },
+  { "MmcFirmwareVersion", MmcBenchFirmwareVersion, 64  },
+};
+
+//
+// The MMC answers 500 us after a request. Every scenario has the batched
+// sensor read, which MmcLib probes once per boot and this benchmark cannot
+// reboot.
+//
+STATIC CONST MMC_BENCH_SCENARIO  mMmcBenchScenarios[] = {
+  {
+    "ASCII 57600",
+    { 57600, { 0 }, TRUE, FALSE, TRUE, FALSE, 0x0100, 500, 0, 0, 1 }, 0
+  },
+  {
+    "binary 57600",
+    { 57600, { 921600, 230400, 115200, 0 }, FALSE, TRUE, TRUE, FALSE, 0x0200, 500, 0, 0, 1 }, 0
+  },
+  {
+    "binary 921600",
+    { 57600, { 921600, 230400, 115200, 0 }, FALSE, TRUE, TRUE, FALSE, 0x0200, 500, 0, 0, 1 }, 921600
+  },
+  {
+    "binary 921600, 0.1% drops",
+    { 57600, { 921600, 230400, 115200, 0 }, FALSE, TRUE, TRUE, FALSE, 0x0200, 500, 1000, 0, 1 }, 921600
+  },
+  {
+    "binary 921600, 10% noise",
+    { 57600, { 921600, 230400, 115200, 0 }, FALSE, TRUE, TRUE, FALSE, 0x0200, 500, 0, 100, 1 }, 921600
+  },
+};
+
+/**
+  Run every API of mMmcBenchApis in one scenario and print a row for each.
+
+**/
+STATIC
+VOID
+MmcBenchRun (
+  IN CONST MMC_BENCH_SCENARIO  *Scenario
+  )
+{
+  MMC_TRANSPORT_STATISTICS  Before;
+  MMC_TRANSPORT_STATISTICS  After;
+  MMC_SIM_STATISTICS        Start;
+  MMC_SIM_STATISTICS        End;
+  UINTN                     Api;
+  UINTN                     Index;
+  UINTN                     Failed;
+  UINT64                    Bytes;
+
+  for (Api = 0; Api < ARRAY_SIZE (mMmcBenchApis); Api++) {
+    MmcSimReset (&Scenario->Config);
+    if (Scenario->MaxBaudRate != 0) {
+      MmcNegotiateBaudRate (Scenario->MaxBaudRate);
+    }
+
+    //
+    // Leave framing selection out of the figures.
+    //
+    MmcPostCode (0);
+
+    MmcGetTransportStatistics (&Before);
+    MmcSimGetStatistics (&Start);
+    Failed = 0;
+    for (Index = 0; Index < mMmcBenchApis[Api].Calls; Index++) {
+      if (EFI_ERROR (mMmcBenchApis[Api].Call (Index))) {
+        Failed++;
+      }
+    }
+
+    MmcSimGetStatistics (&End);
+    MmcGetTransportStatistics (&After);
+
+    Bytes = (UINT64)(After.BytesWritten - Before.BytesWritten) + (After.BytesRead - Before.BytesRead);
+    printf (
+      "%-26s %-19s %6u %11.1f %11.1f %8u %8u %6u\n",
+      Scenario->Name,
+      mMmcBenchApis[Api].Name,
+      (unsigned)mMmcBenchApis[Api].Calls,
+      (double)Bytes / mMmcBenchApis[Api].Calls,
+      (double)(End.NowNs - Start.NowNs) / 1000 / mMmcBenchApis[Api].Calls,
+      (unsigned)(After.Timeouts - Before.Timeouts),
+      (unsigned)(After.Resyncs - Before.Resyncs),
+      (unsigned)Failed
+      );
+  }
+}
+
+/**
+  Standard POSIX C entry point for the host based benchmark.
+
+**/
+int
+main (
+  int   argc,
+  char  *argv[]
+  )
+{
+  UINTN  Index;
+
+  printf (
+    "%-26s %-19s %6s %11s %11s %8s %8s %6s\n",
+    "Link",
+    "Call",
+    "Calls",
+    "Bytes/call",
+    "us/call",
+    "Timeouts",
+    "Resyncs",
+    "Failed"
+    );
+
+  for (Index = 0; Index < ARRAY_SIZE (mMmcBenchScenarios); Index++) {
+    MmcBenchRun (&mMmcBenchScenarios[Index]);
+  }
+
+  return 0;
+}
@@ -0,0 +1,110 @@
+/** @file
+  Host parts of the MMC Library, for the host based tests and benchmark.
+
+  The host runs one thread, so, as in PEI, the transaction busy flag of the
+  link state alone catches re-entry. The link state and the link variable
+  are plain globals, reset by the tests between simulated boots. The board
+  is a revision with MMC sensor support, and has not published its identity.
+
+  Copyright (c) 2022, ADLink. All rights reserved.<BR>
+
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#include "../MmcLibInternal.h"
+#include "MmcSimulator.h"
+
+STATIC ADLINK_MMC_LINK        mMmcHostLink;
+STATIC ADLINK_MMC_LINK_CACHE  mMmcHostCache;
+STATIC BOOLEAN                mMmcHostCacheValid;
+
+UINTN
+MmcEnterCriticalSection (
+  VOID
+  )
+{
+  return 0;
+}
+
+VOID
+MmcLeaveCriticalSection (
+  IN UINTN  State
+  )
+{
+}
+
+ADLINK_MMC_LINK *
+MmcGetLink (
+  VOID
+  )
+{
+  if (mMmcHostLink.Signature != ADLINK_MMC_LINK_SIGNATURE) {
+    ZeroMem (&mMmcHostLink, sizeof (mMmcHostLink));
+    mMmcHostLink.Signature = ADLINK_MMC_LINK_SIGNATURE;
+  }
+
+  return &mMmcHostLink;
+}
+
+BOOLEAN
+MmcReadLinkCache (
+  OUT ADLINK_MMC_LINK_CACHE  *Cache
+  )
+{
+  if (!mMmcHostCacheValid) {
+    return FALSE;
+  }
+
+  CopyMem (Cache, &mMmcHostCache, sizeof (*Cache));
+  return TRUE;
+}
+
+ADLINK_MMC_TRACE_LOG *
+MmcGetTraceLog (
+  VOID
+  )
+{
+  return NULL;
+}
+
+VOID
+MmcHostResetLink (
+  IN CONST ADLINK_MMC_LINK_CACHE  *Cache OPTIONAL
+  )
+{
+  ZeroMem (&mMmcHostLink, sizeof (mMmcHostLink));
+
+  mMmcHostCacheValid = (BOOLEAN)(Cache != NULL);
+  if (Cache != NULL) {
+    CopyMem (&mMmcHostCache, Cache, sizeof (mMmcHostCache));
+  }
+}
+
+BOOLEAN
+MmcHostGetDirtyCache (
+  OUT ADLINK_MMC_LINK_CACHE  *Cache
+  )
+{
+  ADLINK_MMC_LINK  *Link;
+
+  Link = MmcGetLink ();
+  CopyMem (Cache, &Link->Cache, sizeof (*Cache));
+  return Link->CacheDirty;
+}
+
+CONST ADLINK_BOARD_IDENTITY *
+GetBoardIdentity (
+  VOID
+  )
+{
+  return NULL;
+}
+
+UINT8
+GetFirmwareMajorVersion (
+  VOID
+  )
+{
+  return 0xA2;
+}
@@ -0,0 +1,620 @@
+/** @file
+  Host based unit tests of the MMC Library, against the simulated MMC.
+
+  Copyright (c) 2022, ADLink. All rights reserved.<BR>
+
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#include "../MmcLibInternal.h"
+#include <Library/UnitTestLib.h>
+#include "MmcSimulator.h"
+
+#define UNIT_TEST_APP_NAME     "MMC Library Unit Tests"
+#define UNIT_TEST_APP_VERSION  "1.0"
+
+#define MMC_TEST_VERSION       0x1234
+#define MMC_TEST_DEFAULT_RATE  57600
+
+//
+// Firmware answering in both framings, at every candidate rate, after 2 ms.
+//
+STATIC CONST MMC_SIM_CONFIG  mMmcTestCurrent = {
+  MMC_TEST_DEFAULT_RATE, { 921600, 230400, 115200, 0 }, FALSE, TRUE, TRUE, FALSE, MMC_TEST_VERSION, 2000, 0, 0, 1
+};
+
+//
+// Firmware knowing neither the binary framing nor other rates, and echoing
+// ASCII requests.
+//
+STATIC CONST MMC_SIM_CONFIG  mMmcTestLegacy = {
+  MMC_TEST_DEFAULT_RATE, { 0 }, TRUE, FALSE, FALSE, TRUE, MMC_TEST_VERSION, 2000, 0, 0, 1
+};
+
+//
+// Firmware doing only 115200 besides the default rate.
+//
+STATIC CONST MMC_SIM_CONFIG  mMmcTestSlow = {
+  MMC_TEST_DEFAULT_RATE, { 115200, 0 }, FALSE, TRUE, TRUE, FALSE, MMC_TEST_VERSION, 2000, 0, 0, 1
+};
+
+//
+// Current firmware also reporting the factors of its sensor data records.
+//
+STATIC CONST MMC_SIM_CONFIG  mMmcTestFactors = {
+  MMC_TEST_DEFAULT_RATE, { 921600, 230400, 115200, 0 }, FALSE, TRUE, TRUE, FALSE, MMC_TEST_VERSION, 2000, 0, 0, 1, TRUE
+};
+
+//
+// Current firmware without batched sensor reads.
+//
+STATIC CONST MMC_SIM_CONFIG  mMmcTestNoBatch = {
+  MMC_TEST_DEFAULT_RATE, { 921600, 230400, 115200, 0 }, FALSE, TRUE, FALSE, FALSE, MMC_TEST_VERSION, 2000, 0, 0, 1
+};
+
+//
+// Current firmware too busy for the first batched sensor read.
+//
+STATIC CONST MMC_SIM_CONFIG  mMmcTestBusyBatch = {
+  MMC_TEST_DEFAULT_RATE, { 921600, 230400, 115200, 0 }, FALSE, TRUE, TRUE, FALSE, MMC_TEST_VERSION, 2000, 0, 0, 1, FALSE, 1
+};
+
+//
+// Current firmware behind a line with a noise burst before every answer.
+//
+STATIC CONST MMC_SIM_CONFIG  mMmcTestNoisy = {
+  MMC_TEST_DEFAULT_RATE, { 921600, 230400, 115200, 0 }, FALSE, TRUE, TRUE, TRUE, MMC_TEST_VERSION, 2000, 0, 1000, 7
+};
+
+//
+// Current firmware behind a line losing every byte.
+//
+STATIC CONST MMC_SIM_CONFIG  mMmcTestDead = {
+  MMC_TEST_DEFAULT_RATE, { 921600, 230400, 115200, 0 }, FALSE, TRUE, TRUE, FALSE, MMC_TEST_VERSION, 2000, 1000000, 0, 1
+};
+
+/**
+  A POST code goes out as one ASCII frame to firmware without the binary
+  framing.
+
+**/
+STATIC
+UNIT_TEST_STATUS
+EFIAPI
+PostCodeAscii (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  MMC_TRANSPORT_STATISTICS  Before;
+  MMC_TRANSPORT_STATISTICS  After;
+  MMC_SIM_STATISTICS        Sim;
+
+  MmcSimReset (Context);
+
+  UT_ASSERT_NOT_EFI_ERROR (MmcPostCode (0x11));
+  MmcGetTransportStatistics (&Before);
+  UT_ASSERT_NOT_EFI_ERROR (MmcPostCode (0x5A));
+  MmcGetTransportStatistics (&After);
+  MmcSimGetStatistics (&Sim);
+
+  UT_ASSERT_EQUAL (Sim.LastPostCode, 0x5A);
+  UT_ASSERT_EQUAL (After.BytesWritten - Before.BytesWritten, sizeof ("[C0 00 80 5A]\r\n") - 1);
+  UT_ASSERT_EQUAL (MmcGetLink ()->Framing, MmcFramingAscii);
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  The binary framing is selected at first contact, and answers in it are
+  decoded.
+
+**/
+STATIC
+UNIT_TEST_STATUS
+EFIAPI
+FramingBinary (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  CHAR8    Version[ADLINK_MMC_VERSION_LENGTH];
+  UINT32   BaudRate;
+  BOOLEAN  Binary;
+
+  MmcSimReset (Context);
+
+  UT_ASSERT_NOT_EFI_ERROR (MmcFirmwareVersion ((UINT8 *)Version, sizeof (Version)));
+  UT_ASSERT_MEM_EQUAL (Version, "12.34", sizeof ("12.34"));
+  MmcSimGetMmcState (&BaudRate, &Binary);
+  UT_ASSERT_TRUE (Binary);
+  UT_ASSERT_EQUAL (MmcGetLink ()->Framing, MmcFramingBinary);
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  Noise and ASCII echoes ahead of the answers are skipped.
+
+**/
+STATIC
+UNIT_TEST_STATUS
+EFIAPI
+NoiseSkipped (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  CHAR8               Version[ADLINK_MMC_VERSION_LENGTH];
+  MMC_SIM_STATISTICS  Sim;
+  UINTN               Index;
+
+  MmcSimReset (Context);
+
+  for (Index = 0; Index < 16; Index++) {
+    UT_ASSERT_NOT_EFI_ERROR (MmcFirmwareVersion ((UINT8 *)Version, sizeof (Version)));
+    UT_ASSERT_MEM_EQUAL (Version, "12.34", sizeof ("12.34"));
+  }
+
+  MmcSimGetStatistics (&Sim);
+  UT_ASSERT_NOT_EQUAL (Sim.NoiseBytes, 0);
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  A command without answer times out after MMC_COMMAND_TIMEOUT_US.
+
+**/
+STATIC
+UNIT_TEST_STATUS
+EFIAPI
+NoAnswer (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  CHAR8                     Version[ADLINK_MMC_VERSION_LENGTH];
+  MMC_TRANSPORT_STATISTICS  Before;
+  MMC_TRANSPORT_STATISTICS  After;
+  MMC_SIM_STATISTICS        Start;
+  MMC_SIM_STATISTICS        End;
+
+  MmcSimReset (Context);
+
+  MmcGetTransportStatistics (&Before);
+  MmcSimGetStatistics (&Start);
+  UT_ASSERT_STATUS_EQUAL (MmcFirmwareVersion ((UINT8 *)Version, sizeof (Version)), EFI_NO_RESPONSE);
+  MmcSimGetStatistics (&End);
+  MmcGetTransportStatistics (&After);
+
+  //
+  // Framing selection and the version query.
+  //
+  UT_ASSERT_EQUAL (After.Timeouts - Before.Timeouts, 2);
+  UT_ASSERT_TRUE (End.NowNs - Start.NowNs >= 2ULL * MMC_COMMAND_TIMEOUT_US * 1000);
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  The fastest rate is negotiated and remembered, and MmcResetLink () brings
+  the MMC back to the rate and framing it powers on in.
+
+**/
+STATIC
+UNIT_TEST_STATUS
+EFIAPI
+NegotiateAndReset (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  ADLINK_MMC_LINK_CACHE  Cache;
+  MMC_SIM_STATISTICS     Sim;
+  UINT32                 BaudRate;
+  BOOLEAN                Binary;
+
+  MmcSimReset (Context);
+
+  UT_ASSERT_EQUAL (MmcNegotiateBaudRate (921600), 921600);
+  MmcSimGetMmcState (&BaudRate, &Binary);
+  UT_ASSERT_EQUAL (BaudRate, 921600);
+  UT_ASSERT_TRUE (MmcHostGetDirtyCache (&Cache));
+  UT_ASSERT_EQUAL (Cache.MmcVersion, MMC_TEST_VERSION);
+  UT_ASSERT_EQUAL (Cache.BaudRate, 921600);
+
+  UT_ASSERT_NOT_EFI_ERROR (MmcPostCode (0x42));
+  UT_ASSERT_NOT_EFI_ERROR (MmcResetLink ());
+  MmcSimGetMmcState (&BaudRate, &Binary);
+  UT_ASSERT_EQUAL (BaudRate, MMC_TEST_DEFAULT_RATE);
+  UT_ASSERT_FALSE (Binary);
+
+  MmcSimGetStatistics (&Sim);
+  UT_ASSERT_EQUAL (Sim.LastPostCode, 0x42);
+  UT_ASSERT_EQUAL (Sim.MisclockedBytes, 0);
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  An MMC left at a faster rate by a boot ending without MmcResetLink () is
+  found and kept there.
+
+**/
+STATIC
+UNIT_TEST_STATUS
+EFIAPI
+RebootWithoutReset (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  CHAR8               Version[ADLINK_MMC_VERSION_LENGTH];
+  MMC_SIM_STATISTICS  Sim;
+  UINT32              BaudRequests;
+
+  MmcSimReset (Context);
+
+  UT_ASSERT_EQUAL (MmcNegotiateBaudRate (921600), 921600);
+  MmcSimGetStatistics (&Sim);
+  BaudRequests = Sim.BaudRequests;
+
+  MmcSimRebootHost (NULL);
+  UT_ASSERT_EQUAL (MmcNegotiateBaudRate (921600), 921600);
+  UT_ASSERT_NOT_EFI_ERROR (MmcFirmwareVersion ((UINT8 *)Version, sizeof (Version)));
+
+  MmcSimGetStatistics (&Sim);
+  UT_ASSERT_EQUAL (Sim.BaudRequests, BaudRequests);
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  Firmware leaving SET_BAUD_RATE unanswered gets no recovery frame at a
+  rate it does not run at, and later boots of the same firmware do not ask
+  again.
+
+**/
+STATIC
+UNIT_TEST_STATUS
+EFIAPI
+BaudRateIgnored (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  ADLINK_MMC_LINK_CACHE  Cache;
+  MMC_SIM_STATISTICS     Sim;
+  UINT32                 BaudRequests;
+
+  MmcSimReset (Context);
+
+  UT_ASSERT_EQUAL (MmcNegotiateBaudRate (921600), MMC_TEST_DEFAULT_RATE);
+  MmcSimGetStatistics (&Sim);
+  UT_ASSERT_EQUAL (Sim.MisclockedBytes, 0);
+  UT_ASSERT_TRUE (MmcHostGetDirtyCache (&Cache));
+  UT_ASSERT_EQUAL (Cache.MmcVersion, MMC_TEST_VERSION);
+  UT_ASSERT_EQUAL (Cache.BaudRate, 0);
+
+  BaudRequests = Sim.BaudRequests;
+  MmcSimRebootHost (&Cache);
+  UT_ASSERT_EQUAL (MmcNegotiateBaudRate (921600), MMC_TEST_DEFAULT_RATE);
+  MmcSimGetStatistics (&Sim);
+  UT_ASSERT_EQUAL (Sim.BaudRequests, BaudRequests);
+  UT_ASSERT_FALSE (MmcHostGetDirtyCache (&Cache));
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  Refused rates are skipped, and later boots start at the rate reached.
+
+**/
+STATIC
+UNIT_TEST_STATUS
+EFIAPI
+BaudRateRefused (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  ADLINK_MMC_LINK_CACHE  Cache;
+  MMC_SIM_STATISTICS     Sim;
+  UINT32                 BaudRequests;
+
+  MmcSimReset (Context);
+
+  UT_ASSERT_EQUAL (MmcNegotiateBaudRate (921600), 115200);
+  UT_ASSERT_TRUE (MmcHostGetDirtyCache (&Cache));
+  UT_ASSERT_EQUAL (Cache.BaudRate, 115200);
+  UT_ASSERT_NOT_EFI_ERROR (MmcResetLink ());
+
+  MmcSimGetStatistics (&Sim);
+  BaudRequests = Sim.BaudRequests;
+  MmcSimRebootHost (&Cache);
+  UT_ASSERT_EQUAL (MmcNegotiateBaudRate (921600), 115200);
+  MmcSimGetStatistics (&Sim);
+  UT_ASSERT_EQUAL (Sim.BaudRequests - BaudRequests, 1);
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  Sensors are read with one request when the firmware supports it, once
+  their factors are known.
+
+**/
+STATIC
+UNIT_TEST_STATUS
+EFIAPI
+SensorsBatched (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  MMC_SENSOR_ID       Ids[MmcSensorMax];
+  MMC_SENSOR_READING  Readings[MmcSensorMax];
+  MMC_SIM_STATISTICS  Sim;
+  UINT32              Requests;
+  UINTN               Index;
+
+  MmcSimReset (Context);
+
+  for (Index = 0; Index < MmcSensorMax; Index++) {
+    Ids[Index] = (MMC_SENSOR_ID)Index;
+  }
+
+  UT_ASSERT_NOT_EFI_ERROR (MmcReadSensors (Ids, MmcSensorMax, Readings));
+  MmcSimGetStatistics (&Sim);
+  Requests = Sim.Requests;
+
+  UT_ASSERT_NOT_EFI_ERROR (MmcReadSensors (Ids, MmcSensorMax, Readings));
+  MmcSimGetStatistics (&Sim);
+  UT_ASSERT_EQUAL (Sim.Requests - Requests, 1);
+  UT_ASSERT_EQUAL (Readings[MmcSensorP12V].Raw, 0x02 * 7);
+  UT_ASSERT_EQUAL (Readings[MmcSensorCpuTemp].Value, 0x0C * 7 * 1000);
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  Firmware refusing batched reads has its sensors read one by one, and is
+  not asked for a batch again.
+
+**/
+STATIC
+UNIT_TEST_STATUS
+EFIAPI
+SensorsFallback (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  MMC_SENSOR_ID       Ids[MmcSensorMax];
+  MMC_SENSOR_READING  Readings[MmcSensorMax];
+  MMC_SIM_STATISTICS  Sim;
+  UINT32              Requests;
+  UINTN               Index;
+
+  MmcSimReset (Context);
+
+  for (Index = 0; Index < MmcSensorMax; Index++) {
+    Ids[Index] = (MMC_SENSOR_ID)Index;
+  }
+
+  UT_ASSERT_NOT_EFI_ERROR (MmcReadSensors (Ids, MmcSensorMax, Readings));
+  UT_ASSERT_EQUAL (Readings[MmcSensorP12V].Raw, 0x02 * 7);
+  UT_ASSERT_EQUAL (Readings[MmcSensorCpuTemp].Value, 0x0C * 7 * 1000);
+  MmcSimGetStatistics (&Sim);
+  UT_ASSERT_EQUAL (Sim.BatchRequests, 1);
+  Requests = Sim.Requests;
+
+  UT_ASSERT_NOT_EFI_ERROR (MmcReadSensors (Ids, MmcSensorMax, Readings));
+  MmcSimGetStatistics (&Sim);
+  UT_ASSERT_EQUAL (Sim.BatchRequests, 1);
+  UT_ASSERT_EQUAL (Sim.Requests - Requests, MmcSensorMax);
+  UT_ASSERT_EQUAL (Readings[MmcSensorP12V].Raw, 0x02 * 7);
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  A batched read the MMC is too busy for falls back to single reads for
+  that call only; the next call batches again.
+
+**/
+STATIC
+UNIT_TEST_STATUS
+EFIAPI
+SensorsBatchTransient (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  MMC_SENSOR_ID       Ids[MmcSensorMax];
+  MMC_SENSOR_READING  Readings[MmcSensorMax];
+  MMC_SIM_STATISTICS  Sim;
+  UINT32              Requests;
+  UINTN               Index;
+
+  MmcSimReset (Context);
+
+  for (Index = 0; Index < MmcSensorMax; Index++) {
+    Ids[Index] = (MMC_SENSOR_ID)Index;
+  }
+
+  UT_ASSERT_NOT_EFI_ERROR (MmcReadSensors (Ids, MmcSensorMax, Readings));
+  UT_ASSERT_EQUAL (Readings[MmcSensorP12V].Raw, 0x02 * 7);
+  MmcSimGetStatistics (&Sim);
+  UT_ASSERT_EQUAL (Sim.BatchRequests, 1);
+  Requests = Sim.Requests;
+
+  UT_ASSERT_NOT_EFI_ERROR (MmcReadSensors (Ids, MmcSensorMax, Readings));
+  MmcSimGetStatistics (&Sim);
+  UT_ASSERT_EQUAL (Sim.BatchRequests, 2);
+  UT_ASSERT_EQUAL (Sim.Requests - Requests, 1);
+  UT_ASSERT_EQUAL (Readings[MmcSensorCpuTemp].Value, 0x0C * 7 * 1000);
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  Readings are converted with the factors the MMC reports, which are asked
+  for once.
+
+**/
+STATIC
+UNIT_TEST_STATUS
+EFIAPI
+SensorFactors (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  MMC_SENSOR_READING  Reading;
+  MMC_SIM_STATISTICS  Sim;
+  UINT32              Requests;
+  INT32               Expected;
+
+  MmcSimReset (Context);
+
+  //
+  // (39 * Raw - 5 * 10^1) * 10^-2 volts, in millivolts.
+  //
+  Expected = (MMC_SIM_FACTOR_M * 0x02 * 7 + MMC_SIM_FACTOR_B * 10) * 10;
+  UT_ASSERT_NOT_EFI_ERROR (MmcReadSensor (MmcSensorP12V, &Reading));
+  UT_ASSERT_EQUAL (Reading.Value, Expected);
+
+  MmcSimGetStatistics (&Sim);
+  Requests = Sim.Requests;
+  UT_ASSERT_NOT_EFI_ERROR (MmcReadSensor (MmcSensorP12V, &Reading));
+  UT_ASSERT_EQUAL (Reading.Value, Expected);
+  MmcSimGetStatistics (&Sim);
+  UT_ASSERT_EQUAL (Sim.Requests - Requests, 1);
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  Firmware refusing Get Sensor Reading Factors gets the nominal factors,
+  and is not asked again.
+
+**/
+STATIC
+UNIT_TEST_STATUS
+EFIAPI
+SensorFactorsNominal (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  MMC_SENSOR_READING  Reading;
+  MMC_SIM_STATISTICS  Sim;
+  UINT32              Requests;
+
+  MmcSimReset (Context);
+
+  UT_ASSERT_NOT_EFI_ERROR (MmcReadSensor (MmcSensorP12V, &Reading));
+  UT_ASSERT_EQUAL (Reading.Value, 80 * 0x02 * 7);
+
+  MmcSimGetStatistics (&Sim);
+  Requests = Sim.Requests;
+  UT_ASSERT_NOT_EFI_ERROR (MmcReadSensor (MmcSensorP12V, &Reading));
+  MmcSimGetStatistics (&Sim);
+  UT_ASSERT_EQUAL (Sim.Requests - Requests, 1);
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  The legacy accessors copy BufferSize bytes of the ASCII reply from the
+  reading byte on, without terminating NUL.
+
+**/
+STATIC
+UNIT_TEST_STATUS
+EFIAPI
+LegacyReading (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  UINT8  Buffer[16];
+
+  MmcSimReset (Context);
+
+  SetMem (Buffer, sizeof (Buffer), 0x55);
+  UT_ASSERT_NOT_EFI_ERROR (IPMI_P12V_Sensor_Reading (Buffer, 2));
+  UT_ASSERT_MEM_EQUAL (Buffer, "0E", 2);
+  UT_ASSERT_EQUAL (Buffer[2], 0x55);
+
+  SetMem (Buffer, sizeof (Buffer), 0x55);
+  UT_ASSERT_NOT_EFI_ERROR (IPMI_P12V_Sensor_Reading (Buffer, sizeof (Buffer)));
+  UT_ASSERT_MEM_EQUAL (Buffer, "0E C0 00]\r\n", sizeof ("0E C0 00]\r\n") - 1);
+  UT_ASSERT_EQUAL (Buffer[sizeof ("0E C0 00]\r\n") - 1], 0x55);
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  Initialize the unit test framework, suite, and unit tests for the MMC
+  Library and run them.
+
+  @retval EFI_SUCCESS           All test cases were dispatched.
+  @retval EFI_OUT_OF_RESOURCES  There are not enough resources available to
+                                initialize the unit tests.
+**/
+STATIC
+EFI_STATUS
+EFIAPI
+UnitTestingEntry (
+  VOID
+  )
+{
+  EFI_STATUS                  Status;
+  UNIT_TEST_FRAMEWORK_HANDLE  Framework;
+  UNIT_TEST_SUITE_HANDLE      Transport;
+  UNIT_TEST_SUITE_HANDLE      BaudRate;
+  UNIT_TEST_SUITE_HANDLE      Sensors;
+
+  Framework = NULL;
+
+  DEBUG ((DEBUG_INFO, "%a v%a\n", UNIT_TEST_APP_NAME, UNIT_TEST_APP_VERSION));
+
+  Status = InitUnitTestFramework (&Framework, UNIT_TEST_APP_NAME, gEfiCallerBaseName, UNIT_TEST_APP_VERSION);
+  if (EFI_ERROR (Status)) {
+    DEBUG ((DEBUG_ERROR, "Failed in InitUnitTestFramework. Status = %r\n", Status));
+    goto EXIT;
+  }
+
+  Status = CreateUnitTestSuite (&Transport, Framework, "MMC transport", "MmcLib.Transport", NULL, NULL);
+  if (EFI_ERROR (Status)) {
+    Status = EFI_OUT_OF_RESOURCES;
+    goto EXIT;
+  }
+
+  AddTestCase (Transport, "POST code in ASCII framing", "PostCodeAscii", PostCodeAscii, NULL, NULL, (VOID *)&mMmcTestLegacy);
+  AddTestCase (Transport, "Binary framing at first contact", "FramingBinary", FramingBinary, NULL, NULL, (VOID *)&mMmcTestCurrent);
+  AddTestCase (Transport, "Noise before answers is skipped", "NoiseSkipped", NoiseSkipped, NULL, NULL, (VOID *)&mMmcTestNoisy);
+  AddTestCase (Transport, "Lost answers time out", "NoAnswer", NoAnswer, NULL, NULL, (VOID *)&mMmcTestDead);
+
+  Status = CreateUnitTestSuite (&BaudRate, Framework, "MMC baud rate", "MmcLib.BaudRate", NULL, NULL);
+  if (EFI_ERROR (Status)) {
+    Status = EFI_OUT_OF_RESOURCES;
+    goto EXIT;
+  }
+
+  AddTestCase (BaudRate, "Negotiate, then reset the link", "NegotiateAndReset", NegotiateAndReset, NULL, NULL, (VOID *)&mMmcTestCurrent);
+  AddTestCase (BaudRate, "MMC left at a faster rate", "RebootWithoutReset", RebootWithoutReset, NULL, NULL, (VOID *)&mMmcTestCurrent);
+  AddTestCase (BaudRate, "Firmware without SET_BAUD_RATE", "BaudRateIgnored", BaudRateIgnored, NULL, NULL, (VOID *)&mMmcTestLegacy);
+  AddTestCase (BaudRate, "Firmware refusing faster rates", "BaudRateRefused", BaudRateRefused, NULL, NULL, (VOID *)&mMmcTestSlow);
+
+  Status = CreateUnitTestSuite (&Sensors, Framework, "MMC sensors", "MmcLib.Sensors", NULL, NULL);
+  if (EFI_ERROR (Status)) {
+    Status = EFI_OUT_OF_RESOURCES;
+    goto EXIT;
+  }
+
+  AddTestCase (Sensors, "Batched sensor read", "SensorsBatched", SensorsBatched, NULL, NULL, (VOID *)&mMmcTestCurrent);
+  AddTestCase (Sensors, "Single reads without batches", "SensorsFallback", SensorsFallback, NULL, NULL, (VOID *)&mMmcTestNoBatch);
+  AddTestCase (Sensors, "Busy MMC is asked again", "SensorsBatchTransient", SensorsBatchTransient, NULL, NULL, (VOID *)&mMmcTestBusyBatch);
+  AddTestCase (Sensors, "Factors reported by the MMC", "SensorFactors", SensorFactors, NULL, NULL, (VOID *)&mMmcTestFactors);
+  AddTestCase (Sensors, "Nominal factors", "SensorFactorsNominal", SensorFactorsNominal, NULL, NULL, (VOID *)&mMmcTestCurrent);
+  AddTestCase (Sensors, "Legacy accessors copy the reply", "LegacyReading", LegacyReading, NULL, NULL, (VOID *)&mMmcTestCurrent);
+
+  Status = RunAllTestSuites (Framework);
+
+EXIT:
+  if (Framework != NULL) {
+    FreeUnitTestFramework (Framework);
+  }
+
+  return Status;
+}
+
+/**
+  Standard POSIX C entry point for host based unit test execution.
+
+**/
+int
+main (
+  int   argc,
+  char  *argv[]
+  )
+{
+  return UnitTestingEntry ();
+}
@@ -0,0 +1,770 @@
+/** @file
+  Simulated MMC for the host based build of the MMC Library.
+
+  The host UART has a transmit FIFO, written bytes leave one byte time
+  apart at the host rate. The MMC parses requests in either framing as
+  their bytes arrive and queues its answer on the receive line, one byte
+  time apart at its own rate, after its answer delay. Bytes sent while both
+  ends run at different rates arrive as noise. Drops and noise bursts come
+  from a seeded generator, so a run is repeatable.
+
+  Copyright (c) 2022, ADLink. All rights reserved.<BR>
+
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#include "../MmcLibInternal.h"
+#include "MmcSimulator.h"
+
+//
+// Host UART transmit FIFO depth, and bytes the receive line holds.
+//
+#define MMC_SIM_TX_FIFO_DEPTH  32
+#define MMC_SIM_RX_LINE_BYTES  4096
+
+//
+// Modeled cost of one performance counter read, which bounds every polling
+// loop, and of the MMC reprogramming its UART after acknowledging a rate.
+//
+#define MMC_SIM_POLL_NS        1000
+#define MMC_SIM_SWITCH_NS      (100 * 1000)
+
+//
+// Longest burst of line noise, and bits per byte on the wire, 8N1.
+//
+#define MMC_SIM_NOISE_BYTES    8
+#define MMC_SIM_BITS_PER_BYTE  10
+
+//
+// The performance counter counts modeled nanoseconds.
+//
+#define MMC_SIM_COUNTER_HZ     1000000000ULL
+
+typedef enum {
+  MmcSimParseIdle = 0,
+  MmcSimParseAscii,
+  MmcSimParseBinaryLength,
+  MmcSimParseBinaryBytes
+} MMC_SIM_PARSE_STATE;
+
+typedef struct {
+  UINT64    At;
+  UINT8     Byte;
+} MMC_SIM_LINE_BYTE;
+
+STATIC MMC_SIM_CONFIG      mSimConfig;
+STATIC MMC_SIM_STATISTICS  mSimStatistics;
+STATIC UINT64              mSimNow;
+STATIC UINT32              mSimRandom;
+
+//
+// Host UART.
+//
+STATIC UINT64             mSimHostBaudRate;
+STATIC UINT64             mSimHostTxFreeAt;
+STATIC UINT64             mSimHostTxDone[MMC_SIM_TX_FIFO_DEPTH];
+STATIC UINTN              mSimHostTxNext;
+STATIC MMC_SIM_LINE_BYTE  mSimRxLine[MMC_SIM_RX_LINE_BYTES];
+STATIC UINTN              mSimRxHead;
+STATIC UINTN              mSimRxCount;
+
+//
+// MMC.
+//
+STATIC UINT64               mSimMmcBaudRate;
+STATIC UINT64               mSimMmcPendingBaudRate;
+STATIC UINT64               mSimMmcPendingAt;
+STATIC UINT64               mSimMmcTxFreeAt;
+STATIC BOOLEAN              mSimMmcBinary;
+STATIC MMC_SIM_PARSE_STATE  mSimParseState;
+STATIC UINT8                mSimParseBytes[MMC_FRAME_MAX_BYTES];
+STATIC UINTN                mSimParseCount;
+STATIC UINTN                mSimParseLength;
+STATIC UINT8                mSimParseValue;
+STATIC UINTN                mSimParseDigits;
+STATIC CHAR8                mSimParseEcho[MMC_FRAME_MAX_BYTES * 3 + 4];
+STATIC UINTN                mSimParseEchoLength;
+
+/**
+  Return the next value of the xorshift generator.
+
+**/
+STATIC
+UINT32
+MmcSimRandom (
+  VOID
+  )
+{
+  mSimRandom ^= mSimRandom << 13;
+  mSimRandom ^= mSimRandom >> 17;
+  mSimRandom ^= mSimRandom << 5;
+  return mSimRandom;
+}
+
+/**
+  Return TRUE with the given probability, in parts per million.
+
+**/
+STATIC
+BOOLEAN
+MmcSimChance (
+  IN UINT32  PerMillion
+  )
+{
+  return (BOOLEAN)((PerMillion != 0) && ((MmcSimRandom () % 1000000) < PerMillion));
+}
+
+/**
+  Return the time one byte takes on the wire at BaudRate.
+
+**/
+STATIC
+UINT64
+MmcSimByteNs (
+  IN UINT64  BaudRate
+  )
+{
+  return DivU64x64Remainder (MMC_SIM_BITS_PER_BYTE * MMC_SIM_COUNTER_HZ, BaudRate, NULL);
+}
+
+/**
+  Return the rate the MMC runs at, at time At.
+
+**/
+STATIC
+UINT64
+MmcSimMmcBaudRateAt (
+  IN UINT64  At
+  )
+{
+  if ((mSimMmcPendingBaudRate != 0) && (At >= mSimMmcPendingAt)) {
+    mSimMmcBaudRate        = mSimMmcPendingBaudRate;
+    mSimMmcPendingBaudRate = 0;
+  }
+
+  return mSimMmcBaudRate;
+}
+
+/**
+  Update a CRC-8 with polynomial x^8 + x^2 + x + 1, as the MMC does.
+
+**/
+STATIC
+UINT8
+MmcSimCrc8 (
+  IN UINT8        Crc,
+  IN CONST UINT8  *Data,
+  IN UINTN        Length
+  )
+{
+  UINTN  Bit;
+
+  while (Length-- != 0) {
+    Crc ^= *Data++;
+    for (Bit = 0; Bit < 8; Bit++) {
+      Crc = (UINT8)((Crc & 0x80) != 0 ? (Crc << 1) ^ 0x07 : (Crc << 1));
+    }
+  }
+
+  return Crc;
+}
+
+/**
+  Put bytes from the MMC on the receive line of the host, the first one
+  leaving no earlier than Ready.
+
+  @param[in] Bytes   The bytes.
+  @param[in] Length  Number of bytes.
+  @param[in] Ready   Time the MMC has them ready.
+  @param[in] Noise   The bytes are line noise.
+
+**/
+STATIC
+VOID
+MmcSimMmcSend (
+  IN CONST UINT8  *Bytes,
+  IN UINTN        Length,
+  IN UINT64       Ready,
+  IN BOOLEAN      Noise
+  )
+{
+  UINT64  At;
+  UINT64  ByteNs;
+  UINTN   Index;
+  UINT8   Byte;
+
+  At     = MAX (Ready, mSimMmcTxFreeAt);
+  ByteNs = MmcSimByteNs (MmcSimMmcBaudRateAt (At));
+  for (Index = 0; Index < Length; Index++) {
+    At += ByteNs;
+    mSimStatistics.BytesFromMmc++;
+    if (Noise) {
+      mSimStatistics.NoiseBytes++;
+    }
+
+    if (MmcSimChance (mSimConfig.DropPerMillion) || (mSimRxCount == MMC_SIM_RX_LINE_BYTES)) {
+      mSimStatistics.BytesDropped++;
+      continue;
+    }
+
+    Byte = Bytes[Index];
+    if (mSimHostBaudRate != mSimMmcBaudRate) {
+      Byte = (UINT8)MmcSimRandom ();
+      mSimStatistics.MisclockedBytes++;
+    }
+
+    mSimRxLine[(mSimRxHead + mSimRxCount) % MMC_SIM_RX_LINE_BYTES].At   = At;
+    mSimRxLine[(mSimRxHead + mSimRxCount) % MMC_SIM_RX_LINE_BYTES].Byte = Byte;
+    mSimRxCount++;
+  }
+
+  mSimMmcTxFreeAt = At;
+}
+
+/**
+  Answer a request received in full at time At.
+
+  @param[in] Request  The request, starting with the NetFn.
+  @param[in] Length   Number of request bytes.
+  @param[in] Ascii    The request came in ASCII framing.
+  @param[in] At       Time its last byte arrived.
+
+**/
+STATIC
+VOID
+MmcSimAnswer (
+  IN CONST UINT8  *Request,
+  IN UINTN        Length,
+  IN BOOLEAN      Ascii,
+  IN UINT64       At
+  )
+{
+  UINT8    Response[MMC_FRAME_MAX_BYTES];
+  UINT8    Frame[MMC_FRAME_MAX_BYTES * 3 + 4];
+  UINT8    Noise[MMC_SIM_NOISE_BYTES];
+  UINTN    Size;
+  UINTN    FrameLength;
+  UINTN    Index;
+  UINT32   BaudRate;
+  UINT64   Ready;
+  BOOLEAN  Binary;
+
+  mSimStatistics.Requests++;
+  if (Length < 3) {
+    return;
+  }
+
+  Ready = At + MultU64x32 (mSimConfig.ResponseDelayUs, 1000);
+  if (Ascii && mSimConfig.EchoesAscii) {
+    MmcSimMmcSend ((UINT8 *)mSimParseEcho, mSimParseEchoLength, At, FALSE);
+  }
+
+  Response[0] = MMC_IPMI_RESPONSE_NETFN (Request[0]);
+  Response[1] = Request[1];
+  Response[2] = Request[2];
+  Response[3] = MMC_IPMI_CC_SUCCESS;
+  Size        = MMC_IPMI_RESPONSE_DATA;
+  Binary      = mSimMmcBinary;
+  BaudRate    = 0;
+
+  if ((Request[0] == MMC_IPMI_NETFN_APP) && (Request[2] == MMC_IPMI_GET_DEVICE_ID)) {
+    //
+    // Device ID, revisions, IPMI version, support, manufacturer, product,
+    // and the MMC version in the last two auxiliary revision bytes.
+    //
+    ZeroMem (&Response[Size], MMC_DEVICE_ID_RESPONSE_SIZE - Size);
+    Response[Size]                      = 0x20;
+    Response[Size + 4]                  = 0x02;
+    Response[MMC_DEVICE_ID_VERSION]     = (UINT8)(mSimConfig.Version >> 8);
+    Response[MMC_DEVICE_ID_VERSION + 1] = (UINT8)mSimConfig.Version;
+    Size                                = MMC_DEVICE_ID_RESPONSE_SIZE;
+  } else if ((Request[0] == MMC_IPMI_NETFN_SENSOR) && (Request[2] == MMC_IPMI_GET_SENSOR_READING) && (Length == 4)) {
+    Response[Size++] = (UINT8)(Request[3] * 7);
+    Response[Size++] = 0xC0;
+    Response[Size++] = 0x00;
+  } else if ((Request[0] == MMC_IPMI_NETFN_SENSOR) && (Request[2] == MMC_IPMI_GET_SENSOR_FACTORS) &&
+             (Length == 5) && mSimConfig.ReportsFactors)
+  {
+    //
+    // Next reading, M and B as 10 bit two's complement with their upper
+    // bits on top of the tolerance and accuracy, then the 4 bit exponents.
+    //
+    Response[Size++] = 0xFF;
+    Response[Size++] = (UINT8)MMC_SIM_FACTOR_M;
+    Response[Size++] = (UINT8)(((MMC_SIM_FACTOR_M >> 8) & 0x03) << 6);
+    Response[Size++] = (UINT8)MMC_SIM_FACTOR_B;
+    Response[Size++] = (UINT8)(((MMC_SIM_FACTOR_B >> 8) & 0x03) << 6);
+    Response[Size++] = 0x00;
+    Response[Size++] = (UINT8)(((MMC_SIM_FACTOR_REXP & 0x0F) << 4) | (MMC_SIM_FACTOR_BEXP & 0x0F));
+  } else if (Request[0] != MMC_IPMI_NETFN_OEM) {
+    Response[3] = 0xC1;
+  } else {
+    switch (Request[2]) {
+      case MMC_OEM_POST_CODE:
+        mSimStatistics.LastPostCode = (Length > 3) ? Request[3] : 0;
+        return;
+
+      case MMC_OEM_GET_SENSOR_READINGS:
+        mSimStatistics.BatchRequests++;
+        if (!mSimConfig.SupportsBatch || (Length < 4) || (Length != 4 + (UINTN)Request[3])) {
+          Response[3] = MMC_IPMI_CC_INVALID_COMMAND;
+          break;
+        }
+
+        if (mSimStatistics.BatchRequests <= mSimConfig.BusyBatches) {
+          Response[3] = 0xC0;
+          break;
+        }
+
+        for (Index = 0; Index < Request[3]; Index++) {
+          Response[Size++] = (UINT8)(Request[4 + Index] * 7);
+        }
+
+        break;
+
+      case MMC_OEM_SET_FRAMING:
+        if ((Length != 4) || ((Request[3] == MmcFramingBinary) && !mSimConfig.SupportsBinary)) {
+          Response[3] = 0xC1;
+          break;
+        }
+
+        Binary = (BOOLEAN)(Request[3] == MmcFramingBinary);
+        break;
+
+      case MMC_OEM_SET_BAUD_RATE:
+        mSimStatistics.BaudRequests++;
+        if (mSimConfig.IgnoresBaudRate) {
+          return;
+        }
+
+        Response[3] = 0xCC;
+        if (Length == 7) {
+          BaudRate = Request[3] | (Request[4] << 8) | (Request[5] << 16) | ((UINT32)Request[6] << 24);
+          if (BaudRate == FixedPcdGet64 (PcdSerialDbgUartBaudRate)) {
+            Response[3] = MMC_IPMI_CC_SUCCESS;
+          }
+
+          for (Index = 0; Index < MMC_SIM_MAX_RATES; Index++) {
+            if ((mSimConfig.Rates[Index] != 0) && (mSimConfig.Rates[Index] == BaudRate)) {
+              Response[3] = MMC_IPMI_CC_SUCCESS;
+            }
+          }
+        }
+
+        if (Response[3] != MMC_IPMI_CC_SUCCESS) {
+          BaudRate = 0;
+        }
+
+        break;
+
+      default:
+        Response[3] = 0xC1;
+        break;
+    }
+  }
+
+  if (mSimMmcBinary) {
+    Frame[0] = MMC_BINARY_SOF;
+    Frame[1] = (UINT8)Size;
+    CopyMem (&Frame[2], Response, Size);
+    Frame[2 + Size] = MmcSimCrc8 (0, &Frame[1], Size + 1);
+    FrameLength     = Size + MMC_BINARY_OVERHEAD;
+  } else {
+    FrameLength = 0;
+    for (Index = 0; Index < Size; Index++) {
+      FrameLength += AsciiSPrint (
+                       (CHAR8 *)Frame + FrameLength,
+                       sizeof (Frame) - FrameLength,
+                       (Index == 0) ? "[%02X" : " %02X",
+                       Response[Index]
+                       );
+    }
+
+    FrameLength += AsciiSPrint ((CHAR8 *)Frame + FrameLength, sizeof (Frame) - FrameLength, "]" MMC_ASCII_TERMINATOR);
+  }
+
+  if (MmcSimChance (mSimConfig.GarbagePerThousand * 1000)) {
+    for (Index = 0; Index < ARRAY_SIZE (Noise); Index++) {
+      Noise[Index] = (UINT8)MmcSimRandom ();
+    }
+
+    MmcSimMmcSend (Noise, 1 + MmcSimRandom () % ARRAY_SIZE (Noise), Ready, TRUE);
+  }
+
+  MmcSimMmcSend (Frame, FrameLength, Ready, FALSE);
+
+  //
+  // The answer goes out in the old framing and at the old rate, the MMC
+  // switches right after it.
+  //
+  mSimMmcBinary = Binary;
+  if (BaudRate != 0) {
+    mSimMmcPendingBaudRate = BaudRate;
+    mSimMmcPendingAt       = mSimMmcTxFreeAt + MMC_SIM_SWITCH_NS;
+  }
+}
+
+/**
+  Feed one byte arriving at the MMC at time At to its request parser.
+
+**/
+STATIC
+VOID
+MmcSimMmcReceive (
+  IN UINT8   Byte,
+  IN UINT64  At
+  )
+{
+  UINT8  Digit;
+
+  switch (mSimParseState) {
+    case MmcSimParseIdle:
+      if (Byte == '[') {
+        mSimParseState      = MmcSimParseAscii;
+        mSimParseCount      = 0;
+        mSimParseDigits     = 0;
+        mSimParseValue      = 0;
+        mSimParseEcho[0]    = '[';
+        mSimParseEchoLength = 1;
+      } else if (Byte == MMC_BINARY_SOF) {
+        mSimParseState = MmcSimParseBinaryLength;
+      }
+
+      return;
+
+    case MmcSimParseAscii:
+      if (mSimParseEchoLength < sizeof (mSimParseEcho) - 2) {
+        mSimParseEcho[mSimParseEchoLength++] = (CHAR8)Byte;
+      }
+
+      if ((Byte == ' ') || (Byte == ']')) {
+        if ((mSimParseDigits == 2) && (mSimParseCount < MMC_FRAME_MAX_BYTES)) {
+          mSimParseBytes[mSimParseCount++] = mSimParseValue;
+        } else if (mSimParseDigits != 0) {
+          mSimParseState = MmcSimParseIdle;
+          return;
+        }
+
+        mSimParseDigits = 0;
+        mSimParseValue  = 0;
+        if (Byte == ']') {
+          mSimParseState                       = MmcSimParseIdle;
+          mSimParseEcho[mSimParseEchoLength++] = '\r';
+          mSimParseEcho[mSimParseEchoLength++] = '\n';
+          MmcSimAnswer (mSimParseBytes, mSimParseCount, TRUE, At);
+        }
+
+        return;
+      }
+
+      Digit = (UINT8)(((Byte >= '0') && (Byte <= '9')) ? Byte - '0' :
+                      ((Byte >= 'A') && (Byte <= 'F')) ? Byte - 'A' + 10 : MAX_UINT8);
+      if ((Digit == MAX_UINT8) || (mSimParseDigits == 2)) {
+        mSimParseState = MmcSimParseIdle;
+        return;
+      }
+
+      mSimParseValue = (UINT8)((mSimParseValue << 4) | Digit);
+      mSimParseDigits++;
+      return;
+
+    case MmcSimParseBinaryLength:
+      if ((Byte == 0) || (Byte > MMC_FRAME_MAX_BYTES)) {
+        mSimParseState = MmcSimParseIdle;
+        return;
+      }
+
+      mSimParseLength = Byte;
+      mSimParseCount  = 0;
+      mSimParseState  = MmcSimParseBinaryBytes;
+      return;
+
+    case MmcSimParseBinaryBytes:
+      if (mSimParseCount < mSimParseLength) {
+        mSimParseBytes[mSimParseCount++] = Byte;
+        return;
+      }
+
+      mSimParseState = MmcSimParseIdle;
+      Digit          = (UINT8)mSimParseLength;
+      if (Byte == MmcSimCrc8 (MmcSimCrc8 (0, &Digit, 1), mSimParseBytes, mSimParseLength)) {
+        MmcSimAnswer (mSimParseBytes, mSimParseCount, FALSE, At);
+      }
+
+      return;
+  }
+}
+
+VOID
+MmcSimReset (
+  IN CONST MMC_SIM_CONFIG  *Config
+  )
+{
+  CopyMem (&mSimConfig, Config, sizeof (mSimConfig));
+  ZeroMem (&mSimStatistics, sizeof (mSimStatistics));
+  ZeroMem (mSimHostTxDone, sizeof (mSimHostTxDone));
+  mSimNow                = 0;
+  mSimRandom             = (Config->Seed != 0) ? Config->Seed : 1;
+  mSimHostTxFreeAt       = 0;
+  mSimHostTxNext         = 0;
+  mSimMmcBaudRate        = Config->BaudRate;
+  mSimMmcPendingBaudRate = 0;
+  mSimMmcTxFreeAt        = 0;
+  mSimMmcBinary          = FALSE;
+
+  MmcSimRebootHost (NULL);
+}
+
+VOID
+MmcSimRebootHost (
+  IN CONST ADLINK_MMC_LINK_CACHE  *Cache OPTIONAL
+  )
+{
+  mSimHostBaudRate = FixedPcdGet64 (PcdSerialDbgUartBaudRate);
+  mSimRxHead       = 0;
+  mSimRxCount      = 0;
+  mSimParseState   = MmcSimParseIdle;
+
+  MmcHostResetLink (Cache);
+}
+
+VOID
+MmcSimGetMmcState (
+  OUT UINT32   *BaudRate,
+  OUT BOOLEAN  *Binary
+  )
+{
+  *BaudRate = (UINT32)MmcSimMmcBaudRateAt (mSimNow);
+  *Binary   = mSimMmcBinary;
+}
+
+VOID
+MmcSimGetStatistics (
+  OUT MMC_SIM_STATISTICS  *Statistics
+  )
+{
+  CopyMem (Statistics, &mSimStatistics, sizeof (*Statistics));
+  Statistics->NowNs = mSimNow;
+}
+
+//
+// PL011UartLib.
+//
+
+RETURN_STATUS
+EFIAPI
+PL011UartInitializePort (
+  IN     UINTN               UartBase,
+  IN     UINT32              UartClkInHz,
+  IN OUT UINT64              *BaudRate,
+  IN OUT UINT32              *ReceiveFifoDepth,
+  IN OUT EFI_PARITY_TYPE     *Parity,
+  IN OUT UINT8               *DataBits,
+  IN OUT EFI_STOP_BITS_TYPE  *StopBits
+  )
+{
+  UINT64  Divisor;
+
+  if (*BaudRate == 0) {
+    *BaudRate = FixedPcdGet64 (PcdSerialDbgUartBaudRate);
+  }
+
+  //
+  // Same limits as the hardware: a 16 bit integer part of at least 1.
+  //
+  Divisor = DivU64x64Remainder (MultU64x32 (UartClkInHz, 4), *BaudRate, NULL);
+  if (((Divisor >> 6) == 0) || ((Divisor >> 6) > MAX_UINT16)) {
+    return RETURN_INVALID_PARAMETER;
+  }
+
+  //
+  // Reprogramming waits for the transmitter to drain.
+  //
+  mSimNow          = MAX (mSimNow, mSimHostTxFreeAt);
+  mSimHostBaudRate = *BaudRate;
+  return RETURN_SUCCESS;
+}
+
+RETURN_STATUS
+EFIAPI
+PL011UartGetControl (
+  IN  UINTN   UartBase,
+  OUT UINT32  *Control
+  )
+{
+  *Control = 0;
+  if (mSimHostTxFreeAt <= mSimNow) {
+    *Control |= EFI_SERIAL_OUTPUT_BUFFER_EMPTY;
+  }
+
+  if (!PL011UartPoll (UartBase)) {
+    *Control |= EFI_SERIAL_INPUT_BUFFER_EMPTY;
+  }
+
+  return RETURN_SUCCESS;
+}
+
+UINTN
+EFIAPI
+PL011UartWrite (
+  IN UINTN  UartBase,
+  IN UINT8  *Buffer,
+  IN UINTN  NumberOfBytes
+  )
+{
+  UINT64  Done;
+  UINTN   Index;
+
+  for (Index = 0; Index < NumberOfBytes; Index++) {
+    //
+    // Wait for room in the FIFO, then the byte leaves after the ones ahead.
+    //
+    mSimNow          = MAX (mSimNow, mSimHostTxDone[mSimHostTxNext]);
+    Done             = MAX (mSimNow, mSimHostTxFreeAt) + MmcSimByteNs (mSimHostBaudRate);
+    mSimHostTxFreeAt = Done;
+
+    mSimHostTxDone[mSimHostTxNext] = Done;
+    mSimHostTxNext                 = (mSimHostTxNext + 1) % MMC_SIM_TX_FIFO_DEPTH;
+
+    mSimStatistics.BytesToMmc++;
+    if (MmcSimChance (mSimConfig.DropPerMillion)) {
+      mSimStatistics.BytesDropped++;
+      continue;
+    }
+
+    if (mSimHostBaudRate != MmcSimMmcBaudRateAt (Done)) {
+      mSimStatistics.MisclockedBytes++;
+      mSimParseState = MmcSimParseIdle;
+      continue;
+    }
+
+    MmcSimMmcReceive (Buffer[Index], Done);
+  }
+
+  return NumberOfBytes;
+}
+
+UINTN
+EFIAPI
+PL011UartRead (
+  IN  UINTN  UartBase,
+  OUT UINT8  *Buffer,
+  IN  UINTN  NumberOfBytes
+  )
+{
+  UINTN  Index;
+
+  for (Index = 0; (Index < NumberOfBytes) && (mSimRxCount != 0); Index++) {
+    mSimNow       = MAX (mSimNow, mSimRxLine[mSimRxHead].At);
+    Buffer[Index] = mSimRxLine[mSimRxHead].Byte;
+    mSimRxHead    = (mSimRxHead + 1) % MMC_SIM_RX_LINE_BYTES;
+    mSimRxCount--;
+  }
+
+  return Index;
+}
+
+BOOLEAN
+EFIAPI
+PL011UartPoll (
+  IN UINTN  UartBase
+  )
+{
+  return (BOOLEAN)((mSimRxCount != 0) && (mSimRxLine[mSimRxHead].At <= mSimNow));
+}
+
+//
+// The flag and baud rate divisor registers, the only UART registers MmcLib
+// reads directly.
+//
+
+UINT32
+EFIAPI
+MmioRead32 (
+  IN UINTN  Address
+  )
+{
+  UINT32  Divisor;
+
+  Divisor = (UINT32)DivU64x64Remainder (
+                      MultU64x32 (FixedPcdGet32 (PcdSerialDbgUartClkInReference), 4),
+                      mSimHostBaudRate,
+                      NULL
+                      );
+  switch (Address - MMC_UART_BASE) {
+    case PL011_UARTFR:
+      return (mSimHostTxDone[mSimHostTxNext] > mSimNow) ? PL011_UARTFR_TXFF : 0;
+
+    case PL011_UARTIBRD:
+      return Divisor >> 6;
+
+    case PL011_UARTFBRD:
+      return Divisor & 0x3F;
+
+    default:
+      ASSERT (FALSE);
+      return 0;
+  }
+}
+
+//
+// TimerLib.
+//
+
+UINTN
+EFIAPI
+MicroSecondDelay (
+  IN UINTN  MicroSeconds
+  )
+{
+  mSimNow += MultU64x32 (MicroSeconds, 1000);
+  return MicroSeconds;
+}
+
+UINTN
+EFIAPI
+NanoSecondDelay (
+  IN UINTN  NanoSeconds
+  )
+{
+  mSimNow += NanoSeconds;
+  return NanoSeconds;
+}
+
+UINT64
+EFIAPI
+GetPerformanceCounter (
+  VOID
+  )
+{
+  mSimNow += MMC_SIM_POLL_NS;
+  return mSimNow;
+}
+
+UINT64
+EFIAPI
+GetPerformanceCounterProperties (
+  OUT UINT64  *StartValue OPTIONAL,
+  OUT UINT64  *EndValue OPTIONAL
+  )
+{
+  if (StartValue != NULL) {
+    *StartValue = 0;
+  }
+
+  if (EndValue != NULL) {
+    *EndValue = MAX_UINT64;
+  }
+
+  return MMC_SIM_COUNTER_HZ;
+}
+
+UINT64
+EFIAPI
+GetTimeInNanoSecond (
+  IN UINT64  Ticks
+  )
+{
+  return Ticks;
+}
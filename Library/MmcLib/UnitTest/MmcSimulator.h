@@ -0,0 +1,181 @@
+/** @file
+  Simulated MMC for the host based build of the MMC Library.
+
+  The simulator stands in for PL011UartLib, TimerLib and the two UART
+  registers MmcLib reads, and answers on the simulated line the way the MMC
+  firmware does. Time is modeled, not measured: it advances with the bytes
+  on the wire at the baud rate of each end, the answer delay of the MMC,
+  settle times and polling, so that results do not depend on the host.
+
+  Copyright (c) 2022, ADLink. All rights reserved.<BR>
+
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#ifndef MMC_SIMULATOR_H_
+#define MMC_SIMULATOR_H_
+
+#include <Uefi.h>
+#include <Guid/MmcLink.h>
+
+#define MMC_SIM_MAX_RATES  4
+
+///
+/// Behavior of the simulated MMC firmware and of the line.
+///
+typedef struct {
+  ///
+  /// Rate the MMC powers on at.
+  ///
+  UINT32     BaudRate;
+  ///
+  /// Rates acknowledged by SET_BAUD_RATE besides PcdSerialDbgUartBaudRate,
+  /// others are refused. Unused entries are 0.
+  ///
+  UINT32     Rates[MMC_SIM_MAX_RATES];
+  ///
+  /// Firmware without SET_BAUD_RATE, which leaves it unanswered.
+  ///
+  BOOLEAN    IgnoresBaudRate;
+  BOOLEAN    SupportsBinary;
+  BOOLEAN    SupportsBatch;
+  ///
+  /// ASCII requests are echoed back before the answer.
+  ///
+  BOOLEAN    EchoesAscii;
+  ///
+  /// Firmware version reported by Get Device ID.
+  ///
+  UINT16     Version;
+  ///
+  /// Time from the last byte of a request to the first byte of its answer.
+  ///
+  UINT32     ResponseDelayUs;
+  ///
+  /// Bytes lost on the line, in either direction, per million.
+  ///
+  UINT32     DropPerMillion;
+  ///
+  /// Answers preceded by a burst of line noise, per thousand.
+  ///
+  UINT32     GarbagePerThousand;
+  ///
+  /// Seed of the generator behind drops and noise.
+  ///
+  UINT32     Seed;
+  ///
+  /// Get Sensor Reading Factors is answered with MMC_SIM_FACTOR_M,
+  /// MMC_SIM_FACTOR_B and their exponents for every sensor. It is refused
+  /// otherwise.
+  ///
+  BOOLEAN    ReportsFactors;
+  ///
+  /// Batched reads answered with CC 0xC0, node busy, before the MMC reads
+  /// sensors in batches.
+  ///
+  UINT32     BusyBatches;
+} MMC_SIM_CONFIG;
+
+//
+// Conversion factors reported by the MMC with ReportsFactors:
+// (M * Raw + B * 10^BExp) * 10^RExp.
+//
+#define MMC_SIM_FACTOR_M     39
+#define MMC_SIM_FACTOR_B     (-5)
+#define MMC_SIM_FACTOR_REXP  (-2)
+#define MMC_SIM_FACTOR_BEXP  1
+
+///
+/// What happened on the simulated line since MmcSimReset ().
+///
+typedef struct {
+  UINT64    NowNs;            ///< Modeled time.
+  UINT32    BytesToMmc;       ///< Bytes the host put on the line.
+  UINT32    BytesFromMmc;     ///< Bytes the MMC put on the line, noise included.
+  UINT32    BytesDropped;     ///< Bytes lost on the line.
+  UINT32    NoiseBytes;       ///< Bytes of line noise.
+  UINT32    MisclockedBytes;  ///< Bytes sent while both ends ran at different rates.
+  UINT32    Requests;         ///< Well formed requests the MMC received.
+  UINT32    BaudRequests;     ///< SET_BAUD_RATE requests among them.
+  UINT32    BatchRequests;    ///< GET_SENSOR_READINGS requests among them.
+  UINT32    LastPostCode;     ///< Value of the last POST code received.
+} MMC_SIM_STATISTICS;
+
+/**
+  Power on the simulated MMC, reset the host UART to PcdSerialDbgUartBaudRate
+  and the modeled time to 0.
+
+  @param[in] Config  Behavior of the MMC and of the line.
+
+**/
+VOID
+MmcSimReset (
+  IN CONST MMC_SIM_CONFIG  *Config
+  );
+
+/**
+  Reset the host only: its UART returns to PcdSerialDbgUartBaudRate and the
+  link state of MmcLib is lost, while the MMC keeps running as it was.
+
+  @param[in] Cache  Content of the link variable the next boot finds, or
+                    NULL if there is none.
+
+**/
+VOID
+MmcSimRebootHost (
+  IN CONST ADLINK_MMC_LINK_CACHE  *Cache OPTIONAL
+  );
+
+/**
+  Return the rate and framing the simulated MMC currently uses.
+
+  @param[out] BaudRate  The rate the MMC answers at.
+  @param[out] Binary    TRUE if the MMC answers in binary framing.
+
+**/
+VOID
+MmcSimGetMmcState (
+  OUT UINT32   *BaudRate,
+  OUT BOOLEAN  *Binary
+  );
+
+/**
+  Return what happened on the simulated line since MmcSimReset ().
+
+  @param[out] Statistics  The statistics.
+
+**/
+VOID
+MmcSimGetStatistics (
+  OUT MMC_SIM_STATISTICS  *Statistics
+  );
+
+/**
+  Reset the link state kept by the host phase of MmcLib, and set the link
+  variable it reads. Implemented by MmcLibHost.c.
+
+  @param[in] Cache  Content of the link variable, or NULL if there is none.
+
+**/
+VOID
+MmcHostResetLink (
+  IN CONST ADLINK_MMC_LINK_CACHE  *Cache OPTIONAL
+  );
+
+/**
+  Return what the DXE phase would save in the link variable. Implemented by
+  MmcLibHost.c.
+
+  @param[out] Cache  The link cache.
+
+  @retval TRUE   MmcLib asks for Cache to be saved.
+  @retval FALSE  The variable is up to date.
+
+**/
+BOOLEAN
+MmcHostGetDirtyCache (
+  OUT ADLINK_MMC_LINK_CACHE  *Cache
+  );
+
+#endif
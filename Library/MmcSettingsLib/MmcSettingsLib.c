@@ -0,0 +1,226 @@
+/** @file
+  MMC settings store, common to all phases.
+
+  Copyright (c) 2022, ADLink. All rights reserved.<BR>
+
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#include "MmcSettingsLibInternal.h"
+
+typedef struct {
+  CONST CHAR8    *Name;
+  UINT8          Command;   ///< OEM command carrying the value.
+} MMC_SETTING_DESCRIPTOR;
+
+STATIC CONST MMC_SETTING_DESCRIPTOR  mMmcSettings[MmcSettingMax] = {
+  { "Power off type", MMC_OEM_SET_POWER_OFF_TYPE },
+  { "Wake On LAN",    MMC_OEM_WOL                },
+};
+
+/**
+  Record the version of the MMC firmware in the acknowledged values.
+
+  @param[out] Shadow  The acknowledged values.
+
+  @retval TRUE   The version is known.
+  @retval FALSE  The board identity HOB does not carry the version.
+
+**/
+STATIC
+BOOLEAN
+MmcSettingsSetMmcVersion (
+  OUT ADLINK_MMC_SETTINGS_SHADOW  *Shadow
+  )
+{
+  CONST ADLINK_BOARD_IDENTITY  *Identity;
+
+  Identity = GetBoardIdentity ();
+  if ((Identity == NULL) || (Identity->MmcVersion[0] == '\0')) {
+    return FALSE;
+  }
+
+  CopyMem (Shadow->MmcVersion, Identity->MmcVersion, sizeof (Shadow->MmcVersion));
+  return TRUE;
+}
+
+VOID
+MmcSettingsInitializeStore (
+  OUT ADLINK_MMC_SETTINGS_STORE         *Store,
+  IN  CONST ADLINK_MMC_SETTINGS_SHADOW  *Saved  OPTIONAL
+  )
+{
+  ZeroMem (Store, sizeof (*Store));
+
+  //
+  // Without the MMC version there is no telling whether the saved values
+  // were acknowledged by the firmware the MMC runs now.
+  //
+  if (!MmcSettingsSetMmcVersion (&Store->Acknowledged) || (Saved == NULL)) {
+    return;
+  }
+
+  if (CompareMem (Saved->MmcVersion, Store->Acknowledged.MmcVersion, sizeof (Saved->MmcVersion)) != 0) {
+    DEBUG ((DEBUG_INFO, "%a MMC firmware changed, settings are sent again\n", __FUNCTION__));
+    return;
+  }
+
+  CopyMem (&Store->Acknowledged, Saved, sizeof (*Saved));
+}
+
+EFI_STATUS
+EFIAPI
+MmcSettingsSet (
+  IN MMC_SETTING_ID  Id,
+  IN UINT8           Value
+  )
+{
+  ADLINK_MMC_SETTINGS_STORE  *Store;
+
+  if ((UINTN)Id >= MmcSettingMax) {
+    return EFI_INVALID_PARAMETER;
+  }
+
+  Store = MmcSettingsGetStore ();
+  if (Store == NULL) {
+    return EFI_OUT_OF_RESOURCES;
+  }
+
+  Store->Desired[Id] = Value;
+  Store->Staged     |= MMC_SETTING_BIT (Id);
+
+  return EFI_SUCCESS;
+}
+
+EFI_STATUS
+EFIAPI
+MmcSettingsGet (
+  IN  MMC_SETTING_ID  Id,
+  OUT UINT8           *Value
+  )
+{
+  ADLINK_MMC_SETTINGS_STORE  *Store;
+
+  if (((UINTN)Id >= MmcSettingMax) || (Value == NULL)) {
+    return EFI_INVALID_PARAMETER;
+  }
+
+  Store = MmcSettingsGetStore ();
+  if (Store == NULL) {
+    return EFI_OUT_OF_RESOURCES;
+  }
+
+  if ((Store->Acknowledged.Known & MMC_SETTING_BIT (Id)) == 0) {
+    return EFI_NOT_FOUND;
+  }
+
+  *Value = Store->Acknowledged.Value[Id];
+  return EFI_SUCCESS;
+}
+
+EFI_STATUS
+EFIAPI
+MmcSettingsCommit (
+  VOID
+  )
+{
+  ADLINK_MMC_SETTINGS_STORE  *Store;
+  ADLINK_MMC_SETTINGS_SHADOW  *Acknowledged;
+  UINTN                       Id;
+  UINT32                      Bit;
+  EFI_STATUS                  Status;
+  EFI_STATUS                  Result;
+
+  Store = MmcSettingsGetStore ();
+  if (Store == NULL) {
+    return EFI_OUT_OF_RESOURCES;
+  }
+
+  Acknowledged = &Store->Acknowledged;
+  Result       = EFI_SUCCESS;
+
+  for (Id = 0; Id < MmcSettingMax; Id++) {
+    Bit = MMC_SETTING_BIT (Id);
+    if ((Store->Staged & Bit) == 0) {
+      continue;
+    }
+
+    if (((Acknowledged->Known & Bit) != 0) && (Acknowledged->Value[Id] == Store->Desired[Id])) {
+      Store->Staged &= ~Bit;
+      continue;
+    }
+
+    DEBUG ((DEBUG_INFO, "%a Write MMC %a %d\n", __FUNCTION__, mMmcSettings[Id].Name, Store->Desired[Id]));
+
+    Status = MmcExecuteOemCommand (mMmcSettings[Id].Command, &Store->Desired[Id], 1);
+    if (EFI_ERROR (Status)) {
+      DEBUG ((DEBUG_ERROR, "%a Failed to Write MMC %a - %r\n", __FUNCTION__, mMmcSettings[Id].Name, Status));
+      //
+      // The MMC may or may not have taken the value.
+      //
+      if ((Acknowledged->Known & Bit) != 0) {
+        Acknowledged->Known &= ~Bit;
+        Store->Dirty         = TRUE;
+      }
+
+      Result = Status;
+      continue;
+    }
+
+    //
+    // A store created before the board identity HOB only holds values
+    // acknowledged during this boot, so the version can be filled in late.
+    //
+    if (Acknowledged->MmcVersion[0] == '\0') {
+      MmcSettingsSetMmcVersion (Acknowledged);
+    }
+
+    Acknowledged->Known    |= Bit;
+    Acknowledged->Value[Id] = Store->Desired[Id];
+    Store->Staged          &= ~Bit;
+    Store->Dirty            = TRUE;
+  }
+
+  if (Store->Dirty && MmcSettingsPersist (Acknowledged)) {
+    Store->Dirty = FALSE;
+  }
+
+  return Result;
+}
+
+/**
+  Stage the Wake On LAN setting and commit it.
+
+**/
+STATIC
+EFI_STATUS
+MmcSetWol (
+  IN BOOLEAN  Enable
+  )
+{
+  EFI_STATUS  Status;
+
+  Status = MmcSettingsSet (MmcSettingWakeOnLan, Enable ? 1 : 0);
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+
+  return MmcSettingsCommit ();
+}
+
+EFI_STATUS
+WolDisableCmd (
+  VOID
+  )
+{
+  return MmcSetWol (FALSE);
+}
+
+EFI_STATUS
+WolEnableCmd (
+  VOID
+  )
+{
+  return MmcSetWol (TRUE);
+}
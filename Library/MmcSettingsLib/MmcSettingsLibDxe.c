@@ -0,0 +1,93 @@
+/** @file
+  DXE parts of the MMC Settings Library.
+
+  The store is published as a configuration table by the first module
+  using it, starting from the values handed over by PEI or, without them,
+  from the variable. It must not be used after ExitBootServices ().
+
+  Copyright (c) 2022, ADLink. All rights reserved.<BR>
+
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#include "MmcSettingsLibInternal.h"
+#include <Library/MemoryAllocationLib.h>
+#include <Library/UefiBootServicesTableLib.h>
+#include <Library/UefiLib.h>
+#include <Library/UefiRuntimeServicesTableLib.h>
+
+STATIC ADLINK_MMC_SETTINGS_STORE  *mMmcSettingsStore;
+
+ADLINK_MMC_SETTINGS_STORE *
+MmcSettingsGetStore (
+  VOID
+  )
+{
+  ADLINK_MMC_SETTINGS_STORE   *Store;
+  ADLINK_MMC_SETTINGS_SHADOW  Saved;
+  VOID                        *GuidHob;
+  UINTN                       Size;
+  EFI_STATUS                  Status;
+
+  if (mMmcSettingsStore != NULL) {
+    return mMmcSettingsStore;
+  }
+
+  Status = EfiGetSystemConfigurationTable (&gAdlinkMmcSettingsGuid, (VOID **)&Store);
+  if (!EFI_ERROR (Status)) {
+    mMmcSettingsStore = Store;
+    return Store;
+  }
+
+  Store = AllocatePool (sizeof (*Store));
+  if (Store == NULL) {
+    return NULL;
+  }
+
+  GuidHob = GetFirstGuidHob (&gAdlinkMmcSettingsGuid);
+  if ((GuidHob != NULL) && (GET_GUID_HOB_DATA_SIZE (GuidHob) >= sizeof (*Store))) {
+    CopyMem (Store, GET_GUID_HOB_DATA (GuidHob), sizeof (*Store));
+  } else {
+    Size   = sizeof (Saved);
+    Status = gRT->GetVariable (
+                    ADLINK_MMC_SETTINGS_VARIABLE_NAME,
+                    &gAdlinkMmcSettingsGuid,
+                    NULL,
+                    &Size,
+                    &Saved
+                    );
+    MmcSettingsInitializeStore (Store, (!EFI_ERROR (Status) && (Size == sizeof (Saved))) ? &Saved : NULL);
+  }
+
+  Status = gBS->InstallConfigurationTable (&gAdlinkMmcSettingsGuid, Store);
+  if (EFI_ERROR (Status)) {
+    FreePool (Store);
+    return NULL;
+  }
+
+  mMmcSettingsStore = Store;
+  return Store;
+}
+
+BOOLEAN
+MmcSettingsPersist (
+  IN CONST ADLINK_MMC_SETTINGS_SHADOW  *Shadow
+  )
+{
+  EFI_STATUS  Status;
+
+  Status = gRT->SetVariable (
+                  ADLINK_MMC_SETTINGS_VARIABLE_NAME,
+                  &gAdlinkMmcSettingsGuid,
+                  EFI_VARIABLE_NON_VOLATILE | EFI_VARIABLE_BOOTSERVICE_ACCESS,
+                  sizeof (*Shadow),
+                  (VOID *)Shadow
+                  );
+  if (EFI_ERROR (Status)) {
+    DEBUG ((DEBUG_ERROR, "%a Failed to save MMC settings - %r\n", __FUNCTION__, Status));
+    return FALSE;
+  }
+
+  return TRUE;
+}
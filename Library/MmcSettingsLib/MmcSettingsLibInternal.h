@@ -0,0 +1,73 @@
+/** @file
+  Internal definitions shared by the MMC Settings Library source files.
+
+  Copyright (c) 2022, ADLink. All rights reserved.<BR>
+
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#ifndef MMC_SETTINGS_LIB_INTERNAL_H_
+#define MMC_SETTINGS_LIB_INTERNAL_H_
+
+#include <PiDxe.h>
+#include <Library/BaseLib.h>
+#include <Library/BaseMemoryLib.h>
+#include <Library/DebugLib.h>
+#include <Library/HobLib.h>
+#include <Library/MmcLib.h>
+#include <Library/MmcSettingsLib.h>
+#include <Library/NVLib.h>
+#include <Guid/MmcSettings.h>
+
+//
+// OEM commands carrying a setting:
+//   request  [C0 00 <Command> <Value>]
+//   response [C4 00 <Command> <CC>]
+//
+#define MMC_OEM_SET_POWER_OFF_TYPE  0x15
+#define MMC_OEM_WOL                 0x3C
+
+#define MMC_SETTING_BIT(Id)  ((UINT32)1 << (Id))
+
+/**
+  Return the store shared by the modules of this phase, creating it on
+  first use. Implemented per phase.
+
+  @return The store, or NULL if it could not be created.
+
+**/
+ADLINK_MMC_SETTINGS_STORE *
+MmcSettingsGetStore (
+  VOID
+  );
+
+/**
+  Write the acknowledged values to the variable. Implemented per phase.
+
+  @param[in] Shadow  The acknowledged values.
+
+  @retval TRUE   The variable was written.
+  @retval FALSE  The variable is left to a later phase, or could not be
+                 written.
+
+**/
+BOOLEAN
+MmcSettingsPersist (
+  IN CONST ADLINK_MMC_SETTINGS_SHADOW  *Shadow
+  );
+
+/**
+  Fill a new store from the content of the variable.
+
+  @param[out] Store  The store.
+  @param[in]  Saved  The content of the variable, or NULL if it is missing.
+
+**/
+VOID
+MmcSettingsInitializeStore (
+  OUT ADLINK_MMC_SETTINGS_STORE         *Store,
+  IN  CONST ADLINK_MMC_SETTINGS_SHADOW  *Saved  OPTIONAL
+  );
+
+#endif
@@ -0,0 +1,73 @@
+/** @file
+  PEI parts of the MMC Settings Library.
+
+  The store lives in a GUIDed HOB, so that all PEIMs share it and DXE picks
+  it up. Variables are read-only in PEI, so the values acknowledged here
+  are written to the variable by the first DXE commit.
+
+  Copyright (c) 2022, ADLink. All rights reserved.<BR>
+
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#include <PiPei.h>
+#include "MmcSettingsLibInternal.h"
+#include <Library/PeiServicesLib.h>
+#include <Ppi/ReadOnlyVariable2.h>
+
+ADLINK_MMC_SETTINGS_STORE *
+MmcSettingsGetStore (
+  VOID
+  )
+{
+  ADLINK_MMC_SETTINGS_STORE        *Store;
+  ADLINK_MMC_SETTINGS_SHADOW       Saved;
+  EFI_PEI_READ_ONLY_VARIABLE2_PPI  *Variable;
+  VOID                             *GuidHob;
+  UINTN                            Size;
+  EFI_STATUS                       Status;
+
+  //
+  // The HOB moves when PEI memory is installed, so it is looked up on each
+  // call rather than cached.
+  //
+  GuidHob = GetFirstGuidHob (&gAdlinkMmcSettingsGuid);
+  if (GuidHob != NULL) {
+    return GET_GUID_HOB_DATA (GuidHob);
+  }
+
+  Store = BuildGuidHob (&gAdlinkMmcSettingsGuid, sizeof (*Store));
+  if (Store == NULL) {
+    return NULL;
+  }
+
+  Size   = 0;
+  Status = PeiServicesLocatePpi (&gEfiPeiReadOnlyVariable2PpiGuid, 0, NULL, (VOID **)&Variable);
+  if (!EFI_ERROR (Status)) {
+    Size   = sizeof (Saved);
+    Status = Variable->GetVariable (
+                         Variable,
+                         ADLINK_MMC_SETTINGS_VARIABLE_NAME,
+                         &gAdlinkMmcSettingsGuid,
+                         NULL,
+                         &Size,
+                         &Saved
+                         );
+    if (EFI_ERROR (Status)) {
+      Size = 0;
+    }
+  }
+
+  MmcSettingsInitializeStore (Store, (Size == sizeof (Saved)) ? &Saved : NULL);
+
+  return Store;
+}
+
+BOOLEAN
+MmcSettingsPersist (
+  IN CONST ADLINK_MMC_SETTINGS_SHADOW  *Shadow
+  )
+{
+  return FALSE;
+}
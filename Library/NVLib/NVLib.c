@@ -14,22 +14,52 @@
 #include <Library/PL011UartLib.h>
 #include <Library/MmcLib.h>
 #include <Library/BaseMemoryLib.h>
+#include <Library/HobLib.h>
 #include <Library/NVParamLib.h>
+#include <Library/NVLib.h>
 #include <NVParamDef.h>
 
+STATIC CONST ADLINK_BOARD_IDENTITY  *mBoardIdentity;
+
+CONST ADLINK_BOARD_IDENTITY *
+GetBoardIdentity (
+  VOID
+  )
+{
+  VOID  *GuidHob;
+
+  if (mBoardIdentity == NULL) {
+    GuidHob = GetFirstGuidHob (&gAdlinkBoardIdentityHobGuid);
+    if (GuidHob != NULL) {
+      mBoardIdentity = GET_GUID_HOB_DATA (GuidHob);
+    }
+  }
+
+  return mBoardIdentity;
+}
 
 UINT8
 GetFirmwareMajorVersion (
 )
 {
+  CONST ADLINK_BOARD_IDENTITY  *Identity;
   UINT16     ACLRd = NV_PERM_ALL;
   EFI_STATUS Status;
   UINT32     Val;
-  
+
+  Identity = GetBoardIdentity ();
+  if (Identity != NULL) {
+    return Identity->BoardRevision;
+  }
+
+  //
+  // Only reached in PEI before the board identity HOB is published.
+  //
+  Val    = 0;
   Status = NVParamGet (NV_SI_RO_BOARD_I2C_VRD_CONFIG_INFO, ACLRd, &Val);
   
   if (!EFI_ERROR (Status)) {
-      DEBUG ((DEBUG_ERROR, " I2C brd config info    0x%X (%d)\n",  Val, Val));
+      DEBUG ((DEBUG_INFO, " I2C brd config info    0x%X (%d)\n",  Val, Val));
   }
   if (Val == 0x6A685860)
   {
@@ -21,6 +21,7 @@
 #include <Library/HiiLib.h>
 #include <Library/HobLib.h>
 #include <Library/MemoryAllocationLib.h>
+#include <Library/NVLib.h>
 #include <Library/OemMiscLib.h>
 #include <Library/PrintLib.h>
 #include <Guid/PlatformInfoHob.h>
@@ -303,9 +304,10 @@ OemUpdateSmbiosInfo (
   IN OEM_MISC_SMBIOS_HII_STRING_FIELD Field
   )
 {
-  EFI_STRING UnicodeString;
-  UINT8      StringLength;
-  UINT32     *Ecid;
+  EFI_STRING                  UnicodeString;
+  UINT8                       StringLength;
+  UINT32                      *Ecid;
+  CONST ADLINK_BOARD_IDENTITY *Identity;
 
   StringLength = SMBIOS_STRING_MAX_LENGTH * sizeof (CHAR16);
   UnicodeString = AllocatePool (StringLength);
@@ -359,7 +361,17 @@ OemUpdateSmbiosInfo (
       break;
 
     case ProcessorPartNumType04:
-      if (IsAc01Processor ()) {
+      Identity = GetBoardIdentity ();
+      if (Identity != NULL) {
+        UnicodeSPrint (
+          UnicodeString,
+          StringLength,
+          L"%c%02d-%02X",
+          Identity->CpuIsAltraMax ? L'M' : L'Q',
+          Identity->CpuSkuMaxCore,
+          Identity->CpuSkuMaxTurbo
+          );
+      } else if (IsAc01Processor ()) {
         UnicodeSPrint (
           UnicodeString,
           StringLength,
@@ -0,0 +1,270 @@
+/** @file
+  Writes and finds the persistent status code logs described in
+  Guid/PersistentStatusCodeLog.h.
+
+  A record is reserved by incrementing NextSequence atomically, so that
+  writers on several CPUs, as the OS may have at runtime, or a status code
+  reported from an interrupt of another one, never share a record.
+
+  A warm reset does not write the data caches back, so every store to the
+  region is cleaned to the point of coherency right away.
+
+  Copyright (c) 2022, ADLink. All rights reserved.<BR>
+
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#include <Base.h>
+#include <Library/BaseLib.h>
+#include <Library/BaseMemoryLib.h>
+#include <Library/CacheMaintenanceLib.h>
+#include <Library/PcdLib.h>
+#include <Library/PersistentStatusCodeLogLib.h>
+#include <Library/SynchronizationLib.h>
+#include <Library/TimerLib.h>
+
+/**
+  Return one of the two logs of the region.
+
+  @param[in] Index  0 or 1.
+
+**/
+STATIC
+ADLINK_PERSISTENT_LOG_HEADER *
+PersistentLogSlot (
+  IN UINTN  Index
+  )
+{
+  return (ADLINK_PERSISTENT_LOG_HEADER *)(UINTN)(FixedPcdGet64 (PcdStatusCodePersistentLogBase) +
+                                                 Index * (FixedPcdGet32 (PcdStatusCodePersistentLogSize) * SIZE_1KB / 2));
+}
+
+/**
+  Return the number of records a log has room for.
+
+**/
+STATIC
+UINT32
+PersistentLogMaxRecords (
+  VOID
+  )
+{
+  return (FixedPcdGet32 (PcdStatusCodePersistentLogSize) * SIZE_1KB / 2 - sizeof (ADLINK_PERSISTENT_LOG_HEADER)) /
+         sizeof (ADLINK_PERSISTENT_LOG_RECORD);
+}
+
+/**
+  Return whether a log was started by this firmware and is intact.
+
+  @param[in] Log  The log.
+
+**/
+STATIC
+BOOLEAN
+PersistentLogValid (
+  IN CONST ADLINK_PERSISTENT_LOG_HEADER  *Log
+  )
+{
+  return (BOOLEAN)((Log->Signature == ADLINK_PERSISTENT_LOG_SIGNATURE) &&
+                   (Log->RecordSize == sizeof (ADLINK_PERSISTENT_LOG_RECORD)) &&
+                   (Log->MaxRecordsNumber == PersistentLogMaxRecords ()) &&
+                   (Log->HeaderCrc == CalculateCrc32 ((VOID *)Log, OFFSET_OF (ADLINK_PERSISTENT_LOG_HEADER, HeaderCrc))));
+}
+
+/**
+  Return the index of the log of the latest boot, or -1 if neither is valid.
+
+**/
+STATIC
+INTN
+PersistentLogLatest (
+  VOID
+  )
+{
+  ADLINK_PERSISTENT_LOG_HEADER  *Log0;
+  ADLINK_PERSISTENT_LOG_HEADER  *Log1;
+  BOOLEAN                       Valid0;
+  BOOLEAN                       Valid1;
+
+  if (FixedPcdGet32 (PcdStatusCodePersistentLogSize) == 0) {
+    return -1;
+  }
+
+  Log0   = PersistentLogSlot (0);
+  Log1   = PersistentLogSlot (1);
+  Valid0 = PersistentLogValid (Log0);
+  Valid1 = PersistentLogValid (Log1);
+  if (Valid0 && Valid1) {
+    //
+    // Boot counts wrap around, the latest is the one just above the other.
+    //
+    return (Log1->BootCount - Log0->BootCount == 1) ? 1 : 0;
+  }
+
+  if (Valid0) {
+    return 0;
+  }
+
+  return Valid1 ? 1 : -1;
+}
+
+ADLINK_PERSISTENT_LOG_HEADER *
+EFIAPI
+PersistentLogStart (
+  VOID
+  )
+{
+  ADLINK_PERSISTENT_LOG_HEADER  *Log;
+  INTN                          Latest;
+  UINT32                        BootCount;
+
+  if (FixedPcdGet32 (PcdStatusCodePersistentLogSize) == 0) {
+    return NULL;
+  }
+
+  Latest    = PersistentLogLatest ();
+  BootCount = 1;
+  if (Latest >= 0) {
+    BootCount = PersistentLogSlot (Latest)->BootCount + 1;
+  }
+
+  Log = PersistentLogSlot ((Latest == 0) ? 1 : 0);
+  ZeroMem (Log, FixedPcdGet32 (PcdStatusCodePersistentLogSize) * SIZE_1KB / 2);
+  Log->Signature        = ADLINK_PERSISTENT_LOG_SIGNATURE;
+  Log->RecordSize       = sizeof (ADLINK_PERSISTENT_LOG_RECORD);
+  Log->MaxRecordsNumber = PersistentLogMaxRecords ();
+  Log->BootCount        = BootCount;
+  Log->Frequency        = GetPerformanceCounterProperties (NULL, NULL);
+  Log->HeaderCrc        = CalculateCrc32 (Log, OFFSET_OF (ADLINK_PERSISTENT_LOG_HEADER, HeaderCrc));
+  WriteBackDataCacheRange (Log, FixedPcdGet32 (PcdStatusCodePersistentLogSize) * SIZE_1KB / 2);
+
+  return Log;
+}
+
+ADLINK_PERSISTENT_LOG_HEADER *
+EFIAPI
+PersistentLogGetCurrent (
+  VOID
+  )
+{
+  INTN  Latest;
+
+  Latest = PersistentLogLatest ();
+  return (Latest < 0) ? NULL : PersistentLogSlot (Latest);
+}
+
+CONST ADLINK_PERSISTENT_LOG_HEADER *
+EFIAPI
+PersistentLogGetPrevious (
+  VOID
+  )
+{
+  ADLINK_PERSISTENT_LOG_HEADER  *Current;
+  ADLINK_PERSISTENT_LOG_HEADER  *Previous;
+  INTN                          Latest;
+
+  Latest = PersistentLogLatest ();
+  if (Latest < 0) {
+    return NULL;
+  }
+
+  Current  = PersistentLogSlot (Latest);
+  Previous = PersistentLogSlot (1 - Latest);
+  if (!PersistentLogValid (Previous) || (Current->BootCount - Previous->BootCount != 1)) {
+    return NULL;
+  }
+
+  return Previous;
+}
+
+VOID
+EFIAPI
+PersistentLogAppend (
+  IN ADLINK_PERSISTENT_LOG_HEADER  *Log,
+  IN EFI_STATUS_CODE_TYPE          CodeType,
+  IN EFI_STATUS_CODE_VALUE         Value,
+  IN UINT32                        Instance,
+  IN UINT8                         PostCode,
+  IN CONST EFI_GUID                *CallerId  OPTIONAL
+  )
+{
+  ADLINK_PERSISTENT_LOG_RECORD  *Record;
+  UINT32                        Sequence;
+
+  Sequence = InterlockedIncrement (&Log->NextSequence) - 1;
+  Record   = (ADLINK_PERSISTENT_LOG_RECORD *)(Log + 1) + Sequence % Log->MaxRecordsNumber;
+
+  //
+  // The CRC goes last, a reset before it leaves a record readers skip.
+  //
+  Record->Crc = 0;
+  ZeroMem (&Record->Record, sizeof (Record->Record));
+  Record->Sequence         = Sequence;
+  Record->Record.CodeType  = CodeType;
+  Record->Record.Value     = Value;
+  Record->Record.Instance  = Instance;
+  Record->Record.PostCode  = PostCode;
+  Record->Record.Timestamp = GetPerformanceCounter ();
+  if (CallerId != NULL) {
+    CopyGuid (&Record->Record.CallerId, CallerId);
+  }
+
+  Record->Crc = CalculateCrc32 (Record, sizeof (*Record));
+  WriteBackDataCacheRange (Record, sizeof (*Record));
+  WriteBackDataCacheRange (&Log->NextSequence, sizeof (Log->NextSequence));
+}
+
+UINTN
+EFIAPI
+PersistentLogSnapshot (
+  IN  CONST ADLINK_PERSISTENT_LOG_HEADER  *Log,
+  OUT ADLINK_PERSISTENT_LOG_HEADER        *Snapshot,
+  IN  UINTN                               Size
+  )
+{
+  CONST ADLINK_PERSISTENT_LOG_RECORD  *Records;
+  ADLINK_PERSISTENT_LOG_RECORD        *Copies;
+  UINT32                              MaxRecords;
+  UINT32                              Next;
+  UINT32                              Sequence;
+
+  if (Size < sizeof (*Snapshot) + sizeof (*Copies)) {
+    return 0;
+  }
+
+  MaxRecords = (UINT32)MIN (Log->MaxRecordsNumber, (Size - sizeof (*Snapshot)) / sizeof (*Copies));
+  Next       = Log->NextSequence;
+
+  CopyMem (Snapshot, Log, sizeof (*Snapshot));
+  Snapshot->MaxRecordsNumber = MaxRecords;
+  Snapshot->HeaderCrc        = CalculateCrc32 (Snapshot, OFFSET_OF (ADLINK_PERSISTENT_LOG_HEADER, HeaderCrc));
+  Snapshot->NextSequence     = Next;
+
+  //
+  // Records keep their sequence number and CRC, only their index changes.
+  //
+  Records = (CONST ADLINK_PERSISTENT_LOG_RECORD *)(Log + 1);
+  Copies  = (ADLINK_PERSISTENT_LOG_RECORD *)(Snapshot + 1);
+  ZeroMem (Copies, MaxRecords * sizeof (*Copies));
+  for (Sequence = Next - MIN (Next, MaxRecords); Sequence != Next; Sequence++) {
+    CopyMem (&Copies[Sequence % MaxRecords], &Records[Sequence % Log->MaxRecordsNumber], sizeof (*Copies));
+  }
+
+  return sizeof (*Snapshot) + MaxRecords * sizeof (*Copies);
+}
+
+BOOLEAN
+EFIAPI
+PersistentLogSnapshotValid (
+  IN CONST ADLINK_PERSISTENT_LOG_HEADER  *Snapshot,
+  IN UINTN                               Size
+  )
+{
+  return (BOOLEAN)((Size >= sizeof (*Snapshot)) &&
+                   (Snapshot->Signature == ADLINK_PERSISTENT_LOG_SIGNATURE) &&
+                   (Snapshot->RecordSize == sizeof (ADLINK_PERSISTENT_LOG_RECORD)) &&
+                   (Snapshot->MaxRecordsNumber != 0) &&
+                   (Snapshot->MaxRecordsNumber == (Size - sizeof (*Snapshot)) / sizeof (ADLINK_PERSISTENT_LOG_RECORD)) &&
+                   (Snapshot->HeaderCrc == CalculateCrc32 ((VOID *)Snapshot, OFFSET_OF (ADLINK_PERSISTENT_LOG_HEADER, HeaderCrc))));
+}
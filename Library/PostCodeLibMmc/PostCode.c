@@ -9,6 +9,181 @@
 #include <Library/DebugLib.h>
 #include <Library/PcdLib.h>
 #include <Library/MmcLib.h>
+#include <Library/MmcPostCodeLib.h>
+
+//
+// POST codes that must reach the MMC before PostCode () returns, see the
+// progress and error maps in README.md.
+//
+#define POST_CODE_READY_TO_BOOT        0xAD
+#define POST_CODE_EXIT_BOOT_SERVICES   0xAF
+#define POST_CODE_RESET_SYSTEM         0xB3
+
+#define POST_CODE_QUEUE_DEPTH  FixedPcdGet32 (PcdMmcPostCodeQueueDepth)
+#define POST_CODE_RING_SIZE    MAX (POST_CODE_QUEUE_DEPTH, 1)
+
+//
+// Codes waiting for the UART, oldest at mPostCodeHead.
+//
+STATIC UINT32                    mPostCodeRing[POST_CODE_RING_SIZE];
+STATIC UINTN                     mPostCodeHead;
+STATIC UINTN                     mPostCodeCount;
+STATIC UINT32                    mPostCodeLast;
+STATIC BOOLEAN                   mPostCodeBusy;
+STATIC MMC_POST_CODE_STATISTICS  mPostCodeStatistics;
+
+/**
+  Return TRUE if Value reports an error or a hand-off to the OS, after which
+  the MMC must hold the code without further delay.
+
+**/
+STATIC
+BOOLEAN
+PostCodeNeedsFlush (
+  IN UINT32  Value
+  )
+{
+  switch (Value & 0xF0) {
+    case 0x50:
+    case 0xD0:
+      return TRUE;
+    case 0xE0:
+    case 0xF0:
+      return (BOOLEAN)((Value & 0x08) != 0);
+    default:
+      return (BOOLEAN)((Value == POST_CODE_READY_TO_BOOT) ||
+                       (Value == POST_CODE_EXIT_BOOT_SERVICES) ||
+                       (Value == POST_CODE_RESET_SYSTEM));
+  }
+}
+
+/**
+  Write queued codes to the MMC, oldest first.
+
+  @param[in] Wait  TRUE to write every queued code, FALSE to stop as soon as
+                   the UART has not finished sending earlier output.
+
+**/
+STATIC
+VOID
+PostCodeDrain (
+  IN BOOLEAN  Wait
+  )
+{
+  while ((mPostCodeCount != 0) && (Wait || MmcCanSendCommand ())) {
+    //
+    // Keep the code queued while another MMC transaction owns the UART.
+    //
+    if (MmcPostCode (mPostCodeRing[mPostCodeHead]) == EFI_ALREADY_STARTED) {
+      break;
+    }
+
+    mPostCodeHead = (mPostCodeHead + 1) % POST_CODE_RING_SIZE;
+    mPostCodeCount--;
+    mPostCodeStatistics.Sent++;
+  }
+}
+
+/**
+  Queue a POST code for the MMC and send what the UART accepts without
+  waiting.
+
+  Repeats of the previous code are collapsed. When the queue is full the
+  oldest code is dropped, so the MMC always ends up with the latest one.
+  Codes reported from within the library, or that the UART did not take
+  without a queue, are dropped too.
+
+**/
+STATIC
+VOID
+PostCodeReport (
+  IN UINT32  Value
+  )
+{
+  mPostCodeStatistics.Reported++;
+  if (mPostCodeBusy) {
+    mPostCodeStatistics.Dropped++;
+    return;
+  }
+
+  mPostCodeBusy = TRUE;
+
+  if (Value == mPostCodeLast) {
+    mPostCodeStatistics.Collapsed++;
+  } else if (POST_CODE_QUEUE_DEPTH == 0) {
+    //
+    // A code the UART did not take is not the last one the MMC holds, so
+    // that the next report of it is sent rather than collapsed.
+    //
+    if (EFI_ERROR (MmcPostCode (Value))) {
+      mPostCodeStatistics.Dropped++;
+    } else {
+      mPostCodeLast = Value;
+      mPostCodeStatistics.Sent++;
+    }
+  } else {
+    mPostCodeLast = Value;
+    if (mPostCodeCount == POST_CODE_QUEUE_DEPTH) {
+      mPostCodeHead = (mPostCodeHead + 1) % POST_CODE_RING_SIZE;
+      mPostCodeCount--;
+      mPostCodeStatistics.Dropped++;
+    }
+
+    mPostCodeRing[(mPostCodeHead + mPostCodeCount) % POST_CODE_RING_SIZE] = Value;
+    mPostCodeCount++;
+    mPostCodeStatistics.HighWater = MAX (mPostCodeStatistics.HighWater, (UINT32)mPostCodeCount);
+  }
+
+  PostCodeDrain (PostCodeNeedsFlush (Value));
+
+  if (Value == POST_CODE_EXIT_BOOT_SERVICES) {
+    DEBUG ((
+      DEBUG_INFO,
+      "POST codes: %d reported, %d collapsed, %d dropped, %d sent, queue high water %d\n",
+      mPostCodeStatistics.Reported,
+      mPostCodeStatistics.Collapsed,
+      mPostCodeStatistics.Dropped,
+      mPostCodeStatistics.Sent,
+      mPostCodeStatistics.HighWater
+      ));
+  }
+
+  mPostCodeBusy = FALSE;
+}
+
+/**
+  Write every queued POST code to the MMC, waiting for the UART as needed.
+
+**/
+VOID
+EFIAPI
+MmcPostCodeFlush (
+  VOID
+  )
+{
+  if (mPostCodeBusy) {
+    return;
+  }
+
+  mPostCodeBusy = TRUE;
+  PostCodeDrain (TRUE);
+  mPostCodeBusy = FALSE;
+}
+
+/**
+  Return the POST code queue counters.
+
+  @param[out] Statistics  Receives the counters.
+
+**/
+VOID
+EFIAPI
+MmcPostCodeGetStatistics (
+  OUT MMC_POST_CODE_STATISTICS  *Statistics
+  )
+{
+  *Statistics = mPostCodeStatistics;
+}
 
 /**
   Sends an 32-bit value to a POST card.
@@ -36,7 +211,7 @@ PostCode (
 {
   if (PostCodeEnabled() && (Value != 0)) {
     DEBUG ((DEBUG_INFO, "POST %08x\n", Value));
-    MmcPostCode(Value);
+    PostCodeReport (Value);
   }
   return Value;
 }
@@ -75,7 +250,7 @@ PostCodeWithDescription (
   if (PostCodeDescriptionEnabled() && (Value != 0)) {
 
     DEBUG ((DEBUG_INFO, "POST %08x - %s\n", Value, Description));
-    MmcPostCode(Value);
+    PostCodeReport (Value);
   }
   return Value;
 }
@@ -0,0 +1,485 @@
+/** @file
+  Writes the binary status code log described in Guid/StatusCodeLog.h.
+
+  Records never wrap around the end of the ring: when one does not fit
+  before the end, a PAD record fills the rest and the record starts over
+  at offset 0. Room is made by dropping the oldest records.
+
+  Copyright (c) 2022, ADLink. All rights reserved.<BR>
+
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#include <Base.h>
+#include <Library/BaseLib.h>
+#include <Library/BaseMemoryLib.h>
+#include <Library/StatusCodeLogLib.h>
+#include <Library/TimerLib.h>
+
+//
+// Longest format string kept, NUL included.
+//
+#define STATUS_CODE_LOG_MAX_FORMAT  0x100
+
+//
+// Smallest ring worth having.
+//
+#define STATUS_CODE_LOG_MIN_SIZE  SIZE_4KB
+
+//
+// Bytes following a DEBUG record header: the arguments, then a copy of
+// each string or GUID they point to.
+//
+#define STATUS_CODE_LOG_MAX_DEBUG_DATA  \
+  (ADLINK_STATUS_CODE_LOG_MAX_ARGS * (sizeof (UINT64) + ADLINK_STATUS_CODE_LOG_MAX_STRING))
+
+/**
+  Return the address of a position in the ring.
+
+**/
+STATIC
+UINT8 *
+StatusCodeLogAt (
+  IN ADLINK_STATUS_CODE_LOG_HEADER  *Log,
+  IN UINT64                         Position
+  )
+{
+  UINT32  Offset;
+
+  DivU64x32Remainder (Position, Log->Size, &Offset);
+  return (UINT8 *)(Log + 1) + Offset;
+}
+
+/**
+  Return the position following the record at Position.
+
+**/
+STATIC
+UINT64
+StatusCodeLogNext (
+  IN CONST ADLINK_STATUS_CODE_LOG_HEADER  *Log,
+  IN UINT64                               Position
+  )
+{
+  CONST ADLINK_STATUS_CODE_LOG_RECORD  *Record;
+  UINT32                               Offset;
+
+  DivU64x32Remainder (Position, Log->Size, &Offset);
+  Record = (CONST ADLINK_STATUS_CODE_LOG_RECORD *)((CONST UINT8 *)(Log + 1) + Offset);
+  if (Record->Type == ADLINK_STATUS_CODE_LOG_PAD) {
+    return Position + (Log->Size - Offset);
+  }
+
+  return Position + ALIGN_VALUE (Record->Size, ADLINK_STATUS_CODE_LOG_ALIGNMENT);
+}
+
+/**
+  Make room for a record and return where it goes.
+
+  @param[in]  Log       The log.
+  @param[in]  Size      Record bytes, header included.
+  @param[out] Position  Position of the record.
+
+  @return The record, or NULL if it is too large for the ring.
+
+**/
+STATIC
+ADLINK_STATUS_CODE_LOG_RECORD *
+StatusCodeLogReserve (
+  IN  ADLINK_STATUS_CODE_LOG_HEADER  *Log,
+  IN  UINTN                          Size,
+  OUT UINT64                         *Position
+  )
+{
+  ADLINK_STATUS_CODE_LOG_RECORD  *Record;
+  UINT32                         Offset;
+  UINTN                          Needed;
+
+  Size = ALIGN_VALUE (Size, ADLINK_STATUS_CODE_LOG_ALIGNMENT);
+  if (Size > Log->Size / 4) {
+    return NULL;
+  }
+
+  DivU64x32Remainder (Log->Head, Log->Size, &Offset);
+  Needed = Size;
+  if (Log->Size - Offset < Size) {
+    Needed += Log->Size - Offset;
+  }
+
+  while (Log->Head + Needed - Log->Tail > Log->Size) {
+    if (((ADLINK_STATUS_CODE_LOG_RECORD *)StatusCodeLogAt (Log, Log->Tail))->Type != ADLINK_STATUS_CODE_LOG_PAD) {
+      Log->Overwritten++;
+    }
+
+    Log->Tail = StatusCodeLogNext (Log, Log->Tail);
+  }
+
+  if (Needed != Size) {
+    ((ADLINK_STATUS_CODE_LOG_RECORD *)StatusCodeLogAt (Log, Log->Head))->Type = ADLINK_STATUS_CODE_LOG_PAD;
+    Log->Head += Needed - Size;
+  }
+
+  *Position  = Log->Head;
+  Record     = (ADLINK_STATUS_CODE_LOG_RECORD *)StatusCodeLogAt (Log, Log->Head);
+  Log->Head += Size;
+
+  return Record;
+}
+
+/**
+  Fill in the common part of a record.
+
+**/
+STATIC
+VOID
+StatusCodeLogSetHeader (
+  OUT ADLINK_STATUS_CODE_LOG_RECORD  *Record,
+  IN  UINTN                          Size,
+  IN  UINT8                          Type,
+  IN  CONST EFI_GUID                 *CallerId  OPTIONAL
+  )
+{
+  ZeroMem (Record, sizeof (*Record));
+  Record->Size      = (UINT16)Size;
+  Record->Type      = Type;
+  Record->Timestamp = GetPerformanceCounter ();
+  if (CallerId != NULL) {
+    CopyGuid (&Record->CallerId, CallerId);
+  }
+}
+
+/**
+  Return the token of a format string, a FNV-1a hash of its text, never 0.
+
+  @param[in]  Format  The format string.
+  @param[out] Length  Characters hashed.
+
+**/
+STATIC
+UINT32
+StatusCodeLogToken (
+  IN  CONST CHAR8  *Format,
+  OUT UINTN        *Length
+  )
+{
+  UINT32  Hash;
+  UINTN   Index;
+
+  Hash = 0x811C9DC5;
+  for (Index = 0; (Index < STATUS_CODE_LOG_MAX_FORMAT - 1) && (Format[Index] != '\0'); Index++) {
+    Hash = (Hash ^ (UINT8)Format[Index]) * 0x01000193;
+  }
+
+  *Length = Index;
+  return (Hash != 0) ? Hash : 1;
+}
+
+/**
+  Write the text of a format string, unless a record of it is still in the
+  ring.
+
+**/
+STATIC
+VOID
+StatusCodeLogFormat (
+  IN ADLINK_STATUS_CODE_LOG_HEADER  *Log,
+  IN UINT32                         Token,
+  IN CONST CHAR8                    *Format,
+  IN UINTN                          Length
+  )
+{
+  ADLINK_STATUS_CODE_LOG_FORMAT_ENTRY  *Entry;
+  ADLINK_STATUS_CODE_LOG_RECORD        *Record;
+  UINT64                               Position;
+  UINT8                                *Text;
+
+  Entry = &Log->Formats[Token % ADLINK_STATUS_CODE_LOG_FORMAT_CACHE];
+  if ((Entry->Token == Token) && (Entry->Position >= Log->Tail)) {
+    return;
+  }
+
+  Record = StatusCodeLogReserve (Log, sizeof (*Record) + Length + 1, &Position);
+  if (Record == NULL) {
+    return;
+  }
+
+  StatusCodeLogSetHeader (Record, sizeof (*Record) + Length + 1, ADLINK_STATUS_CODE_LOG_FORMAT, NULL);
+  Record->Token = Token;
+  Text          = (UINT8 *)(Record + 1);
+  CopyMem (Text, Format, Length);
+  Text[Length] = '\0';
+
+  Entry->Token    = Token;
+  Entry->Position = Position;
+}
+
+/**
+  Copy the string an argument points to, narrowed to ASCII.
+
+  @return Bytes written to Buffer, NUL included.
+
+**/
+STATIC
+UINTN
+StatusCodeLogCopyString (
+  OUT UINT8    *Buffer,
+  IN  UINT64   Argument,
+  IN  BOOLEAN  Unicode
+  )
+{
+  CONST CHAR8   *Ascii;
+  CONST CHAR16  *Wide;
+  UINTN         Index;
+
+  Ascii = (CONST CHAR8 *)(UINTN)Argument;
+  Wide  = (CONST CHAR16 *)(UINTN)Argument;
+  Index = 0;
+  if (Argument != 0) {
+    while (Index < ADLINK_STATUS_CODE_LOG_MAX_STRING - 1) {
+      Buffer[Index] = Unicode ? (UINT8)Wide[Index] : (UINT8)Ascii[Index];
+      if (Buffer[Index] == '\0') {
+        break;
+      }
+
+      Index++;
+    }
+  }
+
+  Buffer[Index] = '\0';
+  return Index + 1;
+}
+
+/**
+  Return whether a character of a conversion specification comes before
+  its type: a flag, the width or the precision.
+
+**/
+STATIC
+BOOLEAN
+StatusCodeLogIsFlag (
+  IN CHAR8  Char
+  )
+{
+  return (BOOLEAN)(((Char >= '0') && (Char <= '9')) ||
+                   (Char == '-') || (Char == '+') || (Char == ' ') ||
+                   (Char == ',') || (Char == '#') || (Char == '.'));
+}
+
+ADLINK_STATUS_CODE_LOG_HEADER *
+EFIAPI
+StatusCodeLogInitialize (
+  OUT VOID   *Buffer,
+  IN  UINTN  BufferSize
+  )
+{
+  ADLINK_STATUS_CODE_LOG_HEADER  *Log;
+
+  if ((Buffer == NULL) || (BufferSize < sizeof (*Log) + STATUS_CODE_LOG_MIN_SIZE)) {
+    return NULL;
+  }
+
+  Log = Buffer;
+  ZeroMem (Log, sizeof (*Log));
+  Log->Signature = ADLINK_STATUS_CODE_LOG_SIGNATURE;
+  Log->Size      = (UINT32)MIN (
+                             (BufferSize - sizeof (*Log)) & ~(ADLINK_STATUS_CODE_LOG_ALIGNMENT - 1),
+                             MAX_UINT32 & ~(ADLINK_STATUS_CODE_LOG_ALIGNMENT - 1)
+                             );
+  Log->Frequency = GetPerformanceCounterProperties (NULL, NULL);
+
+  return Log;
+}
+
+VOID
+EFIAPI
+StatusCodeLogDebug (
+  IN ADLINK_STATUS_CODE_LOG_HEADER  *Log,
+  IN CONST EFI_GUID                 *CallerId  OPTIONAL,
+  IN UINT32                         ErrorLevel,
+  IN CONST CHAR8                    *Format,
+  IN BASE_LIST                      Marker
+  )
+{
+  ADLINK_STATUS_CODE_LOG_RECORD  *Record;
+  UINT64                         Args[ADLINK_STATUS_CODE_LOG_MAX_ARGS];
+  UINT8                          Strings[STATUS_CODE_LOG_MAX_DEBUG_DATA - sizeof (Args)];
+  UINTN                          ArgCount;
+  UINTN                          StringsSize;
+  UINTN                          Length;
+  UINTN                          Index;
+  UINT64                         Position;
+  UINT32                         Token;
+  BOOLEAN                        Long;
+  CONST EFI_GUID                 *Guid;
+
+  Token = StatusCodeLogToken (Format, &Length);
+
+  //
+  // Take the arguments off the BASE_LIST the way PrintLib would, keeping
+  // copies of what pointer arguments point to.
+  //
+  ArgCount    = 0;
+  StringsSize = 0;
+  for (Index = 0; (Index < Length) && (ArgCount < ADLINK_STATUS_CODE_LOG_MAX_ARGS); Index++) {
+    if (Format[Index] != '%') {
+      continue;
+    }
+
+    Long = FALSE;
+    for (Index++; Index < Length; Index++) {
+      if ((Format[Index] == 'l') || (Format[Index] == 'L')) {
+        Long = TRUE;
+      } else if (Format[Index] == '*') {
+        Args[ArgCount++] = (UINT64)BASE_ARG (Marker, UINTN);
+        if (ArgCount == ADLINK_STATUS_CODE_LOG_MAX_ARGS) {
+          break;
+        }
+      } else if (!StatusCodeLogIsFlag (Format[Index])) {
+        break;
+      }
+    }
+
+    if ((Index == Length) || (ArgCount == ADLINK_STATUS_CODE_LOG_MAX_ARGS)) {
+      break;
+    }
+
+    switch (Format[Index]) {
+      case 'a':
+      case 's':
+      case 'S':
+        Args[ArgCount] = (UINT64)(UINTN)BASE_ARG (Marker, VOID *);
+        StringsSize   += StatusCodeLogCopyString (&Strings[StringsSize], Args[ArgCount], (BOOLEAN)(Format[Index] != 'a'));
+        ArgCount++;
+        break;
+
+      case 'g':
+        Args[ArgCount] = (UINT64)(UINTN)BASE_ARG (Marker, VOID *);
+        Guid           = (CONST EFI_GUID *)(UINTN)Args[ArgCount];
+        if (Guid != NULL) {
+          CopyMem (&Strings[StringsSize], Guid, sizeof (EFI_GUID));
+        } else {
+          ZeroMem (&Strings[StringsSize], sizeof (EFI_GUID));
+        }
+
+        StringsSize += sizeof (EFI_GUID);
+        ArgCount++;
+        break;
+
+      case 't':
+        Args[ArgCount++] = (UINT64)(UINTN)BASE_ARG (Marker, VOID *);
+        break;
+
+      case 'p':
+        Args[ArgCount++] = (UINT64)(UINTN)BASE_ARG (Marker, VOID *);
+        break;
+
+      case 'r':
+        Args[ArgCount++] = (UINT64)BASE_ARG (Marker, RETURN_STATUS);
+        break;
+
+      case 'c':
+        Args[ArgCount++] = (UINT64)BASE_ARG (Marker, UINTN);
+        break;
+
+      case 'X':
+      case 'x':
+      case 'd':
+      case 'u':
+        if (Long) {
+          Args[ArgCount++] = BASE_ARG (Marker, UINT64);
+        } else {
+          Args[ArgCount++] = (UINT64)(UINT32)BASE_ARG (Marker, int);
+        }
+
+        break;
+
+      default:
+        break;
+    }
+  }
+
+  StatusCodeLogFormat (Log, Token, Format, Length);
+
+  Record = StatusCodeLogReserve (
+             Log,
+             sizeof (*Record) + ArgCount * sizeof (UINT64) + StringsSize,
+             &Position
+             );
+  if (Record == NULL) {
+    return;
+  }
+
+  StatusCodeLogSetHeader (
+    Record,
+    sizeof (*Record) + ArgCount * sizeof (UINT64) + StringsSize,
+    ADLINK_STATUS_CODE_LOG_DEBUG,
+    CallerId
+    );
+  Record->ArgCount = (UINT8)ArgCount;
+  Record->Token    = Token;
+  Record->CodeType = ErrorLevel;
+  CopyMem (Record + 1, Args, ArgCount * sizeof (UINT64));
+  CopyMem ((UINT64 *)(Record + 1) + ArgCount, Strings, StringsSize);
+}
+
+VOID
+EFIAPI
+StatusCodeLogCode (
+  IN ADLINK_STATUS_CODE_LOG_HEADER  *Log,
+  IN CONST EFI_GUID                 *CallerId  OPTIONAL,
+  IN EFI_STATUS_CODE_TYPE           CodeType,
+  IN EFI_STATUS_CODE_VALUE          Value,
+  IN UINT32                         Instance
+  )
+{
+  ADLINK_STATUS_CODE_LOG_RECORD  *Record;
+  UINT64                         Position;
+
+  Record = StatusCodeLogReserve (Log, sizeof (*Record), &Position);
+  if (Record == NULL) {
+    return;
+  }
+
+  StatusCodeLogSetHeader (Record, sizeof (*Record), ADLINK_STATUS_CODE_LOG_CODE, CallerId);
+  Record->CodeType = CodeType;
+  Record->Value    = Value;
+  Record->Instance = Instance;
+}
+
+VOID
+EFIAPI
+StatusCodeLogAppendLog (
+  IN ADLINK_STATUS_CODE_LOG_HEADER        *Log,
+  IN CONST ADLINK_STATUS_CODE_LOG_HEADER  *Source
+  )
+{
+  CONST ADLINK_STATUS_CODE_LOG_RECORD  *From;
+  ADLINK_STATUS_CODE_LOG_RECORD        *To;
+  ADLINK_STATUS_CODE_LOG_FORMAT_ENTRY  *Entry;
+  UINT64                               Walk;
+  UINT64                               Position;
+  UINT32                               Offset;
+
+  Log->Overwritten += Source->Overwritten;
+
+  for (Walk = Source->Tail; Walk < Source->Head; Walk = StatusCodeLogNext (Source, Walk)) {
+    DivU64x32Remainder (Walk, Source->Size, &Offset);
+    From = (CONST ADLINK_STATUS_CODE_LOG_RECORD *)((CONST UINT8 *)(Source + 1) + Offset);
+    if (From->Type == ADLINK_STATUS_CODE_LOG_PAD) {
+      continue;
+    }
+
+    To = StatusCodeLogReserve (Log, From->Size, &Position);
+    if (To == NULL) {
+      continue;
+    }
+
+    CopyMem (To, From, From->Size);
+    if (From->Type == ADLINK_STATUS_CODE_LOG_FORMAT) {
+      Entry           = &Log->Formats[From->Token % ADLINK_STATUS_CODE_LOG_FORMAT_CACHE];
+      Entry->Token    = From->Token;
+      Entry->Position = Position;
+    }
+  }
+}
@@ -0,0 +1,126 @@
+/** @file
+  Decisions of the status code routing policy described in
+  Guid/StatusCodeRouting.h.
+
+  Copyright (c) 2022, ADLink. All rights reserved.<BR>
+
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#include <Base.h>
+#include <Guid/StatusCodeDataTypeDebug.h>
+#include <Library/BaseMemoryLib.h>
+#include <Library/StatusCodeRoutingLib.h>
+
+/**
+  Fill a policy forwarding every status code to every sink.
+
+  @param[out] Routing  The policy.
+
+**/
+VOID
+EFIAPI
+StatusCodeRoutingSetDefault (
+  OUT ADLINK_STATUS_CODE_ROUTING  *Routing
+  )
+{
+  ZeroMem (Routing, sizeof (*Routing));
+  Routing->Signature = ADLINK_STATUS_CODE_ROUTING_SIGNATURE;
+  SetMem (Routing->Sinks, sizeof (Routing->Sinks), 0xFF);
+}
+
+/**
+  Tell whether a policy read from the variable or the HOB can be used.
+
+  @param[in] Routing  The policy.
+  @param[in] Size     Size of the policy as read.
+
+  @retval TRUE   The policy is well formed.
+  @retval FALSE  The policy is to be ignored.
+
+**/
+BOOLEAN
+EFIAPI
+StatusCodeRoutingIsValid (
+  IN CONST ADLINK_STATUS_CODE_ROUTING  *Routing,
+  IN UINTN                             Size
+  )
+{
+  return (BOOLEAN)((Size == sizeof (*Routing)) &&
+                   (Routing->Signature == ADLINK_STATUS_CODE_ROUTING_SIGNATURE) &&
+                   (Routing->CallerCount <= ADLINK_STATUS_CODE_ROUTING_CALLERS));
+}
+
+/**
+  Tell whether a policy forwards a status code to a sink.
+
+  The code type and severity masks are tested first. The DEBUG () error
+  level and the caller rules are only looked at for a DEBUG () message
+  that passed them.
+
+  @param[in] Routing   The policy.
+  @param[in] Sink      ADLINK_STATUS_CODE_SINK_*.
+  @param[in] CodeType  The type of the status code.
+  @param[in] CallerId  The reporting module, or NULL.
+  @param[in] Data      The data of the status code, or NULL.
+
+  @retval TRUE   The status code goes to the sink.
+  @retval FALSE  The sink does not take the status code.
+
+**/
+BOOLEAN
+EFIAPI
+StatusCodeRoutingAccepts (
+  IN CONST ADLINK_STATUS_CODE_ROUTING  *Routing,
+  IN UINTN                             Sink,
+  IN EFI_STATUS_CODE_TYPE              CodeType,
+  IN CONST EFI_GUID                    *CallerId  OPTIONAL,
+  IN CONST EFI_STATUS_CODE_DATA        *Data      OPTIONAL
+  )
+{
+  CONST ADLINK_STATUS_CODE_ROUTE  *Route;
+  CONST EFI_DEBUG_INFO            *DebugInfo;
+  UINT32                          Type;
+  UINT32                          ErrorLevels;
+  UINTN                           Index;
+
+  if (Sink >= ADLINK_STATUS_CODE_SINK_COUNT) {
+    return FALSE;
+  }
+
+  Route = &Routing->Sinks[Sink];
+  Type  = CodeType & EFI_STATUS_CODE_TYPE_MASK;
+  if ((Type >= 32) || ((Route->CodeTypes & (1U << Type)) == 0)) {
+    return FALSE;
+  }
+
+  if ((Type == EFI_ERROR_CODE) && ((Route->Severities & (1U << (CodeType >> 28))) == 0)) {
+    return FALSE;
+  }
+
+  //
+  // Same test as ReportStatusCodeExtractDebugInfo (): a DEBUG () message
+  // carries an EFI_DEBUG_INFO right after the data header.
+  //
+  if ((Type != EFI_DEBUG_CODE) || (Data == NULL) ||
+      !CompareGuid (&Data->Type, &gEfiStatusCodeDataTypeDebugGuid))
+  {
+    return TRUE;
+  }
+
+  DebugInfo   = (CONST EFI_DEBUG_INFO *)(Data + 1);
+  ErrorLevels = Route->ErrorLevels;
+  if (CallerId != NULL) {
+    for (Index = 0; Index < Routing->CallerCount; Index++) {
+      if (((Routing->Callers[Index].Sinks & (1U << Sink)) != 0) &&
+          CompareGuid (&Routing->Callers[Index].CallerId, CallerId))
+      {
+        ErrorLevels = Routing->Callers[Index].ErrorLevels;
+        break;
+      }
+    }
+  }
+
+  return (BOOLEAN)((DebugInfo->ErrorLevel & ErrorLevels) != 0);
+}
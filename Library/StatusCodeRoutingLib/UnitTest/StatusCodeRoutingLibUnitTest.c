@@ -0,0 +1,281 @@
+/** @file
+  Host based unit tests of the Status Code Routing Library.
+
+  Copyright (c) 2022, ADLink. All rights reserved.<BR>
+
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#include <Uefi.h>
+#include <Guid/StatusCodeDataTypeDebug.h>
+#include <Library/BaseMemoryLib.h>
+#include <Library/DebugLib.h>
+#include <Library/StatusCodeRoutingLib.h>
+#include <Library/UnitTestLib.h>
+
+#define UNIT_TEST_APP_NAME     "Status Code Routing Library Unit Tests"
+#define UNIT_TEST_APP_VERSION  "1.0"
+
+///
+/// What DEBUG () reports through ReportStatusCode ().
+///
+typedef struct {
+  EFI_STATUS_CODE_DATA    Header;
+  EFI_DEBUG_INFO          Info;
+} ROUTING_TEST_DEBUG_DATA;
+
+STATIC CONST EFI_GUID  mRoutingTestCaller = {
+  0x2b341f3e, 0xb2b7, 0x4b36, { 0xbf, 0xc9, 0x81, 0x3d, 0x0c, 0x00, 0xab, 0xd8 }
+};
+
+STATIC CONST EFI_GUID  mRoutingTestOtherCaller = {
+  0x9cb4c42e, 0x40fd, 0x4ff5, { 0x96, 0x1a, 0x71, 0x73, 0x59, 0x3f, 0x3f, 0x3e }
+};
+
+/**
+  Build the data of a DEBUG () message at ErrorLevel.
+
+**/
+STATIC
+VOID
+RoutingTestDebugData (
+  OUT ROUTING_TEST_DEBUG_DATA  *Data,
+  IN  UINT32                   ErrorLevel
+  )
+{
+  ZeroMem (Data, sizeof (*Data));
+  Data->Header.HeaderSize = sizeof (Data->Header);
+  Data->Header.Size       = sizeof (Data->Info);
+  CopyGuid (&Data->Header.Type, &gEfiStatusCodeDataTypeDebugGuid);
+  Data->Info.ErrorLevel = ErrorLevel;
+}
+
+/**
+  Without a policy, every status code goes to every sink.
+
+**/
+STATIC
+UNIT_TEST_STATUS
+EFIAPI
+DefaultAcceptsAll (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  ADLINK_STATUS_CODE_ROUTING  Routing;
+  ROUTING_TEST_DEBUG_DATA     Debug;
+  UINTN                       Sink;
+
+  StatusCodeRoutingSetDefault (&Routing);
+  UT_ASSERT_TRUE (StatusCodeRoutingIsValid (&Routing, sizeof (Routing)));
+  RoutingTestDebugData (&Debug, DEBUG_VERBOSE);
+
+  for (Sink = 0; Sink < ADLINK_STATUS_CODE_SINK_COUNT; Sink++) {
+    UT_ASSERT_TRUE (StatusCodeRoutingAccepts (&Routing, Sink, EFI_PROGRESS_CODE, NULL, NULL));
+    UT_ASSERT_TRUE (StatusCodeRoutingAccepts (&Routing, Sink, EFI_ERROR_CODE | EFI_ERROR_MINOR, NULL, NULL));
+    UT_ASSERT_TRUE (StatusCodeRoutingAccepts (&Routing, Sink, EFI_DEBUG_CODE, &mRoutingTestCaller, &Debug.Header));
+  }
+
+  UT_ASSERT_FALSE (StatusCodeRoutingAccepts (&Routing, ADLINK_STATUS_CODE_SINK_COUNT, EFI_PROGRESS_CODE, NULL, NULL));
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  A sink only takes the code types and error severities set in its masks.
+
+**/
+STATIC
+UNIT_TEST_STATUS
+EFIAPI
+CodeTypeAndSeverityMasks (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  ADLINK_STATUS_CODE_ROUTING  Routing;
+  ADLINK_STATUS_CODE_ROUTE    *Route;
+
+  StatusCodeRoutingSetDefault (&Routing);
+  Route             = &Routing.Sinks[ADLINK_STATUS_CODE_SINK_POST_CODE];
+  Route->CodeTypes  = (1U << EFI_PROGRESS_CODE) | (1U << EFI_ERROR_CODE);
+  Route->Severities = 1U << (EFI_ERROR_UNRECOVERED >> 28);
+
+  UT_ASSERT_TRUE (StatusCodeRoutingAccepts (&Routing, ADLINK_STATUS_CODE_SINK_POST_CODE, EFI_PROGRESS_CODE, NULL, NULL));
+  UT_ASSERT_FALSE (StatusCodeRoutingAccepts (&Routing, ADLINK_STATUS_CODE_SINK_POST_CODE, EFI_DEBUG_CODE, NULL, NULL));
+  UT_ASSERT_TRUE (StatusCodeRoutingAccepts (&Routing, ADLINK_STATUS_CODE_SINK_POST_CODE, EFI_ERROR_CODE | EFI_ERROR_UNRECOVERED, NULL, NULL));
+  UT_ASSERT_FALSE (StatusCodeRoutingAccepts (&Routing, ADLINK_STATUS_CODE_SINK_POST_CODE, EFI_ERROR_CODE | EFI_ERROR_MINOR, NULL, NULL));
+  UT_ASSERT_FALSE (StatusCodeRoutingAccepts (&Routing, ADLINK_STATUS_CODE_SINK_POST_CODE, 0x20, NULL, NULL));
+
+  //
+  // Other sinks keep their own masks.
+  //
+  UT_ASSERT_TRUE (StatusCodeRoutingAccepts (&Routing, ADLINK_STATUS_CODE_SINK_SERIAL, EFI_DEBUG_CODE, NULL, NULL));
+  UT_ASSERT_TRUE (StatusCodeRoutingAccepts (&Routing, ADLINK_STATUS_CODE_SINK_SERIAL, EFI_ERROR_CODE | EFI_ERROR_MINOR, NULL, NULL));
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  A DEBUG () message goes through when one of its error levels is set for
+  the sink. Debug codes without a DEBUG () message are not filtered on it.
+
+**/
+STATIC
+UNIT_TEST_STATUS
+EFIAPI
+ErrorLevels (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  ADLINK_STATUS_CODE_ROUTING  Routing;
+  ROUTING_TEST_DEBUG_DATA     Debug;
+
+  StatusCodeRoutingSetDefault (&Routing);
+  Routing.Sinks[ADLINK_STATUS_CODE_SINK_SERIAL].ErrorLevels = DEBUG_ERROR | DEBUG_WARN;
+
+  RoutingTestDebugData (&Debug, DEBUG_INFO);
+  UT_ASSERT_FALSE (StatusCodeRoutingAccepts (&Routing, ADLINK_STATUS_CODE_SINK_SERIAL, EFI_DEBUG_CODE, NULL, &Debug.Header));
+  UT_ASSERT_TRUE (StatusCodeRoutingAccepts (&Routing, ADLINK_STATUS_CODE_SINK_MEMORY, EFI_DEBUG_CODE, NULL, &Debug.Header));
+
+  RoutingTestDebugData (&Debug, DEBUG_WARN);
+  UT_ASSERT_TRUE (StatusCodeRoutingAccepts (&Routing, ADLINK_STATUS_CODE_SINK_SERIAL, EFI_DEBUG_CODE, NULL, &Debug.Header));
+
+  RoutingTestDebugData (&Debug, DEBUG_INFO);
+  ZeroMem (&Debug.Header.Type, sizeof (Debug.Header.Type));
+  UT_ASSERT_TRUE (StatusCodeRoutingAccepts (&Routing, ADLINK_STATUS_CODE_SINK_SERIAL, EFI_DEBUG_CODE, NULL, &Debug.Header));
+  UT_ASSERT_TRUE (StatusCodeRoutingAccepts (&Routing, ADLINK_STATUS_CODE_SINK_SERIAL, EFI_DEBUG_CODE, NULL, NULL));
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  A caller rule replaces the error levels of the sinks it names, for that
+  caller only.
+
+**/
+STATIC
+UNIT_TEST_STATUS
+EFIAPI
+CallerRules (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  ADLINK_STATUS_CODE_ROUTING  Routing;
+  ROUTING_TEST_DEBUG_DATA     Debug;
+
+  StatusCodeRoutingSetDefault (&Routing);
+  Routing.Sinks[ADLINK_STATUS_CODE_SINK_SERIAL].ErrorLevels = DEBUG_ERROR;
+  Routing.CallerCount                                       = 2;
+  CopyGuid (&Routing.Callers[0].CallerId, &mRoutingTestCaller);
+  Routing.Callers[0].Sinks       = 1U << ADLINK_STATUS_CODE_SINK_SERIAL;
+  Routing.Callers[0].ErrorLevels = DEBUG_ERROR | DEBUG_INFO;
+  CopyGuid (&Routing.Callers[1].CallerId, &mRoutingTestOtherCaller);
+  Routing.Callers[1].Sinks       = 1U << ADLINK_STATUS_CODE_SINK_BINARY_LOG;
+  Routing.Callers[1].ErrorLevels = 0;
+
+  RoutingTestDebugData (&Debug, DEBUG_INFO);
+  UT_ASSERT_TRUE (StatusCodeRoutingAccepts (&Routing, ADLINK_STATUS_CODE_SINK_SERIAL, EFI_DEBUG_CODE, &mRoutingTestCaller, &Debug.Header));
+  UT_ASSERT_FALSE (StatusCodeRoutingAccepts (&Routing, ADLINK_STATUS_CODE_SINK_SERIAL, EFI_DEBUG_CODE, &mRoutingTestOtherCaller, &Debug.Header));
+  UT_ASSERT_FALSE (StatusCodeRoutingAccepts (&Routing, ADLINK_STATUS_CODE_SINK_SERIAL, EFI_DEBUG_CODE, NULL, &Debug.Header));
+
+  //
+  // ErrorLevels 0 mutes the module on its sinks only.
+  //
+  UT_ASSERT_FALSE (StatusCodeRoutingAccepts (&Routing, ADLINK_STATUS_CODE_SINK_BINARY_LOG, EFI_DEBUG_CODE, &mRoutingTestOtherCaller, &Debug.Header));
+  UT_ASSERT_TRUE (StatusCodeRoutingAccepts (&Routing, ADLINK_STATUS_CODE_SINK_BINARY_LOG, EFI_DEBUG_CODE, &mRoutingTestCaller, &Debug.Header));
+  UT_ASSERT_TRUE (StatusCodeRoutingAccepts (&Routing, ADLINK_STATUS_CODE_SINK_BINARY_LOG, EFI_PROGRESS_CODE, &mRoutingTestOtherCaller, NULL));
+
+  //
+  // Rules past CallerCount are ignored.
+  //
+  Routing.CallerCount = 1;
+  UT_ASSERT_TRUE (StatusCodeRoutingAccepts (&Routing, ADLINK_STATUS_CODE_SINK_BINARY_LOG, EFI_DEBUG_CODE, &mRoutingTestOtherCaller, &Debug.Header));
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  A policy of the wrong size, signature or caller count is not used.
+
+**/
+STATIC
+UNIT_TEST_STATUS
+EFIAPI
+InvalidPolicy (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  ADLINK_STATUS_CODE_ROUTING  Routing;
+
+  StatusCodeRoutingSetDefault (&Routing);
+  UT_ASSERT_FALSE (StatusCodeRoutingIsValid (&Routing, sizeof (Routing) - 1));
+
+  Routing.CallerCount = ADLINK_STATUS_CODE_ROUTING_CALLERS + 1;
+  UT_ASSERT_FALSE (StatusCodeRoutingIsValid (&Routing, sizeof (Routing)));
+
+  Routing.CallerCount = ADLINK_STATUS_CODE_ROUTING_CALLERS;
+  UT_ASSERT_TRUE (StatusCodeRoutingIsValid (&Routing, sizeof (Routing)));
+
+  Routing.Signature = 0;
+  UT_ASSERT_FALSE (StatusCodeRoutingIsValid (&Routing, sizeof (Routing)));
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  Initialize the unit test framework, suite, and unit tests for the
+  Status Code Routing Library and run them.
+
+  @retval  EFI_SUCCESS           All test cases were dispatched.
+  @retval  EFI_OUT_OF_RESOURCES  There are not enough resources available to
+                                 initialize the unit tests.
+**/
+EFI_STATUS
+EFIAPI
+UnitTestingEntry (
+  VOID
+  )
+{
+  EFI_STATUS                  Status;
+  UNIT_TEST_FRAMEWORK_HANDLE  Framework;
+  UNIT_TEST_SUITE_HANDLE      Routing;
+
+  Framework = NULL;
+
+  DEBUG ((DEBUG_INFO, "%a v%a\n", UNIT_TEST_APP_NAME, UNIT_TEST_APP_VERSION));
+
+  Status = InitUnitTestFramework (&Framework, UNIT_TEST_APP_NAME, gEfiCallerBaseName, UNIT_TEST_APP_VERSION);
+  if (EFI_ERROR (Status)) {
+    DEBUG ((DEBUG_ERROR, "Failed in InitUnitTestFramework. Status = %r\n", Status));
+    goto EXIT;
+  }
+
+  Status = CreateUnitTestSuite (&Routing, Framework, "Status code routing", "StatusCodeRoutingLib.Routing", NULL, NULL);
+  if (EFI_ERROR (Status)) {
+    Status = EFI_OUT_OF_RESOURCES;
+    goto EXIT;
+  }
+
+  AddTestCase (Routing, "Default policy takes everything", "DefaultAcceptsAll", DefaultAcceptsAll, NULL, NULL, NULL);
+  AddTestCase (Routing, "Code type and severity masks", "CodeTypeAndSeverityMasks", CodeTypeAndSeverityMasks, NULL, NULL, NULL);
+  AddTestCase (Routing, "DEBUG () error levels", "ErrorLevels", ErrorLevels, NULL, NULL, NULL);
+  AddTestCase (Routing, "Caller rules", "CallerRules", CallerRules, NULL, NULL, NULL);
+  AddTestCase (Routing, "Malformed policy", "InvalidPolicy", InvalidPolicy, NULL, NULL, NULL);
+
+  Status = RunAllTestSuites (Framework);
+
+EXIT:
+  if (Framework != NULL) {
+    FreeUnitTestFramework (Framework);
+  }
+
+  return Status;
+}
+
+/**
+  Standard POSIX C entry point for host based unit test execution.
+
+**/
+int
+main (
+  int   argc,
+  char  *argv[]
+  )
+{
+  return UnitTestingEntry ();
+}
@@ -0,0 +1,225 @@
+/** @file
+  Host based benchmark of the XHCI memory pool.
+
+  Two workloads are timed on the host clock, so figures are only comparable
+  between runs on the same machine:
+  - Enumeration: 30 devices are attached and detached again and again, each
+    taking an input context, a device context and three transfer rings, the
+    way XhcInitializeDeviceSlot and XhcDisableSlotCmd allocate and free them.
+  - Translation: the PCI to host address translation done for every event
+    and transfer completion, over 40000 allocations, with the identity
+    mapping and with the PCI addresses offset from the host addresses.
+
+  Copyright (c) 2022, ADLink. All rights reserved.<BR>
+
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#include <stdio.h>
+#include <time.h>
+#include "UsbHcMemHost.h"
+
+#define USBHC_BENCH_DEVICES  30
+#define USBHC_BENCH_RINGS    3
+#define USBHC_BENCH_ROUNDS   2000
+
+#define USBHC_BENCH_ALLOCATIONS  40000
+#define USBHC_BENCH_LOOKUPS      20
+
+#define USBHC_BENCH_RING_SIZE  (sizeof (TRB_TEMPLATE) * TR_RING_TRB_NUMBER)
+
+STATIC VOID    *mUsbHcBenchInput[USBHC_BENCH_DEVICES];
+STATIC VOID    *mUsbHcBenchOutput[USBHC_BENCH_DEVICES];
+STATIC VOID    *mUsbHcBenchRing[USBHC_BENCH_DEVICES][USBHC_BENCH_RINGS];
+STATIC VOID    *mUsbHcBenchMem[USBHC_BENCH_ALLOCATIONS];
+STATIC UINTN   mUsbHcBenchSize[USBHC_BENCH_ALLOCATIONS];
+STATIC UINT32  mUsbHcBenchSeed;
+
+/**
+  Return the host clock in nanoseconds.
+
+**/
+STATIC
+UINT64
+UsbHcBenchNow (
+  VOID
+  )
+{
+  struct timespec  Now;
+
+  clock_gettime (CLOCK_MONOTONIC, &Now);
+  return (UINT64)Now.tv_sec * 1000000000 + Now.tv_nsec;
+}
+
+/**
+  Return the next value of the generator behind the translation workload.
+
+**/
+STATIC
+UINT32
+UsbHcBenchRandom (
+  VOID
+  )
+{
+  mUsbHcBenchSeed = mUsbHcBenchSeed * 1103515245 + 12345;
+  return mUsbHcBenchSeed >> 16;
+}
+
+/**
+  Attach and detach USBHC_BENCH_DEVICES devices USBHC_BENCH_ROUNDS times,
+  next to the memory the controller keeps while it runs, and print the
+  time per allocation and free.
+
+**/
+STATIC
+VOID
+UsbHcBenchEnumerate (
+  VOID
+  )
+{
+  USBHC_MEM_POOL         *Pool;
+  USBHC_HOST_STATISTICS  Statistics;
+  VOID                   *Dcbaa;
+  VOID                   *EventRing;
+  VOID                   *Erst;
+  VOID                   *CmdRing;
+  UINT64                 Start;
+  UINT64                 AllocNs;
+  UINT64                 FreeNs;
+  UINTN                  Objects;
+  UINTN                  Round;
+  UINTN                  Device;
+  UINTN                  Ring;
+
+  Pool      = UsbHcInitMemPool (UsbHcHostGetPciIo (0));
+  Dcbaa     = UsbHcAllocateMem (Pool, 257 * sizeof (UINT64));
+  EventRing = UsbHcAllocateMem (Pool, sizeof (TRB_TEMPLATE) * EVENT_RING_TRB_NUMBER);
+  Erst      = UsbHcAllocateMem (Pool, sizeof (EVENT_RING_SEG_TABLE_ENTRY));
+  CmdRing   = UsbHcAllocateMem (Pool, sizeof (TRB_TEMPLATE) * CMD_RING_TRB_NUMBER);
+
+  AllocNs = 0;
+  FreeNs  = 0;
+  Objects = 0;
+  for (Round = 0; Round < USBHC_BENCH_ROUNDS; Round++) {
+    Start = UsbHcBenchNow ();
+    for (Device = 0; Device < USBHC_BENCH_DEVICES; Device++) {
+      mUsbHcBenchInput[Device] = UsbHcAllocateMem (Pool, sizeof (INPUT_CONTEXT));
+      ZeroMem (mUsbHcBenchInput[Device], sizeof (INPUT_CONTEXT));
+      mUsbHcBenchOutput[Device] = UsbHcAllocateMem (Pool, sizeof (DEVICE_CONTEXT));
+      ZeroMem (mUsbHcBenchOutput[Device], sizeof (DEVICE_CONTEXT));
+      for (Ring = 0; Ring < USBHC_BENCH_RINGS; Ring++) {
+        mUsbHcBenchRing[Device][Ring] = UsbHcAllocateMem (Pool, USBHC_BENCH_RING_SIZE);
+        ZeroMem (mUsbHcBenchRing[Device][Ring], USBHC_BENCH_RING_SIZE);
+      }
+
+      Objects += 2 + USBHC_BENCH_RINGS;
+    }
+
+    AllocNs += UsbHcBenchNow () - Start;
+
+    Start = UsbHcBenchNow ();
+    for (Device = 0; Device < USBHC_BENCH_DEVICES; Device++) {
+      for (Ring = 0; Ring < USBHC_BENCH_RINGS; Ring++) {
+        UsbHcFreeMem (Pool, mUsbHcBenchRing[Device][Ring], USBHC_BENCH_RING_SIZE);
+      }
+
+      UsbHcFreeMem (Pool, mUsbHcBenchOutput[Device], sizeof (DEVICE_CONTEXT));
+      UsbHcFreeMem (Pool, mUsbHcBenchInput[Device], sizeof (INPUT_CONTEXT));
+    }
+
+    FreeNs += UsbHcBenchNow () - Start;
+  }
+
+  UsbHcHostGetStatistics (&Statistics);
+  printf (
+    "%-34s %10.1f %10.1f %8u %8u\n",
+    "Enumeration, 30 devices",
+    (double)AllocNs / Objects,
+    (double)FreeNs / Objects,
+    (unsigned)Statistics.Maps,
+    (unsigned)Pool->MaxBlocks
+    );
+
+  UsbHcFreeMem (Pool, CmdRing, sizeof (TRB_TEMPLATE) * CMD_RING_TRB_NUMBER);
+  UsbHcFreeMem (Pool, Erst, sizeof (EVENT_RING_SEG_TABLE_ENTRY));
+  UsbHcFreeMem (Pool, EventRing, sizeof (TRB_TEMPLATE) * EVENT_RING_TRB_NUMBER);
+  UsbHcFreeMem (Pool, Dcbaa, 257 * sizeof (UINT64));
+  UsbHcFreeMemPool (Pool);
+}
+
+/**
+  Allocate USBHC_BENCH_ALLOCATIONS small buffers and time the translation
+  of their PCI addresses back to host addresses.
+
+  @param[in] Name       Name of the row.
+  @param[in] PciOffset  Offset of the PCI addresses from the host addresses.
+
+**/
+STATIC
+VOID
+UsbHcBenchTranslate (
+  IN CONST CHAR8  *Name,
+  IN UINTN        PciOffset
+  )
+{
+  USBHC_MEM_POOL         *Pool;
+  USBHC_HOST_STATISTICS  Statistics;
+  volatile UINT64        Sum;
+  UINT64                 Start;
+  UINT64                 LookupNs;
+  UINTN                  Index;
+  UINTN                  Lookup;
+
+  Pool            = UsbHcInitMemPool (UsbHcHostGetPciIo (PciOffset));
+  mUsbHcBenchSeed = 1;
+  for (Index = 0; Index < USBHC_BENCH_ALLOCATIONS; Index++) {
+    mUsbHcBenchSize[Index] = ((UsbHcBenchRandom () % 4) == 0) ? 1024 : 16 + UsbHcBenchRandom () % 300;
+    mUsbHcBenchMem[Index]  = UsbHcAllocateMem (Pool, mUsbHcBenchSize[Index]);
+  }
+
+  Sum   = 0;
+  Start = UsbHcBenchNow ();
+  for (Lookup = 0; Lookup < USBHC_BENCH_LOOKUPS; Lookup++) {
+    for (Index = 0; Index < USBHC_BENCH_ALLOCATIONS; Index++) {
+      Sum += UsbHcGetHostAddrForPciAddr (Pool, (UINT8 *)mUsbHcBenchMem[Index] + PciOffset, 16);
+    }
+  }
+
+  LookupNs = UsbHcBenchNow () - Start;
+
+  UsbHcHostGetStatistics (&Statistics);
+  printf (
+    "%-34s %10.1f %10s %8u %8u\n",
+    Name,
+    (double)LookupNs / (USBHC_BENCH_LOOKUPS * USBHC_BENCH_ALLOCATIONS),
+    "",
+    (unsigned)Statistics.Maps,
+    (unsigned)Pool->MaxBlocks
+    );
+
+  for (Index = 0; Index < USBHC_BENCH_ALLOCATIONS; Index++) {
+    UsbHcFreeMem (Pool, mUsbHcBenchMem[Index], mUsbHcBenchSize[Index]);
+  }
+
+  UsbHcFreeMemPool (Pool);
+}
+
+/**
+  Standard POSIX C entry point for the host based benchmark.
+
+**/
+int
+main (
+  int   argc,
+  char  *argv[]
+  )
+{
+  printf ("%-34s %10s %10s %8s %8s\n", "Workload", "ns/alloc", "ns/free", "Maps", "Blocks");
+  UsbHcBenchEnumerate ();
+
+  printf ("%-34s %10s %10s %8s %8s\n", "", "ns/lookup", "", "", "");
+  UsbHcBenchTranslate ("Translation, identity mapping", 0);
+  UsbHcBenchTranslate ("Translation, translated mapping", SIZE_1GB);
+  return 0;
+}
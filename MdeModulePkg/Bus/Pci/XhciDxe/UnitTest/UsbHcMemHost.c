@@ -0,0 +1,119 @@
+/** @file
+  Host stand-ins for the PCI I/O protocol and boot services the XHCI memory
+  pool uses, for the host based tests and benchmark of UsbHcMem.c.
+
+  Copyright (c) 2022, ADLink. All rights reserved.<BR>
+
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#include "UsbHcMemHost.h"
+
+STATIC EFI_BOOT_SERVICES      mUsbHcHostBootServices;
+STATIC EFI_PCI_IO_PROTOCOL    mUsbHcHostPciIo;
+STATIC UINTN                  mUsbHcHostPciOffset;
+STATIC USBHC_HOST_STATISTICS  mUsbHcHostStatistics;
+
+EFI_BOOT_SERVICES  *gBS = &mUsbHcHostBootServices;
+
+STATIC
+EFI_STATUS
+EFIAPI
+UsbHcHostFreePool (
+  IN VOID  *Buffer
+  )
+{
+  FreePool (Buffer);
+  return EFI_SUCCESS;
+}
+
+STATIC
+EFI_STATUS
+EFIAPI
+UsbHcHostAllocateBuffer (
+  IN  EFI_PCI_IO_PROTOCOL  *This,
+  IN  EFI_ALLOCATE_TYPE    Type,
+  IN  EFI_MEMORY_TYPE      MemoryType,
+  IN  UINTN                Pages,
+  OUT VOID                 **HostAddress,
+  IN  UINT64               Attributes
+  )
+{
+  *HostAddress = AllocateAlignedPages (Pages, EFI_PAGE_SIZE);
+  if (*HostAddress == NULL) {
+    return EFI_OUT_OF_RESOURCES;
+  }
+
+  mUsbHcHostStatistics.LiveBuffers++;
+  return EFI_SUCCESS;
+}
+
+STATIC
+EFI_STATUS
+EFIAPI
+UsbHcHostFreeBuffer (
+  IN EFI_PCI_IO_PROTOCOL  *This,
+  IN UINTN                Pages,
+  IN VOID                 *HostAddress
+  )
+{
+  ASSERT (mUsbHcHostStatistics.LiveBuffers > 0);
+  FreeAlignedPages (HostAddress, Pages);
+  mUsbHcHostStatistics.LiveBuffers--;
+  return EFI_SUCCESS;
+}
+
+STATIC
+EFI_STATUS
+EFIAPI
+UsbHcHostMap (
+  IN     EFI_PCI_IO_PROTOCOL            *This,
+  IN     EFI_PCI_IO_PROTOCOL_OPERATION  Operation,
+  IN     VOID                           *HostAddress,
+  IN OUT UINTN                          *NumberOfBytes,
+  OUT    EFI_PHYSICAL_ADDRESS           *DeviceAddress,
+  OUT    VOID                           **Mapping
+  )
+{
+  *DeviceAddress = (EFI_PHYSICAL_ADDRESS)((UINTN)HostAddress + mUsbHcHostPciOffset);
+  *Mapping       = HostAddress;
+  mUsbHcHostStatistics.Maps++;
+  return EFI_SUCCESS;
+}
+
+STATIC
+EFI_STATUS
+EFIAPI
+UsbHcHostUnmap (
+  IN EFI_PCI_IO_PROTOCOL  *This,
+  IN VOID                 *Mapping
+  )
+{
+  return EFI_SUCCESS;
+}
+
+EFI_PCI_IO_PROTOCOL *
+UsbHcHostGetPciIo (
+  IN UINTN  PciOffset
+  )
+{
+  mUsbHcHostBootServices.FreePool = UsbHcHostFreePool;
+
+  mUsbHcHostPciIo.AllocateBuffer = UsbHcHostAllocateBuffer;
+  mUsbHcHostPciIo.FreeBuffer     = UsbHcHostFreeBuffer;
+  mUsbHcHostPciIo.Map            = UsbHcHostMap;
+  mUsbHcHostPciIo.Unmap          = UsbHcHostUnmap;
+
+  mUsbHcHostPciOffset = PciOffset;
+  ZeroMem (&mUsbHcHostStatistics, sizeof (mUsbHcHostStatistics));
+  return &mUsbHcHostPciIo;
+}
+
+VOID
+UsbHcHostGetStatistics (
+  OUT USBHC_HOST_STATISTICS  *Statistics
+  )
+{
+  CopyMem (Statistics, &mUsbHcHostStatistics, sizeof (*Statistics));
+}
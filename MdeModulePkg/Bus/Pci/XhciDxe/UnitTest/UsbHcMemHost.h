@@ -0,0 +1,53 @@
+/** @file
+  Host stand-ins for the PCI I/O protocol and boot services the XHCI memory
+  pool uses, for the host based tests and benchmark of UsbHcMem.c.
+
+  The buffers come from MemoryAllocationLib and are mapped at their host
+  address plus a chosen offset, so that both the identity and the
+  translated paths of the pool can be exercised.
+
+  Copyright (c) 2022, ADLink. All rights reserved.<BR>
+
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#ifndef USBHC_MEM_HOST_H_
+#define USBHC_MEM_HOST_H_
+
+#include "../Xhci.h"
+
+///
+/// What the stand-in PCI I/O protocol did since UsbHcHostGetPciIo ().
+///
+typedef struct {
+  UINTN    LiveBuffers;   ///< Buffers allocated and not freed yet.
+  UINTN    Maps;          ///< Buffers mapped.
+} USBHC_HOST_STATISTICS;
+
+/**
+  Return the stand-in PCI I/O protocol, and reset its statistics.
+
+  @param[in] PciOffset  Offset of the PCI address of a buffer from its host
+                        address, 0 for the identity mapping.
+
+  @return The PCI I/O protocol to create a memory pool with.
+
+**/
+EFI_PCI_IO_PROTOCOL *
+UsbHcHostGetPciIo (
+  IN UINTN  PciOffset
+  );
+
+/**
+  Return what the stand-in PCI I/O protocol did since UsbHcHostGetPciIo ().
+
+  @param[out] Statistics  The statistics.
+
+**/
+VOID
+UsbHcHostGetStatistics (
+  OUT USBHC_HOST_STATISTICS  *Statistics
+  );
+
+#endif
@@ -0,0 +1,465 @@
+/** @file
+  Host based unit tests of the XHCI memory pool.
+
+  Copyright (c) 2022, ADLink. All rights reserved.<BR>
+
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#include "UsbHcMemHost.h"
+#include <Library/UnitTestLib.h>
+
+#define UNIT_TEST_APP_NAME     "XHCI Memory Pool Unit Tests"
+#define UNIT_TEST_APP_VERSION  "1.0"
+
+#define USBHC_TEST_SLOTS       1000
+#define USBHC_TEST_OPERATIONS  50000
+
+//
+// PCI addresses of the translated mapping, 1 GB above the host addresses.
+//
+#define USBHC_TEST_PCI_OFFSET  ((UINTN)SIZE_1GB)
+
+#define USBHC_TEST_RING_SIZE  (sizeof (TRB_TEMPLATE) * TR_RING_TRB_NUMBER)
+
+//
+// A size of no size class, of which a block of USBHC_MEM_DEFAULT_PAGES
+// holds only one, so that each allocation past the head takes a block.
+//
+#define USBHC_TEST_BLOCK_SIZE  40000
+
+//
+// Sizes the random tests allocate: those of the size classes, and others
+// below, across and above a page and a block.
+//
+STATIC CONST UINTN  mUsbHcTestSizes[] = {
+  16,
+  64,
+  sizeof (DEVICE_CONTEXT),
+  sizeof (INPUT_CONTEXT),
+  sizeof (DEVICE_CONTEXT_64),
+  sizeof (INPUT_CONTEXT_64),
+  USBHC_TEST_RING_SIZE,
+  100,
+  700,
+  3000,
+  8192,
+  20000,
+  70000
+};
+
+STATIC VOID    *mUsbHcTestMem[USBHC_TEST_SLOTS];
+STATIC UINTN   mUsbHcTestSize[USBHC_TEST_SLOTS];
+STATIC UINT8   mUsbHcTestFill[USBHC_TEST_SLOTS];
+STATIC UINT32  mUsbHcTestSeed;
+
+/**
+  Return the next value of the generator behind the random tests.
+
+  @return A pseudo random number.
+
+**/
+STATIC
+UINT32
+UsbHcTestRandom (
+  VOID
+  )
+{
+  mUsbHcTestSeed = mUsbHcTestSeed * 1103515245 + 12345;
+  return mUsbHcTestSeed >> 16;
+}
+
+/**
+  Check that no memory block other than the head holds a cached allocation
+  while it has nothing else allocated, and that the counters of the pool
+  match its blocks.
+
+  @param[in] Pool  The memory pool.
+
+  @retval TRUE   The pool is consistent.
+  @retval FALSE  A block is kept by the cache, or a counter is wrong.
+
+**/
+STATIC
+BOOLEAN
+UsbHcTestPoolConsistent (
+  IN USBHC_MEM_POOL  *Pool
+  )
+{
+  USBHC_MEM_BLOCK  *Block;
+  UINTN            Used;
+  UINTN            Cached;
+  UINTN            Empty;
+
+  Used   = 0;
+  Cached = 0;
+  Empty  = 0;
+  for (Block = Pool->Head; Block != NULL; Block = Block->Next) {
+    if ((Block != Pool->Head) && (Block->Cached > 0) && (Block->Used == Block->Cached)) {
+      return FALSE;
+    }
+
+    if ((Block != Pool->Head) && (Block->Used == 0)) {
+      Empty++;
+    }
+
+    Used   += Block->Used - Block->Cached;
+    Cached += Block->Cached;
+  }
+
+  return (BOOLEAN)((Used == Pool->UsedUnits) && (Cached == Pool->CachedUnits) && (Empty == Pool->EmptyBlocks));
+}
+
+/**
+  Empty blocks stay mapped up to the reserve, and one more releases them
+  down to half the reserve. Allocations take the kept blocks back without
+  mapping again, and the high-water marks record the peak.
+
+**/
+STATIC
+UNIT_TEST_STATUS
+EFIAPI
+EmptyBlockReserve (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  USBHC_MEM_POOL         *Pool;
+  USBHC_HOST_STATISTICS  Statistics;
+  UINTN                  Reserve;
+  UINTN                  Count;
+  UINTN                  Index;
+
+  Pool = UsbHcInitMemPool (UsbHcHostGetPciIo (0));
+  UT_ASSERT_NOT_NULL (Pool);
+
+  Reserve = Pool->EmptyReserve;
+  Count   = Reserve + 2;
+  UT_ASSERT_TRUE (Reserve >= 2);
+  UT_ASSERT_TRUE (Count <= USBHC_TEST_SLOTS);
+
+  for (Index = 0; Index < Count; Index++) {
+    mUsbHcTestMem[Index] = UsbHcAllocateMem (Pool, USBHC_TEST_BLOCK_SIZE);
+    UT_ASSERT_NOT_NULL (mUsbHcTestMem[Index]);
+  }
+
+  UT_ASSERT_EQUAL (Pool->BlockCount, Count);
+
+  //
+  // The head keeps the first allocation. Emptying the reserve's worth of
+  // blocks keeps them all.
+  //
+  for (Index = 1; Index <= Reserve; Index++) {
+    UsbHcFreeMem (Pool, mUsbHcTestMem[Index], USBHC_TEST_BLOCK_SIZE);
+  }
+
+  UT_ASSERT_EQUAL (Pool->EmptyBlocks, Reserve);
+  UT_ASSERT_EQUAL (Pool->BlockCount, Count);
+
+  //
+  // One more goes down to half the reserve.
+  //
+  UsbHcFreeMem (Pool, mUsbHcTestMem[Count - 1], USBHC_TEST_BLOCK_SIZE);
+  UT_ASSERT_EQUAL (Pool->EmptyBlocks, Reserve / 2);
+  UT_ASSERT_EQUAL (Pool->BlockCount, 1 + Reserve / 2);
+  UsbHcHostGetStatistics (&Statistics);
+  UT_ASSERT_EQUAL (Statistics.LiveBuffers, Pool->BlockCount);
+
+  for (Index = 1; Index <= Reserve / 2; Index++) {
+    mUsbHcTestMem[Index] = UsbHcAllocateMem (Pool, USBHC_TEST_BLOCK_SIZE);
+    UT_ASSERT_NOT_NULL (mUsbHcTestMem[Index]);
+  }
+
+  UT_ASSERT_EQUAL (Pool->EmptyBlocks, 0);
+  UsbHcHostGetStatistics (&Statistics);
+  UT_ASSERT_EQUAL (Statistics.Maps, Count);
+
+  UT_ASSERT_EQUAL (Pool->MaxBlocks, Count);
+  UT_ASSERT_EQUAL (Pool->BlocksAllocated, Count);
+  UT_ASSERT_EQUAL (Pool->MaxUsedUnits, Count * USBHC_TEST_BLOCK_SIZE / USBHC_MEM_UNIT);
+  UT_ASSERT_EQUAL (Pool->UsedUnits, (1 + Reserve / 2) * USBHC_TEST_BLOCK_SIZE / USBHC_MEM_UNIT);
+
+  for (Index = 0; Index <= Reserve / 2; Index++) {
+    UsbHcFreeMem (Pool, mUsbHcTestMem[Index], USBHC_TEST_BLOCK_SIZE);
+  }
+
+  UT_ASSERT_EQUAL (Pool->UsedUnits, 0);
+  UsbHcFreeMemPool (Pool);
+  UsbHcHostGetStatistics (&Statistics);
+  UT_ASSERT_EQUAL (Statistics.LiveBuffers, 0);
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  Allocations and frees around a block boundary map the block once.
+
+**/
+STATIC
+UNIT_TEST_STATUS
+EFIAPI
+BoundaryNoRemap (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  USBHC_MEM_POOL         *Pool;
+  USBHC_HOST_STATISTICS  Statistics;
+  VOID                   *Head;
+  VOID                   *Mem;
+  UINTN                  Round;
+
+  Pool = UsbHcInitMemPool (UsbHcHostGetPciIo (0));
+  UT_ASSERT_NOT_NULL (Pool);
+
+  Head = UsbHcAllocateMem (Pool, USBHC_TEST_BLOCK_SIZE);
+  UT_ASSERT_NOT_NULL (Head);
+
+  for (Round = 0; Round < 100; Round++) {
+    Mem = UsbHcAllocateMem (Pool, USBHC_TEST_BLOCK_SIZE);
+    UT_ASSERT_NOT_NULL (Mem);
+    UsbHcFreeMem (Pool, Mem, USBHC_TEST_BLOCK_SIZE);
+  }
+
+  UsbHcHostGetStatistics (&Statistics);
+  UT_ASSERT_EQUAL (Statistics.Maps, 2);
+  UT_ASSERT_EQUAL (Pool->BlocksAllocated, 2);
+
+  UsbHcFreeMem (Pool, Head, USBHC_TEST_BLOCK_SIZE);
+  UsbHcFreeMemPool (Pool);
+  UsbHcHostGetStatistics (&Statistics);
+  UT_ASSERT_EQUAL (Statistics.LiveBuffers, 0);
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  Random allocations and frees keep their content and alignment, translate
+  both ways, and the pool releases every buffer it allocated when freed.
+
+  @param[in] Context  The PCI offset of the mapping, as a UINTN.
+
+**/
+STATIC
+UNIT_TEST_STATUS
+EFIAPI
+RandomAllocFree (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  USBHC_MEM_POOL         *Pool;
+  USBHC_HOST_STATISTICS  Statistics;
+  UINTN                  Offset;
+  UINTN                  Operation;
+  UINTN                  Slot;
+  UINTN                  Index;
+  UINT8                  *Mem;
+
+  Offset         = (UINTN)Context;
+  Pool           = UsbHcInitMemPool (UsbHcHostGetPciIo (Offset));
+  mUsbHcTestSeed = 7;
+  UT_ASSERT_NOT_NULL (Pool);
+
+  ZeroMem (mUsbHcTestMem, sizeof (mUsbHcTestMem));
+  for (Operation = 0; Operation < USBHC_TEST_OPERATIONS; Operation++) {
+    Slot = UsbHcTestRandom () % USBHC_TEST_SLOTS;
+    Mem  = mUsbHcTestMem[Slot];
+    if (Mem != NULL) {
+      for (Index = 0; Index < mUsbHcTestSize[Slot]; Index++) {
+        UT_ASSERT_EQUAL (Mem[Index], mUsbHcTestFill[Slot]);
+      }
+
+      UT_ASSERT_EQUAL (
+        UsbHcGetHostAddrForPciAddr (Pool, Mem + Offset, mUsbHcTestSize[Slot]),
+        (EFI_PHYSICAL_ADDRESS)(UINTN)Mem
+        );
+      UsbHcFreeMem (Pool, Mem, mUsbHcTestSize[Slot]);
+      mUsbHcTestMem[Slot] = NULL;
+    } else {
+      mUsbHcTestSize[Slot] = mUsbHcTestSizes[UsbHcTestRandom () % ARRAY_SIZE (mUsbHcTestSizes)];
+      mUsbHcTestFill[Slot] = (UINT8)Operation;
+      Mem                  = UsbHcAllocateMem (Pool, mUsbHcTestSize[Slot]);
+      UT_ASSERT_NOT_NULL (Mem);
+      UT_ASSERT_EQUAL ((UINTN)Mem & USBHC_MEM_UNIT_MASK, 0);
+      UT_ASSERT_EQUAL (
+        UsbHcGetPciAddrForHostAddr (Pool, Mem, mUsbHcTestSize[Slot]),
+        (EFI_PHYSICAL_ADDRESS)(UINTN)(Mem + Offset)
+        );
+      SetMem (Mem, mUsbHcTestSize[Slot], mUsbHcTestFill[Slot]);
+      mUsbHcTestMem[Slot] = Mem;
+    }
+
+    if ((Operation % 1000) == 0) {
+      UT_ASSERT_TRUE (UsbHcTestPoolConsistent (Pool));
+    }
+  }
+
+  for (Slot = 0; Slot < USBHC_TEST_SLOTS; Slot++) {
+    if (mUsbHcTestMem[Slot] != NULL) {
+      UsbHcFreeMem (Pool, mUsbHcTestMem[Slot], mUsbHcTestSize[Slot]);
+    }
+  }
+
+  UT_ASSERT_TRUE (UsbHcTestPoolConsistent (Pool));
+  UT_ASSERT_EQUAL (Pool->UsedUnits, 0);
+  UT_ASSERT_TRUE (Pool->BlockCount <= 1 + Pool->EmptyReserve);
+
+  UsbHcFreeMemPool (Pool);
+  UsbHcHostGetStatistics (&Statistics);
+  UT_ASSERT_EQUAL (Statistics.LiveBuffers, 0);
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  A freed allocation of a size class is counted as cached, not used, and
+  the next allocation of that size takes it back.
+
+**/
+STATIC
+UNIT_TEST_STATUS
+EFIAPI
+CachedNotUsed (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  USBHC_MEM_POOL  *Pool;
+  VOID            *Ring;
+  UINTN           Units;
+
+  Pool  = UsbHcInitMemPool (UsbHcHostGetPciIo (0));
+  Units = USBHC_MEM_ROUND (USBHC_TEST_RING_SIZE) / USBHC_MEM_UNIT;
+  UT_ASSERT_NOT_NULL (Pool);
+
+  Ring = UsbHcAllocateMem (Pool, USBHC_TEST_RING_SIZE);
+  UT_ASSERT_NOT_NULL (Ring);
+  UT_ASSERT_EQUAL (Pool->UsedUnits, Units);
+
+  UsbHcFreeMem (Pool, Ring, USBHC_TEST_RING_SIZE);
+  UT_ASSERT_EQUAL (Pool->UsedUnits, 0);
+  UT_ASSERT_EQUAL (Pool->CachedUnits, Units);
+
+  UT_ASSERT_EQUAL ((UINTN)UsbHcAllocateMem (Pool, USBHC_TEST_RING_SIZE), (UINTN)Ring);
+  UT_ASSERT_EQUAL (Pool->UsedUnits, Units);
+  UT_ASSERT_EQUAL (Pool->CachedUnits, 0);
+  UT_ASSERT_EQUAL (Pool->MaxUsedUnits, Units);
+
+  UsbHcFreeMem (Pool, Ring, USBHC_TEST_RING_SIZE);
+  UsbHcFreeMemPool (Pool);
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  Blocks filled with transfer rings are released once the rings are freed,
+  although the size class of the rings caches some of them.
+
+**/
+STATIC
+UNIT_TEST_STATUS
+EFIAPI
+CacheReleasesBlocks (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  USBHC_MEM_POOL         *Pool;
+  USBHC_HOST_STATISTICS  Statistics;
+  UINTN                  Count;
+  UINTN                  Index;
+  UINTN                  Blocks;
+
+  Pool = UsbHcInitMemPool (UsbHcHostGetPciIo (0));
+  UT_ASSERT_NOT_NULL (Pool);
+
+  //
+  // Enough rings for more blocks than the reserve of empty blocks keeps.
+  //
+  Count = 0;
+  while ((Pool->BlockCount < 2 * Pool->EmptyReserve + 2) && (Count < USBHC_TEST_SLOTS)) {
+    mUsbHcTestMem[Count] = UsbHcAllocateMem (Pool, USBHC_TEST_RING_SIZE);
+    UT_ASSERT_NOT_NULL (mUsbHcTestMem[Count]);
+    Count++;
+  }
+
+  Blocks = Pool->BlockCount;
+  UT_ASSERT_TRUE (Blocks > 1 + Pool->EmptyReserve);
+
+  //
+  // Free the newest rings first, so that the class cache fills up with
+  // rings of the newest block, which leaves it with cached rings only.
+  //
+  for (Index = Count; Index > 0; Index--) {
+    UsbHcFreeMem (Pool, mUsbHcTestMem[Index - 1], USBHC_TEST_RING_SIZE);
+    UT_ASSERT_TRUE (UsbHcTestPoolConsistent (Pool));
+  }
+
+  UT_ASSERT_EQUAL (Pool->UsedUnits, 0);
+  UT_ASSERT_TRUE (Pool->EmptyBlocks <= Pool->EmptyReserve);
+  UT_ASSERT_EQUAL (Pool->BlockCount, 1 + Pool->EmptyBlocks);
+
+  UsbHcFreeMemPool (Pool);
+  UsbHcHostGetStatistics (&Statistics);
+  UT_ASSERT_EQUAL (Statistics.LiveBuffers, 0);
+  UT_ASSERT_EQUAL (Statistics.Maps, Blocks);
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  Initialize the unit test framework, suite, and unit tests for the
+  XHCI memory pool and run the unit tests.
+
+  @retval EFI_SUCCESS           All test cases were dispatched.
+  @retval EFI_OUT_OF_RESOURCES  There are not enough resources available to
+                                initialize the unit tests.
+**/
+STATIC
+EFI_STATUS
+EFIAPI
+UnitTestingEntry (
+  VOID
+  )
+{
+  EFI_STATUS                  Status;
+  UNIT_TEST_FRAMEWORK_HANDLE  Framework;
+  UNIT_TEST_SUITE_HANDLE      Pool;
+
+  Framework = NULL;
+
+  DEBUG ((DEBUG_INFO, "%a v%a\n", UNIT_TEST_APP_NAME, UNIT_TEST_APP_VERSION));
+
+  Status = InitUnitTestFramework (&Framework, UNIT_TEST_APP_NAME, gEfiCallerBaseName, UNIT_TEST_APP_VERSION);
+  if (EFI_ERROR (Status)) {
+    DEBUG ((DEBUG_ERROR, "Failed in InitUnitTestFramework. Status = %r\n", Status));
+    goto EXIT;
+  }
+
+  Status = CreateUnitTestSuite (&Pool, Framework, "XHCI memory pool", "XhciDxe.UsbHcMem", NULL, NULL);
+  if (EFI_ERROR (Status)) {
+    Status = EFI_OUT_OF_RESOURCES;
+    goto EXIT;
+  }
+
+  AddTestCase (Pool, "Empty blocks are kept up to the reserve", "EmptyBlockReserve", EmptyBlockReserve, NULL, NULL, NULL);
+  AddTestCase (Pool, "A block boundary does not map again", "BoundaryNoRemap", BoundaryNoRemap, NULL, NULL, NULL);
+  AddTestCase (Pool, "Random allocations, identity mapping", "RandomIdentity", RandomAllocFree, NULL, NULL, (VOID *)0);
+  AddTestCase (Pool, "Random allocations, translated mapping", "RandomTranslated", RandomAllocFree, NULL, NULL, (VOID *)USBHC_TEST_PCI_OFFSET);
+  AddTestCase (Pool, "Cached allocations are not counted as used", "CachedNotUsed", CachedNotUsed, NULL, NULL, NULL);
+  AddTestCase (Pool, "The cache does not keep blocks", "CacheReleasesBlocks", CacheReleasesBlocks, NULL, NULL, NULL);
+
+  Status = RunAllTestSuites (Framework);
+
+EXIT:
+  if (Framework != NULL) {
+    FreeUnitTestFramework (Framework);
+  }
+
+  return Status;
+}
+
+/**
+  Standard POSIX C entry point for host based unit test execution.
+
+**/
+int
+main (
+  int   argc,
+  char  *argv[]
+  )
+{
+  return UnitTestingEntry ();
+}
@@ -0,0 +1,491 @@
+/** @file
+  Host based unit tests of the TRB to URB index of the XHCI transfer rings.
+
+  Copyright (c) 2022, ADLink. All rights reserved.<BR>
+
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#include "UsbHcMemHost.h"
+#include <Library/UnitTestLib.h>
+
+#define UNIT_TEST_APP_NAME     "XHCI TRB to URB Index Unit Tests"
+#define UNIT_TEST_APP_VERSION  "1.0"
+
+//
+// PCI addresses of the rings, 1 GB above the host addresses, so that an
+// event pointing at a host address is told apart from one at a PCI address.
+//
+#define XHC_TEST_PCI_OFFSET  ((UINTN)SIZE_1GB)
+
+#define XHC_TEST_SLOT_ID  1
+#define XHC_TEST_DCI      2
+
+//
+// The index of the link TRB, the last one of a transfer ring.
+//
+#define XHC_TEST_LINK_INDEX  (TR_RING_TRB_NUMBER - 1)
+
+//
+// The TRBs of a URB wrapping past the end of a transfer ring.
+//
+STATIC CONST UINTN  mXhcTestWrapTrbs[] = {
+  XHC_TEST_LINK_INDEX - 2,
+  XHC_TEST_LINK_INDEX - 1,
+  0,
+  1
+};
+
+/**
+  Create an XHCI instance with a memory pool, a command ring and a transfer
+  ring for the endpoint XHC_TEST_DCI of the slot XHC_TEST_SLOT_ID.
+
+  @return The XHCI instance, or NULL if out of resources.
+
+**/
+STATIC
+USB_XHCI_INSTANCE *
+XhcTestCreateXhc (
+  VOID
+  )
+{
+  USB_XHCI_INSTANCE  *Xhc;
+  TRANSFER_RING      *Ring;
+
+  Xhc  = AllocateZeroPool (sizeof (USB_XHCI_INSTANCE));
+  Ring = AllocateZeroPool (sizeof (TRANSFER_RING));
+  if ((Xhc == NULL) || (Ring == NULL)) {
+    return NULL;
+  }
+
+  Xhc->PciIo   = UsbHcHostGetPciIo (XHC_TEST_PCI_OFFSET);
+  Xhc->MemPool = UsbHcInitMemPool (Xhc->PciIo);
+  if (Xhc->MemPool == NULL) {
+    return NULL;
+  }
+
+  CreateTransferRing (Xhc, CMD_RING_TRB_NUMBER, &Xhc->CmdRing);
+  CreateTransferRing (Xhc, TR_RING_TRB_NUMBER, Ring);
+  Xhc->UsbDevContext[XHC_TEST_SLOT_ID].EndpointTransferRing[XHC_TEST_DCI - 1] = Ring;
+  return Xhc;
+}
+
+/**
+  Free the rings, the memory pool and the XHCI instance, and check that no
+  buffer of the pool is left.
+
+  @param[in] Xhc  The XHCI instance.
+
+  @retval TRUE   All the buffers were freed.
+  @retval FALSE  A buffer of the pool is left.
+
+**/
+STATIC
+BOOLEAN
+XhcTestFreeXhc (
+  IN USB_XHCI_INSTANCE  *Xhc
+  )
+{
+  TRANSFER_RING          *Ring;
+  USBHC_HOST_STATISTICS  Statistics;
+
+  Ring = Xhc->UsbDevContext[XHC_TEST_SLOT_ID].EndpointTransferRing[XHC_TEST_DCI - 1];
+  FreeTransferRing (Xhc, Ring);
+  FreePool (Ring);
+  FreeTransferRing (Xhc, &Xhc->CmdRing);
+  UsbHcFreeMemPool (Xhc->MemPool);
+  FreePool (Xhc);
+
+  UsbHcHostGetStatistics (&Statistics);
+  return (BOOLEAN)(Statistics.LiveBuffers == 0);
+}
+
+/**
+  Return the transfer ring of the endpoint XHC_TEST_DCI.
+
+  @param[in] Xhc  The XHCI instance.
+
+  @return The transfer ring.
+
+**/
+STATIC
+TRANSFER_RING *
+XhcTestRing (
+  IN USB_XHCI_INSTANCE  *Xhc
+  )
+{
+  return Xhc->UsbDevContext[XHC_TEST_SLOT_ID].EndpointTransferRing[XHC_TEST_DCI - 1];
+}
+
+/**
+  Queue the URB on TRBs of the ring, as XhcCreateTransferTrb () does once it
+  has built them.
+
+  @param[in] Urb     The URB.
+  @param[in] Ring    The ring.
+  @param[in] Start   The index of the first TRB of the URB.
+  @param[in] TrbNum  The number of TRBs of the URB, not counting the link TRB
+                     if they wrap.
+
+**/
+STATIC
+VOID
+XhcTestQueue (
+  IN URB            *Urb,
+  IN TRANSFER_RING  *Ring,
+  IN UINTN          Start,
+  IN UINTN          TrbNum
+  )
+{
+  UINTN  End;
+
+  End = (Start + TrbNum - 1) % (Ring->TrbNumber - 1);
+
+  Urb->Ring     = Ring;
+  Urb->TrbStart = (TRB_TEMPLATE *)Ring->RingSeg0 + Start;
+  Urb->TrbEnd   = (TRB_TEMPLATE *)Ring->RingSeg0 + End;
+  Urb->TrbNum   = TrbNum;
+  XhcUpdateTrbUrbIndex (Urb, TRUE);
+}
+
+/**
+  Build the transfer event the controller reports on a TRB of the transfer
+  ring of the endpoint XHC_TEST_DCI.
+
+  @param[in]  Ring    The ring.
+  @param[in]  Offset  The offset of the TRB pointer from the start of the ring.
+  @param[out] EvtTrb  The transfer event.
+
+**/
+STATIC
+VOID
+XhcTestEvent (
+  IN  TRANSFER_RING     *Ring,
+  IN  UINT64            Offset,
+  OUT EVT_TRB_TRANSFER  *EvtTrb
+  )
+{
+  EFI_PHYSICAL_ADDRESS  PhyAddr;
+
+  PhyAddr = Ring->RingSeg0Phy + Offset;
+
+  ZeroMem (EvtTrb, sizeof (*EvtTrb));
+  EvtTrb->TRBPtrLo   = XHC_LOW_32BIT (PhyAddr);
+  EvtTrb->TRBPtrHi   = XHC_HIGH_32BIT (PhyAddr);
+  EvtTrb->Type       = TRB_TYPE_TRANS_EVENT;
+  EvtTrb->EndpointId = XHC_TEST_DCI;
+  EvtTrb->SlotId     = XHC_TEST_SLOT_ID;
+}
+
+/**
+  A URB whose TRBs wrap past the end of the ring is indexed on the TRBs
+  before the link TRB and on the first ones of the ring, not on the link TRB,
+  and events on each of them find it.
+
+**/
+STATIC
+UNIT_TEST_STATUS
+EFIAPI
+RingWrap (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  USB_XHCI_INSTANCE  *Xhc;
+  TRANSFER_RING      *Ring;
+  EVT_TRB_TRANSFER   EvtTrb;
+  TRB_TEMPLATE       *Trb;
+  URB                Urb;
+  UINTN              Index;
+
+  Xhc = XhcTestCreateXhc ();
+  UT_ASSERT_NOT_NULL (Xhc);
+  Ring = XhcTestRing (Xhc);
+
+  ZeroMem (&Urb, sizeof (Urb));
+  XhcTestQueue (&Urb, Ring, mXhcTestWrapTrbs[0], ARRAY_SIZE (mXhcTestWrapTrbs));
+
+  for (Index = 0; Index < ARRAY_SIZE (mXhcTestWrapTrbs); Index++) {
+    UT_ASSERT_EQUAL ((UINTN)Ring->TrbUrb[mXhcTestWrapTrbs[Index]], (UINTN)&Urb);
+
+    XhcTestEvent (Ring, sizeof (TRB_TEMPLATE) * mXhcTestWrapTrbs[Index], &EvtTrb);
+    UT_ASSERT_EQUAL ((UINTN)XhcEventTrbToUrb (Xhc, &EvtTrb, &Trb), (UINTN)&Urb);
+    UT_ASSERT_EQUAL ((UINTN)Trb, (UINTN)((TRB_TEMPLATE *)Ring->RingSeg0 + mXhcTestWrapTrbs[Index]));
+  }
+
+  UT_ASSERT_EQUAL ((UINTN)Ring->TrbUrb[XHC_TEST_LINK_INDEX], 0);
+  UT_ASSERT_EQUAL ((UINTN)Ring->TrbUrb[2], 0);
+  UT_ASSERT_EQUAL ((UINTN)Ring->TrbUrb[XHC_TEST_LINK_INDEX - 3], 0);
+
+  //
+  // An event on the link TRB finds the TRB but no URB.
+  //
+  XhcTestEvent (Ring, sizeof (TRB_TEMPLATE) * XHC_TEST_LINK_INDEX, &EvtTrb);
+  UT_ASSERT_EQUAL ((UINTN)XhcEventTrbToUrb (Xhc, &EvtTrb, &Trb), 0);
+  UT_ASSERT_EQUAL ((UINTN)Trb, (UINTN)((TRB_TEMPLATE *)Ring->RingSeg0 + XHC_TEST_LINK_INDEX));
+
+  //
+  // Events past the ring, inside a TRB, or on the host address of a TRB
+  // find neither.
+  //
+  XhcTestEvent (Ring, sizeof (TRB_TEMPLATE) * TR_RING_TRB_NUMBER, &EvtTrb);
+  UT_ASSERT_EQUAL ((UINTN)XhcEventTrbToUrb (Xhc, &EvtTrb, &Trb), 0);
+  UT_ASSERT_EQUAL ((UINTN)Trb, 0);
+
+  XhcTestEvent (Ring, sizeof (TRB_TEMPLATE) * mXhcTestWrapTrbs[0] + 4, &EvtTrb);
+  UT_ASSERT_EQUAL ((UINTN)XhcEventTrbToUrb (Xhc, &EvtTrb, &Trb), 0);
+  UT_ASSERT_EQUAL ((UINTN)Trb, 0);
+
+  XhcTestEvent (Ring, sizeof (TRB_TEMPLATE) * mXhcTestWrapTrbs[0] - XHC_TEST_PCI_OFFSET, &EvtTrb);
+  UT_ASSERT_EQUAL ((UINTN)XhcEventTrbToUrb (Xhc, &EvtTrb, &Trb), 0);
+  UT_ASSERT_EQUAL ((UINTN)Trb, 0);
+
+  //
+  // Forgetting the URB clears the TRBs on both sides of the link TRB.
+  //
+  XhcUpdateTrbUrbIndex (&Urb, FALSE);
+  for (Index = 0; Index < TR_RING_TRB_NUMBER; Index++) {
+    UT_ASSERT_EQUAL ((UINTN)Ring->TrbUrb[Index], 0);
+  }
+
+  UT_ASSERT_TRUE (XhcTestFreeXhc (Xhc));
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  A command completion event finds the command URB on the command ring, not
+  on a transfer ring.
+
+**/
+STATIC
+UNIT_TEST_STATUS
+EFIAPI
+CommandRing (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  USB_XHCI_INSTANCE  *Xhc;
+  EVT_TRB_TRANSFER   EvtTrb;
+  TRB_TEMPLATE       *Trb;
+  URB                CmdUrb;
+  URB                Urb;
+
+  Xhc = XhcTestCreateXhc ();
+  UT_ASSERT_NOT_NULL (Xhc);
+
+  ZeroMem (&CmdUrb, sizeof (CmdUrb));
+  ZeroMem (&Urb, sizeof (Urb));
+  XhcTestQueue (&CmdUrb, &Xhc->CmdRing, 3, 1);
+  XhcTestQueue (&Urb, XhcTestRing (Xhc), 3, 1);
+
+  XhcTestEvent (&Xhc->CmdRing, sizeof (TRB_TEMPLATE) * 3, &EvtTrb);
+  EvtTrb.Type       = TRB_TYPE_COMMAND_COMPLT_EVENT;
+  EvtTrb.EndpointId = 0;
+  UT_ASSERT_EQUAL ((UINTN)XhcEventTrbToUrb (Xhc, &EvtTrb, &Trb), (UINTN)&CmdUrb);
+  UT_ASSERT_EQUAL ((UINTN)Trb, (UINTN)((TRB_TEMPLATE *)Xhc->CmdRing.RingSeg0 + 3));
+
+  //
+  // A transfer event of no endpoint is not on any ring.
+  //
+  EvtTrb.Type = TRB_TYPE_TRANS_EVENT;
+  UT_ASSERT_EQUAL ((UINTN)XhcEventTrbToUrb (Xhc, &EvtTrb, &Trb), 0);
+  UT_ASSERT_EQUAL ((UINTN)Trb, 0);
+
+  XhcUpdateTrbUrbIndex (&CmdUrb, FALSE);
+  XhcUpdateTrbUrbIndex (&Urb, FALSE);
+  UT_ASSERT_TRUE (XhcTestFreeXhc (Xhc));
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  An async interrupt URB queued again leaves its previous TRBs, without
+  clearing those another URB took over in between, and events on its new
+  TRBs find it.
+
+**/
+STATIC
+UNIT_TEST_STATUS
+EFIAPI
+UrbQueuedAgain (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  USB_XHCI_INSTANCE  *Xhc;
+  TRANSFER_RING      *Ring;
+  EVT_TRB_TRANSFER   EvtTrb;
+  TRB_TEMPLATE       *Trb;
+  URB                IntUrb;
+  URB                Urb;
+
+  Xhc = XhcTestCreateXhc ();
+  UT_ASSERT_NOT_NULL (Xhc);
+  Ring = XhcTestRing (Xhc);
+
+  ZeroMem (&IntUrb, sizeof (IntUrb));
+  ZeroMem (&Urb, sizeof (Urb));
+
+  //
+  // The interrupt URB completed on TRBs 10 and 11, and another URB was
+  // queued on TRBs 11 and 12 before the interrupt URB is queued again.
+  //
+  XhcTestQueue (&IntUrb, Ring, 10, 2);
+  XhcTestQueue (&Urb, Ring, 11, 2);
+  UT_ASSERT_EQUAL ((UINTN)Ring->TrbUrb[10], (UINTN)&IntUrb);
+  UT_ASSERT_EQUAL ((UINTN)Ring->TrbUrb[11], (UINTN)&Urb);
+
+  XhcUpdateTrbUrbIndex (&IntUrb, FALSE);
+  XhcTestQueue (&IntUrb, Ring, 13, 2);
+
+  UT_ASSERT_EQUAL ((UINTN)Ring->TrbUrb[10], 0);
+  UT_ASSERT_EQUAL ((UINTN)Ring->TrbUrb[11], (UINTN)&Urb);
+  UT_ASSERT_EQUAL ((UINTN)Ring->TrbUrb[12], (UINTN)&Urb);
+  UT_ASSERT_EQUAL ((UINTN)Ring->TrbUrb[13], (UINTN)&IntUrb);
+  UT_ASSERT_EQUAL ((UINTN)Ring->TrbUrb[14], (UINTN)&IntUrb);
+
+  XhcTestEvent (Ring, sizeof (TRB_TEMPLATE) * 10, &EvtTrb);
+  UT_ASSERT_EQUAL ((UINTN)XhcEventTrbToUrb (Xhc, &EvtTrb, &Trb), 0);
+  XhcTestEvent (Ring, sizeof (TRB_TEMPLATE) * 11, &EvtTrb);
+  UT_ASSERT_EQUAL ((UINTN)XhcEventTrbToUrb (Xhc, &EvtTrb, &Trb), (UINTN)&Urb);
+  XhcTestEvent (Ring, sizeof (TRB_TEMPLATE) * 14, &EvtTrb);
+  UT_ASSERT_EQUAL ((UINTN)XhcEventTrbToUrb (Xhc, &EvtTrb, &Trb), (UINTN)&IntUrb);
+
+  //
+  // Queued again on the same TRBs, the URB keeps them.
+  //
+  XhcUpdateTrbUrbIndex (&IntUrb, FALSE);
+  XhcTestQueue (&IntUrb, Ring, 13, 2);
+  UT_ASSERT_EQUAL ((UINTN)Ring->TrbUrb[13], (UINTN)&IntUrb);
+  UT_ASSERT_EQUAL ((UINTN)Ring->TrbUrb[14], (UINTN)&IntUrb);
+
+  XhcUpdateTrbUrbIndex (&Urb, FALSE);
+  XhcUpdateTrbUrbIndex (&IntUrb, FALSE);
+  UT_ASSERT_EQUAL ((UINTN)Ring->TrbUrb[11], 0);
+  UT_ASSERT_EQUAL ((UINTN)Ring->TrbUrb[14], 0);
+
+  UT_ASSERT_TRUE (XhcTestFreeXhc (Xhc));
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  Freeing a ring with URBs still on it detaches them, so that forgetting or
+  freeing them afterwards does not touch the freed ring, and events on the
+  freed ring find no URB.
+
+**/
+STATIC
+UNIT_TEST_STATUS
+EFIAPI
+RingFreedWithUrbs (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  USB_XHCI_INSTANCE  *Xhc;
+  TRANSFER_RING      *Ring;
+  EVT_TRB_TRANSFER   EvtTrb;
+  TRB_TEMPLATE       *Trb;
+  URB                *IntUrb;
+  URB                Urb;
+
+  Xhc = XhcTestCreateXhc ();
+  UT_ASSERT_NOT_NULL (Xhc);
+  Ring = XhcTestRing (Xhc);
+
+  IntUrb = AllocateZeroPool (sizeof (URB));
+  UT_ASSERT_NOT_NULL (IntUrb);
+  ZeroMem (&Urb, sizeof (Urb));
+  XhcTestQueue (IntUrb, Ring, XHC_TEST_LINK_INDEX - 1, 2);
+  XhcTestQueue (&Urb, Ring, 1, 3);
+
+  XhcTestEvent (Ring, sizeof (TRB_TEMPLATE) * 2, &EvtTrb);
+  FreeTransferRing (Xhc, Ring);
+
+  UT_ASSERT_EQUAL ((UINTN)Ring->TrbUrb, 0);
+  UT_ASSERT_EQUAL ((UINTN)Ring->RingSeg0, 0);
+  UT_ASSERT_EQUAL ((UINTN)IntUrb->Ring, 0);
+  UT_ASSERT_EQUAL (IntUrb->TrbNum, 0);
+  UT_ASSERT_EQUAL ((UINTN)Urb.Ring, 0);
+  UT_ASSERT_EQUAL (Urb.TrbNum, 0);
+
+  UT_ASSERT_EQUAL ((UINTN)XhcEventTrbToUrb (Xhc, &EvtTrb, &Trb), 0);
+  UT_ASSERT_EQUAL ((UINTN)Trb, 0);
+
+  //
+  // The async interrupt URBs of a removed device are freed after its slot.
+  //
+  XhcUpdateTrbUrbIndex (&Urb, FALSE);
+  XhcFreeUrb (Xhc, IntUrb);
+
+  //
+  // The endpoint gets a new ring when it is configured again.
+  //
+  CreateTransferRing (Xhc, TR_RING_TRB_NUMBER, Ring);
+  XhcTestQueue (&Urb, Ring, 1, 3);
+  XhcTestEvent (Ring, sizeof (TRB_TEMPLATE) * 2, &EvtTrb);
+  UT_ASSERT_EQUAL ((UINTN)XhcEventTrbToUrb (Xhc, &EvtTrb, &Trb), (UINTN)&Urb);
+
+  UT_ASSERT_TRUE (XhcTestFreeXhc (Xhc));
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  Initialize the unit test framework, suite, and unit tests for the TRB to
+  URB index and run the unit tests.
+
+  @retval EFI_SUCCESS           All test cases were dispatched.
+  @retval EFI_OUT_OF_RESOURCES  There are not enough resources available to
+                                initialize the unit tests.
+**/
+STATIC
+EFI_STATUS
+EFIAPI
+UnitTestingEntry (
+  VOID
+  )
+{
+  EFI_STATUS                  Status;
+  UNIT_TEST_FRAMEWORK_HANDLE  Framework;
+  UNIT_TEST_SUITE_HANDLE      TrbUrb;
+
+  Framework = NULL;
+
+  DEBUG ((DEBUG_INFO, "%a v%a\n", UNIT_TEST_APP_NAME, UNIT_TEST_APP_VERSION));
+
+  Status = InitUnitTestFramework (&Framework, UNIT_TEST_APP_NAME, gEfiCallerBaseName, UNIT_TEST_APP_VERSION);
+  if (EFI_ERROR (Status)) {
+    DEBUG ((DEBUG_ERROR, "Failed in InitUnitTestFramework. Status = %r\n", Status));
+    goto EXIT;
+  }
+
+  Status = CreateUnitTestSuite (&TrbUrb, Framework, "XHCI TRB to URB index", "XhciDxe.XhciSched", NULL, NULL);
+  if (EFI_ERROR (Status)) {
+    Status = EFI_OUT_OF_RESOURCES;
+    goto EXIT;
+  }
+
+  AddTestCase (TrbUrb, "A URB wrapping past the link TRB", "RingWrap", RingWrap, NULL, NULL, NULL);
+  AddTestCase (TrbUrb, "Command completion events use the command ring", "CommandRing", CommandRing, NULL, NULL, NULL);
+  AddTestCase (TrbUrb, "A URB queued again", "UrbQueuedAgain", UrbQueuedAgain, NULL, NULL, NULL);
+  AddTestCase (TrbUrb, "A ring freed with URBs on it", "RingFreedWithUrbs", RingFreedWithUrbs, NULL, NULL, NULL);
+
+  Status = RunAllTestSuites (Framework);
+
+EXIT:
+  if (Framework != NULL) {
+    FreeUnitTestFramework (Framework);
+  }
+
+  return Status;
+}
+
+/**
+  Standard POSIX C entry point for host based unit test execution.
+
+**/
+int
+main (
+  int   argc,
+  char  *argv[]
+  )
+{
+  return UnitTestingEntry ();
+}
@@ -9,6 +9,20 @@ SPDX-License-Identifier: BSD-2-Clause-Patent
 
 #include "Xhci.h"
 
+//
+// Number of units of each size class, see USBHC_MEM_CLASS_NUMBER.
+//
+#define USBHC_MEM_UNITS(Size)  (USBHC_MEM_ROUND (Size) / USBHC_MEM_UNIT)
+
+UINTN  mUsbHcMemClassUnits[USBHC_MEM_CLASS_NUMBER] = {
+  1,
+  USBHC_MEM_UNITS (sizeof (DEVICE_CONTEXT)),
+  USBHC_MEM_UNITS (sizeof (INPUT_CONTEXT)),
+  USBHC_MEM_UNITS (sizeof (DEVICE_CONTEXT_64)),
+  USBHC_MEM_UNITS (sizeof (INPUT_CONTEXT_64)),
+  USBHC_MEM_UNITS (sizeof (TRB_TEMPLATE) * TR_RING_TRB_NUMBER)
+};
+
 /**
   Allocate a block of memory to be used by the buffer pool.
 
@@ -43,11 +57,11 @@ UsbHcAllocMemBlock (
   // each bit in the bit array represents USBHC_MEM_UNIT
   // bytes of memory in the memory block.
   //
-  ASSERT (USBHC_MEM_UNIT * 8 <= EFI_PAGE_SIZE);
+  ASSERT (USBHC_MEM_UNIT * 64 == EFI_PAGE_SIZE);
 
   Block->BufLen  = EFI_PAGES_TO_SIZE (Pages);
-  Block->BitsLen = Block->BufLen / (USBHC_MEM_UNIT * 8);
-  Block->Bits    = AllocateZeroPool (Block->BitsLen);
+  Block->BitsLen = Block->BufLen / (USBHC_MEM_UNIT * 64);
+  Block->Bits    = AllocateZeroPool (Block->BitsLen * sizeof (UINT64));
 
   if (Block->Bits == NULL) {
     gBS->FreePool (Block);
@@ -89,6 +103,10 @@ UsbHcAllocMemBlock (
   Block->Buf     = (UINT8 *)((UINTN)MappedAddr);
   Block->Mapping = Mapping;
 
+  Pool->Pages += Pages;
+  Pool->BlocksAllocated++;
+  Pool->MaxPages = MAX (Pool->MaxPages, Pool->Pages);
+
   return Block;
 
 FREE_BUFFER:
@@ -119,6 +137,8 @@ UsbHcFreeMemBlock (
 
   PciIo = Pool->PciIo;
 
+  Pool->Pages -= EFI_SIZE_TO_PAGES (Block->BufLen);
+
   //
   // Unmap the common buffer then free the structures
   //
@@ -129,6 +149,77 @@ UsbHcFreeMemBlock (
   gBS->FreePool (Block);
 }
 
+/**
+  Return the index of the lowest bit set in a non-zero 64-bit value.
+
+  @param  Operand        The value, must not be 0.
+
+  @return The index of the lowest bit set.
+
+**/
+UINTN
+UsbHcLowBitSet64 (
+  IN UINT64  Operand
+  )
+{
+  ASSERT (Operand != 0);
+#if defined (__GNUC__)
+  return (UINTN)__builtin_ctzll (Operand);
+#else
+  return (UINTN)LowBitSet64 (Operand);
+#endif
+}
+
+/**
+  Mark a run of memory units of the block as allocated or free.
+
+  @param  Block          The memory block.
+  @param  Start          The first unit of the run.
+  @param  Units          Number of units in the run.
+  @param  Allocated      TRUE to mark the units allocated, FALSE to mark them free.
+
+**/
+VOID
+UsbHcMarkMemUnits (
+  IN USBHC_MEM_BLOCK  *Block,
+  IN UINTN            Start,
+  IN UINTN            Units,
+  IN BOOLEAN          Allocated
+  )
+{
+  UINTN   Word;
+  UINTN   Bit;
+  UINTN   Count;
+  UINT64  Mask;
+
+  if (Allocated) {
+    Block->Used += Units;
+  } else {
+    ASSERT (Block->Used >= Units);
+    Block->Used -= Units;
+  }
+
+  Word = Start / 64;
+  Bit  = Start % 64;
+
+  while (Units > 0) {
+    Count = MIN (Units, 64 - Bit);
+    Mask  = (Count == 64) ? MAX_UINT64 : LShiftU64 (LShiftU64 (1, Count) - 1, Bit);
+
+    if (Allocated) {
+      ASSERT ((Block->Bits[Word] & Mask) == 0);
+      Block->Bits[Word] |= Mask;
+    } else {
+      ASSERT ((Block->Bits[Word] & Mask) == Mask);
+      Block->Bits[Word] &= ~Mask;
+    }
+
+    Units -= Count;
+    Word++;
+    Bit = 0;
+  }
+}
+
 /**
   Alloc some memory from the block.
 
@@ -145,60 +236,301 @@ UsbHcAllocMemFromBlock (
   IN  UINTN            Units
   )
 {
-  UINTN  Byte;
-  UINT8  Bit;
-  UINTN  StartByte;
-  UINT8  StartBit;
-  UINTN  Available;
-  UINTN  Count;
+  UINTN   Word;
+  UINTN   Bit;
+  UINTN   Run;
+  UINT64  Bits;
+  UINTN   Start;
+  UINTN   Available;
 
   ASSERT ((Block != 0) && (Units != 0));
 
-  StartByte = 0;
-  StartBit  = 0;
+  Start     = 0;
   Available = 0;
 
-  for (Byte = 0, Bit = 0; Byte < Block->BitsLen;) {
-    //
-    // If current bit is zero, the corresponding memory unit is
-    // available, otherwise we need to restart our searching.
-    // Available counts the consective number of zero bit.
-    //
-    if (!USB_HC_BIT_IS_SET (Block->Bits[Byte], Bit)) {
-      Available++;
+  //
+  // Available counts the consecutive free units starting at Start.
+  // Whole free and whole allocated words are taken at once, the runs
+  // of free and allocated units in the other words are counted with
+  // the lowest bit set in what remains of the word.
+  //
+  for (Word = 0; Word < Block->BitsLen; Word++) {
+    Bits = Block->Bits[Word];
+
+    if (Bits == MAX_UINT64) {
+      Available = 0;
+      Start     = (Word + 1) * 64;
+      continue;
+    }
 
+    Bit = 0;
+    while (TRUE) {
+      Run        = (Bits == 0) ? (64 - Bit) : UsbHcLowBitSet64 (Bits);
+      Available += Run;
       if (Available >= Units) {
+        UsbHcMarkMemUnits (Block, Start, Units, TRUE);
+        return Block->BufHost + Start * USBHC_MEM_UNIT;
+      }
+
+      Bit += Run;
+      if (Bit == 64) {
         break;
       }
 
-      NEXT_BIT (Byte, Bit);
-    } else {
-      NEXT_BIT (Byte, Bit);
+      Bits = RShiftU64 (Bits, Run);
+      Run  = UsbHcLowBitSet64 (~Bits);
+      Bit += Run;
 
       Available = 0;
-      StartByte = Byte;
-      StartBit  = Bit;
+      Start     = Word * 64 + Bit;
+      if (Bit == 64) {
+        break;
+      }
+
+      Bits = RShiftU64 (Bits, Run);
+    }
+  }
+
+  return NULL;
+}
+
+/**
+  Find the size class of an allocation.
+
+  @param  Pool           The memory pool of the host controller.
+  @param  Units          Number of memory units of the allocation.
+
+  @return The size class, or NULL if the size has none.
+
+**/
+USBHC_MEM_CLASS *
+UsbHcGetMemClass (
+  IN USBHC_MEM_POOL  *Pool,
+  IN UINTN           Units
+  )
+{
+  UINTN  Index;
+
+  for (Index = 0; Index < USBHC_MEM_CLASS_NUMBER; Index++) {
+    if (Pool->Classes[Index].Units == Units) {
+      return &Pool->Classes[Index];
     }
   }
 
-  if (Available < Units) {
+  return NULL;
+}
+
+/**
+  Take back from the size classes the allocations cached in a memory block,
+  and mark their units free in the block.
+
+  @param  Pool           The memory pool of the host controller.
+  @param  Block          The memory block.
+
+**/
+VOID
+UsbHcDrainMemClasses (
+  IN USBHC_MEM_POOL   *Pool,
+  IN USBHC_MEM_BLOCK  *Block
+  )
+{
+  USBHC_MEM_CLASS  *Class;
+  UINT8            *Mem;
+  UINTN            Index;
+  UINTN            Entry;
+  UINTN            Kept;
+
+  for (Index = 0; (Index < USBHC_MEM_CLASS_NUMBER) && (Block->Cached > 0); Index++) {
+    Class = &Pool->Classes[Index];
+    Kept  = 0;
+    for (Entry = 0; Entry < Class->Count; Entry++) {
+      Mem = Class->Free[Entry];
+      if ((Mem >= Block->BufHost) && (Mem < Block->BufHost + Block->BufLen)) {
+        UsbHcMarkMemUnits (Block, (Mem - Block->BufHost) / USBHC_MEM_UNIT, Class->Units, FALSE);
+        ASSERT (Block->Cached >= Class->Units);
+        Block->Cached     -= Class->Units;
+        Pool->CachedUnits -= Class->Units;
+      } else {
+        Class->Free[Kept] = Mem;
+        Kept++;
+      }
+    }
+
+    Class->Count = Kept;
+  }
+
+  ASSERT (Block->Cached == 0);
+}
+
+/**
+  Find where an address falls in one of the sorted block arrays of the pool.
+
+  @param  Pool           The memory pool of the host controller.
+  @param  Pci            TRUE to search the blocks by PCI address, FALSE by host address.
+  @param  Mem            The address to look for.
+
+  @return The number of blocks starting at or below Mem. The block holding
+          Mem, if any, is the last of them.
+
+**/
+UINTN
+UsbHcSearchMemBlock (
+  IN USBHC_MEM_POOL  *Pool,
+  IN BOOLEAN         Pci,
+  IN UINT8           *Mem
+  )
+{
+  USBHC_MEM_BLOCK  **Index;
+  UINT8            *Start;
+  UINTN            Low;
+  UINTN            High;
+  UINTN            Middle;
+
+  Index = Pci ? Pool->PciIndex : Pool->HostIndex;
+  Low   = 0;
+  High  = Pool->BlockCount;
+
+  while (Low < High) {
+    Middle = (Low + High) / 2;
+    Start  = Pci ? Index[Middle]->Buf : Index[Middle]->BufHost;
+    if (Start <= Mem) {
+      Low = Middle + 1;
+    } else {
+      High = Middle;
+    }
+  }
+
+  return Low;
+}
+
+/**
+  Find the memory block that completely contains a memory region.
+
+  @param  Pool           The memory pool of the host controller.
+  @param  Pci            TRUE if Mem is a PCI address, FALSE if it is a host address.
+  @param  Mem            The start of the memory region.
+  @param  Size           The size of the memory region.
+
+  @return The memory block, or NULL if no block contains the region.
+
+**/
+USBHC_MEM_BLOCK *
+UsbHcFindMemBlock (
+  IN USBHC_MEM_POOL  *Pool,
+  IN BOOLEAN         Pci,
+  IN VOID            *Mem,
+  IN UINTN           Size
+  )
+{
+  USBHC_MEM_BLOCK  *Block;
+  UINT8            *Start;
+  UINTN            Position;
+
+  Position = UsbHcSearchMemBlock (Pool, Pci, Mem);
+  if (Position == 0) {
     return NULL;
   }
 
-  //
-  // Mark the memory as allocated
-  //
-  Byte = StartByte;
-  Bit  = StartBit;
+  Block = Pci ? Pool->PciIndex[Position - 1] : Pool->HostIndex[Position - 1];
+  Start = Pci ? Block->Buf : Block->BufHost;
+  if (((UINT8 *)Mem + Size) > (Start + Block->BufLen)) {
+    return NULL;
+  }
+
+  return Block;
+}
+
+/**
+  Add a memory block to the sorted block arrays of the pool.
+
+  @param  Pool           The memory pool of the host controller.
+  @param  Block          The memory block to add.
 
-  for (Count = 0; Count < Units; Count++) {
-    ASSERT (!USB_HC_BIT_IS_SET (Block->Bits[Byte], Bit));
+  @retval EFI_SUCCESS           The block is added.
+  @retval EFI_OUT_OF_RESOURCES  The arrays couldn't be grown.
 
-    Block->Bits[Byte] = (UINT8)(Block->Bits[Byte] | USB_HC_BIT (Bit));
-    NEXT_BIT (Byte, Bit);
+**/
+EFI_STATUS
+UsbHcIndexMemBlock (
+  IN USBHC_MEM_POOL   *Pool,
+  IN USBHC_MEM_BLOCK  *Block
+  )
+{
+  USBHC_MEM_BLOCK  **HostIndex;
+  USBHC_MEM_BLOCK  **PciIndex;
+  UINTN            Size;
+  UINTN            Position;
+
+  if (Pool->BlockCount == Pool->IndexSize) {
+    Size      = (Pool->IndexSize == 0) ? USBHC_MEM_INDEX_SIZE : Pool->IndexSize * 2;
+    HostIndex = ReallocatePool (
+                  Pool->IndexSize * sizeof (USBHC_MEM_BLOCK *),
+                  Size * sizeof (USBHC_MEM_BLOCK *),
+                  Pool->HostIndex
+                  );
+    if (HostIndex == NULL) {
+      return EFI_OUT_OF_RESOURCES;
+    }
+
+    Pool->HostIndex = HostIndex;
+    PciIndex        = ReallocatePool (
+                        Pool->IndexSize * sizeof (USBHC_MEM_BLOCK *),
+                        Size * sizeof (USBHC_MEM_BLOCK *),
+                        Pool->PciIndex
+                        );
+    if (PciIndex == NULL) {
+      return EFI_OUT_OF_RESOURCES;
+    }
+
+    Pool->PciIndex  = PciIndex;
+    Pool->IndexSize = Size;
   }
 
-  return Block->BufHost + (StartByte * 8 + StartBit) * USBHC_MEM_UNIT;
+  Position = UsbHcSearchMemBlock (Pool, FALSE, Block->BufHost);
+  CopyMem (&Pool->HostIndex[Position + 1], &Pool->HostIndex[Position], (Pool->BlockCount - Position) * sizeof (USBHC_MEM_BLOCK *));
+  Pool->HostIndex[Position] = Block;
+
+  Position = UsbHcSearchMemBlock (Pool, TRUE, Block->Buf);
+  CopyMem (&Pool->PciIndex[Position + 1], &Pool->PciIndex[Position], (Pool->BlockCount - Position) * sizeof (USBHC_MEM_BLOCK *));
+  Pool->PciIndex[Position] = Block;
+
+  Pool->BlockCount++;
+  if (Block->Buf != Block->BufHost) {
+    Pool->TranslatedBlocks++;
+  }
+
+  Pool->MaxBlocks = MAX (Pool->MaxBlocks, Pool->BlockCount);
+
+  return EFI_SUCCESS;
+}
+
+/**
+  Remove a memory block from the sorted block arrays of the pool.
+
+  @param  Pool           The memory pool of the host controller.
+  @param  Block          The memory block to remove.
+
+**/
+VOID
+UsbHcUnindexMemBlock (
+  IN USBHC_MEM_POOL   *Pool,
+  IN USBHC_MEM_BLOCK  *Block
+  )
+{
+  UINTN  Position;
+
+  Position = UsbHcSearchMemBlock (Pool, FALSE, Block->BufHost) - 1;
+  ASSERT (Pool->HostIndex[Position] == Block);
+  CopyMem (&Pool->HostIndex[Position], &Pool->HostIndex[Position + 1], (Pool->BlockCount - Position - 1) * sizeof (USBHC_MEM_BLOCK *));
+
+  Position = UsbHcSearchMemBlock (Pool, TRUE, Block->Buf) - 1;
+  ASSERT (Pool->PciIndex[Position] == Block);
+  CopyMem (&Pool->PciIndex[Position], &Pool->PciIndex[Position + 1], (Pool->BlockCount - Position - 1) * sizeof (USBHC_MEM_BLOCK *));
+
+  Pool->BlockCount--;
+  if (Block->Buf != Block->BufHost) {
+    Pool->TranslatedBlocks--;
+  }
 }
 
 /**
@@ -218,30 +550,30 @@ UsbHcGetPciAddrForHostAddr (
   IN UINTN           Size
   )
 {
-  USBHC_MEM_BLOCK       *Head;
   USBHC_MEM_BLOCK       *Block;
   UINTN                 AllocSize;
   EFI_PHYSICAL_ADDRESS  PhyAddr;
   UINTN                 Offset;
 
-  Head      = Pool->Head;
   AllocSize = USBHC_MEM_ROUND (Size);
 
   if (Mem == NULL) {
     return 0;
   }
 
-  for (Block = Head; Block != NULL; Block = Block->Next) {
-    //
-    // scan the memory block list for the memory block that
-    // completely contains the allocated memory.
-    //
-    if ((Block->BufHost <= (UINT8 *)Mem) && (((UINT8 *)Mem + AllocSize) <= (Block->BufHost + Block->BufLen))) {
-      break;
-    }
+  if (Pool->TranslatedBlocks == 0) {
+    return (EFI_PHYSICAL_ADDRESS)(UINTN)Mem;
   }
 
+  //
+  // find the memory block that completely contains the allocated memory.
+  //
+  Block = UsbHcFindMemBlock (Pool, FALSE, Mem, AllocSize);
   ASSERT ((Block != NULL));
+  if (Block == NULL) {
+    return 0;
+  }
+
   //
   // calculate the pci memory address for host memory address.
   //
@@ -267,30 +599,30 @@ UsbHcGetHostAddrForPciAddr (
   IN UINTN           Size
   )
 {
-  USBHC_MEM_BLOCK       *Head;
   USBHC_MEM_BLOCK       *Block;
   UINTN                 AllocSize;
   EFI_PHYSICAL_ADDRESS  HostAddr;
   UINTN                 Offset;
 
-  Head      = Pool->Head;
   AllocSize = USBHC_MEM_ROUND (Size);
 
   if (Mem == NULL) {
     return 0;
   }
 
-  for (Block = Head; Block != NULL; Block = Block->Next) {
-    //
-    // scan the memory block list for the memory block that
-    // completely contains the allocated memory.
-    //
-    if ((Block->Buf <= (UINT8 *)Mem) && (((UINT8 *)Mem + AllocSize) <= (Block->Buf + Block->BufLen))) {
-      break;
-    }
+  if (Pool->TranslatedBlocks == 0) {
+    return (EFI_PHYSICAL_ADDRESS)(UINTN)Mem;
   }
 
+  //
+  // find the memory block that completely contains the allocated memory.
+  //
+  Block = UsbHcFindMemBlock (Pool, TRUE, Mem, AllocSize);
   ASSERT ((Block != NULL));
+  if (Block == NULL) {
+    return 0;
+  }
+
   //
   // calculate the pci memory address for host memory address.
   //
@@ -302,19 +634,31 @@ UsbHcGetHostAddrForPciAddr (
 /**
   Insert the memory block to the pool's list of the blocks.
 
-  @param  Head           The head of the memory pool's block list.
+  @param  Pool           The memory pool.
   @param  Block          The memory block to insert.
 
+  @retval EFI_SUCCESS           The block is inserted.
+  @retval EFI_OUT_OF_RESOURCES  The block couldn't be indexed.
+
 **/
-VOID
+EFI_STATUS
 UsbHcInsertMemBlockToPool (
-  IN USBHC_MEM_BLOCK  *Head,
+  IN USBHC_MEM_POOL   *Pool,
   IN USBHC_MEM_BLOCK  *Block
   )
 {
-  ASSERT ((Head != NULL) && (Block != NULL));
-  Block->Next = Head->Next;
-  Head->Next  = Block;
+  EFI_STATUS  Status;
+
+  ASSERT ((Pool->Head != NULL) && (Block != NULL));
+
+  Status = UsbHcIndexMemBlock (Pool, Block);
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+
+  Block->Next      = Pool->Head->Next;
+  Pool->Head->Next = Block;
+  return EFI_SUCCESS;
 }
 
 /**
@@ -331,35 +675,29 @@ UsbHcIsMemBlockEmpty (
   IN USBHC_MEM_BLOCK  *Block
   )
 {
-  UINTN  Index;
-
-  for (Index = 0; Index < Block->BitsLen; Index++) {
-    if (Block->Bits[Index] != 0) {
-      return FALSE;
-    }
-  }
-
-  return TRUE;
+  return (BOOLEAN)(Block->Used == 0);
 }
 
 /**
   Unlink the memory block from the pool's list.
 
-  @param  Head           The block list head of the memory's pool.
+  @param  Pool           The memory pool.
   @param  BlockToUnlink  The memory block to unlink.
 
 **/
 VOID
 UsbHcUnlinkMemBlock (
-  IN USBHC_MEM_BLOCK  *Head,
+  IN USBHC_MEM_POOL   *Pool,
   IN USBHC_MEM_BLOCK  *BlockToUnlink
   )
 {
   USBHC_MEM_BLOCK  *Block;
 
-  ASSERT ((Head != NULL) && (BlockToUnlink != NULL));
+  ASSERT ((Pool->Head != NULL) && (BlockToUnlink != NULL));
 
-  for (Block = Head; Block != NULL; Block = Block->Next) {
+  UsbHcUnindexMemBlock (Pool, BlockToUnlink);
+
+  for (Block = Pool->Head; Block != NULL; Block = Block->Next) {
     if (Block->Next == BlockToUnlink) {
       Block->Next         = BlockToUnlink->Next;
       BlockToUnlink->Next = NULL;
@@ -368,6 +706,53 @@ UsbHcUnlinkMemBlock (
   }
 }
 
+/**
+  Release empty memory blocks, other than the head, until only Keep
+  of them are left in the pool.
+
+  @param  Pool           The memory pool.
+  @param  Keep           Number of empty blocks to keep.
+
+**/
+VOID
+UsbHcReleaseEmptyMemBlocks (
+  IN USBHC_MEM_POOL  *Pool,
+  IN UINTN           Keep
+  )
+{
+  USBHC_MEM_BLOCK  *Block;
+  USBHC_MEM_BLOCK  *Next;
+
+  for (Block = Pool->Head->Next; (Block != NULL) && (Pool->EmptyBlocks > Keep); Block = Next) {
+    Next = Block->Next;
+    if (UsbHcIsMemBlockEmpty (Block)) {
+      UsbHcUnlinkMemBlock (Pool, Block);
+      UsbHcFreeMemBlock (Pool, Block);
+      Pool->EmptyBlocks--;
+    }
+  }
+}
+
+/**
+  Free the sorted block arrays of the pool.
+
+  @param  Pool           The memory pool.
+
+**/
+VOID
+UsbHcFreeMemIndex (
+  IN USBHC_MEM_POOL  *Pool
+  )
+{
+  if (Pool->HostIndex != NULL) {
+    gBS->FreePool (Pool->HostIndex);
+  }
+
+  if (Pool->PciIndex != NULL) {
+    gBS->FreePool (Pool->PciIndex);
+  }
+}
+
 /**
   Initialize the memory management pool for the host controller.
 
@@ -383,17 +768,30 @@ UsbHcInitMemPool (
   )
 {
   USBHC_MEM_POOL  *Pool;
+  UINTN           Index;
 
-  Pool = AllocatePool (sizeof (USBHC_MEM_POOL));
+  Pool = AllocateZeroPool (sizeof (USBHC_MEM_POOL));
 
   if (Pool == NULL) {
     return Pool;
   }
 
-  Pool->PciIo = PciIo;
-  Pool->Head  = UsbHcAllocMemBlock (Pool, USBHC_MEM_DEFAULT_PAGES);
+  for (Index = 0; Index < USBHC_MEM_CLASS_NUMBER; Index++) {
+    Pool->Classes[Index].Units = mUsbHcMemClassUnits[Index];
+  }
+
+  Pool->PciIo        = PciIo;
+  Pool->EmptyReserve = FixedPcdGet32 (PcdUsbHcMemEmptyBlockReserve);
+  Pool->Head         = UsbHcAllocMemBlock (Pool, USBHC_MEM_DEFAULT_PAGES);
 
   if (Pool->Head == NULL) {
+    gBS->FreePool (Pool);
+    return NULL;
+  }
+
+  if (EFI_ERROR (UsbHcIndexMemBlock (Pool, Pool->Head))) {
+    UsbHcFreeMemBlock (Pool, Pool->Head);
+    UsbHcFreeMemIndex (Pool);
     gBS->FreePool (Pool);
     Pool = NULL;
   }
@@ -419,21 +817,55 @@ UsbHcFreeMemPool (
 
   ASSERT (Pool->Head != NULL);
 
+  UsbHcReportMemPool (Pool);
+
   //
   // Unlink all the memory blocks from the pool, then free them.
   // UsbHcUnlinkMemBlock can't be used to unlink and free the
   // first block.
   //
   for (Block = Pool->Head->Next; Block != NULL; Block = Pool->Head->Next) {
-    UsbHcUnlinkMemBlock (Pool->Head, Block);
+    UsbHcUnlinkMemBlock (Pool, Block);
     UsbHcFreeMemBlock (Pool, Block);
   }
 
   UsbHcFreeMemBlock (Pool, Pool->Head);
+  UsbHcFreeMemIndex (Pool);
   gBS->FreePool (Pool);
   return EFI_SUCCESS;
 }
 
+/**
+  Report the high-water marks of the memory pool to the debug output,
+  to size USBHC_MEM_DEFAULT_PAGES and PcdUsbHcMemEmptyBlockReserve.
+
+  @param  Pool           The memory pool of the host controller.
+
+**/
+VOID
+UsbHcReportMemPool (
+  IN USBHC_MEM_POOL  *Pool
+  )
+{
+  DEBUG ((
+    DEBUG_INFO,
+    "UsbHcReportMemPool: peak %Lu blocks, %Lu pages, %Lu bytes allocated; %Lu blocks mapped in all\n",
+    (UINT64)Pool->MaxBlocks,
+    (UINT64)Pool->MaxPages,
+    (UINT64)(Pool->MaxUsedUnits * USBHC_MEM_UNIT),
+    (UINT64)Pool->BlocksAllocated
+    ));
+  DEBUG ((
+    DEBUG_INFO,
+    "UsbHcReportMemPool: now %Lu blocks (%Lu empty), %Lu pages, %Lu bytes allocated, %Lu bytes cached\n",
+    (UINT64)Pool->BlockCount,
+    (UINT64)Pool->EmptyBlocks,
+    (UINT64)Pool->Pages,
+    (UINT64)(Pool->UsedUnits * USBHC_MEM_UNIT),
+    (UINT64)(Pool->CachedUnits * USBHC_MEM_UNIT)
+    ));
+}
+
 /**
   Allocate some memory from the host controller's memory pool
   which can be used to communicate with host controller.
@@ -453,28 +885,57 @@ UsbHcAllocateMem (
   USBHC_MEM_BLOCK  *Head;
   USBHC_MEM_BLOCK  *Block;
   USBHC_MEM_BLOCK  *NewBlock;
+  USBHC_MEM_CLASS  *Class;
   VOID             *Mem;
   UINTN            AllocSize;
+  UINTN            Units;
   UINTN            Pages;
 
   Mem       = NULL;
   AllocSize = USBHC_MEM_ROUND (Size);
+  Units     = AllocSize / USBHC_MEM_UNIT;
   Head      = Pool->Head;
   ASSERT (Head != NULL);
 
+  //
+  // Reuse a freed allocation of the same size if there is one.
+  //
+  Class = UsbHcGetMemClass (Pool, Units);
+  if ((Class != NULL) && (Class->Count > 0)) {
+    Class->Count--;
+    Mem   = Class->Free[Class->Count];
+    Block = UsbHcFindMemBlock (Pool, FALSE, Mem, AllocSize);
+    ASSERT ((Block != NULL) && (Block->Cached >= Units));
+    Block->Cached     -= Units;
+    Pool->CachedUnits -= Units;
+
+    Pool->UsedUnits   += Units;
+    Pool->MaxUsedUnits = MAX (Pool->MaxUsedUnits, Pool->UsedUnits);
+    return Mem;
+  }
+
   //
   // First check whether current memory blocks can satisfy the allocation.
   //
   for (Block = Head; Block != NULL; Block = Block->Next) {
-    Mem = UsbHcAllocMemFromBlock (Block, AllocSize / USBHC_MEM_UNIT);
+    Mem = UsbHcAllocMemFromBlock (Block, Units);
 
     if (Mem != NULL) {
-      ZeroMem (Mem, Size);
       break;
     }
   }
 
   if (Mem != NULL) {
+    //
+    // The block was one of the empty ones kept in the pool
+    //
+    if ((Block != Head) && (Block->Used == Units)) {
+      ASSERT (Pool->EmptyBlocks > 0);
+      Pool->EmptyBlocks--;
+    }
+
+    Pool->UsedUnits   += Units;
+    Pool->MaxUsedUnits = MAX (Pool->MaxUsedUnits, Pool->UsedUnits);
     return Mem;
   }
 
@@ -500,13 +961,16 @@ UsbHcAllocateMem (
   //
   // Add the new memory block to the pool, then allocate memory from it
   //
-  UsbHcInsertMemBlockToPool (Head, NewBlock);
-  Mem = UsbHcAllocMemFromBlock (NewBlock, AllocSize / USBHC_MEM_UNIT);
-
-  if (Mem != NULL) {
-    ZeroMem (Mem, Size);
+  if (EFI_ERROR (UsbHcInsertMemBlockToPool (Pool, NewBlock))) {
+    DEBUG ((DEBUG_ERROR, "UsbHcAllocateMem: failed to index block\n"));
+    UsbHcFreeMemBlock (Pool, NewBlock);
+    return NULL;
   }
 
+  Mem = UsbHcAllocMemFromBlock (NewBlock, Units);
+
+  Pool->UsedUnits   += Units;
+  Pool->MaxUsedUnits = MAX (Pool->MaxUsedUnits, Pool->UsedUnits);
   return Mem;
 }
 
@@ -527,41 +991,20 @@ UsbHcFreeMem (
 {
   USBHC_MEM_BLOCK  *Head;
   USBHC_MEM_BLOCK  *Block;
+  USBHC_MEM_CLASS  *Class;
   UINT8            *ToFree;
   UINTN            AllocSize;
-  UINTN            Byte;
-  UINTN            Bit;
-  UINTN            Count;
+  UINTN            Units;
 
   Head      = Pool->Head;
   AllocSize = USBHC_MEM_ROUND (Size);
+  Units     = AllocSize / USBHC_MEM_UNIT;
   ToFree    = (UINT8 *)Mem;
 
-  for (Block = Head; Block != NULL; Block = Block->Next) {
-    //
-    // scan the memory block list for the memory block that
-    // completely contains the memory to free.
-    //
-    if ((Block->BufHost <= ToFree) && ((ToFree + AllocSize) <= (Block->BufHost + Block->BufLen))) {
-      //
-      // compute the start byte and bit in the bit array
-      //
-      Byte = ((ToFree - Block->BufHost) / USBHC_MEM_UNIT) / 8;
-      Bit  = ((ToFree - Block->BufHost) / USBHC_MEM_UNIT) % 8;
-
-      //
-      // reset associated bits in bit array
-      //
-      for (Count = 0; Count < (AllocSize / USBHC_MEM_UNIT); Count++) {
-        ASSERT (USB_HC_BIT_IS_SET (Block->Bits[Byte], Bit));
-
-        Block->Bits[Byte] = (UINT8)(Block->Bits[Byte] ^ USB_HC_BIT (Bit));
-        NEXT_BIT (Byte, Bit);
-      }
-
-      break;
-    }
-  }
+  //
+  // find the memory block that completely contains the memory to free.
+  //
+  Block = UsbHcFindMemBlock (Pool, FALSE, ToFree, AllocSize);
 
   //
   // If Block == NULL, it means that the current memory isn't
@@ -569,13 +1012,46 @@ UsbHcFreeMem (
   // the caller has passed in a wrong memory point
   //
   ASSERT (Block != NULL);
+  if (Block == NULL) {
+    return;
+  }
 
   //
-  // Release the current memory block if it is empty and not the head
+  // Keep the memory for the next allocation of the same size if its
+  // size class has room, it stays allocated in the block meanwhile.
+  // Otherwise reset associated bits in bit array.
+  //
+  Class = UsbHcGetMemClass (Pool, Units);
+  if ((Class != NULL) && (Class->Count < USBHC_MEM_CLASS_DEPTH)) {
+    Class->Free[Class->Count] = Mem;
+    Class->Count++;
+    Block->Cached     += Units;
+    Pool->CachedUnits += Units;
+  } else {
+    UsbHcMarkMemUnits (Block, (ToFree - Block->BufHost) / USBHC_MEM_UNIT, Units, FALSE);
+  }
+
+  ASSERT (Pool->UsedUnits >= Units);
+  Pool->UsedUnits -= Units;
+
+  //
+  // A block other than the head left with cached allocations only
+  // gets them back, then it is empty.
+  //
+  if ((Block != Head) && (Block->Cached > 0) && (Block->Used == Block->Cached)) {
+    UsbHcDrainMemClasses (Pool, Block);
+  }
+
+  //
+  // Keep the current memory block mapped if it is empty and not the head,
+  // unless the reserve of empty blocks is full. Then release empty blocks
+  // down to half the reserve.
   //
   if ((Block != Head) && UsbHcIsMemBlockEmpty (Block)) {
-    UsbHcUnlinkMemBlock (Head, Block);
-    UsbHcFreeMemBlock (Pool, Block);
+    Pool->EmptyBlocks++;
+    if (Pool->EmptyBlocks > Pool->EmptyReserve) {
+      UsbHcReleaseEmptyMemBlocks (Pool, Pool->EmptyReserve / 2);
+    }
   }
 
   return;
@@ -10,15 +10,12 @@ SPDX-License-Identifier: BSD-2-Clause-Patent
 #ifndef _EFI_XHCI_MEM_H_
 #define _EFI_XHCI_MEM_H_
 
-#define USB_HC_BIT(a)  ((UINTN)(1 << (a)))
-
-#define USB_HC_BIT_IS_SET(Data, Bit)   \
-          ((BOOLEAN)(((Data) & USB_HC_BIT(Bit)) == USB_HC_BIT(Bit)))
-
 typedef struct _USBHC_MEM_BLOCK USBHC_MEM_BLOCK;
 struct _USBHC_MEM_BLOCK {
-  UINT8              *Bits;         // Bit array to record which unit is allocated
-  UINTN              BitsLen;
+  UINT64             *Bits;         // Bit array to record which unit is allocated
+  UINTN              BitsLen;       // Number of 64-bit words in Bits, one per page
+  UINTN              Used;          // Number of units allocated
+  UINTN              Cached;        // Number of allocated units held by the size classes
   UINT8              *Buf;
   UINT8              *BufHost;
   UINTN              BufLen;        // Memory size in bytes
@@ -26,16 +23,69 @@ struct _USBHC_MEM_BLOCK {
   USBHC_MEM_BLOCK    *Next;
 };
 
+//
+// Number of freed allocations kept for reuse in each size class
+//
+#define USBHC_MEM_CLASS_DEPTH  8
+
+//
+// A size class caches freed allocations of one size, still marked as
+// allocated in their block, so that the next allocation of that size
+// takes one without searching the blocks. A block other than the head
+// that holds nothing but cached allocations gets them back, so that the
+// cache never keeps a block from being released.
+//
+typedef struct {
+  UINTN    Units;
+  UINTN    Count;
+  VOID     *Free[USBHC_MEM_CLASS_DEPTH];
+} USBHC_MEM_CLASS;
+
+//
+// The sizes the XHCI driver allocates and frees again and again as devices
+// come and go: a single unit, the input and device contexts with 32 and 64
+// byte contexts, and a transfer ring.
+//
+#define USBHC_MEM_CLASS_NUMBER  6
+
 //
 // USBHC_MEM_POOL is used to manage the memory used by USB
 // host controller. XHCI requires the control memory and transfer
 // data to be on the same 4G memory.
 //
+// The blocks are also kept in two arrays sorted by host address and
+// by PCI address, so that the address translations find the block
+// holding an address by binary search. While every block is mapped
+// at its host address, the translations return the address as is.
+//
+// Blocks other than the head that become empty stay in the pool, still
+// mapped, up to EmptyReserve of them. One more releases empty blocks until
+// half the reserve is left, so that allocations and frees around a block
+// boundary don't allocate and map a block again each time.
+//
 typedef struct _USBHC_MEM_POOL {
   EFI_PCI_IO_PROTOCOL    *PciIo;
   BOOLEAN                Check4G;
   UINT32                 Which4G;
   USBHC_MEM_BLOCK        *Head;
+  USBHC_MEM_BLOCK        **HostIndex;
+  USBHC_MEM_BLOCK        **PciIndex;
+  UINTN                  BlockCount;
+  UINTN                  IndexSize;       // Number of entries in HostIndex and PciIndex
+  UINTN                  TranslatedBlocks; // Blocks whose PCI address isn't their host address
+  USBHC_MEM_CLASS        Classes[USBHC_MEM_CLASS_NUMBER];
+  UINTN                  EmptyBlocks;     // Empty blocks other than the head
+  UINTN                  EmptyReserve;    // Empty blocks kept mapped at most
+  //
+  // Usage statistics, reported by UsbHcReportMemPool
+  //
+  UINTN                  Pages;           // Pages of all the blocks
+  UINTN                  UsedUnits;       // Units allocated in all the blocks, cached units excluded
+  UINTN                  CachedUnits;     // Units held by the size classes
+  UINTN                  MaxBlocks;
+  UINTN                  MaxPages;
+  UINTN                  MaxUsedUnits;
+  UINTN                  BlocksAllocated; // Blocks allocated and mapped since the pool was created
 } USBHC_MEM_POOL;
 
 //
@@ -46,19 +96,12 @@ typedef struct _USBHC_MEM_POOL {
 #define USBHC_MEM_UNIT_MASK      (USBHC_MEM_UNIT - 1)
 #define USBHC_MEM_DEFAULT_PAGES  16
 
-#define USBHC_MEM_ROUND(Len)  (((Len) + USBHC_MEM_UNIT_MASK) & (~USBHC_MEM_UNIT_MASK))
-
 //
-// Advance the byte and bit to the next bit, adjust byte accordingly.
+// Initial number of entries of the sorted block arrays, doubled as needed
 //
-#define NEXT_BIT(Byte, Bit)   \
-          do {                \
-            (Bit)++;          \
-            if ((Bit) > 7) {  \
-              (Byte)++;       \
-              (Bit) = 0;      \
-            }                 \
-          } while (0)
+#define USBHC_MEM_INDEX_SIZE  8
+
+#define USBHC_MEM_ROUND(Len)  (((Len) + USBHC_MEM_UNIT_MASK) & (~USBHC_MEM_UNIT_MASK))
 
 /**
   Initialize the memory management pool for the host controller.
@@ -88,9 +131,22 @@ UsbHcFreeMemPool (
   IN USBHC_MEM_POOL  *Pool
   );
 
+/**
+  Report the high-water marks of the memory pool to the debug output,
+  to size USBHC_MEM_DEFAULT_PAGES and PcdUsbHcMemEmptyBlockReserve.
+
+  @param  Pool  The memory pool of the host controller.
+
+**/
+VOID
+UsbHcReportMemPool (
+  IN USBHC_MEM_POOL  *Pool
+  );
+
 /**
   Allocate some memory from the host controller's memory pool
   which can be used to communicate with host controller.
+  The memory isn't zeroed, callers initialize it.
 
   @param  Pool  The host controller's memory pool.
   @param  Size  Size of the memory to allocate.
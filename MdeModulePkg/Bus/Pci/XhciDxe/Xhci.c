@@ -85,6 +85,18 @@ EFI_USB2_HC_PROTOCOL  gXhciUsb2HcTemplate = {
   0x0
 };
 
+//
+// Template for Xhci's queued bulk transfer protocol instance.
+//
+ADLINK_USB_BULK_QUEUE_PROTOCOL  gXhciBulkQueueTemplate = {
+  ADLINK_USB_BULK_QUEUE_PROTOCOL_REVISION,
+  XHC_BULK_QUEUE_DEPTH,
+  XhcBulkQueueSubmit,
+  XhcBulkQueueComplete,
+  XhcBulkQueueCancel,
+  XhcBulkQueueGetDevice
+};
+
 /**
   Retrieves the capability of root hub ports.
 
@@ -1310,6 +1322,421 @@ ON_EXIT:
   return Status;
 }
 
+/**
+  Start a bulk transfer without waiting for it, see
+  ADLINK_USB_BULK_QUEUE_PROTOCOL.Submit ().
+
+  @param  This                  This ADLINK_USB_BULK_QUEUE_PROTOCOL instance.
+  @param  DeviceAddress         Target device address.
+  @param  EndPointAddress       Endpoint number and its direction in bit 7.
+  @param  DeviceSpeed           Device speed, Low speed device doesn't support bulk
+                                transfer.
+  @param  MaximumPacketLength   Maximum packet size the endpoint is capable of
+                                sending or receiving.
+  @param  Data                  The buffer of data to transmit from or receive into.
+  @param  DataLength            The length of the data buffer.
+
+  @retval EFI_SUCCESS           The transfer was started.
+  @retval EFI_NOT_READY         The queue of the endpoint is full.
+  @retval EFI_INVALID_PARAMETER Some parameters are invalid.
+  @retval EFI_OUT_OF_RESOURCES  The transfer failed due to lack of resource.
+  @retval EFI_DEVICE_ERROR      The transfer failed due to host controller error.
+
+**/
+EFI_STATUS
+EFIAPI
+XhcBulkQueueSubmit (
+  IN ADLINK_USB_BULK_QUEUE_PROTOCOL  *This,
+  IN UINT8                           DeviceAddress,
+  IN UINT8                           EndPointAddress,
+  IN UINT8                           DeviceSpeed,
+  IN UINTN                           MaximumPacketLength,
+  IN VOID                            *Data,
+  IN UINTN                           DataLength
+  )
+{
+  USB_XHCI_INSTANCE  *Xhc;
+  LIST_ENTRY         *Entry;
+  URB                *Urb;
+  UINTN              Transfers;
+  UINTN              TrbNum;
+  UINT8              SlotId;
+  UINT8              Dci;
+  EFI_STATUS         Status;
+  EFI_TPL            OldTpl;
+
+  //
+  // Validate the parameters
+  //
+  if ((Data == NULL) || (DataLength == 0)) {
+    return EFI_INVALID_PARAMETER;
+  }
+
+  if ((DeviceSpeed == EFI_USB_SPEED_LOW) ||
+      ((DeviceSpeed == EFI_USB_SPEED_FULL) && (MaximumPacketLength > 64)) ||
+      ((EFI_USB_SPEED_HIGH == DeviceSpeed) && (MaximumPacketLength > 512)) ||
+      ((EFI_USB_SPEED_SUPER == DeviceSpeed) && (MaximumPacketLength > 1024)))
+  {
+    return EFI_INVALID_PARAMETER;
+  }
+
+  OldTpl = gBS->RaiseTPL (XHC_TPL);
+
+  Xhc    = XHC_FROM_BULK_QUEUE (This);
+  Status = EFI_DEVICE_ERROR;
+
+  if (XhcIsHalt (Xhc) || XhcIsSysError (Xhc)) {
+    DEBUG ((DEBUG_ERROR, "XhcBulkQueueSubmit: HC is halted\n"));
+    goto ON_EXIT;
+  }
+
+  SlotId = XhcBusDevAddrToSlotId (Xhc, DeviceAddress);
+  if (SlotId == 0) {
+    goto ON_EXIT;
+  }
+
+  //
+  // Each TRB carries up to 64 KB. A transfer too large for the share of
+  // the ring left to the queue still goes when nothing else is queued.
+  //
+  Transfers = 0;
+  TrbNum    = (DataLength + 0xFFFF) / 0x10000;
+  BASE_LIST_FOR_EACH (Entry, &Xhc->BulkTransfers) {
+    Urb = EFI_LIST_CONTAINER (Entry, URB, UrbList);
+    if (XhcIsUrbOfEndpoint (Urb, DeviceAddress, EndPointAddress)) {
+      Transfers++;
+      TrbNum += Urb->TrbNum;
+    }
+  }
+
+  if ((Transfers >= XHC_BULK_QUEUE_DEPTH) ||
+      ((Transfers > 0) && (TrbNum > XHC_BULK_QUEUE_TRBS)))
+  {
+    Status = EFI_NOT_READY;
+    goto ON_EXIT;
+  }
+
+  Urb = XhcCreateUrb (
+          Xhc,
+          DeviceAddress,
+          EndPointAddress,
+          DeviceSpeed,
+          MaximumPacketLength,
+          XHC_BULK_TRANSFER,
+          NULL,
+          Data,
+          DataLength,
+          NULL,
+          NULL
+          );
+  if (Urb == NULL) {
+    DEBUG ((DEBUG_ERROR, "XhcBulkQueueSubmit: failed to create URB\n"));
+    Status = EFI_OUT_OF_RESOURCES;
+    goto ON_EXIT;
+  }
+
+  InsertTailList (&Xhc->BulkTransfers, &Urb->UrbList);
+
+  Dci = XhcEndpointToDci (Urb->Ep.EpAddr, (UINT8)(Urb->Ep.Direction));
+  XhcRingDoorBell (Xhc, SlotId, Dci);
+  Status = EFI_SUCCESS;
+
+ON_EXIT:
+  gBS->RestoreTPL (OldTpl);
+  return Status;
+}
+
+/**
+  Complete the oldest transfer queued on an endpoint, see
+  ADLINK_USB_BULK_QUEUE_PROTOCOL.Complete ().
+
+  @param  This                  This ADLINK_USB_BULK_QUEUE_PROTOCOL instance.
+  @param  DeviceAddress         Target device address.
+  @param  EndPointAddress       Endpoint number and its direction in bit 7.
+  @param  Timeout               Indicates the maximum time, in millisecond, to wait
+                                for the transfer, 0 doesn't wait.
+  @param  Data                  Optional. Return the buffer of the transfer.
+  @param  DataLength            Return the length of the data transferred.
+  @param  TransferResult        Return the detailed result of the transfer.
+
+  @retval EFI_SUCCESS           The transfer was completed successfully.
+  @retval EFI_NOT_READY         Timeout is 0 and the transfer isn't finished.
+  @retval EFI_NOT_FOUND         No transfer is queued on the endpoint.
+  @retval EFI_TIMEOUT           The transfer failed due to timeout.
+  @retval EFI_ABORTED           The transfer was aborted after an earlier one failed.
+  @retval EFI_DEVICE_ERROR      The transfer failed due to host controller or device error.
+  @retval EFI_INVALID_PARAMETER Some parameters are invalid.
+
+**/
+EFI_STATUS
+EFIAPI
+XhcBulkQueueComplete (
+  IN  ADLINK_USB_BULK_QUEUE_PROTOCOL  *This,
+  IN  UINT8                           DeviceAddress,
+  IN  UINT8                           EndPointAddress,
+  IN  UINTN                           Timeout,
+  OUT VOID                            **Data OPTIONAL,
+  OUT UINTN                           *DataLength,
+  OUT UINT32                          *TransferResult
+  )
+{
+  USB_XHCI_INSTANCE  *Xhc;
+  URB                *Urb;
+  EFI_STATUS         Status;
+  EFI_STATUS         RecoveryStatus;
+  EFI_TPL            OldTpl;
+
+  if ((DataLength == NULL) || (TransferResult == NULL)) {
+    return EFI_INVALID_PARAMETER;
+  }
+
+  OldTpl = gBS->RaiseTPL (XHC_TPL);
+
+  Xhc = XHC_FROM_BULK_QUEUE (This);
+  Urb = XhcFindBulkTransfer (Xhc, DeviceAddress, EndPointAddress);
+  if (Urb == NULL) {
+    Status = EFI_NOT_FOUND;
+    goto ON_EXIT;
+  }
+
+  if (!Urb->Finished &&
+      ((Urb->Ring == NULL) || XhcIsHalt (Xhc) || XhcIsSysError (Xhc) ||
+       (XhcBusDevAddrToSlotId (Xhc, DeviceAddress) == 0)))
+  {
+    //
+    // The HC is halted, or the device is gone and its transfer ring with it.
+    //
+    Urb->Result   = EFI_USB_ERR_SYSTEM;
+    Urb->Finished = TRUE;
+  }
+
+  if (Urb->Finished) {
+    Status = (Urb->Result == EFI_USB_NOERROR) ? EFI_SUCCESS : EFI_DEVICE_ERROR;
+  } else if (Timeout == 0) {
+    if (!XhcCheckUrbResult (Xhc, Urb)) {
+      Status = EFI_NOT_READY;
+      goto ON_EXIT;
+    }
+
+    Status = (Urb->Result == EFI_USB_NOERROR) ? EFI_SUCCESS : EFI_DEVICE_ERROR;
+  } else {
+    Status = XhcExecTransfer (Xhc, FALSE, Urb, Timeout);
+  }
+
+  if (!Urb->Finished) {
+    //
+    // The transfer timed out. Abort it by dequeueing its TD, which drops
+    // the TDs queued after it as well.
+    //
+    RecoveryStatus = XhcDequeueTrbFromEndpoint (Xhc, Urb);
+    if (RecoveryStatus == EFI_ALREADY_STARTED) {
+      Status = EFI_SUCCESS;
+      DEBUG ((DEBUG_ERROR, "XhcBulkQueueComplete: pending URB is finished, Length = %d.\n", Urb->Completed));
+    } else {
+      if (EFI_ERROR (RecoveryStatus)) {
+        DEBUG ((DEBUG_ERROR, "XhcBulkQueueComplete: XhcDequeueTrbFromEndpoint failed!\n"));
+      }
+
+      XhcAbortBulkTransfers (Xhc, Urb);
+    }
+  }
+
+  if ((Urb->Ring != NULL) &&
+      ((Urb->Result == EFI_USB_ERR_STALL) || (Urb->Result == EFI_USB_ERR_BABBLE)))
+  {
+    //
+    // Recovering the endpoint moves its dequeue pointer past the TDs
+    // queued after this one. A transfer detached from the ring of a
+    // disabled slot has no endpoint left to recover.
+    //
+    RecoveryStatus = XhcRecoverHaltedEndpoint (Xhc, Urb);
+    if (EFI_ERROR (RecoveryStatus)) {
+      DEBUG ((DEBUG_ERROR, "XhcBulkQueueComplete: XhcRecoverHaltedEndpoint failed!\n"));
+    }
+
+    XhcAbortBulkTransfers (Xhc, Urb);
+  }
+
+  if (Urb->Result == EFI_USB_ERR_NOTEXECUTE) {
+    Status = EFI_ABORTED;
+  }
+
+  if (Data != NULL) {
+    *Data = Urb->Data;
+  }
+
+  *DataLength     = Urb->Completed;
+  *TransferResult = Urb->Result;
+
+  Xhc->PciIo->Flush (Xhc->PciIo);
+  RemoveEntryList (&Urb->UrbList);
+  XhcFreeUrb (Xhc, Urb);
+
+ON_EXIT:
+  gBS->RestoreTPL (OldTpl);
+  return Status;
+}
+
+/**
+  Abort and free the transfers queued on an endpoint, see
+  ADLINK_USB_BULK_QUEUE_PROTOCOL.Cancel ().
+
+  @param  This                  This ADLINK_USB_BULK_QUEUE_PROTOCOL instance.
+  @param  DeviceAddress         Target device address.
+  @param  EndPointAddress       Endpoint number and its direction in bit 7.
+
+  @retval EFI_SUCCESS           The transfers were freed.
+  @retval EFI_NOT_FOUND         No transfer is queued on the endpoint.
+
+**/
+EFI_STATUS
+EFIAPI
+XhcBulkQueueCancel (
+  IN ADLINK_USB_BULK_QUEUE_PROTOCOL  *This,
+  IN UINT8                           DeviceAddress,
+  IN UINT8                           EndPointAddress
+  )
+{
+  USB_XHCI_INSTANCE  *Xhc;
+  LIST_ENTRY         *Entry;
+  LIST_ENTRY         *Next;
+  URB                *Urb;
+  EFI_STATUS         Status;
+  EFI_STATUS         RecoveryStatus;
+  EFI_TPL            OldTpl;
+
+  OldTpl = gBS->RaiseTPL (XHC_TPL);
+
+  Xhc    = XHC_FROM_BULK_QUEUE (This);
+  Status = EFI_NOT_FOUND;
+
+  BASE_LIST_FOR_EACH_SAFE (Entry, Next, &Xhc->BulkTransfers) {
+    Urb = EFI_LIST_CONTAINER (Entry, URB, UrbList);
+    if (!XhcIsUrbOfEndpoint (Urb, DeviceAddress, EndPointAddress)) {
+      continue;
+    }
+
+    //
+    // Dequeueing the first TD still in flight drops the ones after it.
+    //
+    if (!Urb->Finished && (Urb->Ring != NULL) && (XhcBusDevAddrToSlotId (Xhc, DeviceAddress) != 0)) {
+      RecoveryStatus = XhcDequeueTrbFromEndpoint (Xhc, Urb);
+      if (RecoveryStatus != EFI_ALREADY_STARTED) {
+        if (EFI_ERROR (RecoveryStatus)) {
+          DEBUG ((DEBUG_ERROR, "XhcBulkQueueCancel: XhcDequeueTrbFromEndpoint failed!\n"));
+        }
+
+        XhcAbortBulkTransfers (Xhc, Urb);
+      }
+    }
+
+    RemoveEntryList (&Urb->UrbList);
+    XhcFreeUrb (Xhc, Urb);
+    Status = EFI_SUCCESS;
+  }
+
+  gBS->RestoreTPL (OldTpl);
+  return Status;
+}
+
+/**
+  Return the address and speed of a device attached to the controller, see
+  ADLINK_USB_BULK_QUEUE_PROTOCOL.GetDevice ().
+
+  The USB nodes following the path of the controller give the port of the
+  device at each tier, from which its route string is rebuilt the way
+  XhcPollPortStatusChange () builds it.
+
+  @param  This                  This ADLINK_USB_BULK_QUEUE_PROTOCOL instance.
+  @param  DevicePath            The device path of a USB I/O instance of the device.
+  @param  DeviceAddress         Return the address of the device.
+  @param  DeviceSpeed           Return the speed of the device.
+
+  @retval EFI_SUCCESS           The device was found.
+  @retval EFI_NOT_FOUND         No device attached to the controller has the path.
+  @retval EFI_INVALID_PARAMETER Some parameters are invalid.
+
+**/
+EFI_STATUS
+EFIAPI
+XhcBulkQueueGetDevice (
+  IN  ADLINK_USB_BULK_QUEUE_PROTOCOL  *This,
+  IN  EFI_DEVICE_PATH_PROTOCOL        *DevicePath,
+  OUT UINT8                           *DeviceAddress,
+  OUT UINT8                           *DeviceSpeed
+  )
+{
+  USB_XHCI_INSTANCE         *Xhc;
+  EFI_DEVICE_PATH_PROTOCOL  *Node;
+  USB_DEV_ROUTE             RouteChart;
+  UINTN                     Size;
+  UINT8                     Port;
+  UINT8                     SlotId;
+  EFI_STATUS                Status;
+  EFI_TPL                   OldTpl;
+
+  if ((DevicePath == NULL) || (DeviceAddress == NULL) || (DeviceSpeed == NULL)) {
+    return EFI_INVALID_PARAMETER;
+  }
+
+  OldTpl = gBS->RaiseTPL (XHC_TPL);
+
+  Xhc    = XHC_FROM_BULK_QUEUE (This);
+  Status = EFI_NOT_FOUND;
+
+  if (Xhc->DevicePath == NULL) {
+    goto ON_EXIT;
+  }
+
+  Size = GetDevicePathSize (Xhc->DevicePath) - END_DEVICE_PATH_LENGTH;
+  if ((GetDevicePathSize (DevicePath) <= Size + END_DEVICE_PATH_LENGTH) ||
+      (CompareMem (DevicePath, Xhc->DevicePath, Size) != 0))
+  {
+    goto ON_EXIT;
+  }
+
+  //
+  // The USB bus driver numbers ports from 0, the route string from 1.
+  //
+  RouteChart.Dword = 0;
+  for (Node = (EFI_DEVICE_PATH_PROTOCOL *)((UINT8 *)DevicePath + Size);
+       !IsDevicePathEnd (Node) &&
+       (DevicePathType (Node) == MESSAGING_DEVICE_PATH) &&
+       (DevicePathSubType (Node) == MSG_USB_DP);
+       Node = NextDevicePathNode (Node))
+  {
+    Port = ((USB_DEVICE_PATH *)Node)->ParentPortNumber + 1;
+    if (RouteChart.Dword == 0) {
+      RouteChart.Route.RootPortNum = Port;
+      RouteChart.Route.TierNum     = 1;
+    } else {
+      if (RouteChart.Route.TierNum > 5) {
+        goto ON_EXIT;
+      }
+
+      RouteChart.Route.RouteString |= ((Port < 14) ? Port : 15) << (4 * (RouteChart.Route.TierNum - 1));
+      RouteChart.Route.TierNum++;
+    }
+  }
+
+  if (RouteChart.Dword == 0) {
+    goto ON_EXIT;
+  }
+
+  SlotId = XhcRouteStringToSlotId (Xhc, RouteChart);
+  if (SlotId == 0) {
+    goto ON_EXIT;
+  }
+
+  *DeviceAddress = Xhc->UsbDevContext[SlotId].BusDevAddr;
+  *DeviceSpeed   = Xhc->UsbDevContext[SlotId].DeviceSpeed;
+  Status         = EFI_SUCCESS;
+
+ON_EXIT:
+  gBS->RestoreTPL (OldTpl);
+  return Status;
+}
+
 /**
   Submits an asynchronous interrupt transfer to an
   interrupt endpoint of a USB device.
@@ -1787,6 +2214,7 @@ XhcCreateUsbHc (
   Xhc->DevicePath            = DevicePath;
   Xhc->OriginalPciAttributes = OriginalPciAttributes;
   CopyMem (&Xhc->Usb2Hc, &gXhciUsb2HcTemplate, sizeof (EFI_USB2_HC_PROTOCOL));
+  CopyMem (&Xhc->BulkQueue, &gXhciBulkQueueTemplate, sizeof (ADLINK_USB_BULK_QUEUE_PROTOCOL));
 
   Status = PciIo->Pci.Read (
                         PciIo,
@@ -1802,6 +2230,7 @@ XhcCreateUsbHc (
   }
 
   InitializeListHead (&Xhc->AsyncIntTransfers);
+  InitializeListHead (&Xhc->BulkTransfers);
 
   //
   // Be caution that the Offset passed to XhcReadCapReg() should be Dword align
@@ -1891,6 +2320,10 @@ XhcExitBootService (
 
   XhcClearBiosOwnership (Xhc);
 
+  if (Xhc->MemPool != NULL) {
+    UsbHcReportMemPool (Xhc->MemPool);
+  }
+
   //
   // Restore original PCI attributes
   //
@@ -2108,6 +2541,20 @@ XhcDriverBindingStart (
     goto FREE_POOL;
   }
 
+  //
+  // The queued bulk transfers only speed up the drivers using them,
+  // don't fail the start because of them.
+  //
+  Status = gBS->InstallProtocolInterface (
+                  &Controller,
+                  &gAdlinkUsbBulkQueueProtocolGuid,
+                  EFI_NATIVE_INTERFACE,
+                  &Xhc->BulkQueue
+                  );
+  if (EFI_ERROR (Status)) {
+    DEBUG ((DEBUG_ERROR, "XhcDriverBindingStart: failed to install bulk queue Protocol\n"));
+  }
+
   DEBUG ((DEBUG_INFO, "XhcDriverBindingStart: XHCI started for controller @ %x\n", Controller));
   return EFI_SUCCESS;
 
@@ -2198,6 +2645,12 @@ XhcDriverBindingStop (
   Xhc   = XHC_FROM_THIS (Usb2Hc);
   PciIo = Xhc->PciIo;
 
+  gBS->UninstallProtocolInterface (
+         Controller,
+         &gAdlinkUsbBulkQueueProtocolGuid,
+         &Xhc->BulkQueue
+         );
+
   //
   // Stop AsyncRequest Polling timer then stop the XHCI driver
   // and uninstall the XHCI protocl.
@@ -2233,6 +2686,7 @@ XhcDriverBindingStop (
   XhcHaltHC (Xhc, XHC_GENERIC_TIMEOUT);
   XhcClearBiosOwnership (Xhc);
   XhciDelAllAsyncIntTransfers (Xhc);
+  XhciDelAllBulkTransfers (Xhc);
   XhcFreeSched (Xhc);
 
   if (Xhc->ControllerNameTable) {
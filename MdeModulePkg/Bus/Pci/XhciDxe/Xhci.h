@@ -15,6 +15,7 @@ SPDX-License-Identifier: BSD-2-Clause-Patent
 
 #include <Protocol/Usb2HostController.h>
 #include <Protocol/PciIo.h>
+#include <Protocol/UsbBulkQueue.h>
 
 #include <Guid/EventGroup.h>
 
@@ -24,8 +25,10 @@ SPDX-License-Identifier: BSD-2-Clause-Patent
 #include <Library/UefiBootServicesTableLib.h>
 #include <Library/MemoryAllocationLib.h>
 #include <Library/UefiLib.h>
+#include <Library/DevicePathLib.h>
 #include <Library/DebugLib.h>
 #include <Library/ReportStatusCodeLib.h>
+#include <Library/PcdLib.h>
 
 #include <IndustryStandard/Pci.h>
 
@@ -77,6 +80,14 @@ typedef struct _USB_DEV_CONTEXT    USB_DEV_CONTEXT;
 #define ERST_NUMBER            0x01
 #define EVENT_RING_TRB_NUMBER  0x200
 
+//
+// Queued bulk transfers in flight per endpoint, and the TRBs they may take
+// in its transfer ring. The rest of the ring is left to the synchronous
+// transfers.
+//
+#define XHC_BULK_QUEUE_DEPTH  16
+#define XHC_BULK_QUEUE_TRBS   (TR_RING_TRB_NUMBER / 2)
+
 #define CMD_INTER        0
 #define CTRL_INTER       1
 #define BULK_INTER       2
@@ -96,6 +107,7 @@ typedef struct _USB_DEV_CONTEXT    USB_DEV_CONTEXT;
 
 #define XHCI_INSTANCE_SIG  SIGNATURE_32 ('x', 'h', 'c', 'i')
 #define XHC_FROM_THIS(a)  CR(a, USB_XHCI_INSTANCE, Usb2Hc, XHCI_INSTANCE_SIG)
+#define XHC_FROM_BULK_QUEUE(a)  CR(a, USB_XHCI_INSTANCE, BulkQueue, XHCI_INSTANCE_SIG)
 
 #define USB_DESC_TYPE_HUB              0x29
 #define USB_DESC_TYPE_HUB_SUPER_SPEED  0x2a
@@ -160,6 +172,10 @@ struct _USB_DEV_CONTEXT {
   //
   UINT8                        BusDevAddr;
   //
+  // The EFI_USB_SPEED_* speed the device was enumerated at.
+  //
+  UINT8                        DeviceSpeed;
+  //
   // The pointer to the input device context.
   //
   VOID                         *InputContext;
@@ -200,6 +216,7 @@ struct _USB_XHCI_INSTANCE {
   USBHC_MEM_POOL              *MemPool;
 
   EFI_USB2_HC_PROTOCOL        Usb2Hc;
+  ADLINK_USB_BULK_QUEUE_PROTOCOL  BulkQueue;
 
   EFI_DEVICE_PATH_PROTOCOL    *DevicePath;
 
@@ -210,6 +227,10 @@ struct _USB_XHCI_INSTANCE {
   EFI_EVENT                   ExitBootServiceEvent;
   EFI_EVENT                   PollTimer;
   LIST_ENTRY                  AsyncIntTransfers;
+  //
+  // Queued bulk transfers, in the order of submission
+  //
+  LIST_ENTRY                  BulkTransfers;
 
   UINT8                       CapLength;  ///< Capability Register Length
   XHC_HCSPARAMS1              HcSParams1; ///< Structural Parameters 1
@@ -230,7 +251,6 @@ struct _USB_XHCI_INSTANCE {
   UINT64                      *DCBAA;
   VOID                        *DCBAAMap;
   UINT32                      MaxSlotsEn;
-  URB                         *PendingUrb;
   //
   // Cmd Transfer Ring
   //
@@ -554,6 +574,116 @@ XhcBulkTransfer (
   OUT    UINT32                              *TransferResult
   );
 
+/**
+  Start a bulk transfer without waiting for it, see
+  ADLINK_USB_BULK_QUEUE_PROTOCOL.Submit ().
+
+  @param  This                  This ADLINK_USB_BULK_QUEUE_PROTOCOL instance.
+  @param  DeviceAddress         Target device address.
+  @param  EndPointAddress       Endpoint number and its direction in bit 7.
+  @param  DeviceSpeed           Device speed, Low speed device doesn't support bulk
+                                transfer.
+  @param  MaximumPacketLength   Maximum packet size the endpoint is capable of
+                                sending or receiving.
+  @param  Data                  The buffer of data to transmit from or receive into.
+  @param  DataLength            The length of the data buffer.
+
+  @retval EFI_SUCCESS           The transfer was started.
+  @retval EFI_NOT_READY         The queue of the endpoint is full.
+  @retval EFI_INVALID_PARAMETER Some parameters are invalid.
+  @retval EFI_OUT_OF_RESOURCES  The transfer failed due to lack of resource.
+  @retval EFI_DEVICE_ERROR      The transfer failed due to host controller error.
+
+**/
+EFI_STATUS
+EFIAPI
+XhcBulkQueueSubmit (
+  IN ADLINK_USB_BULK_QUEUE_PROTOCOL  *This,
+  IN UINT8                           DeviceAddress,
+  IN UINT8                           EndPointAddress,
+  IN UINT8                           DeviceSpeed,
+  IN UINTN                           MaximumPacketLength,
+  IN VOID                            *Data,
+  IN UINTN                           DataLength
+  );
+
+/**
+  Complete the oldest transfer queued on an endpoint, see
+  ADLINK_USB_BULK_QUEUE_PROTOCOL.Complete ().
+
+  @param  This                  This ADLINK_USB_BULK_QUEUE_PROTOCOL instance.
+  @param  DeviceAddress         Target device address.
+  @param  EndPointAddress       Endpoint number and its direction in bit 7.
+  @param  Timeout               Indicates the maximum time, in millisecond, to wait
+                                for the transfer, 0 doesn't wait.
+  @param  Data                  Optional. Return the buffer of the transfer.
+  @param  DataLength            Return the length of the data transferred.
+  @param  TransferResult        Return the detailed result of the transfer.
+
+  @retval EFI_SUCCESS           The transfer was completed successfully.
+  @retval EFI_NOT_READY         Timeout is 0 and the transfer isn't finished.
+  @retval EFI_NOT_FOUND         No transfer is queued on the endpoint.
+  @retval EFI_TIMEOUT           The transfer failed due to timeout.
+  @retval EFI_ABORTED           The transfer was aborted after an earlier one failed.
+  @retval EFI_DEVICE_ERROR      The transfer failed due to host controller or device error.
+  @retval EFI_INVALID_PARAMETER Some parameters are invalid.
+
+**/
+EFI_STATUS
+EFIAPI
+XhcBulkQueueComplete (
+  IN  ADLINK_USB_BULK_QUEUE_PROTOCOL  *This,
+  IN  UINT8                           DeviceAddress,
+  IN  UINT8                           EndPointAddress,
+  IN  UINTN                           Timeout,
+  OUT VOID                            **Data OPTIONAL,
+  OUT UINTN                           *DataLength,
+  OUT UINT32                          *TransferResult
+  );
+
+/**
+  Abort and free the transfers queued on an endpoint, see
+  ADLINK_USB_BULK_QUEUE_PROTOCOL.Cancel ().
+
+  @param  This                  This ADLINK_USB_BULK_QUEUE_PROTOCOL instance.
+  @param  DeviceAddress         Target device address.
+  @param  EndPointAddress       Endpoint number and its direction in bit 7.
+
+  @retval EFI_SUCCESS           The transfers were freed.
+  @retval EFI_NOT_FOUND         No transfer is queued on the endpoint.
+
+**/
+EFI_STATUS
+EFIAPI
+XhcBulkQueueCancel (
+  IN ADLINK_USB_BULK_QUEUE_PROTOCOL  *This,
+  IN UINT8                           DeviceAddress,
+  IN UINT8                           EndPointAddress
+  );
+
+/**
+  Return the address and speed of a device attached to the controller, see
+  ADLINK_USB_BULK_QUEUE_PROTOCOL.GetDevice ().
+
+  @param  This                  This ADLINK_USB_BULK_QUEUE_PROTOCOL instance.
+  @param  DevicePath            The device path of a USB I/O instance of the device.
+  @param  DeviceAddress         Return the address of the device.
+  @param  DeviceSpeed           Return the speed of the device.
+
+  @retval EFI_SUCCESS           The device was found.
+  @retval EFI_NOT_FOUND         No device attached to the controller has the path.
+  @retval EFI_INVALID_PARAMETER Some parameters are invalid.
+
+**/
+EFI_STATUS
+EFIAPI
+XhcBulkQueueGetDevice (
+  IN  ADLINK_USB_BULK_QUEUE_PROTOCOL  *This,
+  IN  EFI_DEVICE_PATH_PROTOCOL        *DevicePath,
+  OUT UINT8                           *DeviceAddress,
+  OUT UINT8                           *DeviceSpeed
+  );
+
 /**
   Submits an asynchronous interrupt transfer to an
   interrupt endpoint of a USB device.
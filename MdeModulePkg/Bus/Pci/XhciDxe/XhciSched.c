@@ -41,6 +41,7 @@ XhcCreateCmdTrb (
   CopyMem (Urb->TrbStart, CmdTrb, sizeof (TRB_TEMPLATE));
   Urb->TrbStart->CycleBit = Urb->Ring->RingPCS & BIT0;
   Urb->TrbEnd             = Urb->TrbStart;
+  XhcUpdateTrbUrbIndex (Urb, TRUE);
 
   return Urb;
 }
@@ -201,6 +202,7 @@ XhcFreeUrb (
     Xhc->PciIo->Unmap (Xhc->PciIo, Urb->DataMap);
   }
 
+  XhcUpdateTrbUrbIndex (Urb, FALSE);
   FreePool (Urb);
 }
 
@@ -238,6 +240,12 @@ XhcCreateTransferTrb (
     return EFI_DEVICE_ERROR;
   }
 
+  //
+  // An async interrupt URB is queued again on each round, its previous TRBs
+  // may be reused by other URBs from now on.
+  //
+  XhcUpdateTrbUrbIndex (Urb, FALSE);
+
   Urb->Finished  = FALSE;
   Urb->StartDone = FALSE;
   Urb->EndDone   = FALSE;
@@ -457,6 +465,8 @@ XhcCreateTransferTrb (
       break;
   }
 
+  XhcUpdateTrbUrbIndex (Urb, TRUE);
+
   return EFI_SUCCESS;
 }
 
@@ -897,6 +907,9 @@ CreateTransferRing (
   ASSERT (((UINTN)Buf & 0x3F) == 0);
   ZeroMem (Buf, sizeof (TRB_TEMPLATE) * TrbNum);
 
+  TransferRing->TrbUrb = AllocateZeroPool (sizeof (URB *) * TrbNum);
+  ASSERT (TransferRing->TrbUrb != NULL);
+
   TransferRing->RingSeg0    = Buf;
   TransferRing->TrbNumber   = TrbNum;
   TransferRing->RingEnqueue = (TRB_TEMPLATE *)TransferRing->RingSeg0;
@@ -920,6 +933,153 @@ CreateTransferRing (
   // Set Cycle bit as other TRB PCS init value
   //
   EndTrb->CycleBit = 0;
+
+  TransferRing->RingSeg0Phy = PhyAddr;
+}
+
+/**
+  Free XHCI transfer ring.
+
+  URBs still occupying TRBs of the ring are detached from it, so that
+  freeing them later does not touch the freed ring or its TRB to URB index.
+
+  @param  Xhc               The XHCI Instance.
+  @param  TransferRing      The transfer ring to be freed.
+
+**/
+VOID
+FreeTransferRing (
+  IN  USB_XHCI_INSTANCE  *Xhc,
+  IN  TRANSFER_RING      *TransferRing
+  )
+{
+  UINTN  Index;
+
+  if (TransferRing->TrbUrb != NULL) {
+    //
+    // The async interrupt URBs of a removed device are freed after its slot.
+    //
+    for (Index = 0; Index < TransferRing->TrbNumber; Index++) {
+      if (TransferRing->TrbUrb[Index] != NULL) {
+        TransferRing->TrbUrb[Index]->TrbNum = 0;
+        TransferRing->TrbUrb[Index]->Ring   = NULL;
+      }
+    }
+
+    FreePool (TransferRing->TrbUrb);
+    TransferRing->TrbUrb = NULL;
+  }
+
+  if (TransferRing->RingSeg0 != NULL) {
+    UsbHcFreeMem (Xhc->MemPool, TransferRing->RingSeg0, sizeof (TRB_TEMPLATE) * TransferRing->TrbNumber);
+    TransferRing->RingSeg0 = NULL;
+  }
+}
+
+/**
+  Record or forget the URB as the occupant of its TRBs in the TRB to URB
+  index of its ring.
+
+  @param  Urb               The URB.
+  @param  Occupied          TRUE when the TRBs of the URB were just queued,
+                            FALSE when the URB is freed or its TRBs reused.
+
+**/
+VOID
+XhcUpdateTrbUrbIndex (
+  IN  URB      *Urb,
+  IN  BOOLEAN  Occupied
+  )
+{
+  TRANSFER_RING  *Ring;
+  UINTN          TrbIndex;
+  UINTN          Index;
+
+  //
+  // A URB detached by FreeTransferRing() has no TRBs, and its ring may be
+  // freed already: test TrbNum before touching the ring.
+  //
+  if ((Urb->TrbNum == 0) || (Urb->Ring == NULL)) {
+    return;
+  }
+
+  Ring = Urb->Ring;
+  if (Ring->TrbUrb == NULL) {
+    return;
+  }
+
+  TrbIndex = ((UINTN)Urb->TrbStart - (UINTN)Ring->RingSeg0) / sizeof (TRB_TEMPLATE);
+  for (Index = 0; Index < Urb->TrbNum; Index++) {
+    ASSERT (TrbIndex < Ring->TrbNumber - 1);
+    if (Occupied) {
+      Ring->TrbUrb[TrbIndex] = Urb;
+    } else if (Ring->TrbUrb[TrbIndex] == Urb) {
+      Ring->TrbUrb[TrbIndex] = NULL;
+    }
+
+    //
+    // The last TRB of the ring is the link TRB back to the first one.
+    //
+    TrbIndex++;
+    if (TrbIndex == Ring->TrbNumber - 1) {
+      TrbIndex = 0;
+    }
+  }
+}
+
+/**
+  Find the TRB an event reports on and the URB occupying it.
+
+  The ring is picked from the slot and endpoint of a transfer event, or is the
+  command ring for a command completion event, then the TRB pointer of the event
+  is turned into an index in that ring.
+
+  @param  Xhc               The XHCI Instance.
+  @param  EvtTrb            The transfer or command completion event.
+  @param  Trb               The host address of the TRB the event reports on,
+                            or NULL if it is not in the ring.
+
+  @return The URB occupying the TRB, or NULL if there is none.
+
+**/
+URB *
+XhcEventTrbToUrb (
+  IN  USB_XHCI_INSTANCE  *Xhc,
+  IN  EVT_TRB_TRANSFER   *EvtTrb,
+  OUT TRB_TEMPLATE       **Trb
+  )
+{
+  TRANSFER_RING         *Ring;
+  EFI_PHYSICAL_ADDRESS  PhyAddr;
+  UINT64                Offset;
+  UINTN                 Index;
+
+  *Trb = NULL;
+
+  if (EvtTrb->Type == TRB_TYPE_COMMAND_COMPLT_EVENT) {
+    Ring = &Xhc->CmdRing;
+  } else if (EvtTrb->EndpointId != 0) {
+    Ring = (TRANSFER_RING *)Xhc->UsbDevContext[EvtTrb->SlotId].EndpointTransferRing[EvtTrb->EndpointId - 1];
+  } else {
+    Ring = NULL;
+  }
+
+  if ((Ring == NULL) || (Ring->TrbUrb == NULL)) {
+    return NULL;
+  }
+
+  PhyAddr = (EFI_PHYSICAL_ADDRESS)(EvtTrb->TRBPtrLo | LShiftU64 ((UINT64)EvtTrb->TRBPtrHi, 32));
+  Offset  = PhyAddr - Ring->RingSeg0Phy;
+  if ((PhyAddr < Ring->RingSeg0Phy) ||
+      (Offset >= sizeof (TRB_TEMPLATE) * Ring->TrbNumber) ||
+      ((Offset & (sizeof (TRB_TEMPLATE) - 1)) != 0))
+  {
+    return NULL;
+  }
+
+  Index = (UINTN)Offset / sizeof (TRB_TEMPLATE);
+  *Trb  = (TRB_TEMPLATE *)Ring->RingSeg0 + Index;
+  return Ring->TrbUrb[Index];
 }
 
 /**
@@ -983,10 +1143,7 @@ XhcFreeSched (
     FreePool (Xhc->ScratchEntry);
   }
 
-  if (Xhc->CmdRing.RingSeg0 != NULL) {
-    UsbHcFreeMem (Xhc->MemPool, Xhc->CmdRing.RingSeg0, sizeof (TRB_TEMPLATE) * CMD_RING_TRB_NUMBER);
-    Xhc->CmdRing.RingSeg0 = NULL;
-  }
+  FreeTransferRing (Xhc, &Xhc->CmdRing);
 
   XhcFreeEventRing (Xhc, &Xhc->EventRing);
 
@@ -1004,84 +1161,6 @@ XhcFreeSched (
   }
 }
 
-/**
-  Check if the Trb is a transaction of the URB.
-
-  @param Xhc    The XHCI Instance.
-  @param Trb    The TRB to be checked
-  @param Urb    The URB to be checked.
-
-  @retval TRUE  It is a transaction of the URB.
-  @retval FALSE It is not any transaction of the URB.
-
-**/
-BOOLEAN
-IsTransferRingTrb (
-  IN  USB_XHCI_INSTANCE  *Xhc,
-  IN  TRB_TEMPLATE       *Trb,
-  IN  URB                *Urb
-  )
-{
-  LINK_TRB              *LinkTrb;
-  TRB_TEMPLATE          *CheckedTrb;
-  UINTN                 Index;
-  EFI_PHYSICAL_ADDRESS  PhyAddr;
-
-  CheckedTrb = Urb->TrbStart;
-  for (Index = 0; Index < Urb->TrbNum; Index++) {
-    if (Trb == CheckedTrb) {
-      return TRUE;
-    }
-
-    CheckedTrb++;
-    //
-    // If the checked TRB is the link TRB at the end of the transfer ring,
-    // recircle it to the head of the ring.
-    //
-    if (CheckedTrb->Type == TRB_TYPE_LINK) {
-      LinkTrb    = (LINK_TRB *)CheckedTrb;
-      PhyAddr    = (EFI_PHYSICAL_ADDRESS)(LinkTrb->PtrLo | LShiftU64 ((UINT64)LinkTrb->PtrHi, 32));
-      CheckedTrb = (TRB_TEMPLATE *)(UINTN)UsbHcGetHostAddrForPciAddr (Xhc->MemPool, (VOID *)(UINTN)PhyAddr, sizeof (TRB_TEMPLATE));
-      ASSERT (CheckedTrb == Urb->Ring->RingSeg0);
-    }
-  }
-
-  return FALSE;
-}
-
-/**
-  Check if the Trb is a transaction of the URBs in XHCI's asynchronous transfer list.
-
-  @param Xhc    The XHCI Instance.
-  @param Trb    The TRB to be checked.
-  @param Urb    The pointer to the matched Urb.
-
-  @retval TRUE  The Trb is matched with a transaction of the URBs in the async list.
-  @retval FALSE The Trb is not matched with any URBs in the async list.
-
-**/
-BOOLEAN
-IsAsyncIntTrb (
-  IN  USB_XHCI_INSTANCE  *Xhc,
-  IN  TRB_TEMPLATE       *Trb,
-  OUT URB                **Urb
-  )
-{
-  LIST_ENTRY  *Entry;
-  LIST_ENTRY  *Next;
-  URB         *CheckedUrb;
-
-  BASE_LIST_FOR_EACH_SAFE (Entry, Next, &Xhc->AsyncIntTransfers) {
-    CheckedUrb = EFI_LIST_CONTAINER (Entry, URB, UrbList);
-    if (IsTransferRingTrb (Xhc, Trb, CheckedUrb)) {
-      *Urb = CheckedUrb;
-      return TRUE;
-    }
-  }
-
-  return FALSE;
-}
-
 /**
   Check the URB's execution result and update the URB's
   result accordingly.
@@ -1103,7 +1182,6 @@ XhcCheckUrbResult (
   UINTN                 Index;
   UINT8                 TRBType;
   EFI_STATUS            Status;
-  URB                   *AsyncUrb;
   URB                   *CheckedUrb;
   UINT64                XhcDequeue;
   UINT32                High;
@@ -1112,8 +1190,7 @@ XhcCheckUrbResult (
 
   ASSERT ((Xhc != NULL) && (Urb != NULL));
 
-  Status   = EFI_SUCCESS;
-  AsyncUrb = NULL;
+  Status = EFI_SUCCESS;
 
   if (Urb->Finished) {
     goto EXIT;
@@ -1147,24 +1224,13 @@ XhcCheckUrbResult (
     }
 
     //
-    // Need convert pci device address to host address
-    //
-    PhyAddr = (EFI_PHYSICAL_ADDRESS)(EvtTrb->TRBPtrLo | LShiftU64 ((UINT64)EvtTrb->TRBPtrHi, 32));
-    TRBPtr  = (TRB_TEMPLATE *)(UINTN)UsbHcGetHostAddrForPciAddr (Xhc->MemPool, (VOID *)(UINTN)PhyAddr, sizeof (TRB_TEMPLATE));
-
-    //
-    // Update the status of URB including the pending URB, the URB that is currently checked,
-    // and URBs in the XHCI's async interrupt transfer list.
+    // Update the status of whichever URB occupies the TRB of the event: the pending URB,
+    // the URB that is currently checked, or a URB in the XHCI's async interrupt transfer list.
     // This way is used to avoid that those completed async transfer events don't get
     // handled in time and are flushed by newer coming events.
     //
-    if ((Xhc->PendingUrb != NULL) && IsTransferRingTrb (Xhc, TRBPtr, Xhc->PendingUrb)) {
-      CheckedUrb = Xhc->PendingUrb;
-    } else if (IsTransferRingTrb (Xhc, TRBPtr, Urb)) {
-      CheckedUrb = Urb;
-    } else if (IsAsyncIntTrb (Xhc, TRBPtr, &AsyncUrb)) {
-      CheckedUrb = AsyncUrb;
-    } else {
+    CheckedUrb = XhcEventTrbToUrb (Xhc, EvtTrb, &TRBPtr);
+    if (CheckedUrb == NULL) {
       continue;
     }
 
@@ -1482,6 +1548,162 @@ XhciDelAllAsyncIntTransfers (
   }
 }
 
+/**
+  Check whether a URB is a transfer of an endpoint.
+
+  @param  Urb                   The URB.
+  @param  BusAddr               The logical device address assigned by UsbBus driver.
+  @param  EpAddr                Endpoint number and its direction encoded in bit 7.
+
+  @return Whether the URB is a transfer of the endpoint.
+
+**/
+BOOLEAN
+XhcIsUrbOfEndpoint (
+  IN URB    *Urb,
+  IN UINT8  BusAddr,
+  IN UINT8  EpAddr
+  )
+{
+  EFI_USB_DATA_DIRECTION  Direction;
+
+  Direction = ((EpAddr & 0x80) != 0) ? EfiUsbDataIn : EfiUsbDataOut;
+
+  return (BOOLEAN)((Urb->Ep.BusAddr == BusAddr) &&
+                   (Urb->Ep.EpAddr == (EpAddr & 0x0F)) &&
+                   (Urb->Ep.Direction == Direction));
+}
+
+/**
+  Find the oldest queued bulk transfer of an endpoint.
+
+  @param  Xhc                   The XHCI Instance.
+  @param  BusAddr               The logical device address assigned by UsbBus driver.
+  @param  EpAddr                Endpoint number and its direction encoded in bit 7.
+
+  @return The URB of the transfer, or NULL if none is queued.
+
+**/
+URB *
+XhcFindBulkTransfer (
+  IN USB_XHCI_INSTANCE  *Xhc,
+  IN UINT8              BusAddr,
+  IN UINT8              EpAddr
+  )
+{
+  LIST_ENTRY  *Entry;
+  URB         *Urb;
+
+  //
+  // The transfers are queued at the tail, the first one found is the oldest.
+  //
+  BASE_LIST_FOR_EACH (Entry, &Xhc->BulkTransfers) {
+    Urb = EFI_LIST_CONTAINER (Entry, URB, UrbList);
+    if (XhcIsUrbOfEndpoint (Urb, BusAddr, EpAddr)) {
+      return Urb;
+    }
+  }
+
+  return NULL;
+}
+
+/**
+  Abort the queued bulk transfers submitted after a URB to the same
+  endpoint, once the transfer ring dequeue pointer was moved past them.
+
+  @param  Xhc                   The XHCI Instance.
+  @param  Urb                   The queued URB that failed or timed out.
+
+**/
+VOID
+XhcAbortBulkTransfers (
+  IN USB_XHCI_INSTANCE  *Xhc,
+  IN URB                *Urb
+  )
+{
+  LIST_ENTRY  *Entry;
+  URB         *Later;
+
+  for (Entry = Urb->UrbList.ForwardLink; Entry != &Xhc->BulkTransfers; Entry = Entry->ForwardLink) {
+    Later = EFI_LIST_CONTAINER (Entry, URB, UrbList);
+    if ((Later->Ep.BusAddr == Urb->Ep.BusAddr) &&
+        (Later->Ep.EpAddr == Urb->Ep.EpAddr) &&
+        (Later->Ep.Direction == Urb->Ep.Direction) &&
+        !Later->Finished)
+    {
+      Later->Result   = EFI_USB_ERR_NOTEXECUTE;
+      Later->Finished = TRUE;
+    }
+  }
+}
+
+/**
+  Finish the queued bulk transfers of a device slot whose transfer rings
+  are about to be freed, and detach them from their rings.
+
+  @param  Xhc                   The XHCI Instance.
+  @param  SlotId                The slot id of the device.
+
+**/
+VOID
+XhcFinishSlotBulkTransfers (
+  IN USB_XHCI_INSTANCE  *Xhc,
+  IN UINT8              SlotId
+  )
+{
+  LIST_ENTRY  *Entry;
+  URB         *Urb;
+  UINTN       Index;
+
+  BASE_LIST_FOR_EACH (Entry, &Xhc->BulkTransfers) {
+    Urb = EFI_LIST_CONTAINER (Entry, URB, UrbList);
+    if (Urb->Ring == NULL) {
+      continue;
+    }
+
+    for (Index = 0; Index < 31; Index++) {
+      if (Urb->Ring == Xhc->UsbDevContext[SlotId].EndpointTransferRing[Index]) {
+        break;
+      }
+    }
+
+    if (Index == 31) {
+      continue;
+    }
+
+    XhcUpdateTrbUrbIndex (Urb, FALSE);
+    if (!Urb->Finished) {
+      Urb->Result   = EFI_USB_ERR_SYSTEM;
+      Urb->Finished = TRUE;
+    }
+
+    Urb->TrbNum = 0;
+    Urb->Ring   = NULL;
+  }
+}
+
+/**
+  Free all the queued bulk transfers.
+
+  @param  Xhc                   The XHCI Instance.
+
+**/
+VOID
+XhciDelAllBulkTransfers (
+  IN USB_XHCI_INSTANCE  *Xhc
+  )
+{
+  LIST_ENTRY  *Entry;
+  LIST_ENTRY  *Next;
+  URB         *Urb;
+
+  BASE_LIST_FOR_EACH_SAFE (Entry, Next, &Xhc->BulkTransfers) {
+    Urb = EFI_LIST_CONTAINER (Entry, URB, UrbList);
+    RemoveEntryList (&Urb->UrbList);
+    XhcFreeUrb (Xhc, Urb);
+  }
+}
+
 /**
   Insert a single asynchronous interrupt transfer for
   the device and endpoint.
@@ -2198,6 +2420,7 @@ XhcInitializeDeviceSlot (
   Xhc->UsbDevContext[SlotId].SlotId                  = SlotId;
   Xhc->UsbDevContext[SlotId].RouteString.Dword       = RouteChart.Dword;
   Xhc->UsbDevContext[SlotId].ParentRouteString.Dword = ParentRouteChart.Dword;
+  Xhc->UsbDevContext[SlotId].DeviceSpeed             = DeviceSpeed;
 
   //
   // 4.3.3 Device Slot Initialization
@@ -2414,6 +2637,7 @@ XhcInitializeDeviceSlot64 (
   Xhc->UsbDevContext[SlotId].SlotId                  = SlotId;
   Xhc->UsbDevContext[SlotId].RouteString.Dword       = RouteChart.Dword;
   Xhc->UsbDevContext[SlotId].ParentRouteString.Dword = ParentRouteChart.Dword;
+  Xhc->UsbDevContext[SlotId].DeviceSpeed             = DeviceSpeed;
 
   //
   // 4.3.3 Device Slot Initialization
@@ -2590,7 +2814,6 @@ XhcDisableSlotCmd (
   TRB_TEMPLATE          *EvtTrb;
   CMD_TRB_DISABLE_SLOT  CmdTrbDisSlot;
   UINT8                 Index;
-  VOID                  *RingSeg;
 
   //
   // Disable the device slots occupied by these devices on its downstream ports.
@@ -2638,15 +2861,13 @@ XhcDisableSlotCmd (
   Xhc->DCBAA[SlotId] = 0;
 
   //
-  // Free the slot related data structure
+  // Free the slot related data structure. The bulk transfers still queued
+  // on its endpoints are finished first, they must not reach the freed rings.
   //
+  XhcFinishSlotBulkTransfers (Xhc, SlotId);
   for (Index = 0; Index < 31; Index++) {
     if (Xhc->UsbDevContext[SlotId].EndpointTransferRing[Index] != NULL) {
-      RingSeg = ((TRANSFER_RING *)(UINTN)Xhc->UsbDevContext[SlotId].EndpointTransferRing[Index])->RingSeg0;
-      if (RingSeg != NULL) {
-        UsbHcFreeMem (Xhc->MemPool, RingSeg, sizeof (TRB_TEMPLATE) * TR_RING_TRB_NUMBER);
-      }
-
+      FreeTransferRing (Xhc, (TRANSFER_RING *)Xhc->UsbDevContext[SlotId].EndpointTransferRing[Index]);
       FreePool (Xhc->UsbDevContext[SlotId].EndpointTransferRing[Index]);
       Xhc->UsbDevContext[SlotId].EndpointTransferRing[Index] = NULL;
     }
@@ -2701,7 +2922,6 @@ XhcDisableSlotCmd64 (
   TRB_TEMPLATE          *EvtTrb;
   CMD_TRB_DISABLE_SLOT  CmdTrbDisSlot;
   UINT8                 Index;
-  VOID                  *RingSeg;
 
   //
   // Disable the device slots occupied by these devices on its downstream ports.
@@ -2749,15 +2969,13 @@ XhcDisableSlotCmd64 (
   Xhc->DCBAA[SlotId] = 0;
 
   //
-  // Free the slot related data structure
+  // Free the slot related data structure. The bulk transfers still queued
+  // on its endpoints are finished first, they must not reach the freed rings.
   //
+  XhcFinishSlotBulkTransfers (Xhc, SlotId);
   for (Index = 0; Index < 31; Index++) {
     if (Xhc->UsbDevContext[SlotId].EndpointTransferRing[Index] != NULL) {
-      RingSeg = ((TRANSFER_RING *)(UINTN)Xhc->UsbDevContext[SlotId].EndpointTransferRing[Index])->RingSeg0;
-      if (RingSeg != NULL) {
-        UsbHcFreeMem (Xhc->MemPool, RingSeg, sizeof (TRB_TEMPLATE) * TR_RING_TRB_NUMBER);
-      }
-
+      FreeTransferRing (Xhc, (TRANSFER_RING *)Xhc->UsbDevContext[SlotId].EndpointTransferRing[Index]);
       FreePool (Xhc->UsbDevContext[SlotId].EndpointTransferRing[Index]);
       Xhc->UsbDevContext[SlotId].EndpointTransferRing[Index] = NULL;
     }
@@ -3400,18 +3618,11 @@ XhcStopEndpoint (
   DEBUG ((DEBUG_INFO, "XhcStopEndpoint: Slot = 0x%x, Dci = 0x%x\n", SlotId, Dci));
 
   //
-  // When XhcCheckUrbResult waits for the Stop_Endpoint completion, it also checks
+  // When XhcCheckUrbResult waits for the Stop_Endpoint completion, it also updates
   // the PendingUrb completion status, because it's possible that the PendingUrb is
   // finished just before stopping the end point, but after the looping check.
-  //
-  // The PendingUrb could be passed to XhcCmdTransfer to XhcExecTransfer to XhcCheckUrbResult
-  // through function parameter, but That will cause every consumer of XhcCmdTransfer,
-  // XhcExecTransfer and XhcCheckUrbResult pass a NULL PendingUrb.
-  // But actually only XhcCheckUrbResult is aware of the PendingUrb.
-  // So we choose to save the PendingUrb into the USB_XHCI_INSTANCE and use it in XhcCheckUrbResult.
-  //
-  ASSERT (Xhc->PendingUrb == NULL);
-  Xhc->PendingUrb = PendingUrb;
+  // The PendingUrb still occupies its TRBs, so the TRB to URB index of the ring
+  // leads the transfer events to it.
   //
   // Reset the URB result from Timeout to NoError.
   // The USB result will be:
@@ -3440,8 +3651,6 @@ XhcStopEndpoint (
     DEBUG ((DEBUG_ERROR, "XhcStopEndpoint: Stop Endpoint Failed, Status = %r\n", Status));
   }
 
-  Xhc->PendingUrb = NULL;
-
   return Status;
 }
 
@@ -3578,7 +3787,6 @@ XhcSetInterface (
   UINT8                     Dci;
   UINT8                     MaxDci;
   EFI_PHYSICAL_ADDRESS      PhyAddr;
-  VOID                      *RingSeg;
 
   CMD_TRB_CONFIG_ENDPOINT     CmdTrbCfgEP;
   INPUT_CONTEXT               *InputContext;
@@ -3680,11 +3888,7 @@ XhcSetInterface (
       // 2) Free Transfer Rings of all endpoints that will be affected by the Alternate Interface setting.
       //
       if (Xhc->UsbDevContext[SlotId].EndpointTransferRing[Dci - 1] != NULL) {
-        RingSeg = ((TRANSFER_RING *)(UINTN)Xhc->UsbDevContext[SlotId].EndpointTransferRing[Dci - 1])->RingSeg0;
-        if (RingSeg != NULL) {
-          UsbHcFreeMem (Xhc->MemPool, RingSeg, sizeof (TRB_TEMPLATE) * TR_RING_TRB_NUMBER);
-        }
-
+        FreeTransferRing (Xhc, (TRANSFER_RING *)Xhc->UsbDevContext[SlotId].EndpointTransferRing[Dci - 1]);
         FreePool (Xhc->UsbDevContext[SlotId].EndpointTransferRing[Dci - 1]);
         Xhc->UsbDevContext[SlotId].EndpointTransferRing[Dci - 1] = NULL;
       }
@@ -3784,7 +3988,6 @@ XhcSetInterface64 (
   UINT8                     Dci;
   UINT8                     MaxDci;
   EFI_PHYSICAL_ADDRESS      PhyAddr;
-  VOID                      *RingSeg;
 
   CMD_TRB_CONFIG_ENDPOINT     CmdTrbCfgEP;
   INPUT_CONTEXT_64            *InputContext;
@@ -3886,11 +4089,7 @@ XhcSetInterface64 (
       // 2) Free Transfer Rings of all endpoints that will be affected by the Alternate Interface setting.
       //
       if (Xhc->UsbDevContext[SlotId].EndpointTransferRing[Dci - 1] != NULL) {
-        RingSeg = ((TRANSFER_RING *)(UINTN)Xhc->UsbDevContext[SlotId].EndpointTransferRing[Dci - 1])->RingSeg0;
-        if (RingSeg != NULL) {
-          UsbHcFreeMem (Xhc->MemPool, RingSeg, sizeof (TRB_TEMPLATE) * TR_RING_TRB_NUMBER);
-        }
-
+        FreeTransferRing (Xhc, (TRANSFER_RING *)Xhc->UsbDevContext[SlotId].EndpointTransferRing[Dci - 1]);
         FreePool (Xhc->UsbDevContext[SlotId].EndpointTransferRing[Dci - 1]);
         Xhc->UsbDevContext[SlotId].EndpointTransferRing[Dci - 1] = NULL;
       }
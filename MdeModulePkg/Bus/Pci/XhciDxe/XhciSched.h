@@ -139,11 +139,17 @@ typedef struct _TRB_TEMPLATE {
 } TRB_TEMPLATE;
 
 typedef struct _TRANSFER_RING {
-  VOID            *RingSeg0;
-  UINTN           TrbNumber;
-  TRB_TEMPLATE    *RingEnqueue;
-  TRB_TEMPLATE    *RingDequeue;
-  UINT32          RingPCS;
+  VOID                    *RingSeg0;
+  UINTN                   TrbNumber;
+  TRB_TEMPLATE            *RingEnqueue;
+  TRB_TEMPLATE            *RingDequeue;
+  UINT32                  RingPCS;
+  //
+  // The PCI address of RingSeg0, and for each TRB the URB occupying it.
+  // Together they map the TRB pointer of an event to its URB in constant time.
+  //
+  EFI_PHYSICAL_ADDRESS    RingSeg0Phy;
+  struct _URB             **TrbUrb;
 } TRANSFER_RING;
 
 typedef struct _EVENT_RING {
@@ -791,6 +797,22 @@ RingIntTransferDoorBell (
   IN  URB                *Urb
   );
 
+/**
+  Check the URB's execution result and update the URB's
+  result accordingly.
+
+  @param  Xhc               The XHCI Instance.
+  @param  Urb               The URB to check result.
+
+  @return Whether the result of URB transfer is finialized.
+
+**/
+BOOLEAN
+XhcCheckUrbResult (
+  IN  USB_XHCI_INSTANCE  *Xhc,
+  IN  URB                *Urb
+  );
+
 /**
   Execute the transfer by polling the URB. This is a synchronous operation.
 
@@ -842,6 +864,79 @@ XhciDelAllAsyncIntTransfers (
   IN USB_XHCI_INSTANCE  *Xhc
   );
 
+/**
+  Check whether a URB is a transfer of an endpoint.
+
+  @param  Urb                   The URB.
+  @param  BusAddr               The logical device address assigned by UsbBus driver.
+  @param  EpAddr                Endpoint number and its direction encoded in bit 7.
+
+  @return Whether the URB is a transfer of the endpoint.
+
+**/
+BOOLEAN
+XhcIsUrbOfEndpoint (
+  IN URB    *Urb,
+  IN UINT8  BusAddr,
+  IN UINT8  EpAddr
+  );
+
+/**
+  Find the oldest queued bulk transfer of an endpoint.
+
+  @param  Xhc                   The XHCI Instance.
+  @param  BusAddr               The logical device address assigned by UsbBus driver.
+  @param  EpAddr                Endpoint number and its direction encoded in bit 7.
+
+  @return The URB of the transfer, or NULL if none is queued.
+
+**/
+URB *
+XhcFindBulkTransfer (
+  IN USB_XHCI_INSTANCE  *Xhc,
+  IN UINT8              BusAddr,
+  IN UINT8              EpAddr
+  );
+
+/**
+  Abort the queued bulk transfers submitted after a URB to the same
+  endpoint, once the transfer ring dequeue pointer was moved past them.
+
+  @param  Xhc                   The XHCI Instance.
+  @param  Urb                   The queued URB that failed or timed out.
+
+**/
+VOID
+XhcAbortBulkTransfers (
+  IN USB_XHCI_INSTANCE  *Xhc,
+  IN URB                *Urb
+  );
+
+/**
+  Finish the queued bulk transfers of a device slot whose transfer rings
+  are about to be freed, and detach them from their rings.
+
+  @param  Xhc                   The XHCI Instance.
+  @param  SlotId                The slot id of the device.
+
+**/
+VOID
+XhcFinishSlotBulkTransfers (
+  IN USB_XHCI_INSTANCE  *Xhc,
+  IN UINT8              SlotId
+  );
+
+/**
+  Free all the queued bulk transfers.
+
+  @param  Xhc                   The XHCI Instance.
+
+**/
+VOID
+XhciDelAllBulkTransfers (
+  IN USB_XHCI_INSTANCE  *Xhc
+  );
+
 /**
   Insert a single asynchronous interrupt transfer for
   the device and endpoint.
@@ -1296,6 +1391,59 @@ CreateTransferRing (
   OUT TRANSFER_RING      *TransferRing
   );
 
+/**
+  Free XHCI transfer ring.
+
+  URBs still occupying TRBs of the ring are detached from it, so that
+  freeing them later does not touch the freed ring.
+
+  @param  Xhc               The XHCI Instance.
+  @param  TransferRing      The transfer ring to be freed.
+
+**/
+VOID
+FreeTransferRing (
+  IN  USB_XHCI_INSTANCE  *Xhc,
+  IN  TRANSFER_RING      *TransferRing
+  );
+
+/**
+  Record or forget the URB as the occupant of its TRBs in the TRB to URB
+  index of its ring.
+
+  @param  Urb               The URB.
+  @param  Occupied          TRUE when the TRBs of the URB were just queued,
+                            FALSE when the URB is freed or its TRBs reused.
+
+**/
+VOID
+XhcUpdateTrbUrbIndex (
+  IN  URB      *Urb,
+  IN  BOOLEAN  Occupied
+  );
+
+/**
+  Find the TRB an event reports on and the URB occupying it.
+
+  The ring is picked from the slot and endpoint of a transfer event, or is the
+  command ring for a command completion event, then the TRB pointer of the event
+  is turned into an index in that ring.
+
+  @param  Xhc               The XHCI Instance.
+  @param  EvtTrb            The transfer or command completion event.
+  @param  Trb               The host address of the TRB the event reports on,
+                            or NULL if it is not in the ring.
+
+  @return The URB occupying the TRB, or NULL if there is none.
+
+**/
+URB *
+XhcEventTrbToUrb (
+  IN  USB_XHCI_INSTANCE  *Xhc,
+  IN  EVT_TRB_TRANSFER   *EvtTrb,
+  OUT TRB_TEMPLATE       **Trb
+  );
+
 /**
   Create XHCI event ring.
 
@@ -0,0 +1,97 @@
+/** @file
+  PEI binary status code log worker.
+
+  Copyright (c) 2022, ADLink. All rights reserved.<BR>
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#include "StatusCodeHandlerPei.h"
+
+/**
+  Create the binary status code log GUID'ed HOB.
+
+  @retval EFI_SUCCESS           The GUID'ed HOB is created successfully.
+  @retval EFI_OUT_OF_RESOURCES  No room for the HOB.
+
+**/
+EFI_STATUS
+BinaryLogStatusCodeInitializeWorker (
+  VOID
+  )
+{
+  VOID   *Buffer;
+  UINTN  Size;
+
+  Size   = sizeof (ADLINK_STATUS_CODE_LOG_HEADER) + FixedPcdGet32 (PcdStatusCodeBinaryLogPeiSize) * 1024;
+  Buffer = BuildGuidHob (&gAdlinkStatusCodeLogGuid, Size);
+  if (StatusCodeLogInitialize (Buffer, Size) == NULL) {
+    return EFI_OUT_OF_RESOURCES;
+  }
+
+  return EFI_SUCCESS;
+}
+
+/**
+  Report status code into the binary status code log GUID'ed HOB.
+
+  DEBUG () messages are kept unformatted, see Guid/StatusCodeLog.h.
+
+  @param  PeiServices      An indirect pointer to the EFI_PEI_SERVICES table published by the PEI Foundation.
+  @param  CodeType         Indicates the type of status code being reported.
+  @param  Value            Describes the current status of a hardware or
+                           software entity. This includes information about the class and
+                           subclass that is used to classify the entity as well as an operation.
+                           For progress codes, the operation is the current activity.
+                           For error codes, it is the exception.For debug codes,it is not defined at this time.
+  @param  Instance         The enumeration of a hardware or software entity within
+                           the system. A system may contain multiple entities that match a class/subclass
+                           pairing. The instance differentiates between them. An instance of 0 indicates
+                           that instance information is unavailable, not meaningful, or not relevant.
+                           Valid instance numbers start with 1.
+  @param  CallerId         This optional parameter may be used to identify the caller.
+                           This parameter allows the status code driver to apply different rules to
+                           different callers.
+  @param  Data             This optional parameter may be used to pass additional data.
+
+  @retval EFI_SUCCESS      The function always return EFI_SUCCESS.
+
+**/
+EFI_STATUS
+EFIAPI
+BinaryLogStatusCodeReportWorker (
+  IN CONST  EFI_PEI_SERVICES     **PeiServices,
+  IN EFI_STATUS_CODE_TYPE        CodeType,
+  IN EFI_STATUS_CODE_VALUE       Value,
+  IN UINT32                      Instance,
+  IN CONST EFI_GUID              *CallerId,
+  IN CONST EFI_STATUS_CODE_DATA  *Data OPTIONAL
+  )
+{
+  EFI_PEI_HOB_POINTERS  Hob;
+  CHAR8                 *Format;
+  UINT32                ErrorLevel;
+  BASE_LIST             Marker;
+
+  if (!StatusCodeRouted (ADLINK_STATUS_CODE_SINK_BINARY_LOG, CodeType, CallerId, Data)) {
+    return EFI_SUCCESS;
+  }
+
+  //
+  // The HOB moves when PEI memory is installed, find it again every time.
+  //
+  Hob.Raw = GetFirstGuidHob (&gAdlinkStatusCodeLogGuid);
+  if (Hob.Raw == NULL) {
+    return EFI_SUCCESS;
+  }
+
+  if ((Data != NULL) &&
+      ReportStatusCodeExtractDebugInfo (Data, &ErrorLevel, &Marker, &Format))
+  {
+    StatusCodeLogDebug (GET_GUID_HOB_DATA (Hob.Guid), CallerId, ErrorLevel, Format, Marker);
+  } else {
+    StatusCodeLogCode (GET_GUID_HOB_DATA (Hob.Guid), CallerId, CodeType, Value, Instance);
+  }
+
+  return EFI_SUCCESS;
+}
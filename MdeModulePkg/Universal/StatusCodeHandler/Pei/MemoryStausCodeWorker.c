@@ -7,11 +7,13 @@
 **/
 
 #include "StatusCodeHandlerPei.h"
+#include <Library/PostCodeMapLib.h>
 
 /**
-  Create the first memory status code GUID'ed HOB as initialization for memory status code worker.
+  Create the first memory status code GUID'ed HOBs as initialization for memory status code worker:
+  the standard one of Guid/MemoryStatusCodeRecord.h and the timed one.
 
-  @retval EFI_SUCCESS  The GUID'ed HOB is created successfully.
+  @retval EFI_SUCCESS  The GUID'ed HOBs are created successfully.
 
 **/
 EFI_STATUS
@@ -23,6 +25,7 @@ MemoryStatusCodeInitializeWorker (
   // Create memory status code GUID'ed HOB.
   //
   MEMORY_STATUSCODE_PACKET_HEADER  *PacketHeader;
+  ADLINK_TIMED_STATUSCODE_HEADER   *Header;
 
   //
   // Build GUID'ed HOB with PCD defined size.
@@ -37,6 +40,18 @@ MemoryStatusCodeInitializeWorker (
   PacketHeader->PacketIndex      = 0;
   PacketHeader->RecordIndex      = 0;
 
+  Header = BuildGuidHob (
+             &gAdlinkTimedStatusCodeRecordGuid,
+             PcdGet16 (PcdStatusCodeMemorySize) * 1024 + sizeof (ADLINK_TIMED_STATUSCODE_HEADER)
+             );
+  ASSERT (Header != NULL);
+
+  ZeroMem (Header, sizeof (*Header));
+  Header->Signature        = ADLINK_TIMED_STATUSCODE_SIGNATURE;
+  Header->RecordSize       = sizeof (ADLINK_TIMED_STATUSCODE_RECORD);
+  Header->MaxRecordsNumber = (PcdGet16 (PcdStatusCodeMemorySize) * 1024) / sizeof (ADLINK_TIMED_STATUSCODE_RECORD);
+  Header->Frequency        = GetPerformanceCounterProperties (NULL, NULL);
+
   return EFI_SUCCESS;
 }
 
@@ -79,7 +94,13 @@ MemoryStatusCodeReportWorker (
 {
   EFI_PEI_HOB_POINTERS             Hob;
   MEMORY_STATUSCODE_PACKET_HEADER  *PacketHeader;
-  MEMORY_STATUSCODE_RECORD         *Record;
+  MEMORY_STATUSCODE_RECORD         *PacketRecord;
+  ADLINK_TIMED_STATUSCODE_HEADER   *Header;
+  ADLINK_TIMED_STATUSCODE_RECORD   *Record;
+
+  if (!StatusCodeRouted (ADLINK_STATUS_CODE_SINK_MEMORY, CodeType, CallerId, Data)) {
+    return EFI_SUCCESS;
+  }
 
   //
   // Find GUID'ed HOBs to locate current record buffer.
@@ -88,15 +109,40 @@ MemoryStatusCodeReportWorker (
   ASSERT (Hob.Raw != NULL);
 
   PacketHeader = (MEMORY_STATUSCODE_PACKET_HEADER *)GET_GUID_HOB_DATA (Hob.Guid);
-  Record       = (MEMORY_STATUSCODE_RECORD *)(PacketHeader + 1);
-  Record       = &Record[PacketHeader->RecordIndex++];
+  PacketRecord = (MEMORY_STATUSCODE_RECORD *)(PacketHeader + 1);
+  PacketRecord = &PacketRecord[PacketHeader->RecordIndex++];
+
+  //
+  // Save status code in the standard record first, then with its time.
+  //
+  PacketRecord->CodeType = CodeType;
+  PacketRecord->Instance = Instance;
+  PacketRecord->Value    = Value;
+
+  if (PacketHeader->RecordIndex == PacketHeader->MaxRecordsNumber) {
+    PacketHeader->RecordIndex = 0;
+    PacketHeader->PacketIndex++;
+  }
+
+  Hob.Raw = GetFirstGuidHob (&gAdlinkTimedStatusCodeRecordGuid);
+  ASSERT (Hob.Raw != NULL);
+
+  Header = (ADLINK_TIMED_STATUSCODE_HEADER *)GET_GUID_HOB_DATA (Hob.Guid);
+  Record = (ADLINK_TIMED_STATUSCODE_RECORD *)(Header + 1);
+  Record = &Record[Header->RecordIndex++];
 
   //
   // Save status code.
   //
-  Record->CodeType = CodeType;
-  Record->Instance = Instance;
-  Record->Value    = Value;
+  ZeroMem (Record, sizeof (*Record));
+  Record->CodeType  = CodeType;
+  Record->Value     = Value;
+  Record->Instance  = Instance;
+  Record->PostCode  = GetPostCodeFromStatusCode (CodeType, Value);
+  Record->Timestamp = GetPerformanceCounter ();
+  if (CallerId != NULL) {
+    CopyGuid (&Record->CallerId, CallerId);
+  }
 
   //
   // If record index equals to max record number, then wrap around record index to zero.
@@ -106,12 +152,12 @@ MemoryStatusCodeReportWorker (
   // so the first record is pointed by record index.
   // If it is less then max number, index of the first record is zero.
   //
-  if (PacketHeader->RecordIndex == PacketHeader->MaxRecordsNumber) {
+  Header->NumberOfRecords++;
+  if (Header->RecordIndex == Header->MaxRecordsNumber) {
     //
     // Wrap around record index.
     //
-    PacketHeader->RecordIndex = 0;
-    PacketHeader->PacketIndex++;
+    Header->RecordIndex = 0;
   }
 
   return EFI_SUCCESS;
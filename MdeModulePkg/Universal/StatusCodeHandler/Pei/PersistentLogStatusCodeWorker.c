@@ -0,0 +1,92 @@
+/** @file
+  PEI persistent status code log worker.
+
+  Copyright (c) 2022, ADLink. All rights reserved.<BR>
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#include "StatusCodeHandlerPei.h"
+#include <Library/PostCodeMapLib.h>
+
+/**
+  Start the persistent status code log of this boot, keeping the log of
+  the previous boot for StatusCodeHandlerRuntimeDxe to publish. The region
+  is reserved in the memory map, so that neither DXE nor the OS use it.
+
+  @retval EFI_SUCCESS      The log is started.
+  @retval EFI_UNSUPPORTED  PcdStatusCodePersistentLogSize is 0.
+
+**/
+EFI_STATUS
+PersistentLogStatusCodeInitializeWorker (
+  VOID
+  )
+{
+  if (PersistentLogStart () == NULL) {
+    return EFI_UNSUPPORTED;
+  }
+
+  BuildMemoryAllocationHob (
+    FixedPcdGet64 (PcdStatusCodePersistentLogBase),
+    FixedPcdGet32 (PcdStatusCodePersistentLogSize) * SIZE_1KB,
+    EfiReservedMemoryType
+    );
+
+  return EFI_SUCCESS;
+}
+
+/**
+  Report status code into the persistent status code log.
+
+  @param  PeiServices      An indirect pointer to the EFI_PEI_SERVICES table published by the PEI Foundation.
+  @param  CodeType         Indicates the type of status code being reported.
+  @param  Value            Describes the current status of a hardware or
+                           software entity. This includes information about the class and
+                           subclass that is used to classify the entity as well as an operation.
+                           For progress codes, the operation is the current activity.
+                           For error codes, it is the exception.For debug codes,it is not defined at this time.
+  @param  Instance         The enumeration of a hardware or software entity within
+                           the system. A system may contain multiple entities that match a class/subclass
+                           pairing. The instance differentiates between them. An instance of 0 indicates
+                           that instance information is unavailable, not meaningful, or not relevant.
+                           Valid instance numbers start with 1.
+  @param  CallerId         This optional parameter may be used to identify the caller.
+                           This parameter allows the status code driver to apply different rules to
+                           different callers.
+  @param  Data             This optional parameter may be used to pass additional data.
+
+  @retval EFI_SUCCESS      The function always return EFI_SUCCESS.
+
+**/
+EFI_STATUS
+EFIAPI
+PersistentLogStatusCodeReportWorker (
+  IN CONST  EFI_PEI_SERVICES     **PeiServices,
+  IN EFI_STATUS_CODE_TYPE        CodeType,
+  IN EFI_STATUS_CODE_VALUE       Value,
+  IN UINT32                      Instance,
+  IN CONST EFI_GUID              *CallerId,
+  IN CONST EFI_STATUS_CODE_DATA  *Data OPTIONAL
+  )
+{
+  ADLINK_PERSISTENT_LOG_HEADER  *Log;
+
+  if (!StatusCodeRouted (ADLINK_STATUS_CODE_SINK_PERSISTENT, CodeType, CallerId, Data)) {
+    return EFI_SUCCESS;
+  }
+
+  Log = PersistentLogGetCurrent ();
+  if (Log != NULL) {
+    PersistentLogAppend (
+      Log,
+      CodeType,
+      Value,
+      Instance,
+      GetPostCodeFromStatusCode (CodeType, Value),
+      CallerId
+      );
+  }
+
+  return EFI_SUCCESS;
+}
@@ -8,6 +8,7 @@
 #include "StatusCodeHandlerPei.h"
 #include <Library/PostCodeLib.h>
 #include <Library/PostCodeMapLib.h>
+#include <Library/MmcLib.h>
 
 /**
   Convert status code value and extended data to readable ASCII string, send string to serial I/O device.
@@ -55,8 +56,13 @@ SerialStatusCodeReportWorker (
 
   Buffer[0] = '\0';
 
-  if ((Data != NULL) &&
-      ReportStatusCodeExtractAssertInfo (CodeType, Value, Data, &Filename, &Description, &LineNumber))
+  if (!StatusCodeRouted (ADLINK_STATUS_CODE_SINK_SERIAL, CodeType, CallerId, Data)) {
+    //
+    // The routing policy keeps it off the serial port.
+    //
+    CharCount = 0;
+  } else if ((Data != NULL) &&
+             ReportStatusCodeExtractAssertInfo (CodeType, Value, Data, &Filename, &Description, &LineNumber))
   {
     //
     // Print ASSERT() information into output buffer.
@@ -73,14 +79,18 @@ SerialStatusCodeReportWorker (
              ReportStatusCodeExtractDebugInfo (Data, &ErrorLevel, &Marker, &Format))
   {
     //
-    // Print DEBUG() information into output buffer.
+    // Print DEBUG() information into output buffer, unless the binary
+    // log keeps it for the host to format.
     //
-    CharCount = AsciiBSPrint (
-                  Buffer,
-                  sizeof (Buffer),
-                  Format,
-                  Marker
-                  );
+    CharCount = 0;
+    if (!FeaturePcdGet (PcdStatusCodeUseBinaryLog)) {
+      CharCount = AsciiBSPrint (
+                    Buffer,
+                    sizeof (Buffer),
+                    Format,
+                    Marker
+                    );
+    }
   } else if ((CodeType & EFI_STATUS_CODE_TYPE_MASK) == EFI_ERROR_CODE) {
     //
     // Print ERROR information into output buffer.
@@ -121,15 +131,19 @@ SerialStatusCodeReportWorker (
                    );
   } else if ((CodeType & EFI_STATUS_CODE_TYPE_MASK) == EFI_PROGRESS_CODE) {
     //
-    // Print PROGRESS information into output buffer.
+    // Print PROGRESS information into output buffer, unless the binary
+    // log keeps it.
     //
-    CharCount = AsciiSPrint (
-                  Buffer,
-                  sizeof (Buffer),
-                  "PROGRESS CODE: V%08x I%x\n\r",
-                  Value,
-                  Instance
-                  );
+    CharCount = 0;
+    if (!FeaturePcdGet (PcdStatusCodeUseBinaryLog)) {
+      CharCount = AsciiSPrint (
+                    Buffer,
+                    sizeof (Buffer),
+                    "PROGRESS CODE: V%08x I%x\n\r",
+                    Value,
+                    Instance
+                    );
+    }
   } else if ((Data != NULL) &&
              CompareGuid (&Data->Type, &gEfiStatusCodeDataTypeStringGuid) &&
              (((EFI_STATUS_CODE_STRING_DATA *)Data)->StringType == EfiStringAscii))
@@ -158,13 +172,18 @@ SerialStatusCodeReportWorker (
   }
 
   //
-  // Call SerialPort Lib function to do print.
+  // Call SerialPort Lib function to do print, unless an MMC transaction
+  // owns the UART and takes the output over until it ends.
   //
-  SerialPortWrite ((UINT8 *)Buffer, CharCount);
+  if ((CharCount != 0) && !MmcHoldDebugOutput ((UINT8 *)Buffer, CharCount)) {
+    SerialPortWrite ((UINT8 *)Buffer, CharCount);
+  }
 
   // DEBUG ((DEBUG_INFO, "POST Code PEI\n"));
-  postcode=GetPostCodeFromStatusCode(CodeType, Value);
-  PostCode(postcode);
+  if (StatusCodeRouted (ADLINK_STATUS_CODE_SINK_POST_CODE, CodeType, CallerId, Data)) {
+    postcode=GetPostCodeFromStatusCode(CodeType, Value);
+    PostCode(postcode);
+  }
 
   return EFI_SUCCESS;
 }
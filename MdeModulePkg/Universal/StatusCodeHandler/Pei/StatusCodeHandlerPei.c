@@ -9,6 +9,63 @@
 
 #include "StatusCodeHandlerPei.h"
 
+/**
+  Reset notification. Puts the MMC link back to its power on state, the MMC
+  is not reset with the host.
+
+  @param  ResetType         The type of reset to perform.
+  @param  ResetStatus       The status code for the reset.
+  @param  DataSize          The size, in bytes, of ResetData.
+  @param  ResetData         Optional data describing the reason of the reset.
+
+**/
+STATIC
+VOID
+EFIAPI
+MmcLinkResetNotify (
+  IN EFI_RESET_TYPE  ResetType,
+  IN EFI_STATUS      ResetStatus,
+  IN UINTN           DataSize,
+  IN VOID            *ResetData OPTIONAL
+  )
+{
+  MmcResetLink ();
+}
+
+/**
+  Register MmcLinkResetNotify () once the reset notification PPI is
+  installed.
+
+  @param  PeiServices       An indirect pointer to the EFI_PEI_SERVICES table published by the PEI Foundation.
+  @param  NotifyDescriptor  Address of the notification descriptor data structure.
+  @param  Ppi               Address of the PPI that was installed.
+
+  @retval EFI_SUCCESS       The function always return EFI_SUCCESS.
+
+**/
+STATIC
+EFI_STATUS
+EFIAPI
+MmcLinkResetNotificationNotify (
+  IN EFI_PEI_SERVICES           **PeiServices,
+  IN EFI_PEI_NOTIFY_DESCRIPTOR  *NotifyDescriptor,
+  IN VOID                       *Ppi
+  )
+{
+  EDKII_PLATFORM_SPECIFIC_RESET_NOTIFICATION_PPI  *ResetNotification;
+
+  ResetNotification = Ppi;
+  ResetNotification->RegisterResetNotify (ResetNotification, MmcLinkResetNotify);
+
+  return EFI_SUCCESS;
+}
+
+STATIC EFI_PEI_NOTIFY_DESCRIPTOR  mMmcLinkResetNotify = {
+  (EFI_PEI_PPI_DESCRIPTOR_NOTIFY_CALLBACK | EFI_PEI_PPI_DESCRIPTOR_TERMINATE_LIST),
+  &gEdkiiPlatformSpecificResetNotificationPpiGuid,
+  MmcLinkResetNotificationNotify
+};
+
 /**
   Entry point of Status Code PEIM.
 
@@ -40,10 +97,15 @@ StatusCodeHandlerPeiEntry (
              );
   ASSERT_EFI_ERROR (Status);
 
+  Status = StatusCodeRoutingInitialize ();
+  ASSERT_EFI_ERROR (Status);
+
   //
   // Dispatch initialization request to sub-statuscode-devices.
   // If enable UseSerial, then initialize serial port.
   // if enable UseMemory, then initialize memory status code worker.
+  // if enable UseBinaryLog, then initialize binary status code log worker.
+  // if the persistent log has a size, then start the log of this boot.
   //
   if (PcdGetBool (PcdStatusCodeUseSerial)) {
     Status = SerialPortInitialize ();
@@ -59,5 +121,22 @@ StatusCodeHandlerPeiEntry (
     ASSERT_EFI_ERROR (Status);
   }
 
+  if (FeaturePcdGet (PcdStatusCodeUseBinaryLog)) {
+    Status = BinaryLogStatusCodeInitializeWorker ();
+    ASSERT_EFI_ERROR (Status);
+    Status = RscHandlerPpi->Register (BinaryLogStatusCodeReportWorker);
+    ASSERT_EFI_ERROR (Status);
+  }
+
+  if (FixedPcdGet32 (PcdStatusCodePersistentLogSize) != 0) {
+    Status = PersistentLogStatusCodeInitializeWorker ();
+    ASSERT_EFI_ERROR (Status);
+    Status = RscHandlerPpi->Register (PersistentLogStatusCodeReportWorker);
+    ASSERT_EFI_ERROR (Status);
+  }
+
+  Status = PeiServicesNotifyPpi (&mMmcLinkResetNotify);
+  ASSERT_EFI_ERROR (Status);
+
   return EFI_SUCCESS;
 }
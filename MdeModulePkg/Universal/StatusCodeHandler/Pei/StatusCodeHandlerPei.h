@@ -10,20 +10,31 @@
 #define __STATUS_CODE_HANDLER_PEI_H__
 
 #include <Ppi/ReportStatusCodeHandler.h>
+#include <Ppi/ReadOnlyVariable2.h>
+#include <Ppi/PlatformSpecificResetNotification.h>
+#include <Ppi/StatusCodeRouting.h>
 
 #include <Guid/MemoryStatusCodeRecord.h>
+#include <Guid/TimedStatusCodeRecord.h>
 #include <Guid/StatusCodeDataTypeId.h>
 #include <Guid/StatusCodeDataTypeDebug.h>
+#include <Guid/StatusCodeLog.h>
+#include <Guid/StatusCodeRouting.h>
 
 #include <Library/DebugLib.h>
 #include <Library/PrintLib.h>
 #include <Library/ReportStatusCodeLib.h>
 #include <Library/SerialPortLib.h>
 #include <Library/HobLib.h>
+#include <Library/MmcLib.h>
 #include <Library/PcdLib.h>
 #include <Library/PeiServicesLib.h>
 #include <Library/PeimEntryPoint.h>
 #include <Library/BaseMemoryLib.h>
+#include <Library/StatusCodeLogLib.h>
+#include <Library/PersistentStatusCodeLogLib.h>
+#include <Library/StatusCodeRoutingLib.h>
+#include <Library/TimerLib.h>
 
 //
 // Define the maximum message length
@@ -112,4 +123,118 @@ MemoryStatusCodeReportWorker (
   IN CONST EFI_STATUS_CODE_DATA  *Data OPTIONAL
   );
 
+/**
+  Create the binary status code log GUID'ed HOB.
+
+  @retval EFI_SUCCESS           The GUID'ed HOB is created successfully.
+  @retval EFI_OUT_OF_RESOURCES  No room for the HOB.
+
+**/
+EFI_STATUS
+BinaryLogStatusCodeInitializeWorker (
+  VOID
+  );
+
+/**
+  Report status code into the binary status code log GUID'ed HOB.
+
+  @param  PeiServices      An indirect pointer to the EFI_PEI_SERVICES table published by the PEI Foundation.
+  @param  CodeType         Indicates the type of status code being reported.
+  @param  Value            Describes the current status of a hardware or
+                           software entity. This includes information about the class and
+                           subclass that is used to classify the entity as well as an operation.
+  @param  Instance         The enumeration of a hardware or software entity within
+                           the system. Valid instance numbers start with 1.
+  @param  CallerId         This optional parameter may be used to identify the caller.
+  @param  Data             This optional parameter may be used to pass additional data.
+
+  @retval EFI_SUCCESS      The function always return EFI_SUCCESS.
+
+**/
+EFI_STATUS
+EFIAPI
+BinaryLogStatusCodeReportWorker (
+  IN CONST  EFI_PEI_SERVICES     **PeiServices,
+  IN EFI_STATUS_CODE_TYPE        CodeType,
+  IN EFI_STATUS_CODE_VALUE       Value,
+  IN UINT32                      Instance,
+  IN CONST EFI_GUID              *CallerId,
+  IN CONST EFI_STATUS_CODE_DATA  *Data OPTIONAL
+  );
+
+/**
+  Start the persistent status code log of this boot, keeping the log of
+  the previous boot for StatusCodeHandlerRuntimeDxe to publish.
+
+  @retval EFI_SUCCESS      The log is started.
+  @retval EFI_UNSUPPORTED  PcdStatusCodePersistentLogSize is 0.
+
+**/
+EFI_STATUS
+PersistentLogStatusCodeInitializeWorker (
+  VOID
+  );
+
+/**
+  Report status code into the persistent status code log.
+
+  @param  PeiServices      An indirect pointer to the EFI_PEI_SERVICES table published by the PEI Foundation.
+  @param  CodeType         Indicates the type of status code being reported.
+  @param  Value            Describes the current status of a hardware or
+                           software entity. This includes information about the class and
+                           subclass that is used to classify the entity as well as an operation.
+  @param  Instance         The enumeration of a hardware or software entity within
+                           the system. Valid instance numbers start with 1.
+  @param  CallerId         This optional parameter may be used to identify the caller.
+  @param  Data             This optional parameter may be used to pass additional data.
+
+  @retval EFI_SUCCESS      The function always return EFI_SUCCESS.
+
+**/
+EFI_STATUS
+EFIAPI
+PersistentLogStatusCodeReportWorker (
+  IN CONST  EFI_PEI_SERVICES     **PeiServices,
+  IN EFI_STATUS_CODE_TYPE        CodeType,
+  IN EFI_STATUS_CODE_VALUE       Value,
+  IN UINT32                      Instance,
+  IN CONST EFI_GUID              *CallerId,
+  IN CONST EFI_STATUS_CODE_DATA  *Data OPTIONAL
+  );
+
+/**
+  Create the routing policy GUID'ed HOB, forwarding every status code to
+  every sink until the policy variable is read, and install the PPI
+  pointing at it.
+
+  @retval EFI_SUCCESS           The GUID'ed HOB is created successfully.
+  @retval EFI_OUT_OF_RESOURCES  No room for the HOB or the PPI descriptor.
+  @retval Others                The PPI could not be installed.
+
+**/
+EFI_STATUS
+StatusCodeRoutingInitialize (
+  VOID
+  );
+
+/**
+  Tell whether a status code is forwarded to a sink.
+
+  @param  Sink             ADLINK_STATUS_CODE_SINK_*.
+  @param  CodeType         Indicates the type of status code being reported.
+  @param  CallerId         This optional parameter may be used to identify the caller.
+  @param  Data             This optional parameter may be used to pass additional data.
+
+  @retval TRUE             The status code goes to the sink.
+  @retval FALSE            The sink does not take the status code.
+
+**/
+BOOLEAN
+StatusCodeRouted (
+  IN UINTN                       Sink,
+  IN EFI_STATUS_CODE_TYPE        CodeType,
+  IN CONST EFI_GUID              *CallerId  OPTIONAL,
+  IN CONST EFI_STATUS_CODE_DATA  *Data      OPTIONAL
+  );
+
 #endif
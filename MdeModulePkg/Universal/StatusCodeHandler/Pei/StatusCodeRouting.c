@@ -0,0 +1,136 @@
+/** @file
+  PEI status code routing policy, see Guid/StatusCodeRouting.h.
+
+  Copyright (c) 2022, ADLink. All rights reserved.<BR>
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#include "StatusCodeHandlerPei.h"
+
+/**
+  Load the routing policy variable into the GUID'ed HOB once variable
+  services are available.
+
+  @param  PeiServices       An indirect pointer to the EFI_PEI_SERVICES table published by the PEI Foundation.
+  @param  NotifyDescriptor  Address of the notification descriptor data structure.
+  @param  Ppi               Address of the PPI that was installed.
+
+  @retval EFI_SUCCESS       The function always return EFI_SUCCESS.
+
+**/
+STATIC
+EFI_STATUS
+EFIAPI
+StatusCodeRoutingVariableNotify (
+  IN EFI_PEI_SERVICES           **PeiServices,
+  IN EFI_PEI_NOTIFY_DESCRIPTOR  *NotifyDescriptor,
+  IN VOID                       *Ppi
+  )
+{
+  EFI_PEI_READ_ONLY_VARIABLE2_PPI  *Variable;
+  ADLINK_STATUS_CODE_ROUTING_PPI   *Policy;
+  ADLINK_STATUS_CODE_ROUTING       Routing;
+  UINTN                            Size;
+  EFI_STATUS                       Status;
+
+  Status = PeiServicesLocatePpi (&gAdlinkStatusCodeRoutingPpiGuid, 0, NULL, (VOID **)&Policy);
+  if (EFI_ERROR (Status)) {
+    return EFI_SUCCESS;
+  }
+
+  Variable = Ppi;
+  Size     = sizeof (Routing);
+  Status   = Variable->GetVariable (
+                         Variable,
+                         ADLINK_STATUS_CODE_ROUTING_VARIABLE_NAME,
+                         &gAdlinkStatusCodeRoutingGuid,
+                         NULL,
+                         &Size,
+                         &Routing
+                         );
+  if (EFI_ERROR (Status) || !StatusCodeRoutingIsValid (&Routing, Size)) {
+    return EFI_SUCCESS;
+  }
+
+  CopyMem (Policy, &Routing, sizeof (Routing));
+
+  return EFI_SUCCESS;
+}
+
+STATIC EFI_PEI_NOTIFY_DESCRIPTOR  mStatusCodeRoutingNotify = {
+  (EFI_PEI_PPI_DESCRIPTOR_NOTIFY_CALLBACK | EFI_PEI_PPI_DESCRIPTOR_TERMINATE_LIST),
+  &gEfiPeiReadOnlyVariable2PpiGuid,
+  StatusCodeRoutingVariableNotify
+};
+
+/**
+  Create the routing policy GUID'ed HOB, forwarding every status code to
+  every sink until the policy variable is read, and install the PPI
+  pointing at it.
+
+  @retval EFI_SUCCESS           The GUID'ed HOB is created successfully.
+  @retval EFI_OUT_OF_RESOURCES  No room for the HOB or the PPI descriptor.
+  @retval Others                The PPI could not be installed.
+
+**/
+EFI_STATUS
+StatusCodeRoutingInitialize (
+  VOID
+  )
+{
+  ADLINK_STATUS_CODE_ROUTING  *Routing;
+  EFI_PEI_PPI_DESCRIPTOR      *Descriptor;
+  EFI_STATUS                  Status;
+
+  Routing = BuildGuidHob (&gAdlinkStatusCodeRoutingGuid, sizeof (*Routing));
+  if (Routing == NULL) {
+    return EFI_OUT_OF_RESOURCES;
+  }
+
+  StatusCodeRoutingSetDefault (Routing);
+
+  Status = PeiServicesAllocatePool (sizeof (*Descriptor), (VOID **)&Descriptor);
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+
+  Descriptor->Flags = EFI_PEI_PPI_DESCRIPTOR_PPI | EFI_PEI_PPI_DESCRIPTOR_TERMINATE_LIST;
+  Descriptor->Guid  = &gAdlinkStatusCodeRoutingPpiGuid;
+  Descriptor->Ppi   = Routing;
+  Status            = PeiServicesInstallPpi (Descriptor);
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+
+  return PeiServicesNotifyPpi (&mStatusCodeRoutingNotify);
+}
+
+/**
+  Tell whether a status code is forwarded to a sink.
+
+  @param  Sink             ADLINK_STATUS_CODE_SINK_*.
+  @param  CodeType         Indicates the type of status code being reported.
+  @param  CallerId         This optional parameter may be used to identify the caller.
+  @param  Data             This optional parameter may be used to pass additional data.
+
+  @retval TRUE             The status code goes to the sink.
+  @retval FALSE            The sink does not take the status code.
+
+**/
+BOOLEAN
+StatusCodeRouted (
+  IN UINTN                       Sink,
+  IN EFI_STATUS_CODE_TYPE        CodeType,
+  IN CONST EFI_GUID              *CallerId  OPTIONAL,
+  IN CONST EFI_STATUS_CODE_DATA  *Data      OPTIONAL
+  )
+{
+  ADLINK_STATUS_CODE_ROUTING_PPI  *Routing;
+
+  if (EFI_ERROR (PeiServicesLocatePpi (&gAdlinkStatusCodeRoutingPpiGuid, 0, NULL, (VOID **)&Routing))) {
+    return TRUE;
+  }
+
+  return StatusCodeRoutingAccepts (Routing, Sink, CodeType, CallerId, Data);
+}
@@ -0,0 +1,92 @@
+/** @file
+  Runtime binary status code log worker.
+
+  Copyright (c) 2022, ADLink. All rights reserved.<BR>
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#include "StatusCodeHandlerRuntimeDxe.h"
+
+ADLINK_STATUS_CODE_LOG_HEADER  *mBinaryStatusCodeLog;
+
+/**
+  Create the runtime binary status code log, carry the records of the PEI
+  log over and publish it as a configuration table.
+
+  @retval EFI_SUCCESS           The log is published.
+  @retval EFI_OUT_OF_RESOURCES  No memory for the log.
+  @retval others                Errors from gBS->InstallConfigurationTable().
+
+**/
+EFI_STATUS
+BinaryLogStatusCodeInitializeWorker (
+  VOID
+  )
+{
+  EFI_PEI_HOB_POINTERS  Hob;
+  VOID                  *Buffer;
+  UINTN                 Size;
+
+  Size   = sizeof (ADLINK_STATUS_CODE_LOG_HEADER) + FixedPcdGet32 (PcdStatusCodeBinaryLogSize) * 1024;
+  Buffer = AllocateRuntimePool (Size);
+  mBinaryStatusCodeLog = StatusCodeLogInitialize (Buffer, Size);
+  if (mBinaryStatusCodeLog == NULL) {
+    return EFI_OUT_OF_RESOURCES;
+  }
+
+  Hob.Raw = GetFirstGuidHob (&gAdlinkStatusCodeLogGuid);
+  if (Hob.Raw != NULL) {
+    StatusCodeLogAppendLog (mBinaryStatusCodeLog, GET_GUID_HOB_DATA (Hob.Guid));
+  }
+
+  return gBS->InstallConfigurationTable (&gAdlinkStatusCodeLogGuid, mBinaryStatusCodeLog);
+}
+
+/**
+  Report status code into the runtime binary status code log.
+
+  DEBUG () messages are kept unformatted, see Guid/StatusCodeLog.h.
+
+  @param  CodeType                Indicates the type of status code being reported.
+  @param  Value                   Describes the current status of a hardware or software entity.
+                                  This included information about the class and subclass that is used to
+                                  classify the entity as well as an operation.
+  @param  Instance                The enumeration of a hardware or software entity within
+                                  the system. Valid instance numbers start with 1.
+  @param  CallerId                This optional parameter may be used to identify the caller.
+                                  This parameter allows the status code driver to apply different rules to
+                                  different callers.
+  @param  Data                    This optional parameter may be used to pass additional data.
+
+  @retval EFI_SUCCESS             Status code successfully recorded in the log.
+
+**/
+EFI_STATUS
+EFIAPI
+BinaryLogStatusCodeReportWorker (
+  IN EFI_STATUS_CODE_TYPE   CodeType,
+  IN EFI_STATUS_CODE_VALUE  Value,
+  IN UINT32                 Instance,
+  IN EFI_GUID               *CallerId,
+  IN EFI_STATUS_CODE_DATA   *Data OPTIONAL
+  )
+{
+  CHAR8      *Format;
+  UINT32     ErrorLevel;
+  BASE_LIST  Marker;
+
+  if (!StatusCodeRouted (ADLINK_STATUS_CODE_SINK_BINARY_LOG, CodeType, CallerId, Data)) {
+    return EFI_SUCCESS;
+  }
+
+  if ((Data != NULL) &&
+      ReportStatusCodeExtractDebugInfo (Data, &ErrorLevel, &Marker, &Format))
+  {
+    StatusCodeLogDebug (mBinaryStatusCodeLog, CallerId, ErrorLevel, Format, Marker);
+  } else {
+    StatusCodeLogCode (mBinaryStatusCodeLog, CallerId, CodeType, Value, Instance);
+  }
+
+  return EFI_SUCCESS;
+}
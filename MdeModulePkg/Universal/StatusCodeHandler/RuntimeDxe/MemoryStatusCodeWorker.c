@@ -8,13 +8,186 @@
 **/
 
 #include "StatusCodeHandlerRuntimeDxe.h"
+#include <Library/PostCodeMapLib.h>
 
-RUNTIME_MEMORY_STATUSCODE_HEADER  *mRtMemoryStatusCodeTable;
+RUNTIME_MEMORY_STATUSCODE_HEADER  *mRtMemoryStatusCodeRecords;
+ADLINK_TIMED_STATUSCODE_HEADER    *mRtMemoryStatusCodeTable;
+
+/**
+  Append a record to the standard runtime memory status code table of
+  Guid/MemoryStatusCodeRecord.h. If the table is full, roll back to the
+  first record and overwrite it.
+
+  @param  CodeType                Indicates the type of status code being reported.
+  @param  Value                   Describes the current status of a hardware or software entity.
+  @param  Instance                The enumeration of a hardware or software entity within
+                                  the system.
+
+**/
+STATIC
+VOID
+RtMemoryStatusCodeAppendStandard (
+  IN EFI_STATUS_CODE_TYPE   CodeType,
+  IN EFI_STATUS_CODE_VALUE  Value,
+  IN UINT32                 Instance
+  )
+{
+  MEMORY_STATUSCODE_RECORD  *Record;
+
+  Record = (MEMORY_STATUSCODE_RECORD *)(mRtMemoryStatusCodeRecords + 1);
+  Record = &Record[mRtMemoryStatusCodeRecords->RecordIndex++];
+
+  Record->CodeType = CodeType;
+  Record->Value    = Value;
+  Record->Instance = Instance;
+
+  mRtMemoryStatusCodeRecords->NumberOfRecords++;
+  if (mRtMemoryStatusCodeRecords->RecordIndex == mRtMemoryStatusCodeRecords->MaxRecordsNumber) {
+    mRtMemoryStatusCodeRecords->RecordIndex = 0;
+  }
+}
+
+/**
+  Append a record to the runtime memory status code table. If the table is
+  full, roll back to the first record and overwrite it.
+
+  @param  Record                  The record to append.
+
+**/
+STATIC
+VOID
+RtMemoryStatusCodeAppend (
+  IN CONST ADLINK_TIMED_STATUSCODE_RECORD  *Record
+  )
+{
+  ADLINK_TIMED_STATUSCODE_RECORD  *Records;
+
+  Records = (ADLINK_TIMED_STATUSCODE_RECORD *)(mRtMemoryStatusCodeTable + 1);
+  CopyMem (&Records[mRtMemoryStatusCodeTable->RecordIndex++], Record, sizeof (*Record));
+
+  //
+  // If record index equals to max record number, then wrap around record index to zero.
+  //
+  // The reader of status code should compare the number of records with max records number,
+  // If it is equal to or larger than the max number, then the wrap-around had happened,
+  // so the first record is pointed by record index.
+  // If it is less then max number, index of the first record is zero.
+  //
+  mRtMemoryStatusCodeTable->NumberOfRecords++;
+  if (mRtMemoryStatusCodeTable->RecordIndex == mRtMemoryStatusCodeTable->MaxRecordsNumber) {
+    //
+    // Wrap around record index.
+    //
+    mRtMemoryStatusCodeTable->RecordIndex = 0;
+  }
+}
+
+/**
+  Carry the records of the PEI memory status code GUID'ed HOB over to the
+  runtime memory status code table, oldest first, with their timestamps.
+
+  The records are copied as they are, in at most two pieces: from the
+  oldest one to the end of the HOB, then from the start of the HOB. If the
+  table is smaller than the HOB, only the newest records are kept.
+
+**/
+STATIC
+VOID
+RtMemoryStatusCodeCarryPeiRecords (
+  VOID
+  )
+{
+  EFI_PEI_HOB_POINTERS                  Hob;
+  CONST ADLINK_TIMED_STATUSCODE_HEADER  *PeiHeader;
+  CONST ADLINK_TIMED_STATUSCODE_RECORD  *PeiRecords;
+  ADLINK_TIMED_STATUSCODE_RECORD        *Records;
+  UINT32                                First;
+  UINT32                                Count;
+  UINT32                                Tail;
+
+  Hob.Raw = GetFirstGuidHob (&gAdlinkTimedStatusCodeRecordGuid);
+  if (Hob.Raw == NULL) {
+    return;
+  }
+
+  PeiHeader  = (CONST ADLINK_TIMED_STATUSCODE_HEADER *)GET_GUID_HOB_DATA (Hob.Guid);
+  PeiRecords = (CONST ADLINK_TIMED_STATUSCODE_RECORD *)(PeiHeader + 1);
+  if ((PeiHeader->RecordSize != sizeof (ADLINK_TIMED_STATUSCODE_RECORD)) ||
+      (PeiHeader->MaxRecordsNumber == 0))
+  {
+    return;
+  }
+
+  //
+  // Same wrap rule as the runtime table: once the HOB wrapped, the oldest
+  // record is the one at RecordIndex.
+  //
+  First = 0;
+  Count = PeiHeader->NumberOfRecords;
+  if (Count >= PeiHeader->MaxRecordsNumber) {
+    First = PeiHeader->RecordIndex;
+    Count = PeiHeader->MaxRecordsNumber;
+  }
+
+  if (Count > mRtMemoryStatusCodeTable->MaxRecordsNumber) {
+    First = (First + Count - mRtMemoryStatusCodeTable->MaxRecordsNumber) % PeiHeader->MaxRecordsNumber;
+    Count = mRtMemoryStatusCodeTable->MaxRecordsNumber;
+  }
+
+  Records = (ADLINK_TIMED_STATUSCODE_RECORD *)(mRtMemoryStatusCodeTable + 1);
+  Tail    = MIN (Count, PeiHeader->MaxRecordsNumber - First);
+  CopyMem (Records, &PeiRecords[First], Tail * sizeof (*Records));
+  CopyMem (&Records[Tail], PeiRecords, (Count - Tail) * sizeof (*Records));
+
+  mRtMemoryStatusCodeTable->NumberOfRecords = Count;
+  mRtMemoryStatusCodeTable->RecordIndex     = Count % mRtMemoryStatusCodeTable->MaxRecordsNumber;
+}
+
+/**
+  Replay the records of the standard PEI memory status code GUID'ed HOB
+  into the standard runtime memory status code table, as the generic
+  handler does when PcdStatusCodeReplayIn is set.
+
+**/
+STATIC
+VOID
+RtMemoryStatusCodeReplayPeiRecords (
+  VOID
+  )
+{
+  EFI_PEI_HOB_POINTERS             Hob;
+  MEMORY_STATUSCODE_PACKET_HEADER  *PacketHeader;
+  MEMORY_STATUSCODE_RECORD         *Record;
+  UINTN                            Index;
+  UINTN                            MaxRecordNumber;
+
+  Hob.Raw = GetFirstGuidHob (&gMemoryStatusCodeRecordGuid);
+  if (Hob.Raw == NULL) {
+    return;
+  }
+
+  PacketHeader    = (MEMORY_STATUSCODE_PACKET_HEADER *)GET_GUID_HOB_DATA (Hob.Guid);
+  Record          = (MEMORY_STATUSCODE_RECORD *)(PacketHeader + 1);
+  MaxRecordNumber = (UINTN)PacketHeader->RecordIndex;
+  if (PacketHeader->PacketIndex > 0) {
+    //
+    // Record has been wrapped around. So, record number has arrived at max number.
+    //
+    MaxRecordNumber = (UINTN)PacketHeader->MaxRecordsNumber;
+  }
+
+  for (Index = 0; Index < MaxRecordNumber; Index++) {
+    RtMemoryStatusCodeAppendStandard (Record[Index].CodeType, Record[Index].Value, Record[Index].Instance);
+  }
+}
 
 /**
   Initialize runtime memory status code table as initialization for runtime memory status code worker
 
-  @retval EFI_SUCCESS  Runtime memory status code table successfully initialized.
+  Both the standard table of Guid/MemoryStatusCodeRecord.h and the timed
+  table are published.
+
+  @retval EFI_SUCCESS  Runtime memory status code tables successfully initialized.
   @retval others       Errors from gBS->InstallConfigurationTable().
 
 **/
@@ -26,19 +199,43 @@ RtMemoryStatusCodeInitializeWorker (
   EFI_STATUS  Status;
 
   //
-  // Allocate runtime memory status code pool.
+  // Allocate runtime memory status code pools.
   //
-  mRtMemoryStatusCodeTable = AllocateRuntimePool (
-                               sizeof (RUNTIME_MEMORY_STATUSCODE_HEADER) +
+  mRtMemoryStatusCodeRecords = AllocateRuntimePool (
+                                 sizeof (RUNTIME_MEMORY_STATUSCODE_HEADER) +
+                                 PcdGet16 (PcdStatusCodeMemorySize) * 1024
+                                 );
+  ASSERT (mRtMemoryStatusCodeRecords != NULL);
+
+  mRtMemoryStatusCodeRecords->RecordIndex      = 0;
+  mRtMemoryStatusCodeRecords->NumberOfRecords  = 0;
+  mRtMemoryStatusCodeRecords->MaxRecordsNumber =
+    (PcdGet16 (PcdStatusCodeMemorySize) * 1024) / sizeof (MEMORY_STATUSCODE_RECORD);
+
+  if (FeaturePcdGet (PcdStatusCodeReplayIn)) {
+    RtMemoryStatusCodeReplayPeiRecords ();
+  }
+
+  Status = gBS->InstallConfigurationTable (&gMemoryStatusCodeRecordGuid, mRtMemoryStatusCodeRecords);
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+
+  mRtMemoryStatusCodeTable = AllocateRuntimeZeroPool (
+                               sizeof (ADLINK_TIMED_STATUSCODE_HEADER) +
                                PcdGet16 (PcdStatusCodeMemorySize) * 1024
                                );
   ASSERT (mRtMemoryStatusCodeTable != NULL);
 
-  mRtMemoryStatusCodeTable->RecordIndex      = 0;
-  mRtMemoryStatusCodeTable->NumberOfRecords  = 0;
+  mRtMemoryStatusCodeTable->Signature        = ADLINK_TIMED_STATUSCODE_SIGNATURE;
+  mRtMemoryStatusCodeTable->RecordSize       = sizeof (ADLINK_TIMED_STATUSCODE_RECORD);
   mRtMemoryStatusCodeTable->MaxRecordsNumber =
-    (PcdGet16 (PcdStatusCodeMemorySize) * 1024) / sizeof (MEMORY_STATUSCODE_RECORD);
-  Status = gBS->InstallConfigurationTable (&gMemoryStatusCodeRecordGuid, mRtMemoryStatusCodeTable);
+    (PcdGet16 (PcdStatusCodeMemorySize) * 1024) / sizeof (ADLINK_TIMED_STATUSCODE_RECORD);
+  mRtMemoryStatusCodeTable->Frequency = GetPerformanceCounterProperties (NULL, NULL);
+
+  RtMemoryStatusCodeCarryPeiRecords ();
+
+  Status = gBS->InstallConfigurationTable (&gAdlinkTimedStatusCodeRecordGuid, mRtMemoryStatusCodeTable);
 
   return Status;
 }
@@ -71,36 +268,28 @@ RtMemoryStatusCodeReportWorker (
   IN EFI_STATUS_CODE_DATA   *Data OPTIONAL
   )
 {
-  MEMORY_STATUSCODE_RECORD  *Record;
+  ADLINK_TIMED_STATUSCODE_RECORD  Record;
 
-  //
-  // Locate current record buffer.
-  //
-  Record = (MEMORY_STATUSCODE_RECORD *)(mRtMemoryStatusCodeTable + 1);
-  Record = &Record[mRtMemoryStatusCodeTable->RecordIndex++];
+  if (!StatusCodeRouted (ADLINK_STATUS_CODE_SINK_MEMORY, CodeType, CallerId, Data)) {
+    return EFI_SUCCESS;
+  }
 
   //
   // Save status code.
   //
-  Record->CodeType = CodeType;
-  Record->Value    = Value;
-  Record->Instance = Instance;
+  RtMemoryStatusCodeAppendStandard (CodeType, Value, Instance);
 
-  //
-  // If record index equals to max record number, then wrap around record index to zero.
-  //
-  // The reader of status code should compare the number of records with max records number,
-  // If it is equal to or larger than the max number, then the wrap-around had happened,
-  // so the first record is pointed by record index.
-  // If it is less then max number, index of the first record is zero.
-  //
-  mRtMemoryStatusCodeTable->NumberOfRecords++;
-  if (mRtMemoryStatusCodeTable->RecordIndex == mRtMemoryStatusCodeTable->MaxRecordsNumber) {
-    //
-    // Wrap around record index.
-    //
-    mRtMemoryStatusCodeTable->RecordIndex = 0;
+  ZeroMem (&Record, sizeof (Record));
+  Record.CodeType  = CodeType;
+  Record.Value     = Value;
+  Record.Instance  = Instance;
+  Record.PostCode  = GetPostCodeFromStatusCode (CodeType, Value);
+  Record.Timestamp = GetPerformanceCounter ();
+  if (CallerId != NULL) {
+    CopyGuid (&Record.CallerId, CallerId);
   }
 
+  RtMemoryStatusCodeAppend (&Record);
+
   return EFI_SUCCESS;
 }
@@ -0,0 +1,385 @@
+/** @file
+  Persistent status code log worker.
+
+  Appends the status codes of this boot to the log started by
+  StatusCodeHandlerPei, and publishes the log of the previous boot as a
+  configuration table and in the Boot Error Record Table region. The
+  region is not mapped for runtime services, the worker stops at
+  ExitBootServices().
+
+  With PcdStatusCodePersistentLogFlashSize set, the latest records of this
+  boot are also copied to the flash slot, at ReadyToBoot and after an
+  unrecovered error. The flash slot stands in for the previous log when
+  that one did not survive the reset. It then holds the last boot that
+  copied its records, which may be older than the previous boot.
+
+  Copyright (c) 2022, ADLink. All rights reserved.<BR>
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#include "StatusCodeHandlerRuntimeDxe.h"
+#include <IndustryStandard/Acpi.h>
+#include <Protocol/AcpiSystemDescriptionTable.h>
+#include <Library/PostCodeMapLib.h>
+
+ADLINK_PERSISTENT_LOG_HEADER  *mPersistentStatusCodeLog = NULL;
+
+STATIC CONST ADLINK_PERSISTENT_LOG_HEADER  *mPersistentLogPrevious  = NULL;
+STATIC BOOLEAN                             mPersistentLogFlashRead  = FALSE;
+STATIC EFI_EVENT                           mPersistentLogFlashEvent = NULL;
+
+/**
+  Find the Boot Error Record Table region in the installed ACPI tables.
+
+  @param  Base          The start of the region.
+  @param  Length        The size of the region in bytes.
+
+  @retval EFI_SUCCESS   The region is found.
+  @retval EFI_NOT_FOUND No Boot Error Record Table is installed.
+
+**/
+STATIC
+EFI_STATUS
+PersistentLogFindBert (
+  OUT UINTN  *Base,
+  OUT UINTN  *Length
+  )
+{
+  EFI_ACPI_SDT_PROTOCOL                        *AcpiSdt;
+  EFI_ACPI_SDT_HEADER                          *Table;
+  EFI_ACPI_6_3_BOOT_ERROR_RECORD_TABLE_HEADER  *Bert;
+  EFI_ACPI_TABLE_VERSION                       Version;
+  UINTN                                        TableKey;
+  UINTN                                        Index;
+  EFI_STATUS                                   Status;
+
+  Status = gBS->LocateProtocol (&gEfiAcpiSdtProtocolGuid, NULL, (VOID **)&AcpiSdt);
+  if (EFI_ERROR (Status)) {
+    return EFI_NOT_FOUND;
+  }
+
+  for (Index = 0; !EFI_ERROR (AcpiSdt->GetAcpiTable (Index, &Table, &Version, &TableKey)); Index++) {
+    if ((Table->Signature == EFI_ACPI_6_3_BOOT_ERROR_RECORD_TABLE_SIGNATURE) &&
+        (Table->Length >= sizeof (*Bert)))
+    {
+      Bert    = (EFI_ACPI_6_3_BOOT_ERROR_RECORD_TABLE_HEADER *)Table;
+      *Base   = (UINTN)Bert->BootErrorRegion;
+      *Length = Bert->BootErrorRegionLength;
+      return EFI_SUCCESS;
+    }
+  }
+
+  return EFI_NOT_FOUND;
+}
+
+/**
+  Read the flash slot, once, and take it as the log of the previous boot
+  if that one did not survive the reset. Called before the slot is first
+  written in this boot.
+
+**/
+STATIC
+VOID
+PersistentLogReadFlash (
+  VOID
+  )
+{
+  ADLINK_PERSISTENT_LOG_HEADER  *Snapshot;
+  UINTN                         Size;
+  EFI_STATUS                    Status;
+
+  if (mPersistentLogFlashRead || (FixedPcdGet32 (PcdStatusCodePersistentLogFlashSize) == 0)) {
+    return;
+  }
+
+  mPersistentLogFlashRead = TRUE;
+  if (mPersistentLogPrevious != NULL) {
+    return;
+  }
+
+  Size     = FixedPcdGet32 (PcdStatusCodePersistentLogFlashSize) * SIZE_1KB;
+  Snapshot = AllocatePool (Size);
+  if (Snapshot == NULL) {
+    return;
+  }
+
+  Status = EfiGetVariable (
+             ADLINK_PERSISTENT_LOG_VARIABLE_NAME,
+             &gAdlinkPersistentStatusCodeLogGuid,
+             NULL,
+             &Size,
+             Snapshot
+             );
+  if (EFI_ERROR (Status) || !PersistentLogSnapshotValid (Snapshot, Size)) {
+    FreePool (Snapshot);
+    return;
+  }
+
+  mPersistentLogPrevious = Snapshot;
+  Status                 = gBS->InstallConfigurationTable (&gAdlinkPersistentStatusCodeLogGuid, Snapshot);
+  ASSERT_EFI_ERROR (Status);
+}
+
+/**
+  Copy the latest records of this boot to the flash slot.
+
+  @param  Event         Event whose notification function is being invoked.
+  @param  Context       Not used.
+
+**/
+STATIC
+VOID
+EFIAPI
+PersistentLogWriteFlash (
+  IN EFI_EVENT  Event,
+  IN VOID       *Context
+  )
+{
+  ADLINK_PERSISTENT_LOG_HEADER  *Snapshot;
+  UINTN                         Size;
+  EFI_STATUS                    Status;
+
+  PersistentLogReadFlash ();
+
+  Snapshot = AllocatePool (FixedPcdGet32 (PcdStatusCodePersistentLogFlashSize) * SIZE_1KB);
+  if (Snapshot == NULL) {
+    return;
+  }
+
+  Size = PersistentLogSnapshot (
+           mPersistentStatusCodeLog,
+           Snapshot,
+           FixedPcdGet32 (PcdStatusCodePersistentLogFlashSize) * SIZE_1KB
+           );
+  if (Size != 0) {
+    Status = EfiSetVariable (
+               ADLINK_PERSISTENT_LOG_VARIABLE_NAME,
+               &gAdlinkPersistentStatusCodeLogGuid,
+               EFI_VARIABLE_NON_VOLATILE | EFI_VARIABLE_BOOTSERVICE_ACCESS,
+               Size,
+               Snapshot
+               );
+    if (EFI_ERROR (Status)) {
+      DEBUG ((DEBUG_WARN, "%a: %r\n", __FUNCTION__, Status));
+    }
+  }
+
+  FreePool (Snapshot);
+}
+
+/**
+  Append the log of the previous boot to the Boot Error Record Table region
+  as a Generic Error Status Block of its own, after the blocks other
+  firmware put there. A block left by an earlier boot of this firmware is
+  replaced.
+
+  @param  Previous      The log of the previous boot.
+
+**/
+STATIC
+VOID
+PersistentLogPublishBert (
+  IN CONST ADLINK_PERSISTENT_LOG_HEADER  *Previous
+  )
+{
+  EFI_ACPI_6_3_GENERIC_ERROR_STATUS_STRUCTURE      *Block;
+  EFI_ACPI_6_3_GENERIC_ERROR_DATA_ENTRY_STRUCTURE  *Entry;
+  UINTN                                            Base;
+  UINTN                                            Length;
+  UINTN                                            End;
+  UINTN                                            LogSize;
+  UINTN                                            BlockSize;
+
+  if (EFI_ERROR (PersistentLogFindBert (&Base, &Length))) {
+    DEBUG ((DEBUG_WARN, "%a: no boot error record table\n", __FUNCTION__));
+    return;
+  }
+
+  LogSize = sizeof (*Previous) + Previous->MaxRecordsNumber * Previous->RecordSize;
+  Block   = (EFI_ACPI_6_3_GENERIC_ERROR_STATUS_STRUCTURE *)Base;
+  End     = Base + Length;
+
+  while (((UINTN)Block + sizeof (*Block) <= End) && (*(UINT32 *)&Block->BlockStatus != 0)) {
+    Entry = (EFI_ACPI_6_3_GENERIC_ERROR_DATA_ENTRY_STRUCTURE *)(Block + 1);
+    if ((Block->DataLength >= sizeof (*Entry)) &&
+        CompareGuid ((EFI_GUID *)Entry->SectionType, &gAdlinkPersistentStatusCodeLogGuid))
+    {
+      break;
+    }
+
+    BlockSize = sizeof (*Block) + Block->DataLength;
+    if (Block->RawDataLength != 0) {
+      BlockSize = Block->RawDataOffset + Block->RawDataLength;
+    }
+
+    if ((BlockSize < sizeof (*Block)) || (BlockSize > End - (UINTN)Block)) {
+      DEBUG ((DEBUG_WARN, "%a: malformed boot error region\n", __FUNCTION__));
+      return;
+    }
+
+    Block = (EFI_ACPI_6_3_GENERIC_ERROR_STATUS_STRUCTURE *)((UINTN)Block + BlockSize);
+  }
+
+  BlockSize = sizeof (*Block) + sizeof (*Entry) + LogSize;
+  if ((UINTN)Block + BlockSize > End) {
+    DEBUG ((DEBUG_WARN, "%a: no room in the boot error region\n", __FUNCTION__));
+    return;
+  }
+
+  Entry = (EFI_ACPI_6_3_GENERIC_ERROR_DATA_ENTRY_STRUCTURE *)(Block + 1);
+  ZeroMem (Block, sizeof (*Block) + sizeof (*Entry));
+  Block->BlockStatus.ErrorDataEntryCount = 1;
+  Block->DataLength                      = (UINT32)(sizeof (*Entry) + LogSize);
+  Block->ErrorSeverity                   = EFI_ACPI_6_3_ERROR_SEVERITY_NONE;
+  CopyGuid ((EFI_GUID *)Entry->SectionType, &gAdlinkPersistentStatusCodeLogGuid);
+  Entry->ErrorSeverity   = EFI_ACPI_6_3_ERROR_SEVERITY_NONE;
+  Entry->Revision        = EFI_ACPI_6_3_GENERIC_ERROR_DATA_ENTRY_REVISION;
+  Entry->ErrorDataLength = (UINT32)LogSize;
+  CopyMem (Entry + 1, Previous, LogSize);
+
+  //
+  // An empty block status ends the list of blocks.
+  //
+  if ((UINTN)Block + BlockSize + sizeof (*Block) <= End) {
+    ZeroMem ((VOID *)((UINTN)Block + BlockSize), sizeof (*Block));
+  }
+}
+
+/**
+  Publish the log of the previous boot in the Boot Error Record Table
+  region, then copy the records of this boot to the flash slot.
+
+  @param  Event         Event whose notification function is being invoked.
+  @param  Context       Not used.
+
+**/
+STATIC
+VOID
+EFIAPI
+PersistentLogReadyToBoot (
+  IN EFI_EVENT  Event,
+  IN VOID       *Context
+  )
+{
+  gBS->CloseEvent (Event);
+
+  PersistentLogReadFlash ();
+  if (mPersistentLogPrevious != NULL) {
+    PersistentLogPublishBert (mPersistentLogPrevious);
+  }
+
+  if (mPersistentLogFlashEvent != NULL) {
+    PersistentLogWriteFlash (NULL, NULL);
+  }
+}
+
+/**
+  Pick up the persistent status code log of this boot, and publish the
+  one of the previous boot.
+
+  @retval EFI_SUCCESS      The log of this boot is found.
+  @retval EFI_NOT_FOUND    StatusCodeHandlerPei did not start a log.
+
+**/
+EFI_STATUS
+PersistentLogStatusCodeInitializeWorker (
+  VOID
+  )
+{
+  EFI_EVENT   Event;
+  EFI_STATUS  Status;
+
+  mPersistentStatusCodeLog = PersistentLogGetCurrent ();
+  if (mPersistentStatusCodeLog == NULL) {
+    return EFI_NOT_FOUND;
+  }
+
+  mPersistentLogPrevious = PersistentLogGetPrevious ();
+  if (mPersistentLogPrevious != NULL) {
+    Status = gBS->InstallConfigurationTable (&gAdlinkPersistentStatusCodeLogGuid, (VOID *)mPersistentLogPrevious);
+    ASSERT_EFI_ERROR (Status);
+  }
+
+  //
+  // Variables can be written from a notification at TPL_CALLBACK, not from
+  // the report worker at TPL_HIGH_LEVEL, which only signals the event.
+  //
+  if (FixedPcdGet32 (PcdStatusCodePersistentLogFlashSize) != 0) {
+    Status = gBS->CreateEvent (
+                    EVT_NOTIFY_SIGNAL,
+                    TPL_CALLBACK,
+                    PersistentLogWriteFlash,
+                    NULL,
+                    &mPersistentLogFlashEvent
+                    );
+    ASSERT_EFI_ERROR (Status);
+  }
+
+  //
+  // Other firmware fills the boot error region in until the end of DXE.
+  //
+  Status = gBS->CreateEventEx (
+                  EVT_NOTIFY_SIGNAL,
+                  TPL_CALLBACK,
+                  PersistentLogReadyToBoot,
+                  NULL,
+                  &gEfiEventReadyToBootGuid,
+                  &Event
+                  );
+  ASSERT_EFI_ERROR (Status);
+
+  return EFI_SUCCESS;
+}
+
+/**
+  Report status code into the persistent status code log.
+
+  @param  CodeType         Indicates the type of status code being reported.
+  @param  Value            Describes the current status of a hardware or
+                           software entity. This includes information about the class and
+                           subclass that is used to classify the entity as well as an operation.
+  @param  Instance         The enumeration of a hardware or software entity within
+                           the system. Valid instance numbers start with 1.
+  @param  CallerId         This optional parameter may be used to identify the caller.
+  @param  Data             This optional parameter may be used to pass additional data.
+
+  @retval EFI_SUCCESS      The function always return EFI_SUCCESS.
+
+**/
+EFI_STATUS
+EFIAPI
+PersistentLogStatusCodeReportWorker (
+  IN EFI_STATUS_CODE_TYPE   CodeType,
+  IN EFI_STATUS_CODE_VALUE  Value,
+  IN UINT32                 Instance,
+  IN EFI_GUID               *CallerId,
+  IN EFI_STATUS_CODE_DATA   *Data OPTIONAL
+  )
+{
+  if (StatusCodeRouted (ADLINK_STATUS_CODE_SINK_PERSISTENT, CodeType, CallerId, Data)) {
+    PersistentLogAppend (
+      mPersistentStatusCodeLog,
+      CodeType,
+      Value,
+      Instance,
+      GetPostCodeFromStatusCode (CodeType, Value),
+      CallerId
+      );
+  }
+
+  if ((mPersistentLogFlashEvent != NULL) &&
+      ((CodeType & EFI_STATUS_CODE_TYPE_MASK) == EFI_ERROR_CODE) &&
+      ((CodeType & EFI_STATUS_CODE_SEVERITY_MASK) >= EFI_ERROR_UNRECOVERED))
+  {
+    gBS->SignalEvent (mPersistentLogFlashEvent);
+  }
+
+  if (((CodeType & EFI_STATUS_CODE_TYPE_MASK) == EFI_PROGRESS_CODE) &&
+      (Value == (EFI_SOFTWARE_EFI_BOOT_SERVICE | EFI_SW_BS_PC_EXIT_BOOT_SERVICES)))
+  {
+    mRscHandlerProtocol->Unregister (PersistentLogStatusCodeReportWorker);
+  }
+
+  return EFI_SUCCESS;
+}
@@ -48,15 +48,23 @@ SerialStatusCodeReportWorker (
   UINTN      CharCount;
   BASE_LIST  Marker;
   UINT8      postcode;
+  BOOLEAN    Flush;
 
   Buffer[0] = '\0';
+  Flush     = FALSE;
 
-  if ((Data != NULL) &&
-      ReportStatusCodeExtractAssertInfo (CodeType, Value, Data, &Filename, &Description, &LineNumber))
+  if (!StatusCodeRouted (ADLINK_STATUS_CODE_SINK_SERIAL, CodeType, CallerId, Data)) {
+    //
+    // The routing policy keeps it off the serial port.
+    //
+    CharCount = 0;
+  } else if ((Data != NULL) &&
+             ReportStatusCodeExtractAssertInfo (CodeType, Value, Data, &Filename, &Description, &LineNumber))
   {
     //
     // Print ASSERT() information into output buffer.
     //
+    Flush     = TRUE;
     CharCount = AsciiSPrint (
                   Buffer,
                   sizeof (Buffer),
@@ -69,18 +77,23 @@ SerialStatusCodeReportWorker (
              ReportStatusCodeExtractDebugInfo (Data, &ErrorLevel, &Marker, &Format))
   {
     //
-    // Print DEBUG() information into output buffer.
+    // Print DEBUG() information into output buffer, unless the binary
+    // log keeps it for the host to format.
     //
-    CharCount = AsciiBSPrint (
-                  Buffer,
-                  sizeof (Buffer),
-                  Format,
-                  Marker
-                  );
+    CharCount = 0;
+    if (!FeaturePcdGet (PcdStatusCodeUseBinaryLog)) {
+      CharCount = AsciiBSPrint (
+                    Buffer,
+                    sizeof (Buffer),
+                    Format,
+                    Marker
+                    );
+    }
   } else if ((CodeType & EFI_STATUS_CODE_TYPE_MASK) == EFI_ERROR_CODE) {
     //
     // Print ERROR information into output buffer.
     //
+    Flush     = TRUE;
     CharCount = AsciiSPrint (
                   Buffer,
                   sizeof (Buffer),
@@ -116,15 +129,19 @@ SerialStatusCodeReportWorker (
                    );
   } else if ((CodeType & EFI_STATUS_CODE_TYPE_MASK) == EFI_PROGRESS_CODE) {
     //
-    // Print PROGRESS information into output buffer.
+    // Print PROGRESS information into output buffer, unless the binary
+    // log keeps it.
     //
-    CharCount = AsciiSPrint (
-                  Buffer,
-                  sizeof (Buffer),
-                  "PROGRESS CODE: V%08x I%x\n\r",
-                  Value,
-                  Instance
-                  );
+    CharCount = 0;
+    if (!FeaturePcdGet (PcdStatusCodeUseBinaryLog)) {
+      CharCount = AsciiSPrint (
+                    Buffer,
+                    sizeof (Buffer),
+                    "PROGRESS CODE: V%08x I%x\n\r",
+                    Value,
+                    Instance
+                    );
+    }
   } else if ((Data != NULL) &&
              CompareGuid (&Data->Type, &gEfiStatusCodeDataTypeStringGuid) &&
              (((EFI_STATUS_CODE_STRING_DATA *)Data)->StringType == EfiStringAscii))
@@ -153,12 +170,24 @@ SerialStatusCodeReportWorker (
   }
 
   //
-  // Call SerialPort Lib function to do print.
+  // Queue the output for the UART. Write it out right away for an assert,
+  // an error or a reset, which may be the last thing this boot prints.
   //
-  SerialPortWrite ((UINT8 *)Buffer, CharCount);
+  if (CharCount != 0) {
+    SerialTxRingWrite ((UINT8 *)Buffer, CharCount);
+  }
 
-  postcode=GetPostCodeFromStatusCode(CodeType, Value);
-  PostCode(postcode);
+  if (Flush ||
+      (((CodeType & EFI_STATUS_CODE_TYPE_MASK) == EFI_PROGRESS_CODE) &&
+       (Value == (EFI_SOFTWARE_EFI_RUNTIME_SERVICE | EFI_SW_RS_PC_RESET_SYSTEM))))
+  {
+    SerialTxRingFlush (FALSE);
+  }
+
+  if (StatusCodeRouted (ADLINK_STATUS_CODE_SINK_POST_CODE, CodeType, CallerId, Data)) {
+    postcode=GetPostCodeFromStatusCode(CodeType, Value);
+    PostCode(postcode);
+  }
 
   //
   // If register an unregister function of gEfiEventExitBootServicesGuid,
@@ -173,3 +202,77 @@ SerialStatusCodeReportWorker (
 
   return EFI_SUCCESS;
 }
+
+/**
+  Print a summary of the status codes reported in PEI: how many there
+  were, the last POST code and every error code, oldest first. Unlike a
+  replay through SerialStatusCodeReportWorker(), progress codes are not
+  printed one by one and no POST code is sent to the MMC again.
+
+  @param  Header           The PEI memory status code GUID'ed HOB.
+
+**/
+VOID
+SerialStatusCodeReplaySummary (
+  IN CONST ADLINK_TIMED_STATUSCODE_HEADER  *Header
+  )
+{
+  CONST ADLINK_TIMED_STATUSCODE_RECORD  *Records;
+  CONST ADLINK_TIMED_STATUSCODE_RECORD  *Record;
+  CHAR8                                 Buffer[MAX_DEBUG_MESSAGE_LENGTH];
+  UINTN                                 CharCount;
+  UINT32                                First;
+  UINT32                                Count;
+  UINT32                                Index;
+  UINT32                                Errors;
+  UINT8                                 LastPostCode;
+
+  if ((Header->RecordSize != sizeof (ADLINK_TIMED_STATUSCODE_RECORD)) ||
+      (Header->MaxRecordsNumber == 0))
+  {
+    return;
+  }
+
+  Records = (CONST ADLINK_TIMED_STATUSCODE_RECORD *)(Header + 1);
+  First   = 0;
+  Count   = Header->NumberOfRecords;
+  if (Count >= Header->MaxRecordsNumber) {
+    First = Header->RecordIndex;
+    Count = Header->MaxRecordsNumber;
+  }
+
+  Errors       = 0;
+  LastPostCode = 0;
+  for (Index = 0; Index < Count; Index++) {
+    Record = &Records[(First + Index) % Header->MaxRecordsNumber];
+    if (Record->PostCode != 0) {
+      LastPostCode = Record->PostCode;
+    }
+
+    if ((Record->CodeType & EFI_STATUS_CODE_TYPE_MASK) != EFI_ERROR_CODE) {
+      continue;
+    }
+
+    Errors++;
+    CharCount = AsciiSPrint (
+                  Buffer,
+                  sizeof (Buffer),
+                  "PEI ERROR: C%08x:V%08x I%x %g\n\r",
+                  Record->CodeType,
+                  Record->Value,
+                  Record->Instance,
+                  &Record->CallerId
+                  );
+    SerialTxRingWrite ((UINT8 *)Buffer, CharCount);
+  }
+
+  CharCount = AsciiSPrint (
+                Buffer,
+                sizeof (Buffer),
+                "PEI: %d status codes, %d errors, last POST code %02x\n\r",
+                Header->NumberOfRecords,
+                Errors,
+                LastPostCode
+                );
+  SerialTxRingWrite ((UINT8 *)Buffer, CharCount);
+}
@@ -0,0 +1,218 @@
+/** @file
+  Asynchronous serial output of the serial status code worker.
+
+  At the build time baud rate a DEBUG () line keeps SerialPortWrite()
+  busy for milliseconds. With PcdStatusCodeSerialTxRingSize set, the worker
+  copies its output into a ring instead, and the ring is pumped out to the
+  UART, byte by byte for as long as its transmit FIFO has room, after
+  every status code and from a periodic timer. The ring is written out
+  synchronously on ASSERT () and error codes, before ResetSystem () and
+  when boot services end, so that the log of a crash or reset is complete.
+  A full ring is made room in synchronously, no byte is dropped.
+
+  Copyright (c) 2022, ADLink. All rights reserved.<BR>
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#include "StatusCodeHandlerRuntimeDxe.h"
+#include <Library/MmcLib.h>
+
+//
+// Most bytes written per pump. The FIFO drains while it is filled, so a
+// fast UART could otherwise keep the pump going for the whole ring at
+// TPL_HIGH_LEVEL.
+//
+#define SERIAL_TX_RING_PUMP_BUDGET  256
+
+STATIC UINT8  *mSerialTxRing     = NULL;
+STATIC UINTN  mSerialTxRingSize  = 0;
+//
+// Bytes ever queued and ever written, the ring offset of a count is
+// Count % mSerialTxRingSize.
+//
+STATIC UINTN  mSerialTxRingHead = 0;
+STATIC UINTN  mSerialTxRingTail = 0;
+
+/**
+  Write bytes to the UART, unless an MMC transaction owns it and takes the
+  output over until it ends.
+
+  @param  Buffer           The bytes.
+  @param  Length           Number of bytes in Buffer.
+
+**/
+STATIC
+VOID
+SerialTxWrite (
+  IN CONST UINT8  *Buffer,
+  IN UINTN        Length
+  )
+{
+  if (!MmcHoldDebugOutput (Buffer, Length)) {
+    SerialPortWrite ((UINT8 *)Buffer, Length);
+  }
+}
+
+/**
+  Write the oldest queued bytes to the UART, waiting for it as needed.
+
+  @param  Length           Number of bytes to write, at most the queued ones.
+
+**/
+STATIC
+VOID
+SerialTxRingWriteOut (
+  IN UINTN  Length
+  )
+{
+  UINTN  Offset;
+  UINTN  Chunk;
+
+  while (Length > 0) {
+    Offset = mSerialTxRingTail % mSerialTxRingSize;
+    Chunk  = MIN (Length, mSerialTxRingSize - Offset);
+    SerialTxWrite (&mSerialTxRing[Offset], Chunk);
+    mSerialTxRingTail += Chunk;
+    Length            -= Chunk;
+  }
+}
+
+/**
+  Write queued bytes for as long as the UART takes them without waiting.
+
+**/
+STATIC
+VOID
+SerialTxRingPumpLocked (
+  VOID
+  )
+{
+  UINTN  Budget;
+
+  //
+  // MmcCanWriteDebugOutput () tells that the transmit FIFO is not full and
+  // that no MMC transaction holds the UART.
+  //
+  Budget = SERIAL_TX_RING_PUMP_BUDGET;
+  while ((mSerialTxRingHead != mSerialTxRingTail) && (Budget > 0) && MmcCanWriteDebugOutput ()) {
+    SerialTxRingWriteOut (1);
+    Budget--;
+  }
+}
+
+/**
+  Allocate the ring if PcdStatusCodeSerialTxRingSize asks for one.
+
+  @retval EFI_SUCCESS           Output is asynchronous, or synchronous by choice.
+  @retval EFI_OUT_OF_RESOURCES  No memory for the ring, output stays synchronous.
+
+**/
+EFI_STATUS
+SerialTxRingInitialize (
+  VOID
+  )
+{
+  UINTN  Size;
+
+  Size = FixedPcdGet32 (PcdStatusCodeSerialTxRingSize) * SIZE_1KB;
+  if (Size == 0) {
+    return EFI_SUCCESS;
+  }
+
+  mSerialTxRing = AllocatePool (Size);
+  if (mSerialTxRing == NULL) {
+    return EFI_OUT_OF_RESOURCES;
+  }
+
+  mSerialTxRingSize = Size;
+  return EFI_SUCCESS;
+}
+
+/**
+  Queue serial output, or write it if there is no ring.
+
+  @param  Buffer           The bytes.
+  @param  Length           Number of bytes in Buffer.
+
+**/
+VOID
+SerialTxRingWrite (
+  IN CONST UINT8  *Buffer,
+  IN UINTN        Length
+  )
+{
+  EFI_TPL  OldTpl;
+  UINTN    Offset;
+  UINTN    Chunk;
+
+  if (mSerialTxRing == NULL) {
+    SerialTxWrite (Buffer, Length);
+    return;
+  }
+
+  OldTpl = gBS->RaiseTPL (TPL_HIGH_LEVEL);
+  while (Length > 0) {
+    if (mSerialTxRingHead - mSerialTxRingTail == mSerialTxRingSize) {
+      SerialTxRingWriteOut (MIN (Length, mSerialTxRingSize));
+    }
+
+    Offset = mSerialTxRingHead % mSerialTxRingSize;
+    Chunk  = MIN (Length, mSerialTxRingSize - Offset);
+    Chunk  = MIN (Chunk, mSerialTxRingSize - (mSerialTxRingHead - mSerialTxRingTail));
+    CopyMem (&mSerialTxRing[Offset], Buffer, Chunk);
+    mSerialTxRingHead += Chunk;
+    Buffer            += Chunk;
+    Length            -= Chunk;
+  }
+
+  SerialTxRingPumpLocked ();
+  gBS->RestoreTPL (OldTpl);
+}
+
+/**
+  Write queued bytes for as long as the UART takes them without waiting.
+
+**/
+VOID
+SerialTxRingPump (
+  VOID
+  )
+{
+  EFI_TPL  OldTpl;
+
+  if (mSerialTxRing == NULL) {
+    return;
+  }
+
+  OldTpl = gBS->RaiseTPL (TPL_HIGH_LEVEL);
+  SerialTxRingPumpLocked ();
+  gBS->RestoreTPL (OldTpl);
+}
+
+/**
+  Write every queued byte, waiting for the UART.
+
+  @param  Release          TRUE to write synchronously from now on, when boot
+                           services end.
+
+**/
+VOID
+SerialTxRingFlush (
+  IN BOOLEAN  Release
+  )
+{
+  EFI_TPL  OldTpl;
+
+  if (mSerialTxRing == NULL) {
+    return;
+  }
+
+  OldTpl = gBS->RaiseTPL (TPL_HIGH_LEVEL);
+  SerialTxRingWriteOut (mSerialTxRingHead - mSerialTxRingTail);
+  if (Release) {
+    mSerialTxRing = NULL;
+  }
+
+  gBS->RestoreTPL (OldTpl);
+}
@@ -10,8 +10,136 @@
 #include "StatusCodeHandlerRuntimeDxe.h"
 
 EFI_EVENT                 mVirtualAddressChangeEvent = NULL;
+EFI_EVENT                 mPostCodeFlushEvent        = NULL;
+EFI_EVENT                 mSerialTxDrainEvent        = NULL;
+EFI_EVENT                 mResetNotificationEvent    = NULL;
+VOID                      *mResetNotificationRegistration;
 EFI_RSC_HANDLER_PROTOCOL  *mRscHandlerProtocol       = NULL;
 
+/**
+  Reset notification. Puts the MMC link back to its power on state, the MMC
+  is not reset with the host.
+
+  @param  ResetType         The type of reset to perform.
+  @param  ResetStatus       The status code for the reset.
+  @param  DataSize          The size, in bytes, of ResetData.
+  @param  ResetData         Optional data describing the reason of the reset.
+
+**/
+VOID
+EFIAPI
+MmcLinkResetNotify (
+  IN EFI_RESET_TYPE  ResetType,
+  IN EFI_STATUS      ResetStatus,
+  IN UINTN           DataSize,
+  IN VOID            *ResetData OPTIONAL
+  )
+{
+  MmcResetLink ();
+}
+
+/**
+  Protocol notification call back. Registers MmcLinkResetNotify () once the
+  Reset Notification Protocol is installed.
+
+  @param  Event         Event whose notification function is being invoked.
+  @param  Context       Pointer to the notification function's context, which is
+                        always zero in current implementation.
+
+**/
+VOID
+EFIAPI
+ResetNotificationInstalledCallBack (
+  IN EFI_EVENT  Event,
+  IN VOID       *Context
+  )
+{
+  EFI_RESET_NOTIFICATION_PROTOCOL  *ResetNotification;
+  EFI_STATUS                       Status;
+
+  Status = gBS->LocateProtocol (&gEfiResetNotificationProtocolGuid, NULL, (VOID **)&ResetNotification);
+  if (EFI_ERROR (Status)) {
+    return;
+  }
+
+  ResetNotification->RegisterResetNotify (ResetNotification, MmcLinkResetNotify);
+  gBS->CloseEvent (Event);
+  mResetNotificationEvent = NULL;
+}
+
+/**
+  Puts the MMC link back to its power on state when the OS resets. Reset
+  notifications are only called before ExitBootServices (), but ResetSystem ()
+  reports a progress code at runtime too.
+
+  @param  CodeType         Indicates the type of status code being reported.
+  @param  Value            Describes the current status of a hardware or software entity.
+  @param  Instance         The enumeration of a hardware or software entity within
+                           the system. Valid instance numbers start with 1.
+  @param  CallerId         This optional parameter may be used to identify the caller.
+  @param  Data             This optional parameter may be used to pass additional data.
+
+  @retval EFI_SUCCESS      The function always return EFI_SUCCESS.
+
+**/
+EFI_STATUS
+EFIAPI
+MmcLinkStatusCodeReportWorker (
+  IN EFI_STATUS_CODE_TYPE   CodeType,
+  IN EFI_STATUS_CODE_VALUE  Value,
+  IN UINT32                 Instance,
+  IN EFI_GUID               *CallerId,
+  IN EFI_STATUS_CODE_DATA   *Data OPTIONAL
+  )
+{
+  if (EfiAtRuntime () &&
+      ((CodeType & EFI_STATUS_CODE_TYPE_MASK) == EFI_PROGRESS_CODE) &&
+      (Value == (EFI_SOFTWARE_EFI_RUNTIME_SERVICE | EFI_SW_RS_PC_RESET_SYSTEM)))
+  {
+    MmcResetLink ();
+  }
+
+  return EFI_SUCCESS;
+}
+
+/**
+  Periodic timer call back. Pushes POST codes still queued for the MMC, so
+  that the last code reaches the BMC even if boot hangs right after it.
+
+  @param  Event         Event whose notification function is being invoked.
+  @param  Context       Pointer to the notification function's context, which is
+                        always zero in current implementation.
+
+**/
+VOID
+EFIAPI
+PostCodeFlushCallBack (
+  IN EFI_EVENT  Event,
+  IN VOID       *Context
+  )
+{
+  MmcPostCodeFlush ();
+}
+
+/**
+  Periodic timer call back. Pumps the serial output queued while the UART
+  was busy.
+
+  @param  Event         Event whose notification function is being invoked.
+  @param  Context       Pointer to the notification function's context, which is
+                        always zero in current implementation.
+
+**/
+VOID
+EFIAPI
+SerialTxDrainCallBack (
+  IN EFI_EVENT  Event,
+  IN VOID       *Context
+  )
+{
+  SerialTxRingPump ();
+}
+
 /**
   Unregister status code callback functions only available at boot time from
   report status code router when exiting boot services.
@@ -25,6 +153,11 @@ UnregisterSerialBootTimeHandlers (
 {
   if (PcdGetBool (PcdStatusCodeUseSerial)) {
     mRscHandlerProtocol->Unregister (SerialStatusCodeReportWorker);
+    SerialTxRingFlush (TRUE);
+    if (mSerialTxDrainEvent != NULL) {
+      gBS->CloseEvent (mSerialTxDrainEvent);
+      mSerialTxDrainEvent = NULL;
+    }
   }
 }
 
@@ -47,10 +180,18 @@ VirtualAddressChangeCallBack (
   //
   // Convert memory status code table to virtual address;
   //
+  EfiConvertPointer (
+    0,
+    (VOID **)&mRtMemoryStatusCodeRecords
+    );
   EfiConvertPointer (
     0,
     (VOID **)&mRtMemoryStatusCodeTable
     );
+  EfiConvertPointer (
+    0,
+    (VOID **)&mBinaryStatusCodeLog
+    );
 }
 
 /**
@@ -63,16 +204,16 @@ InitializationDispatcherWorker (
   VOID
   )
 {
-  EFI_PEI_HOB_POINTERS             Hob;
-  EFI_STATUS                       Status;
-  MEMORY_STATUSCODE_PACKET_HEADER  *PacketHeader;
-  MEMORY_STATUSCODE_RECORD         *Record;
-  UINTN                            Index;
-  UINTN                            MaxRecordNumber;
+  EFI_PEI_HOB_POINTERS  Hob;
+  EFI_STATUS            Status;
+
+  StatusCodeRoutingInitialize ();
 
   //
   // If enable UseSerial, then initialize serial port.
   // if enable UseRuntimeMemory, then initialize runtime memory status code worker.
+  // if enable UseBinaryLog, then initialize binary status code log worker.
+  // if the persistent log has a size, then continue the log of this boot.
   //
   if (PcdGetBool (PcdStatusCodeUseSerial)) {
     //
@@ -80,6 +221,9 @@ InitializationDispatcherWorker (
     //
     Status = SerialPortInitialize ();
     ASSERT_EFI_ERROR (Status);
+
+    Status = SerialTxRingInitialize ();
+    ASSERT_EFI_ERROR (Status);
   }
 
   if (PcdGetBool (PcdStatusCodeUseMemory)) {
@@ -87,50 +231,25 @@ InitializationDispatcherWorker (
     ASSERT_EFI_ERROR (Status);
   }
 
+  if (FeaturePcdGet (PcdStatusCodeUseBinaryLog)) {
+    Status = BinaryLogStatusCodeInitializeWorker ();
+    ASSERT_EFI_ERROR (Status);
+  }
+
+  if (FixedPcdGet32 (PcdStatusCodePersistentLogSize) != 0) {
+    Status = PersistentLogStatusCodeInitializeWorker ();
+    ASSERT_EFI_ERROR (Status);
+  }
+
   //
-  // Replay Status code which saved in GUID'ed HOB to all supported devices.
+  // Summarize the status codes saved in GUID'ed HOB on serial. The memory
+  // status code worker carried the records over already, and the MMC saw
+  // their POST codes in PEI.
   //
-  if (FeaturePcdGet (PcdStatusCodeReplayIn)) {
-    //
-    // Journal GUID'ed HOBs to find all record entry, if found,
-    // then output record to support replay device.
-    //
-    Hob.Raw = GetFirstGuidHob (&gMemoryStatusCodeRecordGuid);
+  if (FeaturePcdGet (PcdStatusCodeReplayIn) && PcdGetBool (PcdStatusCodeUseSerial)) {
+    Hob.Raw = GetFirstGuidHob (&gAdlinkTimedStatusCodeRecordGuid);
     if (Hob.Raw != NULL) {
-      PacketHeader    = (MEMORY_STATUSCODE_PACKET_HEADER *)GET_GUID_HOB_DATA (Hob.Guid);
-      Record          = (MEMORY_STATUSCODE_RECORD *)(PacketHeader + 1);
-      MaxRecordNumber = (UINTN)PacketHeader->RecordIndex;
-      if (PacketHeader->PacketIndex > 0) {
-        //
-        // Record has been wrapped around. So, record number has arrived at max number.
-        //
-        MaxRecordNumber = (UINTN)PacketHeader->MaxRecordsNumber;
-      }
-
-      for (Index = 0; Index < MaxRecordNumber; Index++) {
-        //
-        // Dispatch records to devices based on feature flag.
-        //
-        if (PcdGetBool (PcdStatusCodeUseSerial)) {
-          SerialStatusCodeReportWorker (
-            Record[Index].CodeType,
-            Record[Index].Value,
-            Record[Index].Instance,
-            NULL,
-            NULL
-            );
-        }
-
-        if (PcdGetBool (PcdStatusCodeUseMemory)) {
-          RtMemoryStatusCodeReportWorker (
-            Record[Index].CodeType,
-            Record[Index].Value,
-            Record[Index].Instance,
-            NULL,
-            NULL
-            );
-        }
-      }
+      SerialStatusCodeReplaySummary (GET_GUID_HOB_DATA (Hob.Guid));
     }
   }
 }
@@ -170,12 +289,63 @@ StatusCodeHandlerRuntimeDxeEntry (
 
   if (PcdGetBool (PcdStatusCodeUseSerial)) {
     mRscHandlerProtocol->Register (SerialStatusCodeReportWorker, TPL_HIGH_LEVEL);
+
+    Status = gBS->CreateEvent (
+                    EVT_TIMER | EVT_NOTIFY_SIGNAL,
+                    TPL_NOTIFY,
+                    PostCodeFlushCallBack,
+                    NULL,
+                    &mPostCodeFlushEvent
+                    );
+    ASSERT_EFI_ERROR (Status);
+
+    Status = gBS->SetTimer (
+                    mPostCodeFlushEvent,
+                    TimerPeriodic,
+                    EFI_TIMER_PERIOD_MILLISECONDS (FixedPcdGet32 (PcdMmcPostCodeFlushPeriod))
+                    );
+    ASSERT_EFI_ERROR (Status);
+
+    if (FixedPcdGet32 (PcdStatusCodeSerialTxRingSize) != 0) {
+      Status = gBS->CreateEvent (
+                      EVT_TIMER | EVT_NOTIFY_SIGNAL,
+                      TPL_NOTIFY,
+                      SerialTxDrainCallBack,
+                      NULL,
+                      &mSerialTxDrainEvent
+                      );
+      ASSERT_EFI_ERROR (Status);
+
+      Status = gBS->SetTimer (
+                      mSerialTxDrainEvent,
+                      TimerPeriodic,
+                      EFI_TIMER_PERIOD_MILLISECONDS (FixedPcdGet32 (PcdStatusCodeSerialTxDrainPeriod))
+                      );
+      ASSERT_EFI_ERROR (Status);
+    }
   }
 
   if (PcdGetBool (PcdStatusCodeUseMemory)) {
     mRscHandlerProtocol->Register (RtMemoryStatusCodeReportWorker, TPL_HIGH_LEVEL);
   }
 
+  if (FeaturePcdGet (PcdStatusCodeUseBinaryLog) && (mBinaryStatusCodeLog != NULL)) {
+    mRscHandlerProtocol->Register (BinaryLogStatusCodeReportWorker, TPL_HIGH_LEVEL);
+  }
+
+  if (mPersistentStatusCodeLog != NULL) {
+    mRscHandlerProtocol->Register (PersistentLogStatusCodeReportWorker, TPL_HIGH_LEVEL);
+  }
+
+  mRscHandlerProtocol->Register (MmcLinkStatusCodeReportWorker, TPL_HIGH_LEVEL);
+  mResetNotificationEvent = EfiCreateProtocolNotifyEvent (
+                              &gEfiResetNotificationProtocolGuid,
+                              TPL_CALLBACK,
+                              ResetNotificationInstalledCallBack,
+                              NULL,
+                              &mResetNotificationRegistration
+                              );
+
   Status = gBS->CreateEventEx (
                   EVT_NOTIFY_SIGNAL,
                   TPL_NOTIFY,
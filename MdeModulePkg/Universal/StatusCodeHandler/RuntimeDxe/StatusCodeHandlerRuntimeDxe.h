@@ -11,11 +11,15 @@
 #define __STATUS_CODE_HANDLER_RUNTIME_DXE_H__
 
 #include <Protocol/ReportStatusCodeHandler.h>
+#include <Protocol/ResetNotification.h>
 
 #include <Guid/MemoryStatusCodeRecord.h>
+#include <Guid/TimedStatusCodeRecord.h>
 #include <Guid/StatusCodeDataTypeId.h>
 #include <Guid/StatusCodeDataTypeDebug.h>
 #include <Guid/EventGroup.h>
+#include <Guid/StatusCodeLog.h>
+#include <Guid/StatusCodeRouting.h>
 
 #include <Library/SynchronizationLib.h>
 #include <Library/BaseMemoryLib.h>
@@ -26,16 +30,27 @@
 #include <Library/HobLib.h>
 #include <Library/UefiDriverEntryPoint.h>
 #include <Library/UefiBootServicesTableLib.h>
+#include <Library/UefiLib.h>
 #include <Library/MemoryAllocationLib.h>
 #include <Library/UefiRuntimeLib.h>
 #include <Library/SerialPortLib.h>
+#include <Library/MmcLib.h>
+#include <Library/MmcPostCodeLib.h>
+#include <Library/StatusCodeLogLib.h>
+#include <Library/PersistentStatusCodeLogLib.h>
+#include <Library/StatusCodeRoutingLib.h>
+#include <Library/TimerLib.h>
 
 //
 // Define the maximum message length
 //
 #define MAX_DEBUG_MESSAGE_LENGTH  0x100
 
-extern RUNTIME_MEMORY_STATUSCODE_HEADER  *mRtMemoryStatusCodeTable;
+extern RUNTIME_MEMORY_STATUSCODE_HEADER  *mRtMemoryStatusCodeRecords;
+extern ADLINK_TIMED_STATUSCODE_HEADER    *mRtMemoryStatusCodeTable;
+extern ADLINK_STATUS_CODE_LOG_HEADER     *mBinaryStatusCodeLog;
+extern ADLINK_PERSISTENT_LOG_HEADER      *mPersistentStatusCodeLog;
+extern EFI_RSC_HANDLER_PROTOCOL          *mRscHandlerProtocol;
 
 /**
   Locates Serial I/O Protocol as initialization for serial status code worker.
@@ -78,7 +93,20 @@ SerialStatusCodeReportWorker (
   );
 
 /**
-  Initialize runtime memory status code table as initialization for runtime memory status code worker
+  Print a summary of the status codes reported in PEI: how many there
+  were, the last POST code and every error code, oldest first.
+
+  @param  Header           The PEI memory status code GUID'ed HOB.
+
+**/
+VOID
+SerialStatusCodeReplaySummary (
+  IN CONST ADLINK_TIMED_STATUSCODE_HEADER  *Header
+  );
+
+/**
+  Initialize runtime memory status code table as initialization for runtime memory status code worker,
+  starting with the records of the PEI memory status code GUID'ed HOB.
 
   @retval EFI_SUCCESS  Runtime memory status code table successfully initialized.
   @retval others       Errors from gBS->InstallConfigurationTable().
@@ -117,6 +145,159 @@ RtMemoryStatusCodeReportWorker (
   IN EFI_STATUS_CODE_DATA   *Data OPTIONAL
   );
 
+/**
+  Create the runtime binary status code log, carry the records of the PEI
+  log over and publish it as a configuration table.
+
+  @retval EFI_SUCCESS           The log is published.
+  @retval EFI_OUT_OF_RESOURCES  No memory for the log.
+  @retval others                Errors from gBS->InstallConfigurationTable().
+
+**/
+EFI_STATUS
+BinaryLogStatusCodeInitializeWorker (
+  VOID
+  );
+
+/**
+  Report status code into the runtime binary status code log.
+
+  @param  CodeType                Indicates the type of status code being reported.
+  @param  Value                   Describes the current status of a hardware or software entity.
+                                  This included information about the class and subclass that is used to
+                                  classify the entity as well as an operation.
+  @param  Instance                The enumeration of a hardware or software entity within
+                                  the system. Valid instance numbers start with 1.
+  @param  CallerId                This optional parameter may be used to identify the caller.
+  @param  Data                    This optional parameter may be used to pass additional data.
+
+  @retval EFI_SUCCESS             Status code successfully recorded in the log.
+
+**/
+EFI_STATUS
+EFIAPI
+BinaryLogStatusCodeReportWorker (
+  IN EFI_STATUS_CODE_TYPE   CodeType,
+  IN EFI_STATUS_CODE_VALUE  Value,
+  IN UINT32                 Instance,
+  IN EFI_GUID               *CallerId,
+  IN EFI_STATUS_CODE_DATA   *Data OPTIONAL
+  );
+
+/**
+  Pick up the persistent status code log of this boot, and publish the
+  one of the previous boot.
+
+  @retval EFI_SUCCESS      The log of this boot is found.
+  @retval EFI_NOT_FOUND    StatusCodeHandlerPei did not start a log.
+
+**/
+EFI_STATUS
+PersistentLogStatusCodeInitializeWorker (
+  VOID
+  );
+
+/**
+  Report status code into the persistent status code log.
+
+  @param  CodeType         Indicates the type of status code being reported.
+  @param  Value            Describes the current status of a hardware or
+                           software entity. This includes information about the class and
+                           subclass that is used to classify the entity as well as an operation.
+  @param  Instance         The enumeration of a hardware or software entity within
+                           the system. Valid instance numbers start with 1.
+  @param  CallerId         This optional parameter may be used to identify the caller.
+  @param  Data             This optional parameter may be used to pass additional data.
+
+  @retval EFI_SUCCESS      The function always return EFI_SUCCESS.
+
+**/
+EFI_STATUS
+EFIAPI
+PersistentLogStatusCodeReportWorker (
+  IN EFI_STATUS_CODE_TYPE   CodeType,
+  IN EFI_STATUS_CODE_VALUE  Value,
+  IN UINT32                 Instance,
+  IN EFI_GUID               *CallerId,
+  IN EFI_STATUS_CODE_DATA   *Data OPTIONAL
+  );
+
+/**
+  Allocate the ring if PcdStatusCodeSerialTxRingSize asks for one.
+
+  @retval EFI_SUCCESS           Output is asynchronous, or synchronous by choice.
+  @retval EFI_OUT_OF_RESOURCES  No memory for the ring, output stays synchronous.
+
+**/
+EFI_STATUS
+SerialTxRingInitialize (
+  VOID
+  );
+
+/**
+  Queue serial output, or write it if there is no ring.
+
+  @param  Buffer           The bytes.
+  @param  Length           Number of bytes in Buffer.
+
+**/
+VOID
+SerialTxRingWrite (
+  IN CONST UINT8  *Buffer,
+  IN UINTN        Length
+  );
+
+/**
+  Write queued bytes for as long as the UART takes them without waiting.
+
+**/
+VOID
+SerialTxRingPump (
+  VOID
+  );
+
+/**
+  Write every queued byte, waiting for the UART.
+
+  @param  Release          TRUE to write synchronously from now on, when boot
+                           services end.
+
+**/
+VOID
+SerialTxRingFlush (
+  IN BOOLEAN  Release
+  );
+
+/**
+  Take the routing policy over from the PEI GUID'ed HOB, or forward every
+  status code to every sink if there is none.
+
+**/
+VOID
+StatusCodeRoutingInitialize (
+  VOID
+  );
+
+/**
+  Tell whether a status code is forwarded to a sink.
+
+  @param  Sink             ADLINK_STATUS_CODE_SINK_*.
+  @param  CodeType         Indicates the type of status code being reported.
+  @param  CallerId         This optional parameter may be used to identify the caller.
+  @param  Data             This optional parameter may be used to pass additional data.
+
+  @retval TRUE             The status code goes to the sink.
+  @retval FALSE            The sink does not take the status code.
+
+**/
+BOOLEAN
+StatusCodeRouted (
+  IN UINTN                  Sink,
+  IN EFI_STATUS_CODE_TYPE   CodeType,
+  IN EFI_GUID               *CallerId  OPTIONAL,
+  IN EFI_STATUS_CODE_DATA   *Data      OPTIONAL
+  );
+
 /**
   Unregister status code callback functions only available at boot time from
   report status code router when exiting boot services.
@@ -0,0 +1,59 @@
+/** @file
+  Runtime status code routing policy, see Guid/StatusCodeRouting.h.
+
+  Copyright (c) 2022, ADLink. All rights reserved.<BR>
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#include "StatusCodeHandlerRuntimeDxe.h"
+
+ADLINK_STATUS_CODE_ROUTING  mStatusCodeRouting;
+
+/**
+  Take the routing policy over from the PEI GUID'ed HOB, or forward every
+  status code to every sink if there is none.
+
+**/
+VOID
+StatusCodeRoutingInitialize (
+  VOID
+  )
+{
+  EFI_PEI_HOB_POINTERS              Hob;
+  CONST ADLINK_STATUS_CODE_ROUTING  *Routing;
+
+  Hob.Raw = GetFirstGuidHob (&gAdlinkStatusCodeRoutingGuid);
+  if (Hob.Raw != NULL) {
+    Routing = GET_GUID_HOB_DATA (Hob.Guid);
+    if (StatusCodeRoutingIsValid (Routing, GET_GUID_HOB_DATA_SIZE (Hob.Guid))) {
+      CopyMem (&mStatusCodeRouting, Routing, sizeof (mStatusCodeRouting));
+      return;
+    }
+  }
+
+  StatusCodeRoutingSetDefault (&mStatusCodeRouting);
+}
+
+/**
+  Tell whether a status code is forwarded to a sink.
+
+  @param  Sink             ADLINK_STATUS_CODE_SINK_*.
+  @param  CodeType         Indicates the type of status code being reported.
+  @param  CallerId         This optional parameter may be used to identify the caller.
+  @param  Data             This optional parameter may be used to pass additional data.
+
+  @retval TRUE             The status code goes to the sink.
+  @retval FALSE            The sink does not take the status code.
+
+**/
+BOOLEAN
+StatusCodeRouted (
+  IN UINTN                  Sink,
+  IN EFI_STATUS_CODE_TYPE   CodeType,
+  IN EFI_GUID               *CallerId  OPTIONAL,
+  IN EFI_STATUS_CODE_DATA   *Data      OPTIONAL
+  )
+{
+  return StatusCodeRoutingAccepts (&mStatusCodeRouting, Sink, CodeType, CallerId, Data);
+}
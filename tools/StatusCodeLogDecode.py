@@ -0,0 +1,295 @@
+#!/usr/bin/env python3
+#
+# Formats the binary status code log (Include/Guid/StatusCodeLog.h) kept
+# when PcdStatusCodeUseBinaryLog is TRUE.
+#
+# The log is read from either
+#   - a capture of the serial console while Application/StatusCodeLog ran
+#     (the lines between STATUS CODE LOG BEGIN and END), or
+#   - a raw memory dump holding the log, found by its signature.
+#
+# Usage: StatusCodeLogDecode.py [-g] [FILE]   (FILE defaults to stdin)
+#   -g  also print the GUID of the reporting module
+#
+# Copyright (c) 2022, ADLink. All rights reserved.<BR>
+#
+# SPDX-License-Identifier: BSD-2-Clause-Patent
+#
+
+import re
+import struct
+import sys
+import uuid
+
+SIGNATURE = b'SCLG'
+
+PAD, FORMAT, DEBUG, CODE = 0, 1, 2, 3
+ALIGNMENT = 8
+FORMAT_CACHE = 64
+MAX_STRING = 64
+
+HEADER = struct.Struct('<4sIQQQQ')
+HEADER_SIZE = HEADER.size + FORMAT_CACHE * 16
+RECORD = struct.Struct('<HBBIQ16sIIII')
+
+EFI_STATUS_CODE_TYPE_MASK = 0xFF
+EFI_PROGRESS_CODE = 1
+EFI_ERROR_CODE = 2
+
+WARNINGS = [
+    'Success', 'Warning Unknown Glyph', 'Warning Delete Failure',
+    'Warning Write Failure', 'Warning Buffer Too Small', 'Warning Stale Data',
+    'Warning File System', 'Warning Reset Required',
+]
+
+ERRORS = [
+    'Load Error', 'Invalid Parameter', 'Unsupported', 'Bad Buffer Size',
+    'Buffer Too Small', 'Not Ready', 'Device Error', 'Write Protected',
+    'Out of Resources', 'Volume Corrupt', 'Volume Full', 'No Media',
+    'Media changed', 'Not Found', 'Access Denied', 'No Response', 'No mapping',
+    'Time out', 'Not started', 'Already started', 'Aborted', 'ICMP Error',
+    'TFTP Error', 'Protocol Error', 'Incompatible Version',
+    'Security Violation', 'CRC Error', 'End of Media', 'Reserved (29)',
+    'Reserved (30)', 'End of File', 'Invalid Language', 'Compromised Data',
+    'IP Address Conflict', 'HTTP Error',
+]
+
+
+def read_capture(text):
+    """Return the bytes dumped by Application/StatusCodeLog, or None."""
+    begin = text.rfind('STATUS CODE LOG BEGIN')
+    if begin < 0:
+        return None
+    data = bytearray()
+    for line in text[begin:].splitlines()[1:]:
+        if line.startswith('STATUS CODE LOG END'):
+            break
+        match = re.match(r'\s*([0-9a-fA-F]{8}):((?:\s+[0-9a-fA-F]{2})+)\s*$', line)
+        if match is None:
+            continue
+        offset = int(match.group(1), 16)
+        row = bytes(int(b, 16) for b in match.group(2).split())
+        if len(data) < offset:
+            data.extend(bytes(offset - len(data)))
+        data[offset:offset + len(row)] = row
+    return bytes(data)
+
+
+def find_log(data):
+    """Return the offset of the newest plausible log header in a dump."""
+    found = None
+    at = data.find(SIGNATURE)
+    while at >= 0:
+        if at + HEADER_SIZE <= len(data):
+            _, size, _, head, tail, _ = HEADER.unpack_from(data, at)
+            if (size != 0 and size % ALIGNMENT == 0 and tail <= head
+                    and head - tail <= size
+                    and at + HEADER_SIZE + size <= len(data)):
+                found = at
+        at = data.find(SIGNATURE, at + 1)
+    return found
+
+
+def records(data, base):
+    """Yield (type, header fields, body) of the records, oldest first."""
+    _, size, _, head, tail, _ = HEADER.unpack_from(data, base)
+    ring = base + HEADER_SIZE
+    position = tail
+    while position < head:
+        offset = position % size
+        fields = RECORD.unpack_from(data, ring + offset)
+        if fields[1] == PAD:
+            position += size - offset
+            continue
+        length = fields[0]
+        if length < RECORD.size or offset + length > size:
+            break
+        yield fields, data[ring + offset + RECORD.size:ring + offset + length]
+        position += (length + ALIGNMENT - 1) & ~(ALIGNMENT - 1)
+
+
+def format_guid(raw):
+    return str(uuid.UUID(bytes_le=bytes(raw))).upper()
+
+
+def format_status(value):
+    if value & (1 << 63):
+        index = value & ~(1 << 63)
+        if 1 <= index <= len(ERRORS):
+            return ERRORS[index - 1]
+    elif value < len(WARNINGS):
+        return WARNINGS[value]
+    return '%X' % value
+
+
+def format_number(value, long, radix, flags, width):
+    if not long:
+        value &= 0xFFFFFFFF
+        if radix == 10 and 'signed' in flags and value & 0x80000000:
+            value -= 1 << 32
+    elif radix == 10 and 'signed' in flags and value & (1 << 63):
+        value -= 1 << 64
+    if radix == 16:
+        text = '%X' % value
+    elif ',' in flags:
+        text = '{:,}'.format(abs(value))
+    else:
+        text = '%d' % abs(value)
+    sign = ''
+    if radix == 10:
+        if value < 0:
+            sign = '-'
+        elif '+' in flags:
+            sign = '+'
+        elif ' ' in flags:
+            sign = ' '
+    if '0' in flags and '-' not in flags:
+        text = text.rjust(width - len(sign), '0')
+    return sign + text
+
+
+def format_debug(fmt, args, extra):
+    """Format a DEBUG () message the way the EDK2 PrintLib does."""
+    out = []
+    args = list(args)
+    extra = bytes(extra)
+    index = 0
+    while index < len(fmt):
+        char = fmt[index]
+        index += 1
+        if char != '%':
+            out.append(char)
+            continue
+        flags = set()
+        width = 0
+        precision = None
+        long = False
+        while index < len(fmt):
+            char = fmt[index]
+            if char in '-+ ,#0' and precision is None and not (char == '0' and width):
+                flags.add(char)
+            elif char.isdigit():
+                if precision is None:
+                    width = width * 10 + int(char)
+                else:
+                    precision = precision * 10 + int(char)
+            elif char == '.':
+                precision = 0
+            elif char == '*':
+                value = args.pop(0) if args else 0
+                if precision is None:
+                    width = value
+                else:
+                    precision = value
+            elif char in 'lL':
+                long = True
+            else:
+                break
+            index += 1
+        if index >= len(fmt):
+            break
+        kind = fmt[index]
+        index += 1
+        if kind in 'aSs':
+            if args:
+                args.pop(0)
+            end = extra.find(b'\0')
+            end = len(extra) if end < 0 else end
+            text = extra[:end].decode('ascii', 'replace')
+            extra = extra[end + 1:]
+            if precision is not None:
+                text = text[:precision]
+        elif kind == 'g':
+            if args:
+                args.pop(0)
+            text = format_guid(extra[:16].ljust(16, b'\0'))
+            extra = extra[16:]
+        elif kind in 'xX':
+            text = format_number(args.pop(0) if args else 0, long, 16,
+                                 flags | ({'0'} if kind == 'X' else set()), width)
+        elif kind == 'd':
+            text = format_number(args.pop(0) if args else 0, long, 10,
+                                 flags | {'signed'}, width)
+        elif kind == 'u':
+            text = format_number(args.pop(0) if args else 0, long, 10, flags, width)
+        elif kind == 'p':
+            text = '%016X' % (args.pop(0) if args else 0)
+        elif kind == 'r':
+            text = format_status(args.pop(0) if args else 0)
+        elif kind == 'c':
+            text = chr((args.pop(0) if args else 0) & 0xFFFF)
+        elif kind == 't':
+            text = '<time %X>' % (args.pop(0) if args else 0)
+        elif kind == '%':
+            text = '%'
+        else:
+            text = kind
+        if '-' in flags:
+            text = text.ljust(width)
+        else:
+            text = text.rjust(width)
+        out.append(text)
+    return ''.join(out)
+
+
+def format_code(code_type, value, instance, caller):
+    kind = code_type & EFI_STATUS_CODE_TYPE_MASK
+    if kind == EFI_ERROR_CODE:
+        return 'ERROR: C%08X:V%08X I%X %s\n' % (code_type, value, instance, caller)
+    if kind == EFI_PROGRESS_CODE:
+        return 'PROGRESS CODE: V%08X I%X\n' % (value, instance)
+    return 'Undefined: C%08X:V%08X I%X\n' % (code_type, value, instance)
+
+
+def decode(data, base, show_guid):
+    _, _, frequency, head, tail, overwritten = HEADER.unpack_from(data, base)
+    if overwritten:
+        print('(%d older records were overwritten)' % overwritten)
+    #
+    # The FORMAT record of the oldest messages may have been overwritten,
+    # a later copy of the same format string still applies to them.
+    #
+    formats = {}
+    for fields, body in records(data, base):
+        if fields[1] == FORMAT:
+            formats[fields[3]] = bytes(body).split(b'\0', 1)[0].decode('ascii', 'replace')
+    for fields, body in records(data, base):
+        _, kind, arg_count, token, timestamp, caller, code_type, value, instance, _ = fields
+        caller = format_guid(caller)
+        if kind == DEBUG:
+            args = struct.unpack_from('<%dQ' % arg_count, body)
+            fmt = formats.get(token)
+            if fmt is None:
+                text = '<unknown format %08X>%s\n' % (token, ''.join(' %X' % a for a in args))
+            else:
+                text = format_debug(fmt, args, body[arg_count * 8:])
+        elif kind == CODE:
+            text = format_code(code_type, value, instance, caller)
+        else:
+            continue
+        stamp = '[%12.6f]' % (timestamp / frequency) if frequency else '[%16d]' % timestamp
+        prefix = stamp + (' ' + caller if show_guid else '') + ' '
+        for line in text.replace('\r', '').rstrip('\n').split('\n'):
+            print(prefix + line)
+
+
+def main(argv):
+    show_guid = '-g' in argv
+    argv = [a for a in argv if a != '-g']
+    if argv:
+        with open(argv[0], 'rb') as source:
+            data = source.read()
+    else:
+        data = sys.stdin.buffer.read()
+
+    capture = read_capture(data.decode('latin-1'))
+    if capture is not None:
+        data = capture
+    base = find_log(data)
+    if base is None:
+        sys.exit('no status code log found')
+    decode(data, base, show_guid)
+
+
+if __name__ == '__main__':
+    main(sys.argv[1:])
@@ -0,0 +1,147 @@
+#!/usr/bin/env python3
+#
+# Turns the timed memory status code table (Include/Guid/TimedStatusCodeRecord.h)
+# into boot phase durations, to spot boot time regressions.
+#
+# The table is read from a raw memory dump holding it, or from the output
+# of the UEFI shell command "dmem <address> <size>", and found by its
+# signature. Phases are told apart by the POST code stored with each
+# record (see Library/PostCodeLibMmc/README.md):
+#
+#   PEI        first record       -> DXE_CORE_STARTED (0x60)
+#   DXE core   DXE_CORE_STARTED   -> DXE_BDS_STARTED (0x90)
+#   BDS        DXE_BDS_STARTED    -> DXE_READY_TO_BOOT (0xAD)
+#   PCI        first of 0x94-0x96 -> first record after the last of them
+#   USB        first of 0x9A-0x9D -> first record after the last of them
+#
+# Usage: StatusCodePhases.py [-v] FILE
+#   -v  also list every record with its time
+#
+# Copyright (c) 2022, ADLink. All rights reserved.<BR>
+#
+# SPDX-License-Identifier: BSD-2-Clause-Patent
+#
+
+import re
+import struct
+import sys
+import uuid
+
+SIGNATURE = b'TSCR'
+HEADER = struct.Struct('<4sIIIIIQ')
+RECORD = struct.Struct('<IIIB3xQ16s')
+
+DXE_CORE_STARTED = 0x60
+DXE_BDS_STARTED = 0x90
+DXE_READY_TO_BOOT = 0xAD
+PCI_CODES = range(0x94, 0x97)
+USB_CODES = range(0x9A, 0x9E)
+
+
+def read_dmem(text):
+    """Return the bytes of a UEFI shell dmem output, or None."""
+    data = bytearray()
+    for line in text.splitlines():
+        match = re.match(r'\s*[0-9A-Fa-f]{8,16}:\s+((?:[0-9A-Fa-f]{2}[ -]){1,15}[0-9A-Fa-f]{2})', line)
+        if match:
+            data.extend(int(b, 16) for b in re.split('[ -]', match.group(1)))
+    return bytes(data) if data else None
+
+
+def read_table(data):
+    """Return (frequency, records oldest first, records lost) of the last table found."""
+    found = None
+    at = data.find(SIGNATURE)
+    while at >= 0:
+        if at + HEADER.size <= len(data):
+            _, size, index, number, maximum, _, frequency = HEADER.unpack_from(data, at)
+            if (size == RECORD.size and maximum != 0 and index < maximum
+                    and at + HEADER.size + min(number, maximum) * size <= len(data)):
+                found = at
+        at = data.find(SIGNATURE, at + 1)
+    if found is None:
+        return None
+
+    _, size, index, number, maximum, _, frequency = HEADER.unpack_from(data, found)
+    first, count = (index, maximum) if number >= maximum else (0, number)
+    base = found + HEADER.size
+    records = [RECORD.unpack_from(data, base + ((first + n) % maximum) * size)
+               for n in range(count)]
+    return frequency, records, number - count
+
+
+def first(records, codes, start=0):
+    for n in range(start, len(records)):
+        if records[n][3] in codes:
+            return n
+    return None
+
+
+def span(records, codes):
+    """Return (start, end) indexes of the records covering a code range."""
+    begin = first(records, codes)
+    if begin is None:
+        return None
+    end = max(n for n in range(len(records)) if records[n][3] in codes)
+    return begin, min(end + 1, len(records) - 1)
+
+
+def phases(records):
+    core = first(records, (DXE_CORE_STARTED,))
+    bds = first(records, (DXE_BDS_STARTED,))
+    boot = first(records, (DXE_READY_TO_BOOT,), bds or 0)
+    last = len(records) - 1
+    result = [
+        ('PEI', 0, core),
+        ('DXE core', core, bds),
+        ('BDS', bds, boot if boot is not None else last),
+    ]
+    for name, codes in (('PCI', PCI_CODES), ('USB', USB_CODES)):
+        found = span(records, codes)
+        result.append((name,) + (found if found else (None, None)))
+    return result
+
+
+def main(argv):
+    verbose = '-v' in argv
+    argv = [a for a in argv if a != '-v']
+    if len(argv) != 1:
+        sys.exit('usage: StatusCodePhases.py [-v] FILE')
+    with open(argv[0], 'rb') as source:
+        data = source.read()
+
+    table = read_table(data)
+    if table is None:
+        dump = read_dmem(data.decode('latin-1'))
+        table = read_table(dump) if dump else None
+    if table is None:
+        sys.exit('no timed status code table found')
+    frequency, records, lost = table
+    if not records or not frequency:
+        sys.exit('the table is empty')
+
+    def ms(ticks):
+        return ticks * 1000.0 / frequency
+
+    if lost:
+        print('%d oldest records were overwritten, the first phases may be short' % lost)
+    if verbose:
+        for code_type, value, instance, post, stamp, caller in records:
+            print('%12.3f ms  C%08X V%08X I%-4X POST %02X  %s' % (
+                ms(stamp), code_type, value, instance, post,
+                str(uuid.UUID(bytes_le=caller)).upper()))
+        print()
+
+    print('%-10s %12s %12s' % ('Phase', 'Start (ms)', 'Time (ms)'))
+    print('%-10s %12.3f %12s' % ('Before PEI', 0.0, '%.3f' % ms(records[0][4])))
+    for name, begin, end in phases(records):
+        if begin is None or end is None:
+            print('%-10s %12s %12s' % (name, '-', '-'))
+            continue
+        start = records[begin][4]
+        print('%-10s %12.3f %12.3f' % (name, ms(start), ms(records[end][4] - start)))
+    print('%-10s %12s %12.3f' % ('Total', '', ms(records[-1][4])))
+
+
+if __name__ == '__main__':
+    main(sys.argv[1:])
@@ -0,0 +1,286 @@
+#!/usr/bin/env python3
+#
+# Reads the status code tables the firmware leaves to the OS from a memory
+# dump, and prints them as JSON or CSV.
+#
+# Tables, each found through its EFI configuration table entry:
+#
+#   timed     gAdlinkTimedStatusCodeRecordGuid, runtime table of this boot
+#             (Include/Guid/TimedStatusCodeRecord.h)
+#   memory    gMemoryStatusCodeRecordGuid, the runtime table of the stock
+#             MdeModulePkg handler, for firmware built without ours
+#   previous  gAdlinkPersistentStatusCodeLogGuid, log of the boot before
+#             the last warm reset (Include/Guid/PersistentStatusCodeLog.h)
+#
+# Layout, little endian:
+#
+#   timed     header  Signature 'TSCR', RecordSize, RecordIndex,
+#                     NumberOfRecords, MaxRecordsNumber, Reserved (UINT32),
+#                     Frequency (UINT64)
+#             record  CodeType, Value, Instance (UINT32), PostCode (UINT8),
+#                     3 reserved bytes, Timestamp (UINT64), CallerId (GUID)
+#   memory    header  RecordIndex, NumberOfRecords, MaxRecordsNumber (UINT32)
+#             record  CodeType, Value, Instance (UINT32)
+#   previous  header  Signature 'PSLG', RecordSize, MaxRecordsNumber,
+#                     BootCount (UINT32), Frequency (UINT64), HeaderCrc,
+#                     NextSequence (UINT32)
+#             record  Sequence, Crc (UINT32), then a timed record
+#
+# MaxRecordsNumber records follow the header. In the timed and memory
+# tables the oldest record is the first one while NumberOfRecords is below
+# MaxRecordsNumber, and the one at RecordIndex once it wrapped around. In
+# the previous boot log the record with sequence number N is at index
+# N % MaxRecordsNumber, and only records whose CRC32 matches count.
+#
+# The dump is either raw bytes or the console output of the UEFI shell
+# command "dmem ADDRESS SIZE". From the shell, "memmap" lists the RT_Data
+# ranges holding the timed and memory tables. The previous boot log sits at
+# PcdStatusCodePersistentLogBase. Reading the tables from Linux is not
+# supported: /dev/mem does not give RAM under CONFIG_STRICT_DEVMEM, and
+# arm64 ACPI boots do not expose the EFI system table to user space.
+#
+# Usage: StatusCodeTable.py [-t timed|memory|previous] [-f json|csv]
+#                           [--base ADDRESS] [--address ADDRESS]
+#                           [--systab ADDRESS] FILE
+#   --base     physical address of the first byte of a raw dump (default
+#              0). A dmem output carries its own addresses.
+#   --address  physical address of the table. Needed for the memory table,
+#              which has no signature. Otherwise the table is found through
+#              the EFI system table at --systab, if the dump holds it, or by
+#              its signature.
+#
+# Copyright (c) 2022, ADLink. All rights reserved.<BR>
+#
+# SPDX-License-Identifier: BSD-2-Clause-Patent
+#
+
+import argparse
+import binascii
+import csv
+import json
+import re
+import struct
+import sys
+import uuid
+
+GUIDS = {
+    'timed': uuid.UUID('51376e06-4d6a-485c-8a4f-fc2d818695f1'),
+    'memory': uuid.UUID('060cc026-4c0d-4dda-8f41-595fef00a502'),
+    'previous': uuid.UUID('9922b9eb-0339-470e-a89d-c8a81e5dde22'),
+}
+
+SYSTAB_SIGNATURE = b'IBI SYST'
+SYSTAB_ENTRIES = struct.Struct('<QQ')        # NumberOfTableEntries, ConfigurationTable
+SYSTAB_ENTRIES_OFFSET = 104
+CONFIG_ENTRY = struct.Struct('<16sQ')
+
+TIMED_HEADER = struct.Struct('<4sIIIIIQ')
+TIMED_RECORD = struct.Struct('<IIIB3xQ16s')
+MEMORY_HEADER = struct.Struct('<III')
+MEMORY_RECORD = struct.Struct('<III')
+PERSISTENT_HEADER = struct.Struct('<4sIIIQII')
+PERSISTENT_RECORD = struct.Struct('<II')
+
+MAX_TABLE = 16 << 20
+
+FIELDS = ['index', 'sequence', 'time_ms', 'code_type', 'value', 'instance',
+          'post_code', 'caller']
+
+
+class DumpMem(object):
+    """A raw memory dump standing for physical memory from a base address."""
+
+    def __init__(self, path, base):
+        with open(path, 'rb') as source:
+            self.data = source.read()
+        self.base = base
+        dmem = read_dmem(self.data)
+        if dmem is not None:
+            self.base, self.data = dmem
+
+    def read(self, address, size):
+        offset = address - self.base
+        if offset < 0 or offset + size > len(self.data):
+            raise IOError('0x%x is outside of the dump' % address)
+        return self.data[offset:offset + size]
+
+    def physical(self, address):
+        return address
+
+    def runtime_data(self):
+        return [(self.base, len(self.data))]
+
+
+def read_dmem(raw):
+    """Return (address, bytes) of a UEFI shell dmem output, or None."""
+    text = raw.decode('utf-8', 'ignore').replace('\x00', '')
+    base = None
+    data = bytearray()
+    for line in text.splitlines():
+        match = re.match(r'\s*([0-9A-Fa-f]{8,16}):\s+((?:[0-9A-Fa-f]{2}[ -]){1,15}[0-9A-Fa-f]{2})', line)
+        if match:
+            if base is None:
+                base = int(match.group(1), 16)
+            data.extend(int(b, 16) for b in re.split('[ -]', match.group(2)))
+    return (base, bytes(data)) if data else None
+
+
+def config_tables(memory, systab):
+    """Return {GUID: physical address} of the EFI configuration table."""
+    if memory.read(systab, len(SYSTAB_SIGNATURE)) != SYSTAB_SIGNATURE:
+        raise IOError('no EFI system table at 0x%x' % systab)
+    count, table = SYSTAB_ENTRIES.unpack(
+        memory.read(systab + SYSTAB_ENTRIES_OFFSET, SYSTAB_ENTRIES.size))
+    if count > 1024:
+        raise IOError('implausible EFI system table at 0x%x' % systab)
+    table = memory.physical(table)
+    data = memory.read(table, count * CONFIG_ENTRY.size)
+    tables = {}
+    for n in range(count):
+        guid, address = CONFIG_ENTRY.unpack_from(data, n * CONFIG_ENTRY.size)
+        tables[uuid.UUID(bytes_le=guid)] = memory.physical(address)
+    return tables
+
+
+def scan(memory, signature, header):
+    """Return the address of the last plausible table with a signature."""
+    found = None
+    for base, size in memory.runtime_data():
+        try:
+            data = memory.read(base, size)
+        except (IOError, OSError):
+            continue
+        at = data.find(signature)
+        while at >= 0:
+            if at + header.size <= len(data):
+                found = base + at
+            at = data.find(signature, at + 1)
+    return found
+
+
+def guid_text(raw):
+    return str(uuid.UUID(bytes_le=raw)).upper()
+
+
+def record(index, sequence, frequency, fields):
+    code_type, value, instance = fields[:3]
+    row = {'index': index, 'sequence': sequence, 'time_ms': None,
+           'code_type': '0x%08X' % code_type, 'value': '0x%08X' % value,
+           'instance': instance, 'post_code': None, 'caller': None}
+    if len(fields) > 3:
+        post, stamp, caller = fields[3:]
+        row['time_ms'] = round(stamp * 1000.0 / frequency, 3) if frequency else None
+        row['post_code'] = '0x%02X' % post
+        row['caller'] = guid_text(caller)
+    return row
+
+
+def wrapped(index, number, maximum):
+    """Return (first, count) of the records of a table that wraps around."""
+    if number >= maximum:
+        return index, maximum
+    return 0, number
+
+
+def read_timed(memory, address):
+    signature, size, index, number, maximum, _, frequency = TIMED_HEADER.unpack(
+        memory.read(address, TIMED_HEADER.size))
+    if signature != b'TSCR' or size != TIMED_RECORD.size or not maximum or index >= maximum:
+        raise IOError('no timed status code table at 0x%x' % address)
+    data = memory.read(address + TIMED_HEADER.size, maximum * size)
+    first, count = wrapped(index, number, maximum)
+    rows = [record(n, None, frequency,
+                   TIMED_RECORD.unpack_from(data, ((first + n) % maximum) * size))
+            for n in range(count)]
+    return {'records_written': number, 'records_lost': number - count}, rows
+
+
+def read_memory(memory, address):
+    index, number, maximum = MEMORY_HEADER.unpack(memory.read(address, MEMORY_HEADER.size))
+    if not maximum or index >= maximum or maximum * MEMORY_RECORD.size > MAX_TABLE:
+        raise IOError('no memory status code table at 0x%x' % address)
+    data = memory.read(address + MEMORY_HEADER.size, maximum * MEMORY_RECORD.size)
+    first, count = wrapped(index, number, maximum)
+    rows = [record(n, None, 0,
+                   MEMORY_RECORD.unpack_from(data, ((first + n) % maximum) * MEMORY_RECORD.size))
+            for n in range(count)]
+    return {'records_written': number, 'records_lost': number - count}, rows
+
+
+def read_previous(memory, address):
+    header = memory.read(address, PERSISTENT_HEADER.size)
+    signature, size, maximum, boot, frequency, crc, following = PERSISTENT_HEADER.unpack(header)
+    if (signature != b'PSLG' or size != PERSISTENT_RECORD.size + TIMED_RECORD.size
+            or not maximum or crc != binascii.crc32(header[:24]) & 0xFFFFFFFF):
+        raise IOError('no persistent status code log at 0x%x' % address)
+    data = memory.read(address + PERSISTENT_HEADER.size, maximum * size)
+    found = {}
+    for n in range(maximum):
+        raw = bytearray(data[n * size:(n + 1) * size])
+        sequence, crc = PERSISTENT_RECORD.unpack_from(raw)
+        raw[4:8] = bytes(4)
+        if (crc != binascii.crc32(bytes(raw)) & 0xFFFFFFFF or sequence >= following
+                or sequence + maximum < following):
+            continue
+        found[sequence] = TIMED_RECORD.unpack_from(raw, PERSISTENT_RECORD.size)
+    rows = [record(n, sequence, frequency, found[sequence])
+            for n, sequence in enumerate(sorted(found))]
+    return {'boot_count': boot, 'records_written': following,
+            'records_lost': following - len(rows)}, rows
+
+
+READERS = {
+    'timed': (read_timed, b'TSCR', TIMED_HEADER),
+    'memory': (read_memory, None, None),
+    'previous': (read_previous, b'PSLG', PERSISTENT_HEADER),
+}
+
+
+def locate(memory, table, systab):
+    if systab is not None:
+        try:
+            address = config_tables(memory, systab).get(GUIDS[table])
+            if address is not None:
+                return address
+        except (IOError, OSError):
+            pass
+    _, signature, header = READERS[table]
+    if signature is not None:
+        return scan(memory, signature, header)
+    return None
+
+
+def main(argv):
+    parser = argparse.ArgumentParser(description='Read a firmware status code table.')
+    parser.add_argument('-t', '--table', choices=sorted(READERS), default='timed')
+    parser.add_argument('-f', '--format', choices=('json', 'csv'), default='json')
+    parser.add_argument('--systab', type=lambda text: int(text, 0))
+    parser.add_argument('--address', type=lambda text: int(text, 0))
+    parser.add_argument('--base', type=lambda text: int(text, 0), default=0)
+    parser.add_argument('dump')
+    args = parser.parse_args(argv)
+
+    try:
+        memory = DumpMem(args.dump, args.base)
+        address = args.address
+        if address is None:
+            address = locate(memory, args.table, args.systab)
+        if address is None:
+            sys.exit('no %s status code table found%s' % (
+                args.table, '' if READERS[args.table][1] else ', give its --address'))
+        summary, rows = READERS[args.table][0](memory, address)
+    except (IOError, OSError) as error:
+        sys.exit(str(error))
+
+    if args.format == 'csv':
+        writer = csv.DictWriter(sys.stdout, FIELDS)
+        writer.writeheader()
+        writer.writerows(rows)
+    else:
+        summary.update({'table': args.table, 'address': '0x%x' % address, 'records': rows})
+        json.dump(summary, sys.stdout, indent=2)
+        sys.stdout.write('\n')
+
+
+if __name__ == '__main__':
+    main(sys.argv[1:])